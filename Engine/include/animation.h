@@ -0,0 +1,129 @@
+﻿#ifndef _ANIMATION_H_
+#define _ANIMATION_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "include/threadpool.h"
+
+namespace Engine
+{
+	// Matrices are 16 floats in row-major order applied to row vectors, the
+	// layout of XMFLOAT4X4. Rotations are unit quaternions stored as x, y, z, w.
+	struct JOINT_TRANSFORM_STRUCT
+	{
+		float Translation[3];
+		float Rotation[4];
+		float Scale[3];
+	};
+
+	// Up to four influences per vertex; the weights are expected to sum to one.
+	struct SKIN_WEIGHT_STRUCT
+	{
+		uint16_t Joint[4];
+		float Weight[4];
+	};
+
+	// Output has the layout of Vertex, so it can be passed straight to
+	// IDynamicVertexBuffer::Allocate. Positions are the first three floats of
+	// a vertex and normals three floats at NormalOffset, or SIZE_MAX for none.
+	struct SKIN_STREAM_STRUCT
+	{
+		const void* Vertex;
+		const SKIN_WEIGHT_STRUCT* Weight;
+		void* Output;
+		size_t Count;
+		size_t Stride;
+		size_t NormalOffset;
+	};
+
+	// Joint hierarchy with the parent of every joint added before the joint.
+	class Skeleton
+	{
+	public:
+		static constexpr uint32_t Invalid = 0xFFFFFFFF;
+
+		// InverseBind maps model space of the bind pose to the joint's space.
+		uint32_t AddJoint(uint32_t Parent, const float* InverseBind);
+		uint32_t GetParent(uint32_t Joint) const;
+		const float* GetInverseBind(uint32_t Joint) const;
+		size_t GetJointCount() const;
+	private:
+		std::vector<uint32_t> Parent;
+		std::vector<float> InverseBind;
+	};
+
+	// Local joint transforms stored as structure-of-arrays. Update turns them
+	// into model space matrices and the per-joint skinning matrices and dual
+	// quaternions consumed by SkinLinear and SkinDualQuaternion.
+	class SkeletonPose
+	{
+	public:
+		explicit SkeletonPose(size_t JointCount = 0);
+		void Resize(size_t JointCount);
+		void SetLocal(uint32_t Joint, const JOINT_TRANSFORM_STRUCT& Local);
+		JOINT_TRANSFORM_STRUCT GetLocal(uint32_t Joint) const;
+		// Moves the local transforms towards Other by Weight, normalizing the blended rotations.
+		void Blend(const SkeletonPose& Other, float Weight);
+		void Update(const Skeleton& Skeleton);
+		const float* GetModel(uint32_t Joint) const;
+		// 16 floats per joint.
+		const float* GetSkinMatrix() const;
+		// 8 floats per joint, the rotation quaternion followed by the dual part.
+		const float* GetSkinDualQuaternion() const;
+		size_t GetJointCount() const;
+	private:
+		friend class AnimationClip;
+
+		std::vector<float> TranslationX;
+		std::vector<float> TranslationY;
+		std::vector<float> TranslationZ;
+		std::vector<float> RotationX;
+		std::vector<float> RotationY;
+		std::vector<float> RotationZ;
+		std::vector<float> RotationW;
+		std::vector<float> ScaleX;
+		std::vector<float> ScaleY;
+		std::vector<float> ScaleZ;
+		std::vector<float> Model;
+		std::vector<float> SkinMatrix;
+		std::vector<float> SkinDualQuaternion;
+	};
+
+	// Uniformly sampled clip. Rotations are stored as the three smallest
+	// quaternion components in 48 bits; translations and scales as 16 bits
+	// per component within the range of each joint over the clip, and only
+	// once for the whole clip when no joint animates them. Frames are stored
+	// as structure-of-arrays padded to eight joints so Sample decodes and
+	// interpolates whole groups of joints at a time.
+	class AnimationClip
+	{
+	public:
+		// Sample holds FrameCount frames of JointCount local transforms, frame after frame.
+		void Build(const JOINT_TRANSFORM_STRUCT* Sample, size_t JointCount, size_t FrameCount, float SampleRate);
+		// Writes the local transforms at Time into Pose, wrapping Time when Loop is set and clamping it otherwise.
+		void Sample(float Time, SkeletonPose& Pose, bool Loop = true) const;
+		float GetDuration() const;
+		size_t GetJointCount() const;
+		size_t GetFrameCount() const;
+		size_t GetMemorySize() const;
+	private:
+		std::vector<uint16_t> Frame;
+		std::vector<float> Minimum;
+		std::vector<float> Range;
+		size_t JointCount = 0;
+		size_t PaddedCount = 0;
+		size_t FrameCount = 0;
+		size_t FrameSize = 0;
+		float SampleRate = 0.0f;
+		bool AnimatedTranslation = false;
+		bool AnimatedScale = false;
+	};
+
+	// Linear blend skinning with the matrices of SkeletonPose::GetSkinMatrix.
+	void SkinLinear(const SKIN_STREAM_STRUCT& Stream, const float* SkinMatrix, ThreadPool* Pool = nullptr);
+	// Dual quaternion skinning with SkeletonPose::GetSkinDualQuaternion; joint scale is ignored.
+	void SkinDualQuaternion(const SKIN_STREAM_STRUCT& Stream, const float* DualQuaternion, ThreadPool* Pool = nullptr);
+}
+
+#endif
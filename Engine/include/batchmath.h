@@ -0,0 +1,25 @@
+﻿#ifndef _BATCHMATH_H_
+#define _BATCHMATH_H_
+
+#include <cstdint>
+#include <cstddef>
+#include "include/threadpool.h"
+#include "include/culling.h"
+
+namespace Engine
+{
+	// Matrices are 16 floats in row-major order applied to row vectors, the
+	// layout of XMFLOAT4X4. Kernels use AVX-512 or AVX2 when the build enables
+	// them and SSE otherwise, and split large batches across Pool.
+
+	// Output[i] = Left[i] * Right, transposed for shader constants when Transpose is set.
+	void MultiplyMatrices(const float* Left, const float* Right, float* Output, size_t Count, bool Transpose = false, ThreadPool* Pool = nullptr);
+	// (X, Y, Z, 1) * Matrix for every point of the streams, without the perspective divide.
+	void TransformPoints(const float* Matrix, const float* X, const float* Y, const float* Z, float* OutputX, float* OutputY, float* OutputZ, size_t Count, ThreadPool* Pool = nullptr);
+	// Output[i] = TransformBoundingBox(Box[i], World + 16 * i).
+	void TransformBoundingBoxes(const BOUNDING_BOX_STRUCT* Box, const float* World, BOUNDING_BOX_STRUCT* Output, size_t Count, ThreadPool* Pool = nullptr);
+	// Output[i] = TransformBoundingBox(Box, World + 16 * i).
+	void TransformBoundingBoxes(const BOUNDING_BOX_STRUCT& Box, const float* World, BOUNDING_BOX_STRUCT* Output, size_t Count, ThreadPool* Pool = nullptr);
+}
+
+#endif
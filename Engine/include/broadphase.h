@@ -0,0 +1,101 @@
+﻿#ifndef _BROADPHASE_H_
+#define _BROADPHASE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "include/threadpool.h"
+#include "include/culling.h"
+
+namespace Engine
+{
+	// First < Second.
+	struct BROADPHASE_PAIR_STRUCT
+	{
+		uint32_t First;
+		uint32_t Second;
+	};
+
+	// Axis-aligned boxes of the objects stored as structure-of-arrays, built
+	// from the same bounds the culling uses. Boxes that touch overlap. Update
+	// only records the new box; the derived classes bring their structures
+	// up to date incrementally and FindPairs reports pairs in parallel.
+	class Broadphase
+	{
+	public:
+		virtual ~Broadphase() = default;
+		virtual void Build(const BOUNDING_BOX_STRUCT* Box, size_t Count);
+		virtual void Update(uint32_t Object, const BOUNDING_BOX_STRUCT& Box);
+		// Replaces the contents of Pair with every overlapping pair and returns their number.
+		virtual size_t FindPairs(std::vector<BROADPHASE_PAIR_STRUCT>& Pair, ThreadPool* Pool = nullptr) = 0;
+		size_t GetObjectCount() const;
+	protected:
+		bool Overlap(uint32_t First, uint32_t Second) const;
+		size_t Gather(std::vector<BROADPHASE_PAIR_STRUCT>& Pair) const;
+
+		std::vector<float> Min[3];
+		std::vector<float> Max[3];
+		std::vector<std::vector<BROADPHASE_PAIR_STRUCT>> BlockPair;
+	};
+
+	// Sort and sweep along the axis with the largest spread of centers at
+	// Build. The sorted order is kept between calls and repaired with an
+	// insertion sort, which is close to linear while objects move coherently.
+	class SweepAndPrune : public Broadphase
+	{
+	public:
+		void Build(const BOUNDING_BOX_STRUCT* Box, size_t Count) override;
+		size_t FindPairs(std::vector<BROADPHASE_PAIR_STRUCT>& Pair, ThreadPool* Pool = nullptr) override;
+		uint32_t GetAxis() const;
+	private:
+		void Sort();
+
+		uint32_t Axis = 0;
+		std::vector<uint32_t> Order;
+		std::vector<float> SortedMin[3];
+		std::vector<float> SortedMax[3];
+	};
+
+	// Uniform grid hashed on cell coordinates. Every object is listed in the
+	// cells its box covers and Update only touches the lists of an object
+	// whose cell range changed. A pair is reported by the cell holding the
+	// minimum corner of the overlap, so it is found once however many cells
+	// the two objects share.
+	class SpatialHash : public Broadphase
+	{
+	public:
+		// With a CellSize of zero every Build picks twice the mean box size.
+		explicit SpatialHash(float CellSize = 0.0f);
+		void Build(const BOUNDING_BOX_STRUCT* Box, size_t Count) override;
+		void Update(uint32_t Object, const BOUNDING_BOX_STRUCT& Box) override;
+		size_t FindPairs(std::vector<BROADPHASE_PAIR_STRUCT>& Pair, ThreadPool* Pool = nullptr) override;
+		float GetCellSize() const;
+		size_t GetCellCount() const;
+	private:
+		struct CELL_STRUCT
+		{
+			int32_t Coordinate[3];
+			std::vector<uint32_t> Object;
+		};
+
+		void ComputeRange(uint32_t Object, int32_t* Range) const;
+		void InsertObject(uint32_t Object, const int32_t* Range);
+		void RemoveObject(uint32_t Object, const int32_t* Range);
+		size_t FindSlot(uint64_t Key) const;
+		void ReleaseSlot(size_t Slot);
+		void Grow();
+
+		float CellSize;
+		float InverseCellSize = 0.0f;
+		bool Automatic;
+		std::vector<int32_t> Range;
+		std::vector<CELL_STRUCT> Cell;
+		std::vector<uint32_t> FreeCell;
+		// Open addressing from cell key to index in Cell, a power of two in size.
+		std::vector<uint64_t> SlotKey;
+		std::vector<uint32_t> SlotCell;
+		size_t SlotCount = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,101 @@
+﻿#ifndef _BVH_H_
+#define _BVH_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "include/culling.h"
+
+namespace Engine
+{
+	struct BVH_RAY_HIT_STRUCT
+	{
+		uint32_t Object;
+		float Distance;
+	};
+
+	// Dynamic bounding volume hierarchy over scene objects. The binary tree
+	// is built with binned SAH, updated by insert/remove and by refitting
+	// moved objects with tree rotations, and collapsed into 4-wide nodes
+	// with SoA child bounds that the queries traverse with SSE. Refit writes
+	// the new bounds straight into the wide nodes and only collapses the
+	// wide subtrees that contain a rotation again.
+	class SceneBVH
+	{
+	public:
+		static constexpr uint32_t Invalid = 0xFFFFFFFF;
+
+		void Build(const BOUNDING_BOX_STRUCT* Box, size_t Count);
+		uint32_t Insert(const BOUNDING_BOX_STRUCT& Box);
+		void Remove(uint32_t Object);
+		void Update(uint32_t Object, const BOUNDING_BOX_STRUCT& Box);
+		void Refit();
+		void Clear();
+
+		size_t QueryFrustum(const FRUSTUM_STRUCT& Frustum, std::vector<uint32_t>& Result);
+		size_t QueryBox(const BOUNDING_BOX_STRUCT& Box, std::vector<uint32_t>& Result);
+		// Intersect returns the exact hit distance for an object whose bounds the ray enters, or a negative value on a miss; without it the bounds distance is used.
+		bool Raycast(const float* Origin, const float* Direction, float MaxDistance, BVH_RAY_HIT_STRUCT& Hit, const std::function<float(uint32_t Object)>& Intersect = nullptr);
+
+		size_t GetObjectCount() const;
+		float GetCost() const;
+	private:
+		struct NODE_STRUCT
+		{
+			float Min[3];
+			float Max[3];
+			uint32_t Parent;
+			uint32_t Child[2];
+			uint32_t Object;
+			// Wide node collapsed from this node, and wide node << 2 | slot holding its bounds.
+			uint32_t Wide;
+			uint32_t Slot;
+			bool Dirty;
+		};
+
+		struct alignas(16) WIDE_NODE_STRUCT
+		{
+			float MinX[4];
+			float MinY[4];
+			float MinZ[4];
+			float MaxX[4];
+			float MaxY[4];
+			float MaxZ[4];
+			uint32_t Child[4];
+			uint32_t Source[4];
+		};
+
+		struct BUILD_STRUCT;
+
+		uint32_t AllocateNode();
+		void FreeNode(uint32_t Node);
+		uint32_t BuildRange(BUILD_STRUCT* Record, size_t Count, uint32_t Parent);
+		void InsertLeaf(uint32_t Leaf);
+		void RemoveLeaf(uint32_t Leaf);
+		void RefitUpward(uint32_t Node);
+		void RefitNode(uint32_t Node);
+		bool Rotate(uint32_t Node);
+		void Combine(uint32_t Node);
+		bool Prepare();
+		uint32_t FlattenNode(uint32_t Node, uint32_t Parent, uint32_t Index = Invalid);
+		void ReleaseWide(uint32_t Index, bool Free);
+		void StoreWide(uint32_t Node);
+		void CollectWide(uint32_t Node, std::vector<uint32_t>& Result) const;
+
+		std::vector<NODE_STRUCT> Node;
+		std::vector<uint32_t> FreeList;
+		std::vector<uint32_t> Leaf;
+		std::vector<uint32_t> FreeObject;
+		std::vector<WIDE_NODE_STRUCT> Wide;
+		std::vector<uint32_t> WideParent;
+		std::vector<uint32_t> FreeWide;
+		std::vector<uint32_t> Rotated;
+		std::vector<uint32_t> Stack;
+		uint32_t Root = Invalid;
+		size_t ObjectCount = 0;
+		bool StructureDirty = true;
+	};
+}
+
+#endif
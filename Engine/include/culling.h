@@ -0,0 +1,54 @@
+﻿#ifndef _CULLING_H_
+#define _CULLING_H_
+
+#include <cstdint>
+#include <cstddef>
+#include "include/threadpool.h"
+
+namespace Engine
+{
+	// Planes are stored as (a, b, c, d) with a point inside when a*x + b*y + c*z + d >= 0.
+	struct FRUSTUM_STRUCT
+	{
+		float Plane[6][4];
+	};
+
+	struct BOUNDING_BOX_STRUCT
+	{
+		float Center[3];
+		float Extent[3];
+	};
+
+	// Structure-of-arrays bounds, one entry per object.
+	struct CULL_BOX_STRUCT
+	{
+		const float* CenterX;
+		const float* CenterY;
+		const float* CenterZ;
+		const float* ExtentX;
+		const float* ExtentY;
+		const float* ExtentZ;
+		size_t Count;
+	};
+
+	struct CULL_SPHERE_STRUCT
+	{
+		const float* CenterX;
+		const float* CenterY;
+		const float* CenterZ;
+		const float* Radius;
+		size_t Count;
+	};
+
+	// ViewProjection is row-major for row vectors (v * View * Projection), as stored by XMStoreFloat4x4.
+	FRUSTUM_STRUCT ExtractFrustum(const float* ViewProjection);
+	BOUNDING_BOX_STRUCT ComputeBoundingBox(const void* Vertex, size_t Count, size_t Stride);
+	BOUNDING_BOX_STRUCT TransformBoundingBox(const BOUNDING_BOX_STRUCT& Box, const float* World);
+
+	// Write the indices of the visible objects to Visible (capacity Count) in ascending order and return how many there are.
+	// Bounds with NaN components are never culled.
+	size_t CullBox(const FRUSTUM_STRUCT& Frustum, const CULL_BOX_STRUCT& Box, uint32_t* Visible, ThreadPool* Pool = nullptr);
+	size_t CullSphere(const FRUSTUM_STRUCT& Frustum, const CULL_SPHERE_STRUCT& Sphere, uint32_t* Visible, ThreadPool* Pool = nullptr);
+}
+
+#endif
@@ -0,0 +1,226 @@
+﻿#ifndef _ECS_H_
+#define _ECS_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "include/threadpool.h"
+
+namespace Engine
+{
+	constexpr size_t EntityChunkSize = 16384;
+	constexpr uint32_t MaxComponentType = 64;
+
+	struct ENTITY_STRUCT
+	{
+		uint32_t Index;
+		uint32_t Generation;
+	};
+
+	// Entities with the same set of components share an archetype. Their data
+	// lives in 16 KB chunks holding one array per component plus the entity
+	// indices, kept dense by moving the last entity into removed rows.
+	struct ARCHETYPE_STRUCT
+	{
+		uint64_t Mask;
+		uint32_t Capacity;
+		uint32_t Offset[MaxComponentType];
+		std::vector<uint32_t> Component;
+		std::vector<uint8_t*> Chunk;
+		std::vector<uint32_t> Count;
+		size_t EntityCount;
+	};
+
+	uint32_t AllocateComponentType();
+
+	template<class Component>
+	uint32_t GetComponentType()
+	{
+		static const uint32_t Type = AllocateComponentType();
+		return Type;
+	}
+
+	// Components are plain structs. A query or system lists them as template
+	// arguments; a const component is only read, which lets systems that do
+	// not write each other's components run in parallel.
+	class EntityWorld
+	{
+	public:
+		EntityWorld() = default;
+		EntityWorld(const EntityWorld&) = delete;
+		EntityWorld& operator=(const EntityWorld&) = delete;
+		~EntityWorld();
+
+		template<class... Component>
+		ENTITY_STRUCT Create(const Component&... Value)
+		{
+			(this->RegisterComponent<Component>(), ...);
+			const ENTITY_STRUCT Entity = this->Allocate(GetMask<Component...>());
+			(memcpy(this->GetComponent(Entity, GetComponentType<Component>()), &Value, sizeof(Component)), ...);
+			return Entity;
+		}
+
+		void Destroy(ENTITY_STRUCT Entity);
+		bool IsAlive(ENTITY_STRUCT Entity) const;
+
+		template<class Component>
+		void Add(ENTITY_STRUCT Entity, const Component& Value)
+		{
+			this->RegisterComponent<Component>();
+			this->Move(Entity, this->Record[Entity.Index].Archetype->Mask | GetMask<Component>());
+			memcpy(this->GetComponent(Entity, GetComponentType<Component>()), &Value, sizeof(Component));
+		}
+
+		template<class Component>
+		void Remove(ENTITY_STRUCT Entity)
+		{
+			this->Move(Entity, this->Record[Entity.Index].Archetype->Mask & ~GetMask<Component>());
+		}
+
+		template<class Component>
+		Component* Get(ENTITY_STRUCT Entity)
+		{
+			return static_cast<Component*>(this->GetComponent(Entity, GetComponentType<Component>()));
+		}
+
+		// Callback(Component&...) for every entity that has all the listed components.
+		template<class... Component, class Function>
+		void Each(const Function& Callback, ThreadPool* Pool = nullptr)
+		{
+			this->EachChunk<Component...>([&](size_t Count, Component*... Array)
+			{
+				for (size_t Row = 0; Row < Count; Row++)
+				{
+					Callback(Array[Row]...);
+				}
+			}, Pool);
+		}
+
+		// Callback(Count, Component*...) for every chunk, for loops over the component arrays.
+		template<class... Component, class Function>
+		void EachChunk(const Function& Callback, ThreadPool* Pool = nullptr)
+		{
+			const uint64_t Mask = GetMask<Component...>();
+
+			std::vector<std::pair<ARCHETYPE_STRUCT*, size_t>> Work;
+			for (const std::unique_ptr<ARCHETYPE_STRUCT>& Archetype : this->Archetype)
+			{
+				if ((Archetype->Mask & Mask) == Mask)
+				{
+					for (size_t Chunk = 0; Chunk < Archetype->Chunk.size(); Chunk++)
+					{
+						Work.emplace_back(Archetype.get(), Chunk);
+					}
+				}
+			}
+
+			auto Execute = [&](size_t Index)
+			{
+				InvokeChunk<Component...>(*Work[Index].first, Work[Index].second, Callback);
+			};
+
+			if (Pool)
+			{
+				Pool->Dispatch(Work.size(), Execute);
+			}
+			else
+			{
+				for (size_t Index = 0; Index < Work.size(); Index++)
+				{
+					Execute(Index);
+				}
+			}
+		}
+
+		// Systems are run by RunSystems in the order they were added, except that
+		// a system shares a wave with the earlier ones it has no read/write conflict with.
+		template<class... Component, class Function>
+		void AddSystem(const Function& Callback)
+		{
+			this->AddSystem(GetMask<Component...>(), GetWriteMask<Component...>(), [Callback](ARCHETYPE_STRUCT& Archetype, size_t Chunk)
+			{
+				InvokeChunk<Component...>(Archetype, Chunk, [&](size_t Count, Component*... Array)
+				{
+					for (size_t Row = 0; Row < Count; Row++)
+					{
+						Callback(Array[Row]...);
+					}
+				});
+			});
+		}
+
+		void RunSystems(ThreadPool* Pool = nullptr);
+		size_t GetEntityCount() const;
+		size_t GetArchetypeCount() const;
+		size_t GetSystemWaveCount() const;
+	private:
+		struct RECORD_STRUCT
+		{
+			ARCHETYPE_STRUCT* Archetype;
+			uint32_t Chunk;
+			uint32_t Row;
+			uint32_t Generation;
+		};
+
+		struct SYSTEM_STRUCT
+		{
+			uint64_t Mask;
+			uint64_t Read;
+			uint64_t Write;
+			uint32_t Wave;
+			std::function<void(ARCHETYPE_STRUCT& Archetype, size_t Chunk)> Execute;
+		};
+
+		template<class... Component>
+		static uint64_t GetMask()
+		{
+			return (0ull | ... | (1ull << GetComponentType<std::remove_const_t<Component>>()));
+		}
+
+		template<class... Component>
+		static uint64_t GetWriteMask()
+		{
+			return (0ull | ... | (std::is_const_v<Component> ? 0ull : 1ull << GetComponentType<std::remove_const_t<Component>>()));
+		}
+
+		template<class... Component, class Function>
+		static void InvokeChunk(ARCHETYPE_STRUCT& Archetype, size_t Chunk, const Function& Callback)
+		{
+			uint8_t* Data = Archetype.Chunk[Chunk];
+			Callback(static_cast<size_t>(Archetype.Count[Chunk]), reinterpret_cast<Component*>(Data + Archetype.Offset[GetComponentType<std::remove_const_t<Component>>()])...);
+		}
+
+		template<class Component>
+		void RegisterComponent()
+		{
+			static_assert(std::is_trivially_copyable_v<Component>, "Components must be trivially copyable.");
+			const uint32_t Type = GetComponentType<Component>();
+			this->ComponentSize[Type] = sizeof(Component);
+			this->ComponentAlignment[Type] = alignof(Component);
+		}
+
+		ARCHETYPE_STRUCT* GetArchetype(uint64_t Mask);
+		ENTITY_STRUCT Allocate(uint64_t Mask);
+		void Insert(ARCHETYPE_STRUCT* Archetype, uint32_t Index);
+		void RemoveRow(ARCHETYPE_STRUCT* Archetype, uint32_t Chunk, uint32_t Row);
+		void Move(ENTITY_STRUCT Entity, uint64_t Mask);
+		void* GetComponent(ENTITY_STRUCT Entity, uint32_t Type);
+		void AddSystem(uint64_t Mask, uint64_t Write, std::function<void(ARCHETYPE_STRUCT& Archetype, size_t Chunk)>&& Execute);
+
+		uint32_t ComponentSize[MaxComponentType] = {};
+		uint32_t ComponentAlignment[MaxComponentType] = {};
+		std::vector<std::unique_ptr<ARCHETYPE_STRUCT>> Archetype;
+		std::unordered_map<uint64_t, ARCHETYPE_STRUCT*> ArchetypeMap;
+		std::vector<RECORD_STRUCT> Record;
+		std::vector<uint32_t> FreeIndex;
+		std::vector<SYSTEM_STRUCT> System;
+		size_t EntityCount = 0;
+	};
+}
+
+#endif
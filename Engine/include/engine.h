@@ -1,20 +1,112 @@
 ﻿#ifndef _ENGINE_H_
 #define _ENGINE_H_
 
-#include <tchar.h>
-#include <d3d11.h>
-#include <d3dcompiler.h>
-#include <directxmath.h>
+#include "include/platform.h"
 #include <memory>
+#include <functional>
+#include "include/renderqueue.h"
+#include "include/ringallocator.h"
+#include "include/offsetallocator.h"
+#include "include/threadpool.h"
+#include "include/culling.h"
+#include "include/occlusion.h"
+#include "include/bvh.h"
+#include "include/meshbvh.h"
+#include "include/transform.h"
+#include "include/ecs.h"
+#include "include/pipeline.h"
+#include "include/profiler.h"
+#include "include/telemetry.h"
+#include "include/input.h"
+#include "include/batchmath.h"
+#include "include/animation.h"
+#include "include/particle.h"
+#include "include/broadphase.h"
 
 namespace Engine
 {
-	float GetTimer();
+	// Seconds since the engine was loaded, from a monotonic clock. Take frame
+	// deltas from GetTimestamp() differences instead of subtracting these.
+	double GetTimer();
+
+	class ICommandContext;
+	class ICommandList;
+	class IVertexShader;
+	class IPixelShader;
+	class IConstantBuffer;
+	class IVertexBuffer;
+	class IIndexBuffer;
+	class IInstanceBuffer;
+	class ITexture;
+
+	enum APPLICATION_BACKEND : UINT
+	{
+		APPLICATION_BACKEND_DIRECT3D11 = 0,
+		APPLICATION_BACKEND_NULL = 1,
+		APPLICATION_BACKEND_SOFTWARE = 2,
+	};
+
+	enum CONSTANT_SLOT : UINT
+	{
+		CONSTANT_SLOT_FRAME = 0,
+		CONSTANT_SLOT_MATERIAL = 1,
+		CONSTANT_SLOT_OBJECT = 2,
+	};
+
+	struct CONSTANT_SLICE_STRUCT
+	{
+		UINT FirstConstant;
+		UINT NumConstants;
+	};
+
+	struct DRAW_COMMAND_STRUCT
+	{
+		IVertexShader* VertexShader;
+		IPixelShader* PixelShader;
+		IConstantBuffer* ConstantBuffer;
+		LPCVOID ConstantData;
+		SIZE_T ConstantDataSize;
+		ITexture* Texture;
+		IVertexBuffer* VertexBuffer;
+		IIndexBuffer* IndexBuffer;
+		UINT IndexCount;
+		IInstanceBuffer* InstanceBuffer;
+		UINT InstanceCount;
+		UINT StartIndex;
+		INT BaseVertex;
+	};
+
+	struct APPLICATION_COUNTER_STRUCT
+	{
+		uint64_t DrawCount;
+		uint64_t IndexCount;
+		uint64_t InstanceCount;
+		uint64_t BindCount;
+		uint64_t ConstantBytes;
+		uint64_t CreateCount;
+		uint64_t DestroyCount;
+		uint64_t CreateTime;
+	};
+
+	struct APPLICATION_STATISTICS_STRUCT
+	{
+		uint64_t FrameCount;
+		APPLICATION_COUNTER_STRUCT Frame;
+		APPLICATION_COUNTER_STRUCT Total;
+		uint64_t ResourceCount;
+		UINT SampleCount;
+		double FrameTime;
+		double FrameTimeP50;
+		double FrameTimeP95;
+		double FrameTimeP99;
+		double FrameTimeMax;
+	};
 
 	class IApplication
 	{
 	public:
 		static std::shared_ptr<IApplication> Create(LPCTSTR Title, INT X, INT Y, UINT Width, UINT Height, DWORD Style = WS_OVERLAPPEDWINDOW);
+		static std::shared_ptr<IApplication> Create(APPLICATION_BACKEND Backend, LPCTSTR Title, INT X, INT Y, UINT Width, UINT Height, DWORD Style = WS_OVERLAPPEDWINDOW);
 		virtual bool Run() = 0;
 		virtual void Quit() = 0;
 		virtual int GetWidth() const = 0;
@@ -22,18 +114,136 @@ namespace Engine
 		virtual int GetMouseDirectionX() const = 0;
 		virtual int GetMouseDirectionY() const = 0;
 		virtual bool GetKeyState(BYTE KeyCode) const = 0;
+		// Timestamped key edges and mouse moves in arrival order, filled by Run().
+		virtual InputQueue& GetInputQueue() = 0;
 		virtual bool ResizeBuffer(UINT BufferCount, UINT Width, UINT Height, UINT SampleCount) = 0;
 		virtual void BeginDraw(float R, float G, float B, float A) = 0;
 		virtual bool EndDraw(UINT SyncInterval) = 0;
-		virtual void Draw(UINT IndexCount) = 0;
+		virtual void Draw(UINT IndexCount, UINT StartIndex = 0, INT BaseVertex = 0) = 0;
+		virtual void DrawInstanced(UINT IndexCount, UINT InstanceCount, UINT StartIndex = 0, INT BaseVertex = 0) = 0;
+		virtual void Submit(uint64_t Key, const DRAW_COMMAND_STRUCT& Command) = 0;
+		virtual void Flush() = 0;
+		virtual ICommandContext* GetContext() = 0;
+		virtual void Execute(ICommandList* const* List, UINT Count) = 0;
+		// Counters of the last finished frame and since creation, with frame time
+		// percentiles over the most recent frames.
+		virtual APPLICATION_STATISTICS_STRUCT GetFrameStatistics() = 0;
+		// Rewrites FileName in the Prometheus text format every Interval seconds; nullptr stops it.
+		virtual void SetStatisticsFile(const char* FileName, float Interval) = 0;
 		virtual ~IApplication() = default;
 	};
 
+	struct NULL_INPUT_STRUCT
+	{
+		INT MouseDirectionX;
+		INT MouseDirectionY;
+		bool KeyState[0xff];
+	};
+
+	struct NULL_STATISTICS_STRUCT
+	{
+		uint64_t FrameCount;
+		uint64_t DrawCount;
+		uint64_t IndexCount;
+		uint64_t InstanceCount;
+		uint64_t BindCount;
+		uint64_t UploadCount;
+		uint64_t UploadBytes;
+		uint64_t ResourceCount;
+		const void* VertexShader;
+		const void* PixelShader;
+		const void* VertexConstant[CONSTANT_SLOT_OBJECT + 1];
+		const void* PixelConstant[CONSTANT_SLOT_OBJECT + 1];
+		const void* VertexBuffer;
+		const void* IndexBuffer;
+		const void* InstanceBuffer;
+		const void* Texture;
+	};
+
+	class INullApplication
+	{
+	public:
+		static std::shared_ptr<INullApplication> Get(std::shared_ptr<IApplication> App);
+		virtual void PushInput(const NULL_INPUT_STRUCT& Input) = 0;
+		virtual const NULL_STATISTICS_STRUCT& GetStatistics() const = 0;
+		virtual void ResetStatistics() = 0;
+		virtual ~INullApplication() = default;
+	};
+
+	struct SOFTWARE_VERTEX_INPUT_STRUCT
+	{
+		LPCVOID Vertex;
+		LPCVOID Instance;
+		LPCVOID Constant[CONSTANT_SLOT_OBJECT + 1];
+	};
+
+	struct SOFTWARE_VARYING_STRUCT
+	{
+		DirectX::XMFLOAT4 Position;
+		DirectX::XMFLOAT2 TexCoord;
+		DirectX::XMFLOAT3 Normal;
+	};
+
+	struct SOFTWARE_TEXTURE_STRUCT
+	{
+		const uint32_t* Color;
+		UINT Width;
+		UINT Height;
+	};
+
+	DirectX::XMFLOAT4 SampleTexture(const SOFTWARE_TEXTURE_STRUCT& Texture, float U, float V);
+
+	typedef std::function<void(const SOFTWARE_VERTEX_INPUT_STRUCT& Input, SOFTWARE_VARYING_STRUCT& Output)> SOFTWARE_VERTEX_FUNCTION;
+	typedef std::function<DirectX::XMFLOAT4(const SOFTWARE_VARYING_STRUCT& Input, const SOFTWARE_TEXTURE_STRUCT& Texture)> SOFTWARE_PIXEL_FUNCTION;
+
+	struct SOFTWARE_STATISTICS_STRUCT
+	{
+		uint64_t FrameCount;
+		uint64_t TriangleCount;
+		uint64_t RasterTriangleCount;
+		uint64_t PixelCount;
+		double VertexTime;
+		double RasterTime;
+	};
+
+	class ISoftwareApplication
+	{
+	public:
+		static std::shared_ptr<ISoftwareApplication> Get(std::shared_ptr<IApplication> App);
+		virtual std::shared_ptr<IVertexShader> CreateVertexShader(SOFTWARE_VERTEX_FUNCTION Function) = 0;
+		virtual std::shared_ptr<IPixelShader> CreatePixelShader(SOFTWARE_PIXEL_FUNCTION Function) = 0;
+		virtual void SetThreadCount(UINT ThreadCount) = 0;
+		virtual UINT GetThreadCount() const = 0;
+		virtual const uint32_t* GetColor() const = 0;
+		virtual bool SaveImage(const char* FileName) const = 0;
+		virtual const SOFTWARE_STATISTICS_STRUCT& GetStatistics() const = 0;
+		virtual void ResetStatistics() = 0;
+		virtual ~ISoftwareApplication() = default;
+	};
+
+	class ICommandContext
+	{
+	public:
+		virtual void Draw(UINT IndexCount, UINT StartIndex = 0, INT BaseVertex = 0) = 0;
+		virtual void DrawInstanced(UINT IndexCount, UINT InstanceCount, UINT StartIndex = 0, INT BaseVertex = 0) = 0;
+		virtual ~ICommandContext() = default;
+	};
+
+	class ICommandList
+	{
+	public:
+		static std::shared_ptr<ICommandList> Create(std::shared_ptr<IApplication> App);
+		virtual ICommandContext* Begin() = 0;
+		virtual void End() = 0;
+		virtual ~ICommandList() = default;
+	};
+
 	class IVertexShader
 	{
 	public:
 		static std::shared_ptr<IVertexShader> Create(std::shared_ptr<IApplication> App, LPCVOID Data, SIZE_T Size);
 		virtual void Set() = 0;
+		virtual void Set(ICommandContext* Context) = 0;
 		virtual ~IVertexShader() = default;
 	};
 
@@ -42,6 +252,7 @@ namespace Engine
 	public:
 		static std::shared_ptr<IPixelShader> Create(std::shared_ptr<IApplication> App, LPCVOID Data, SIZE_T Size);
 		virtual void Set() = 0;
+		virtual void Set(ICommandContext* Context) = 0;
 		virtual ~IPixelShader() = default;
 	};
 
@@ -50,16 +261,30 @@ namespace Engine
 	public:
 		static std::shared_ptr<IConstantBuffer> Create(std::shared_ptr<IApplication> App, SIZE_T Size);
 		virtual void Update(LPCVOID Data) = 0;
-		virtual void SetVertexShader() = 0;
-		virtual void SetPixelShader() = 0;
+		virtual void Update(ICommandContext* Context, LPCVOID Data) = 0;
+		virtual void SetVertexShader(UINT Slot = CONSTANT_SLOT_FRAME) = 0;
+		virtual void SetVertexShader(ICommandContext* Context, UINT Slot = CONSTANT_SLOT_FRAME) = 0;
+		virtual void SetPixelShader(UINT Slot = CONSTANT_SLOT_FRAME) = 0;
+		virtual void SetPixelShader(ICommandContext* Context, UINT Slot = CONSTANT_SLOT_FRAME) = 0;
 		virtual ~IConstantBuffer() = default;
 	};
 
+	class IConstantAllocator
+	{
+	public:
+		static std::shared_ptr<IConstantAllocator> Create(std::shared_ptr<IApplication> App, SIZE_T Capacity);
+		virtual CONSTANT_SLICE_STRUCT Allocate(LPCVOID Data, SIZE_T Size) = 0;
+		virtual void SetVertexShader(UINT Slot, const CONSTANT_SLICE_STRUCT& Slice) = 0;
+		virtual void SetPixelShader(UINT Slot, const CONSTANT_SLICE_STRUCT& Slice) = 0;
+		virtual ~IConstantAllocator() = default;
+	};
+
 	class IVertexBuffer
 	{
 	public:
 		static std::shared_ptr<IVertexBuffer> Create(std::shared_ptr<IApplication> App, LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement);
 		virtual void Set() = 0;
+		virtual void Set(ICommandContext* Context) = 0;
 		virtual ~IVertexBuffer() = default;
 	};
 
@@ -68,15 +293,73 @@ namespace Engine
 	public:
 		static std::shared_ptr<IIndexBuffer> Create(std::shared_ptr<IApplication> App, LPCVOID Data, SIZE_T CountElement);
 		virtual void Set() = 0;
+		virtual void Set(ICommandContext* Context) = 0;
 		virtual unsigned int GetIndexCount() = 0;
 		virtual ~IIndexBuffer() = default;
 	};
 
+	class IDynamicVertexBuffer : public IVertexBuffer
+	{
+	public:
+		static std::shared_ptr<IDynamicVertexBuffer> Create(std::shared_ptr<IApplication> App, SIZE_T CountElement, SIZE_T SizeElement);
+		virtual INT Allocate(LPCVOID Data, SIZE_T CountElement) = 0;
+		virtual ~IDynamicVertexBuffer() = default;
+	};
+
+	class IDynamicIndexBuffer : public IIndexBuffer
+	{
+	public:
+		static std::shared_ptr<IDynamicIndexBuffer> Create(std::shared_ptr<IApplication> App, SIZE_T CountElement);
+		virtual UINT Allocate(LPCVOID Data, SIZE_T CountElement) = 0;
+		virtual ~IDynamicIndexBuffer() = default;
+	};
+
+	struct GEOMETRY_MESH_STRUCT
+	{
+		INT BaseVertex;
+		UINT StartIndex;
+		UINT IndexCount;
+	};
+
+	struct GEOMETRY_REPORT_STRUCT
+	{
+		UINT MeshCount;
+		OFFSET_REPORT_STRUCT Vertex;
+		OFFSET_REPORT_STRUCT Index;
+	};
+
+	class IGeometryPool
+	{
+	public:
+		static std::shared_ptr<IGeometryPool> Create(std::shared_ptr<IApplication> App, SIZE_T VertexCount, SIZE_T SizeElement, SIZE_T IndexCount);
+		virtual UINT Add(LPCVOID Vertex, SIZE_T VertexCount, LPCVOID Index, SIZE_T IndexCount) = 0;
+		virtual void Remove(UINT Mesh) = 0;
+		virtual GEOMETRY_MESH_STRUCT GetMesh(UINT Mesh) = 0;
+		virtual void Compact() = 0;
+		virtual GEOMETRY_REPORT_STRUCT GetReport() = 0;
+		virtual IVertexBuffer* GetVertexBuffer() = 0;
+		// Shared by all meshes and sized to the pool; draw a mesh with GetMesh(), not GetIndexCount().
+		virtual IIndexBuffer* GetIndexBuffer() = 0;
+		virtual ~IGeometryPool() = default;
+	};
+
+	class IInstanceBuffer
+	{
+	public:
+		static std::shared_ptr<IInstanceBuffer> Create(std::shared_ptr<IApplication> App, LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement);
+		virtual void Update(LPCVOID Data, SIZE_T CountElement) = 0;
+		virtual void Set() = 0;
+		virtual void Set(ICommandContext* Context) = 0;
+		virtual unsigned int GetInstanceCount() = 0;
+		virtual ~IInstanceBuffer() = default;
+	};
+
 	class ITexture
 	{
 	public:
 		static std::shared_ptr<ITexture> Create(std::shared_ptr<IApplication> App, LPCVOID Data, UINT Width, UINT Height);
 		virtual void Set() = 0;
+		virtual void Set(ICommandContext* Context) = 0;
 		virtual ~ITexture() = default;
 	};
 }
@@ -0,0 +1,78 @@
+﻿#ifndef _INPUT_H_
+#define _INPUT_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <vector>
+
+namespace Engine
+{
+	enum INPUT_EVENT_TYPE : uint32_t
+	{
+		INPUT_EVENT_KEY_DOWN = 0,
+		INPUT_EVENT_KEY_UP = 1,
+		INPUT_EVENT_MOUSE_MOVE = 2,
+	};
+
+	struct INPUT_EVENT_STRUCT
+	{
+		uint64_t Timestamp;
+		INPUT_EVENT_TYPE Type;
+		uint8_t KeyCode;
+		int32_t X;
+		int32_t Y;
+	};
+
+	// Wait-free ring of input events between one producer, usually the window
+	// procedure, and one consumer, usually the simulation. Events pushed while
+	// the ring is full are dropped and counted.
+	class InputQueue
+	{
+	public:
+		explicit InputQueue(size_t Capacity = 1024);
+		InputQueue(const InputQueue&) = delete;
+		InputQueue& operator=(const InputQueue&) = delete;
+		bool Push(const INPUT_EVENT_STRUCT& Event);
+		bool Pop(INPUT_EVENT_STRUCT& Event);
+		size_t GetCapacity() const;
+		uint64_t GetDropCount() const;
+	private:
+		std::vector<INPUT_EVENT_STRUCT> Event;
+		size_t Mask = 0;
+		alignas(64) std::atomic<size_t> Head{ 0 };
+		size_t CachedTail = 0;
+		alignas(64) std::atomic<size_t> Tail{ 0 };
+		size_t CachedHead = 0;
+		std::atomic<uint64_t> DropCount{ 0 };
+	};
+
+	// Input of one simulation step, rebuilt from the queued events in the
+	// order they happened. A key pressed and released within one step still
+	// reports both edges.
+	class InputState
+	{
+	public:
+		size_t Update(InputQueue& Queue, uint64_t Timestamp);
+		int GetMouseDirectionX() const;
+		int GetMouseDirectionY() const;
+		bool GetKeyState(uint8_t KeyCode) const;
+		bool IsKeyPressed(uint8_t KeyCode) const;
+		bool IsKeyReleased(uint8_t KeyCode) const;
+		size_t GetEventCount() const;
+		// Nanoseconds from event to the Update that consumed it, over the last Update.
+		uint64_t GetMaxLatency() const;
+		uint64_t GetMeanLatency() const;
+	private:
+		bool KeyState[256] = {};
+		bool KeyPressed[256] = {};
+		bool KeyReleased[256] = {};
+		int MouseX = 0;
+		int MouseY = 0;
+		size_t EventCount = 0;
+		uint64_t MaxLatency = 0;
+		uint64_t TotalLatency = 0;
+	};
+}
+
+#endif
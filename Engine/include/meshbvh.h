@@ -0,0 +1,87 @@
+﻿#ifndef _MESHBVH_H_
+#define _MESHBVH_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "include/culling.h"
+#include "include/threadpool.h"
+
+namespace Engine
+{
+	struct MESH_RAY_HIT_STRUCT
+	{
+		uint32_t Triangle;
+		float Distance;
+		float U;
+		float V;
+	};
+
+	// Four rays in structure-of-arrays form, traced together by MeshBVH::Raycast4.
+	struct MESH_RAY_PACKET_STRUCT
+	{
+		float OriginX[4];
+		float OriginY[4];
+		float OriginZ[4];
+		float DirectionX[4];
+		float DirectionY[4];
+		float DirectionZ[4];
+		float MaxDistance[4];
+	};
+
+	// Bounding volume hierarchy over the triangles of one mesh, built with
+	// binned SAH. Leaves hold up to four triangles stored as SoA packs that
+	// are intersected with SSE Moller-Trumbore tests. Triangle indices in
+	// the results are the index of the first index of the triangle divided by three.
+	class MeshBVH
+	{
+	public:
+		static constexpr uint32_t Invalid = 0xFFFFFFFF;
+
+		void Build(const void* Vertex, size_t VertexCount, size_t Stride, const uint32_t* Index, size_t IndexCount, ThreadPool* Pool = nullptr);
+		bool Raycast(const float* Origin, const float* Direction, float MaxDistance, MESH_RAY_HIT_STRUCT& Hit) const;
+		// Hit[Ray].Triangle is Invalid for the rays of the packet that missed.
+		void Raycast4(const MESH_RAY_PACKET_STRUCT& Packet, MESH_RAY_HIT_STRUCT* Hit) const;
+		size_t QuerySphere(const float* Center, float Radius, std::vector<uint32_t>& Triangle) const;
+		// Push Center out of every triangle closer than Radius, returning whether it moved.
+		bool ResolveSphere(float* Center, float Radius, size_t IterationCount = 4) const;
+
+		BOUNDING_BOX_STRUCT GetBounds() const;
+		size_t GetTriangleCount() const;
+	private:
+		struct NODE_STRUCT
+		{
+			float Min[3];
+			uint32_t Offset;
+			float Max[3];
+			uint32_t Count;
+		};
+
+		struct alignas(16) PACK_STRUCT
+		{
+			float V0X[4];
+			float V0Y[4];
+			float V0Z[4];
+			float E1X[4];
+			float E1Y[4];
+			float E1Z[4];
+			float E2X[4];
+			float E2Y[4];
+			float E2Z[4];
+			uint32_t Triangle[4];
+		};
+
+		struct BUILD_STRUCT;
+		struct TASK_STRUCT;
+
+		void BuildNode(std::vector<NODE_STRUCT>& Target, uint32_t Node, BUILD_STRUCT* Record, uint32_t First, uint32_t Count, uint32_t Depth, uint32_t TaskSize, std::vector<TASK_STRUCT>* Task) const;
+		template<class Function>
+		void QueryPack(const float* Center, float Radius, const Function& Callback) const;
+
+		std::vector<NODE_STRUCT> Node;
+		std::vector<PACK_STRUCT> Pack;
+		size_t TriangleCount = 0;
+	};
+}
+
+#endif
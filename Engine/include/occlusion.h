@@ -0,0 +1,69 @@
+﻿#ifndef _OCCLUSION_H_
+#define _OCCLUSION_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "include/culling.h"
+
+namespace Engine
+{
+	struct OCCLUSION_REPORT_STRUCT
+	{
+		uint64_t OccluderTriangleCount;
+		uint64_t TestCount;
+		uint64_t CullCount;
+		float CullPercent;
+		double RasterTime;
+		double TestTime;
+	};
+
+	// Low resolution CPU depth buffer for occlusion culling. Occluders are
+	// rasterised with SSE into a per-pixel nearest depth, which is reduced to
+	// the farthest depth of each 8x8 tile; an occludee is hidden when its
+	// nearest projected depth lies behind every tile its bounds overlap.
+	// Depth follows the D3D convention, 0 at the near plane and 1 at the far.
+	class OcclusionCuller
+	{
+	public:
+		OcclusionCuller(uint32_t Width, uint32_t Height);
+		void Resize(uint32_t Width, uint32_t Height);
+		void Clear();
+		void SetViewProjection(const float* ViewProjection);
+		void RenderOccluder(const void* Vertex, size_t VertexStride, size_t VertexCount, const uint32_t* Index, size_t IndexCount, const float* World);
+		void UpdateHierarchy();
+		bool TestBox(const BOUNDING_BOX_STRUCT& Box);
+		size_t CullBox(const CULL_BOX_STRUCT& Box, const uint32_t* Candidate, size_t CandidateCount, uint32_t* Visible);
+		const float* GetDepth() const;
+		uint32_t GetWidth() const;
+		uint32_t GetHeight() const;
+		bool SaveDepth(const char* FileName) const;
+		OCCLUSION_REPORT_STRUCT GetReport() const;
+		void ResetReport();
+	private:
+		static constexpr uint32_t TileSize = 8;
+
+		struct CLIP_VERTEX_STRUCT
+		{
+			float X;
+			float Y;
+			float Z;
+			float W;
+		};
+
+		void RasterTriangle(const CLIP_VERTEX_STRUCT& V0, const CLIP_VERTEX_STRUCT& V1, const CLIP_VERTEX_STRUCT& V2);
+
+		std::vector<float> Depth;
+		std::vector<float> TileDepth;
+		float ViewProjection[16] = {};
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		uint32_t Pitch = 0;
+		uint32_t TileCountX = 0;
+		uint32_t TileCountY = 0;
+		bool Dirty = false;
+		OCCLUSION_REPORT_STRUCT Report = {};
+	};
+}
+
+#endif
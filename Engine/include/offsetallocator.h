@@ -0,0 +1,68 @@
+﻿#ifndef _OFFSETALLOCATOR_H_
+#define _OFFSETALLOCATOR_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+	struct OFFSET_ALLOCATION_STRUCT
+	{
+		uint32_t Offset;
+		uint32_t Node;
+	};
+
+	struct OFFSET_REPORT_STRUCT
+	{
+		uint32_t TotalFree;
+		uint32_t LargestFree;
+		uint32_t FreeRegionCount;
+		float Fragmentation;
+	};
+
+	// Two-level segregated fit allocator over an abstract range of units
+	// (bytes, vertices, indices). Free regions are binned by a 3-bit mantissa
+	// floating point size class, so allocation and free are O(1).
+	class OffsetAllocator
+	{
+	public:
+		static constexpr uint32_t Invalid = 0xFFFFFFFF;
+
+		explicit OffsetAllocator(uint32_t Size);
+		OFFSET_ALLOCATION_STRUCT Allocate(uint32_t Size);
+		void Free(OFFSET_ALLOCATION_STRUCT Allocation);
+		void Reset();
+		uint32_t GetSize() const;
+		uint32_t GetAllocationSize(OFFSET_ALLOCATION_STRUCT Allocation) const;
+		OFFSET_REPORT_STRUCT GetReport() const;
+	private:
+		static constexpr uint32_t TopBinCount = 32;
+		static constexpr uint32_t BinsPerLeaf = 8;
+		static constexpr uint32_t LeafBinCount = TopBinCount * BinsPerLeaf;
+
+		struct NODE_STRUCT
+		{
+			uint32_t Offset;
+			uint32_t Size;
+			uint32_t BinPrev;
+			uint32_t BinNext;
+			uint32_t NeighborPrev;
+			uint32_t NeighborNext;
+			bool Used;
+		};
+
+		uint32_t InsertNodeIntoBin(uint32_t Size, uint32_t Offset);
+		void RemoveNodeFromBin(uint32_t Node);
+		uint32_t NewNode();
+	private:
+		uint32_t Size = 0;
+		uint32_t FreeStorage = 0;
+		uint32_t UsedBinsTop = 0;
+		uint8_t UsedBins[TopBinCount] = {};
+		uint32_t BinIndices[LeafBinCount] = {};
+		std::vector<NODE_STRUCT> Node;
+		std::vector<uint32_t> FreeNode;
+	};
+}
+
+#endif
@@ -0,0 +1,87 @@
+﻿#ifndef _PARTICLE_H_
+#define _PARTICLE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "include/threadpool.h"
+
+namespace Engine
+{
+	// Spreads are the half extents of the uniform random offsets applied to
+	// every new particle. Color is packed as A8R8G8B8.
+	struct PARTICLE_EMITTER_STRUCT
+	{
+		float Position[3];
+		float PositionSpread[3];
+		float Velocity[3];
+		float VelocitySpread[3];
+		float Lifetime;
+		float LifetimeSpread;
+		float Size;
+		uint32_t Color;
+	};
+
+	// Same layout as the game's VERTEX_STRUCT so particle quads can share its
+	// input layout. The normal points back at the camera.
+	struct PARTICLE_VERTEX_STRUCT
+	{
+		float Position[3];
+		float TexCoord[2];
+		float Normal[3];
+	};
+
+	// Particles stored as structure-of-arrays in two buffers. Update moves the
+	// survivors from one buffer to the other in their original order, Sort
+	// radix sorts them back to front and Build expands them into camera facing
+	// quads. View matrices are 16 floats in row-major order applied to row
+	// vectors, the layout of XMFLOAT4X4.
+	class ParticleSystem
+	{
+	public:
+		explicit ParticleSystem(size_t Capacity);
+		// Returns the number of particles added, which is less than Count once the system is full.
+		size_t Emit(const PARTICLE_EMITTER_STRUCT& Emitter, size_t Count, ThreadPool* Pool = nullptr);
+		// Drag is the fraction of velocity lost per second.
+		void Update(float Delta, const float* Acceleration, float Drag, ThreadPool* Pool = nullptr);
+		// Orders back to front by view depth, compared to about four significant digits.
+		void Sort(const float* View, ThreadPool* Pool = nullptr);
+		// Writes four vertices per particle, in sorted order when Sort ran after the last Emit or Update,
+		// and the particle color per quad to Color unless it is null. Returns the number of quads.
+		size_t Build(const float* View, PARTICLE_VERTEX_STRUCT* Vertex, uint32_t* Color = nullptr, ThreadPool* Pool = nullptr) const;
+		void Clear();
+		size_t GetCount() const;
+		size_t GetCapacity() const;
+
+		// Two triangles per quad in the vertex order written by Build.
+		static void BuildIndex(uint32_t* Index, size_t QuadCount);
+	private:
+		struct STREAM_STRUCT
+		{
+			std::vector<float> PositionX;
+			std::vector<float> PositionY;
+			std::vector<float> PositionZ;
+			std::vector<float> VelocityX;
+			std::vector<float> VelocityY;
+			std::vector<float> VelocityZ;
+			std::vector<float> Age;
+			std::vector<float> Lifetime;
+			std::vector<float> Size;
+			std::vector<uint32_t> Color;
+		};
+
+		STREAM_STRUCT Stream[2];
+		size_t Current = 0;
+		size_t Count = 0;
+		size_t Capacity = 0;
+		uint32_t Seed = 0;
+		bool Sorted = false;
+		std::vector<size_t> BlockLive;
+		std::vector<uint32_t> Key[2];
+		std::vector<uint32_t> Order[2];
+		std::vector<float> Packed;
+		std::vector<uint32_t> Histogram;
+	};
+}
+
+#endif
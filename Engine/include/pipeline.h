@@ -0,0 +1,105 @@
+﻿#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+#include "include/platform.h"
+#include <cstdint>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Engine
+{
+	struct PIPELINE_STATISTICS_STRUCT
+	{
+		uint64_t FrameCount;
+		double SimulationWaitTime;
+		double RenderWaitTime;
+		double RenderTime;
+	};
+
+	// Hands frames from the simulation thread to a render thread. Depth is
+	// the number of published frames that may wait for or be in rendering
+	// while the next one is simulated, so Depth + 1 slots exist. Depth 0
+	// renders inline in End.
+	class FramePipeline
+	{
+	public:
+		FramePipeline(UINT Depth, std::function<void(UINT Slot)> Render);
+		~FramePipeline();
+		// Waits until a slot is free and returns it for the simulation to write.
+		UINT Begin();
+		// Publishes the slot returned by Begin to the render thread.
+		void End();
+		// Waits until every published frame was rendered.
+		void Flush();
+		UINT GetDepth() const;
+		PIPELINE_STATISTICS_STRUCT GetStatistics();
+		void ResetStatistics();
+	private:
+		void Worker();
+		void Rethrow();
+
+		const UINT Depth;
+		std::function<void(UINT Slot)> Render;
+		std::thread Thread;
+		std::mutex Mutex;
+		std::condition_variable Published;
+		std::condition_variable Rendered;
+		uint64_t WriteCount = 0;
+		uint64_t RenderCount = 0;
+		bool Exit = false;
+		std::exception_ptr Error;
+		PIPELINE_STATISTICS_STRUCT Statistics = {};
+	};
+
+	// FramePipeline over Depth + 1 copies of a snapshot type. The simulation
+	// fills the snapshot returned by Begin; the render callback only reads it.
+	template<class Snapshot>
+	class SnapshotPipeline
+	{
+	public:
+		SnapshotPipeline(UINT Depth, std::function<void(const Snapshot&)> Render) :
+			Slot(Depth + 1),
+			Pipeline(Depth, [this, Render](UINT Index) { Render(this->Slot[Index]); })
+		{
+		}
+
+		Snapshot& Begin()
+		{
+			return this->Slot[this->Pipeline.Begin()];
+		}
+
+		void End()
+		{
+			this->Pipeline.End();
+		}
+
+		void Flush()
+		{
+			this->Pipeline.Flush();
+		}
+
+		UINT GetDepth() const
+		{
+			return this->Pipeline.GetDepth();
+		}
+
+		PIPELINE_STATISTICS_STRUCT GetStatistics()
+		{
+			return this->Pipeline.GetStatistics();
+		}
+
+		void ResetStatistics()
+		{
+			this->Pipeline.ResetStatistics();
+		}
+	private:
+		std::vector<Snapshot> Slot;
+		FramePipeline Pipeline;
+	};
+}
+
+#endif
@@ -0,0 +1,35 @@
+﻿#ifndef _PLATFORM_H_
+#define _PLATFORM_H_
+
+#ifdef _WIN32
+#include <tchar.h>
+#include <d3d11.h>
+#include <d3dcompiler.h>
+#include <directxmath.h>
+#else
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+
+typedef int INT;
+typedef unsigned int UINT;
+typedef uint32_t DWORD;
+typedef uint8_t BYTE;
+typedef int32_t HRESULT;
+typedef size_t SIZE_T;
+typedef const void* LPCVOID;
+typedef const char* LPCTSTR;
+
+#define _T(x) x
+#define WS_OVERLAPPEDWINDOW 0x00CF0000L
+
+#define S_OK static_cast<HRESULT>(0)
+#define E_NOTIMPL static_cast<HRESULT>(0x80004001u)
+#define E_OUTOFMEMORY static_cast<HRESULT>(0x8007000Eu)
+#define E_INVALIDARG static_cast<HRESULT>(0x80070057u)
+#define E_FAIL static_cast<HRESULT>(0x80004005u)
+#define SUCCEEDED(hr) (static_cast<HRESULT>(hr) >= 0)
+#define FAILED(hr) (static_cast<HRESULT>(hr) < 0)
+#endif
+
+#endif
@@ -0,0 +1,68 @@
+﻿#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#define PROFILE_CONCAT_INNER(A, B) A##B
+#define PROFILE_CONCAT(A, B) PROFILE_CONCAT_INNER(A, B)
+#define PROFILE_SCOPE(Name) Engine::ProfileScope PROFILE_CONCAT(ProfileScope, __LINE__)(Name)
+
+namespace Engine
+{
+	// Monotonic time in nanoseconds.
+	uint64_t GetTimestamp();
+
+	struct PROFILE_NODE_STRUCT
+	{
+		const char* Name;
+		uint32_t Thread;
+		uint32_t Parent;
+		uint32_t Depth;
+		uint32_t Count;
+		double Time;
+	};
+
+	// Scoped CPU markers recorded into a ring buffer per thread. Names must
+	// outlive the profiler, string literals being the usual choice. Only the
+	// most recent 64K events of every thread are kept, about 2 MiB per ring;
+	// rings of exited threads are handed to new ones rather than freed.
+	class Profiler
+	{
+	public:
+		static constexpr uint32_t Invalid = 0xFFFFFFFF;
+
+		static void SetEnabled(bool Enabled);
+		static bool IsEnabled();
+		static void SetThreadName(const char* Name);
+		static void Begin(const char* Name);
+		static void End();
+		// Closes the current frame; GetFrame then reports it.
+		static void NextFrame();
+		// Fills Node with the last closed frame as a tree per thread in depth-first
+		// order, merging sibling scopes of the same name. Returns the frame time in seconds.
+		static double GetFrame(std::vector<PROFILE_NODE_STRUCT>& Node);
+		// Writes every buffered event in the Chrome trace event format.
+		static bool SaveTrace(const char* FileName);
+	};
+
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(const char* Name)
+		{
+			Profiler::Begin(Name);
+		}
+
+		~ProfileScope()
+		{
+			Profiler::End();
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	};
+}
+
+#endif
@@ -0,0 +1,45 @@
+﻿#ifndef _RENDERQUEUE_H_
+#define _RENDERQUEUE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace Engine
+{
+	enum RENDER_PASS : uint32_t
+	{
+		RENDER_PASS_OPAQUE = 0,
+		RENDER_PASS_TRANSPARENT = 8,
+		RENDER_PASS_OVERLAY = 15,
+	};
+
+	struct RENDER_PACKET_STRUCT
+	{
+		uint64_t Key;
+		uint32_t Command;
+	};
+
+	// Key layout, most significant first:
+	// opaque:      pass(4) | shader(12) | material(16) | depth(24) | unused(8)
+	// transparent: pass(4) | inverted depth(24) | shader(12) | material(16) | unused(8)
+	// Opaque draws are grouped by state and then drawn front to back, transparent draws back to front.
+	uint64_t MakeOpaqueKey(uint32_t Pass, uint32_t Shader, uint32_t Material, float Depth);
+	uint64_t MakeTransparentKey(uint32_t Pass, uint32_t Shader, uint32_t Material, float Depth);
+
+	class RenderQueue
+	{
+	public:
+		void Reserve(size_t Count);
+		void Clear();
+		void Submit(uint64_t Key, uint32_t Command);
+		void Sort();
+		size_t GetCount() const;
+		const RENDER_PACKET_STRUCT* GetPacket() const;
+	private:
+		std::vector<RENDER_PACKET_STRUCT> Packet;
+		std::vector<RENDER_PACKET_STRUCT> Temp;
+	};
+}
+
+#endif
@@ -0,0 +1,82 @@
+﻿#ifndef _RINGALLOCATOR_H_
+#define _RINGALLOCATOR_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+
+namespace Engine
+{
+	// Sub-allocates aligned ranges of a fixed-size buffer in submission order.
+	// Allocations made before EndFrame(Fence) stay reserved until Retire() is
+	// called with a fence value greater than Fence, so data the GPU may still
+	// read is never handed out again.
+	class RingAllocator
+	{
+	public:
+		static constexpr size_t Invalid = SIZE_MAX;
+
+		RingAllocator(size_t Capacity, size_t Alignment);
+		size_t Allocate(size_t Size);
+		void EndFrame(uint64_t Fence);
+		void Retire(uint64_t FirstPendingFence);
+		void Reset();
+		size_t GetCapacity() const;
+		size_t GetAlignment() const;
+		size_t GetUsed() const;
+		size_t GetPendingFrameCount() const;
+	private:
+		struct FRAME_STRUCT
+		{
+			uint64_t Fence;
+			size_t Head;
+			size_t Size;
+		};
+
+		size_t Capacity = 0;
+		size_t Alignment = 1;
+		size_t Head = 0;
+		size_t Tail = 0;
+		size_t Used = 0;
+		size_t FrameSize = 0;
+		std::deque<FRAME_STRUCT> Frame;
+	};
+
+	// Fence values shared by a device and its rings: Current is signalled at the
+	// end of the frame being recorded and every fence below Completed has passed.
+	struct FRAME_FENCE_STRUCT
+	{
+		uint64_t Current;
+		uint64_t Completed;
+	};
+
+	// RingAllocator over one dynamic GPU buffer. Allocate() sets Discard when
+	// the buffer has to be mapped with discard instead of no-overwrite: on first
+	// use, without no-overwrite support, or when the ring is full of data the GPU
+	// may still read. Flush is called before such a discard while the ring holds
+	// data, so draws still queued against it are issued before the buffer is renamed.
+	class FencedRing
+	{
+	public:
+		FencedRing(std::shared_ptr<FRAME_FENCE_STRUCT> Fence, size_t Capacity, size_t Alignment, bool NoOverwrite, std::function<void()> Flush = nullptr);
+		size_t Allocate(size_t Size, bool& Discard);
+		size_t GetCapacity() const;
+		size_t GetUsed() const;
+	private:
+		RingAllocator Ring;
+		std::shared_ptr<FRAME_FENCE_STRUCT> Fence;
+		std::function<void()> Flush;
+		uint64_t LastFence = 0;
+		bool NoOverwrite = false;
+		bool Discard = true;
+	};
+
+	inline size_t AlignUp(size_t Value, size_t Alignment)
+	{
+		return (Value + Alignment - 1) / Alignment * Alignment;
+	}
+}
+
+#endif
@@ -0,0 +1,81 @@
+﻿#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace Engine
+{
+	struct TELEMETRY_HEADER_STRUCT
+	{
+		uint32_t Magic;
+		uint32_t Capacity;
+		std::atomic<uint32_t> Count;
+		uint32_t Reserved;
+		std::atomic<uint64_t> Sequence;
+		std::atomic<uint64_t> Frame;
+		std::atomic<uint64_t> Timestamp;
+	};
+
+	struct TELEMETRY_COUNTER_STRUCT
+	{
+		std::atomic<char> Name[56];
+		std::atomic<double> Value;
+	};
+
+	struct TELEMETRY_VALUE_STRUCT
+	{
+		std::string Name;
+		double Value;
+	};
+
+	// Resident memory of the current process in bytes.
+	uint64_t GetProcessMemory();
+
+	// Publishes named counters into a shared memory segment guarded by a
+	// sequence lock, so readers in other processes never block the frame.
+	// Set only stages a value; Publish copies all of them in one write.
+	class TelemetryPublisher
+	{
+	public:
+		static constexpr uint32_t Invalid = 0xFFFFFFFF;
+		static constexpr uint32_t Magic = 0x314D4C54;
+
+		TelemetryPublisher(const char* Name, uint32_t Capacity = 64);
+		~TelemetryPublisher();
+		TelemetryPublisher(const TelemetryPublisher&) = delete;
+		TelemetryPublisher& operator=(const TelemetryPublisher&) = delete;
+
+		// Returns Invalid when the segment is full or could not be created.
+		uint32_t Register(const char* Name);
+		void Set(uint32_t Counter, double Value);
+		void Publish(uint64_t Frame);
+		bool IsOpen() const;
+	private:
+		std::string Name;
+		TELEMETRY_HEADER_STRUCT* Header = nullptr;
+		TELEMETRY_COUNTER_STRUCT* Counter = nullptr;
+		std::vector<double> Value;
+		size_t Size = 0;
+		void* Handle = nullptr;
+	};
+
+	class TelemetryReader
+	{
+	public:
+		~TelemetryReader();
+		bool Open(const char* Name);
+		void Close();
+		// Copies a consistent snapshot; returns false when the segment is gone or never settles.
+		bool Read(uint64_t& Frame, uint64_t& Timestamp, std::vector<TELEMETRY_VALUE_STRUCT>& Value);
+	private:
+		TELEMETRY_HEADER_STRUCT* Header = nullptr;
+		size_t Size = 0;
+		void* Handle = nullptr;
+	};
+}
+
+#endif
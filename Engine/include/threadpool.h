@@ -0,0 +1,65 @@
+﻿#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Engine
+{
+	// Counts the unfinished jobs spawned against it; a job may spawn children
+	// against the same or another counter before it returns.
+	struct JOB_COUNTER_STRUCT
+	{
+		std::atomic<size_t> Pending{ 0 };
+	};
+
+	// Work-stealing job system. Every worker owns a Chase-Lev deque that it
+	// pushes and pops at the bottom while idle workers steal from the top.
+	// The thread that creates the pool owns the first deque; other threads
+	// submit through a shared queue. Waiting threads run jobs instead of
+	// blocking, so jobs may spawn and wait on other jobs.
+	class ThreadPool
+	{
+	public:
+		ThreadPool(size_t ThreadCount = 0, bool Pin = false);
+		~ThreadPool();
+		void Spawn(std::function<void()>&& Function, JOB_COUNTER_STRUCT* Counter = nullptr);
+		void Wait(JOB_COUNTER_STRUCT& Counter);
+		// Calls Function(First, Last) on ranges of at most Grain indices, split in halves on demand.
+		void ParallelFor(size_t Count, size_t Grain, const std::function<void(size_t First, size_t Last)>& Function);
+		// Runs Function(Index) for every Index in [0, Count) and returns once all of them finished.
+		void Dispatch(size_t Count, const std::function<void(size_t Index)>& Function);
+		size_t GetThreadCount() const;
+	private:
+		struct JOB_STRUCT;
+		struct WORKER_STRUCT;
+
+		void Worker(size_t Index);
+		WORKER_STRUCT* GetWorker() const;
+		JOB_STRUCT* Allocate(WORKER_STRUCT* Worker);
+		void Push(WORKER_STRUCT* Worker, JOB_STRUCT* Job);
+		JOB_STRUCT* Find(WORKER_STRUCT* Worker);
+		void Run(WORKER_STRUCT* Worker, JOB_STRUCT* Job);
+		bool HasWork() const;
+
+		std::vector<std::unique_ptr<WORKER_STRUCT>> Workers;
+		std::vector<std::thread> Thread;
+		std::thread::id Owner;
+		std::mutex SharedMutex;
+		std::deque<JOB_STRUCT*> Shared;
+		std::atomic<size_t> SharedCount;
+		std::mutex SleepMutex;
+		std::condition_variable Wake;
+		std::atomic<size_t> Sleeping;
+		std::atomic<bool> Exit;
+	};
+}
+
+#endif
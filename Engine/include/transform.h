@@ -0,0 +1,69 @@
+﻿#ifndef _TRANSFORM_H_
+#define _TRANSFORM_H_
+
+#include "include/platform.h"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "include/threadpool.h"
+
+namespace Engine
+{
+	struct TRANSFORM_STRUCT
+	{
+		DirectX::XMFLOAT3 Position;
+		DirectX::XMFLOAT4 Rotation;
+		DirectX::XMFLOAT3 Scale;
+	};
+
+	// Parent/child transforms stored as structure-of-arrays and kept sorted
+	// by depth, so every level is a contiguous range whose parents were
+	// already updated. Update recomputes the world matrices of changed
+	// transforms and their descendants only, one level at a time.
+	class TransformHierarchy
+	{
+	public:
+		static constexpr uint32_t Invalid = 0xFFFFFFFF;
+
+		uint32_t Create(const TRANSFORM_STRUCT& Local, uint32_t Parent = Invalid);
+		// Destroys the transform together with all of its descendants on the next Update.
+		void Destroy(uint32_t Transform);
+		void SetParent(uint32_t Transform, uint32_t Parent);
+		void SetLocal(uint32_t Transform, const TRANSFORM_STRUCT& Local);
+		TRANSFORM_STRUCT GetLocal(uint32_t Transform) const;
+		uint32_t GetParent(uint32_t Transform) const;
+		const DirectX::XMMATRIX& GetWorld(uint32_t Transform) const;
+
+		void Update(ThreadPool* Pool = nullptr);
+		size_t GetCount() const;
+		size_t GetLevelCount() const;
+	private:
+		void Sort();
+		void UpdateRange(uint32_t First, uint32_t Last);
+
+		std::vector<float> PositionX;
+		std::vector<float> PositionY;
+		std::vector<float> PositionZ;
+		std::vector<float> RotationX;
+		std::vector<float> RotationY;
+		std::vector<float> RotationZ;
+		std::vector<float> RotationW;
+		std::vector<float> ScaleX;
+		std::vector<float> ScaleY;
+		std::vector<float> ScaleZ;
+		std::vector<uint32_t> Parent;
+		std::vector<uint32_t> Handle;
+		std::vector<uint32_t> Stamp;
+		std::vector<uint8_t> Dirty;
+		std::vector<uint8_t> Alive;
+		std::vector<DirectX::XMMATRIX> World;
+
+		std::vector<uint32_t> Index;
+		std::vector<uint32_t> FreeHandle;
+		std::vector<uint32_t> LevelStart;
+		uint32_t Generation = 0;
+		bool StructureDirty = false;
+	};
+}
+
+#endif
@@ -0,0 +1,860 @@
+﻿#include "include/animation.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr size_t SkinGrain = 2048;
+
+		inline __m128 MultiplyAdd(__m128 A, __m128 B, __m128 C)
+		{
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+			return _mm_fmadd_ps(A, B, C);
+#else
+			return _mm_add_ps(_mm_mul_ps(A, B), C);
+#endif
+		}
+
+#if defined(__AVX2__)
+		inline __m256 MultiplyAdd(__m256 A, __m256 B, __m256 C)
+		{
+#if defined(__FMA__) || defined(_MSC_VER)
+			return _mm256_fmadd_ps(A, B, C);
+#else
+			return _mm256_add_ps(_mm256_mul_ps(A, B), C);
+#endif
+		}
+#endif
+
+		inline __m128 Cross(__m128 A, __m128 B)
+		{
+			const __m128 AYZX = _mm_shuffle_ps(A, A, _MM_SHUFFLE(3, 0, 2, 1));
+			const __m128 BYZX = _mm_shuffle_ps(B, B, _MM_SHUFFLE(3, 0, 2, 1));
+			const __m128 Result = _mm_sub_ps(_mm_mul_ps(A, BYZX), _mm_mul_ps(AYZX, B));
+			return _mm_shuffle_ps(Result, Result, _MM_SHUFFLE(3, 0, 2, 1));
+		}
+
+		inline __m128 Normalize3(__m128 Vector)
+		{
+			const __m128 Square = _mm_mul_ps(Vector, Vector);
+			const float Length = _mm_cvtss_f32(Square) + _mm_cvtss_f32(_mm_shuffle_ps(Square, Square, 0x55)) + _mm_cvtss_f32(_mm_shuffle_ps(Square, Square, 0xAA));
+			return Length > 0.0f ? _mm_mul_ps(Vector, _mm_set1_ps(1.0f / std::sqrt(Length))) : Vector;
+		}
+
+		inline __m128 LoadVector3(const void* Source)
+		{
+			const __m128 XY = _mm_castpd_ps(_mm_load_sd(static_cast<const double*>(Source)));
+			return _mm_movelh_ps(XY, _mm_load_ss(static_cast<const float*>(Source) + 2));
+		}
+
+		inline void StoreVector3(void* Destination, __m128 Vector)
+		{
+			_mm_store_sd(static_cast<double*>(Destination), _mm_castps_pd(Vector));
+			_mm_store_ss(static_cast<float*>(Destination) + 2, _mm_movehl_ps(Vector, Vector));
+		}
+
+		void MultiplyMatrix(const float* Left, const float* Right, float* Output)
+		{
+			const __m128 Right0 = _mm_loadu_ps(Right + 0);
+			const __m128 Right1 = _mm_loadu_ps(Right + 4);
+			const __m128 Right2 = _mm_loadu_ps(Right + 8);
+			const __m128 Right3 = _mm_loadu_ps(Right + 12);
+
+			for (size_t Row = 0; Row < 4; Row++)
+			{
+				__m128 Result = _mm_mul_ps(_mm_set1_ps(Left[Row * 4 + 0]), Right0);
+				Result = MultiplyAdd(_mm_set1_ps(Left[Row * 4 + 1]), Right1, Result);
+				Result = MultiplyAdd(_mm_set1_ps(Left[Row * 4 + 2]), Right2, Result);
+				Result = MultiplyAdd(_mm_set1_ps(Left[Row * 4 + 3]), Right3, Result);
+				_mm_storeu_ps(Output + Row * 4, Result);
+			}
+		}
+
+		// Quaternion of the rotation part of a row-vector matrix without scale.
+		void ExtractRotation(const float* Matrix, float* Rotation)
+		{
+			const float Trace = Matrix[0] + Matrix[5] + Matrix[10];
+
+			if (Trace > 0.0f)
+			{
+				const float Scale = 0.5f / std::sqrt(Trace + 1.0f);
+				Rotation[0] = (Matrix[6] - Matrix[9]) * Scale;
+				Rotation[1] = (Matrix[8] - Matrix[2]) * Scale;
+				Rotation[2] = (Matrix[1] - Matrix[4]) * Scale;
+				Rotation[3] = 0.25f / Scale;
+			}
+			else if (Matrix[0] > Matrix[5] && Matrix[0] > Matrix[10])
+			{
+				const float Scale = 2.0f * std::sqrt(1.0f + Matrix[0] - Matrix[5] - Matrix[10]);
+				Rotation[0] = 0.25f * Scale;
+				Rotation[1] = (Matrix[4] + Matrix[1]) / Scale;
+				Rotation[2] = (Matrix[8] + Matrix[2]) / Scale;
+				Rotation[3] = (Matrix[6] - Matrix[9]) / Scale;
+			}
+			else if (Matrix[5] > Matrix[10])
+			{
+				const float Scale = 2.0f * std::sqrt(1.0f + Matrix[5] - Matrix[0] - Matrix[10]);
+				Rotation[0] = (Matrix[4] + Matrix[1]) / Scale;
+				Rotation[1] = 0.25f * Scale;
+				Rotation[2] = (Matrix[9] + Matrix[6]) / Scale;
+				Rotation[3] = (Matrix[8] - Matrix[2]) / Scale;
+			}
+			else
+			{
+				const float Scale = 2.0f * std::sqrt(1.0f + Matrix[10] - Matrix[0] - Matrix[5]);
+				Rotation[0] = (Matrix[8] + Matrix[2]) / Scale;
+				Rotation[1] = (Matrix[9] + Matrix[6]) / Scale;
+				Rotation[2] = 0.25f * Scale;
+				Rotation[3] = (Matrix[1] - Matrix[4]) / Scale;
+			}
+		}
+
+		constexpr float RotationLimit = 0.70710678f;
+		constexpr size_t ClipPadding = 8;
+
+		void EncodeRotation(const float* Rotation, uint16_t* Word)
+		{
+			float Length = 0.0f;
+			size_t Largest = 0;
+			for (size_t Component = 0; Component < 4; Component++)
+			{
+				Length += Rotation[Component] * Rotation[Component];
+				Largest = std::fabs(Rotation[Component]) > std::fabs(Rotation[Largest]) ? Component : Largest;
+			}
+
+			const float Scale = (Rotation[Largest] < 0.0f ? -1.0f : 1.0f) / (Length > 0.0f ? std::sqrt(Length) : 1.0f);
+
+			size_t Current = 0;
+			for (size_t Component = 0; Component < 4; Component++)
+			{
+				if (Component != Largest)
+				{
+					const float Value = (Rotation[Component] * Scale / RotationLimit * 0.5f + 0.5f) * 32767.0f;
+					Word[Current++] = static_cast<uint16_t>((std::min)((std::max)(std::lround(Value), 0L), 32767L));
+				}
+			}
+
+			Word[0] |= static_cast<uint16_t>((Largest & 1) << 15);
+			Word[1] |= static_cast<uint16_t>((Largest >> 1) << 15);
+		}
+
+		uint16_t EncodeValue(float Value, float Minimum, float Range)
+		{
+			return Range > 0.0f ? static_cast<uint16_t>((std::min)((std::max)(std::lround((Value - Minimum) / Range), 0L), 65535L)) : 0;
+		}
+
+		// Channels are translation x, y, z, rotation x, y, z, w and scale x, y, z.
+		struct CLIP_SOURCE_STRUCT
+		{
+			const uint16_t* Frame;
+			const float* Minimum;
+			const float* Range;
+			size_t FrameSize;
+			size_t PaddedCount;
+			bool AnimatedTranslation;
+			bool AnimatedScale;
+		};
+
+#if defined(__AVX2__)
+		void DecodeGroup(const CLIP_SOURCE_STRUCT& Source, size_t Frame, size_t Base, __m256 (&Channel)[10])
+		{
+			const size_t Padded = Source.PaddedCount;
+			const uint16_t* const Word = Source.Frame + Frame * Source.FrameSize + Base;
+			const __m256i Low = _mm256_set1_epi32(0x7FFF);
+
+			const __m256i Word0 = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Word)));
+			const __m256i Word1 = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Word + Padded)));
+			const __m256i Word2 = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Word + Padded * 2)));
+			const __m256i Largest = _mm256_or_si256(_mm256_srli_epi32(Word0, 15), _mm256_slli_epi32(_mm256_srli_epi32(Word1, 15), 1));
+
+			const __m256 Scale = _mm256_set1_ps(2.0f * RotationLimit / 32767.0f);
+			const __m256 Offset = _mm256_set1_ps(-RotationLimit);
+			const __m256 Small0 = MultiplyAdd(_mm256_cvtepi32_ps(_mm256_and_si256(Word0, Low)), Scale, Offset);
+			const __m256 Small1 = MultiplyAdd(_mm256_cvtepi32_ps(_mm256_and_si256(Word1, Low)), Scale, Offset);
+			const __m256 Small2 = MultiplyAdd(_mm256_cvtepi32_ps(Word2), Scale, Offset);
+			const __m256 Square = MultiplyAdd(Small2, Small2, MultiplyAdd(Small1, Small1, _mm256_mul_ps(Small0, Small0)));
+			const __m256 Large = _mm256_sqrt_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), Square), _mm256_setzero_ps()));
+
+			const __m256 Is0 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(Largest, _mm256_set1_epi32(0)));
+			const __m256 Is1 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(Largest, _mm256_set1_epi32(1)));
+			const __m256 Is2 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(Largest, _mm256_set1_epi32(2)));
+			const __m256 Is3 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(Largest, _mm256_set1_epi32(3)));
+
+			Channel[3] = _mm256_blendv_ps(Small0, Large, Is0);
+			Channel[4] = _mm256_blendv_ps(_mm256_blendv_ps(Small1, Large, Is1), Small0, Is0);
+			Channel[5] = _mm256_blendv_ps(_mm256_blendv_ps(Small2, Large, Is2), Small1, _mm256_or_ps(Is0, Is1));
+			Channel[6] = _mm256_blendv_ps(Small2, Large, Is3);
+
+			const uint16_t* Track = Word + Padded * 3;
+			for (size_t Component = 0; Component < 3; Component++)
+			{
+				const __m256 Minimum = _mm256_loadu_ps(Source.Minimum + Component * Padded + Base);
+				Channel[Component] = Minimum;
+
+				if (Source.AnimatedTranslation)
+				{
+					const __m256i Value = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Track + Component * Padded)));
+					Channel[Component] = MultiplyAdd(_mm256_cvtepi32_ps(Value), _mm256_loadu_ps(Source.Range + Component * Padded + Base), Minimum);
+				}
+			}
+
+			Track += Source.AnimatedTranslation ? Padded * 3 : 0;
+			for (size_t Component = 0; Component < 3; Component++)
+			{
+				const __m256 Minimum = _mm256_loadu_ps(Source.Minimum + (Component + 3) * Padded + Base);
+				Channel[7 + Component] = Minimum;
+
+				if (Source.AnimatedScale)
+				{
+					const __m256i Value = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Track + Component * Padded)));
+					Channel[7 + Component] = MultiplyAdd(_mm256_cvtepi32_ps(Value), _mm256_loadu_ps(Source.Range + (Component + 3) * Padded + Base), Minimum);
+				}
+			}
+		}
+
+		void InterpolateGroup(__m256 (&From)[10], const __m256 (&To)[10], float Alpha)
+		{
+			const __m256 Weight = _mm256_set1_ps(Alpha);
+			const __m256 Dot = MultiplyAdd(From[6], To[6], MultiplyAdd(From[5], To[5], MultiplyAdd(From[4], To[4], _mm256_mul_ps(From[3], To[3]))));
+			const __m256 Sign = _mm256_and_ps(Dot, _mm256_set1_ps(-0.0f));
+
+			for (size_t Current = 0; Current < 10; Current++)
+			{
+				const __m256 Target = Current >= 3 && Current < 7 ? _mm256_xor_ps(To[Current], Sign) : To[Current];
+				From[Current] = MultiplyAdd(_mm256_sub_ps(Target, From[Current]), Weight, From[Current]);
+			}
+
+			const __m256 Length = _mm256_sqrt_ps(MultiplyAdd(From[6], From[6], MultiplyAdd(From[5], From[5], MultiplyAdd(From[4], From[4], _mm256_mul_ps(From[3], From[3])))));
+			for (size_t Current = 3; Current < 7; Current++)
+			{
+				From[Current] = _mm256_div_ps(From[Current], Length);
+			}
+		}
+
+		void LoadLanes(const float* Source, size_t Lanes, __m256& Value)
+		{
+			const __m256i Mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(Lanes)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+			Value = _mm256_maskload_ps(Source, Mask);
+		}
+
+		void StoreLanes(float* Destination, size_t Lanes, __m256 Value)
+		{
+			const __m256i Mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(Lanes)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+			_mm256_maskstore_ps(Destination, Mask, Value);
+		}
+
+		typedef __m256 ANIMATION_LANE;
+#else
+		void DecodeGroup(const CLIP_SOURCE_STRUCT& Source, size_t Frame, size_t Base, __m128 (&Channel)[10])
+		{
+			const size_t Padded = Source.PaddedCount;
+			const uint16_t* const Word = Source.Frame + Frame * Source.FrameSize + Base;
+			const __m128i Zero = _mm_setzero_si128();
+			const __m128i Low = _mm_set1_epi32(0x7FFF);
+
+			const __m128i Word0 = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(Word)), Zero);
+			const __m128i Word1 = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(Word + Padded)), Zero);
+			const __m128i Word2 = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(Word + Padded * 2)), Zero);
+			const __m128i Largest = _mm_or_si128(_mm_srli_epi32(Word0, 15), _mm_slli_epi32(_mm_srli_epi32(Word1, 15), 1));
+
+			const __m128 Scale = _mm_set1_ps(2.0f * RotationLimit / 32767.0f);
+			const __m128 Offset = _mm_set1_ps(-RotationLimit);
+			const __m128 Small0 = MultiplyAdd(_mm_cvtepi32_ps(_mm_and_si128(Word0, Low)), Scale, Offset);
+			const __m128 Small1 = MultiplyAdd(_mm_cvtepi32_ps(_mm_and_si128(Word1, Low)), Scale, Offset);
+			const __m128 Small2 = MultiplyAdd(_mm_cvtepi32_ps(Word2), Scale, Offset);
+			const __m128 Square = _mm_add_ps(_mm_add_ps(_mm_mul_ps(Small0, Small0), _mm_mul_ps(Small1, Small1)), _mm_mul_ps(Small2, Small2));
+			const __m128 Large = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), Square), _mm_setzero_ps()));
+
+			auto Select = [](__m128 Mask, __m128 A, __m128 B)
+			{
+				return _mm_or_ps(_mm_and_ps(Mask, A), _mm_andnot_ps(Mask, B));
+			};
+
+			const __m128 Is0 = _mm_castsi128_ps(_mm_cmpeq_epi32(Largest, _mm_set1_epi32(0)));
+			const __m128 Is1 = _mm_castsi128_ps(_mm_cmpeq_epi32(Largest, _mm_set1_epi32(1)));
+			const __m128 Is2 = _mm_castsi128_ps(_mm_cmpeq_epi32(Largest, _mm_set1_epi32(2)));
+			const __m128 Is3 = _mm_castsi128_ps(_mm_cmpeq_epi32(Largest, _mm_set1_epi32(3)));
+
+			Channel[3] = Select(Is0, Large, Small0);
+			Channel[4] = Select(Is0, Small0, Select(Is1, Large, Small1));
+			Channel[5] = Select(_mm_or_ps(Is0, Is1), Small1, Select(Is2, Large, Small2));
+			Channel[6] = Select(Is3, Large, Small2);
+
+			const uint16_t* Track = Word + Padded * 3;
+			for (size_t Component = 0; Component < 3; Component++)
+			{
+				const __m128 Minimum = _mm_loadu_ps(Source.Minimum + Component * Padded + Base);
+				Channel[Component] = Minimum;
+
+				if (Source.AnimatedTranslation)
+				{
+					const __m128i Value = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(Track + Component * Padded)), Zero);
+					Channel[Component] = MultiplyAdd(_mm_cvtepi32_ps(Value), _mm_loadu_ps(Source.Range + Component * Padded + Base), Minimum);
+				}
+			}
+
+			Track += Source.AnimatedTranslation ? Padded * 3 : 0;
+			for (size_t Component = 0; Component < 3; Component++)
+			{
+				const __m128 Minimum = _mm_loadu_ps(Source.Minimum + (Component + 3) * Padded + Base);
+				Channel[7 + Component] = Minimum;
+
+				if (Source.AnimatedScale)
+				{
+					const __m128i Value = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(Track + Component * Padded)), Zero);
+					Channel[7 + Component] = MultiplyAdd(_mm_cvtepi32_ps(Value), _mm_loadu_ps(Source.Range + (Component + 3) * Padded + Base), Minimum);
+				}
+			}
+		}
+
+		void InterpolateGroup(__m128 (&From)[10], const __m128 (&To)[10], float Alpha)
+		{
+			const __m128 Weight = _mm_set1_ps(Alpha);
+			const __m128 Dot = MultiplyAdd(From[6], To[6], MultiplyAdd(From[5], To[5], MultiplyAdd(From[4], To[4], _mm_mul_ps(From[3], To[3]))));
+			const __m128 Sign = _mm_and_ps(Dot, _mm_set1_ps(-0.0f));
+
+			for (size_t Current = 0; Current < 10; Current++)
+			{
+				const __m128 Target = Current >= 3 && Current < 7 ? _mm_xor_ps(To[Current], Sign) : To[Current];
+				From[Current] = MultiplyAdd(_mm_sub_ps(Target, From[Current]), Weight, From[Current]);
+			}
+
+			const __m128 Length = _mm_sqrt_ps(MultiplyAdd(From[6], From[6], MultiplyAdd(From[5], From[5], MultiplyAdd(From[4], From[4], _mm_mul_ps(From[3], From[3])))));
+			for (size_t Current = 3; Current < 7; Current++)
+			{
+				From[Current] = _mm_div_ps(From[Current], Length);
+			}
+		}
+
+		void LoadLanes(const float* Source, size_t Lanes, __m128& Value)
+		{
+			if (Lanes == 4)
+			{
+				Value = _mm_loadu_ps(Source);
+				return;
+			}
+
+			float Lane[4] = {};
+			memcpy(Lane, Source, Lanes * sizeof(float));
+			Value = _mm_loadu_ps(Lane);
+		}
+
+		void StoreLanes(float* Destination, size_t Lanes, __m128 Value)
+		{
+			if (Lanes == 4)
+			{
+				_mm_storeu_ps(Destination, Value);
+				return;
+			}
+
+			float Lane[4];
+			_mm_storeu_ps(Lane, Value);
+			memcpy(Destination, Lane, Lanes * sizeof(float));
+		}
+
+		typedef __m128 ANIMATION_LANE;
+#endif
+
+		template<class Function>
+		void SkinParallel(size_t Count, ThreadPool* Pool, const Function& Block)
+		{
+			if (!Pool || Count <= SkinGrain)
+			{
+				Block(0, Count);
+				return;
+			}
+
+			Pool->ParallelFor(Count, SkinGrain, Block);
+		}
+
+		void SkinLinearBlock(const SKIN_STREAM_STRUCT& Stream, const float* SkinMatrix, size_t First, size_t Last)
+		{
+			const bool Normal = Stream.NormalOffset != SIZE_MAX;
+
+			for (size_t Index = First; Index < Last; Index++)
+			{
+				const uint8_t* const Source = static_cast<const uint8_t*>(Stream.Vertex) + Index * Stream.Stride;
+				uint8_t* const Destination = static_cast<uint8_t*>(Stream.Output) + Index * Stream.Stride;
+				const SKIN_WEIGHT_STRUCT& Weight = Stream.Weight[Index];
+
+				memcpy(Destination, Source, Stream.Stride);
+
+				float Position[3];
+				memcpy(Position, Source, sizeof(Position));
+
+#if defined(__AVX2__)
+				const float* const Matrix0 = SkinMatrix + Weight.Joint[0] * 16;
+				__m256 Row01 = _mm256_mul_ps(_mm256_set1_ps(Weight.Weight[0]), _mm256_loadu_ps(Matrix0));
+				__m256 Row23 = _mm256_mul_ps(_mm256_set1_ps(Weight.Weight[0]), _mm256_loadu_ps(Matrix0 + 8));
+
+				for (size_t Influence = 1; Influence < 4; Influence++)
+				{
+					const float* const Matrix = SkinMatrix + Weight.Joint[Influence] * 16;
+					const __m256 Scale = _mm256_set1_ps(Weight.Weight[Influence]);
+					Row01 = MultiplyAdd(Scale, _mm256_loadu_ps(Matrix), Row01);
+					Row23 = MultiplyAdd(Scale, _mm256_loadu_ps(Matrix + 8), Row23);
+				}
+
+				const __m256 PositionXY = _mm256_setr_m128(_mm_set1_ps(Position[0]), _mm_set1_ps(Position[1]));
+				const __m256 PositionZW = _mm256_setr_m128(_mm_set1_ps(Position[2]), _mm_set1_ps(1.0f));
+				const __m256 Result = MultiplyAdd(PositionXY, Row01, _mm256_mul_ps(PositionZW, Row23));
+				StoreVector3(Destination, _mm_add_ps(_mm256_castps256_ps128(Result), _mm256_extractf128_ps(Result, 1)));
+
+				if (Normal)
+				{
+					float Direction[3];
+					memcpy(Direction, Source + Stream.NormalOffset, sizeof(Direction));
+
+					const __m256 DirectionXY = _mm256_setr_m128(_mm_set1_ps(Direction[0]), _mm_set1_ps(Direction[1]));
+					const __m256 DirectionZ = _mm256_setr_m128(_mm_set1_ps(Direction[2]), _mm_setzero_ps());
+					const __m256 Transformed = MultiplyAdd(DirectionXY, Row01, _mm256_mul_ps(DirectionZ, Row23));
+					StoreVector3(Destination + Stream.NormalOffset, Normalize3(_mm_add_ps(_mm256_castps256_ps128(Transformed), _mm256_extractf128_ps(Transformed, 1))));
+				}
+#else
+				__m128 Row[4];
+				for (size_t Current = 0; Current < 4; Current++)
+				{
+					Row[Current] = _mm_mul_ps(_mm_set1_ps(Weight.Weight[0]), _mm_loadu_ps(SkinMatrix + Weight.Joint[0] * 16 + Current * 4));
+				}
+
+				for (size_t Influence = 1; Influence < 4; Influence++)
+				{
+					const float* const Matrix = SkinMatrix + Weight.Joint[Influence] * 16;
+					const __m128 Scale = _mm_set1_ps(Weight.Weight[Influence]);
+					for (size_t Current = 0; Current < 4; Current++)
+					{
+						Row[Current] = MultiplyAdd(Scale, _mm_loadu_ps(Matrix + Current * 4), Row[Current]);
+					}
+				}
+
+				__m128 Result = MultiplyAdd(_mm_set1_ps(Position[0]), Row[0], Row[3]);
+				Result = MultiplyAdd(_mm_set1_ps(Position[1]), Row[1], Result);
+				Result = MultiplyAdd(_mm_set1_ps(Position[2]), Row[2], Result);
+				StoreVector3(Destination, Result);
+
+				if (Normal)
+				{
+					float Direction[3];
+					memcpy(Direction, Source + Stream.NormalOffset, sizeof(Direction));
+
+					__m128 Transformed = _mm_mul_ps(_mm_set1_ps(Direction[0]), Row[0]);
+					Transformed = MultiplyAdd(_mm_set1_ps(Direction[1]), Row[1], Transformed);
+					Transformed = MultiplyAdd(_mm_set1_ps(Direction[2]), Row[2], Transformed);
+					StoreVector3(Destination + Stream.NormalOffset, Normalize3(Transformed));
+				}
+#endif
+			}
+		}
+
+		void SkinDualQuaternionBlock(const SKIN_STREAM_STRUCT& Stream, const float* DualQuaternion, size_t First, size_t Last)
+		{
+			const bool Normal = Stream.NormalOffset != SIZE_MAX;
+			const __m128 Two = _mm_set1_ps(2.0f);
+
+			for (size_t Index = First; Index < Last; Index++)
+			{
+				const uint8_t* const Source = static_cast<const uint8_t*>(Stream.Vertex) + Index * Stream.Stride;
+				uint8_t* const Destination = static_cast<uint8_t*>(Stream.Output) + Index * Stream.Stride;
+				const SKIN_WEIGHT_STRUCT& Weight = Stream.Weight[Index];
+
+				memcpy(Destination, Source, Stream.Stride);
+
+				// Influences on the far hemisphere of the first are negated so the blend takes the short path.
+				const float* const Pivot = DualQuaternion + Weight.Joint[0] * 8;
+				__m128 Real;
+				__m128 Dual;
+
+#if defined(__AVX2__)
+				__m256 Blend = _mm256_mul_ps(_mm256_set1_ps(Weight.Weight[0]), _mm256_loadu_ps(Pivot));
+				for (size_t Influence = 1; Influence < 4; Influence++)
+				{
+					const float* const Current = DualQuaternion + Weight.Joint[Influence] * 8;
+					const float Sign = Pivot[0] * Current[0] + Pivot[1] * Current[1] + Pivot[2] * Current[2] + Pivot[3] * Current[3] < 0.0f ? -1.0f : 1.0f;
+					Blend = MultiplyAdd(_mm256_set1_ps(Weight.Weight[Influence] * Sign), _mm256_loadu_ps(Current), Blend);
+				}
+				Real = _mm256_castps256_ps128(Blend);
+				Dual = _mm256_extractf128_ps(Blend, 1);
+#else
+				Real = _mm_mul_ps(_mm_set1_ps(Weight.Weight[0]), _mm_loadu_ps(Pivot));
+				Dual = _mm_mul_ps(_mm_set1_ps(Weight.Weight[0]), _mm_loadu_ps(Pivot + 4));
+				for (size_t Influence = 1; Influence < 4; Influence++)
+				{
+					const float* const Current = DualQuaternion + Weight.Joint[Influence] * 8;
+					const float Sign = Pivot[0] * Current[0] + Pivot[1] * Current[1] + Pivot[2] * Current[2] + Pivot[3] * Current[3] < 0.0f ? -1.0f : 1.0f;
+					const __m128 Scale = _mm_set1_ps(Weight.Weight[Influence] * Sign);
+					Real = MultiplyAdd(Scale, _mm_loadu_ps(Current), Real);
+					Dual = MultiplyAdd(Scale, _mm_loadu_ps(Current + 4), Dual);
+				}
+#endif
+
+				const __m128 Square = _mm_mul_ps(Real, Real);
+				const __m128 Pair = _mm_add_ps(Square, _mm_shuffle_ps(Square, Square, _MM_SHUFFLE(2, 3, 0, 1)));
+				const __m128 Length = _mm_sqrt_ps(_mm_add_ps(Pair, _mm_shuffle_ps(Pair, Pair, _MM_SHUFFLE(1, 0, 3, 2))));
+				Real = _mm_div_ps(Real, Length);
+				Dual = _mm_div_ps(Dual, Length);
+
+				const __m128 RealW = _mm_shuffle_ps(Real, Real, 0xFF);
+				const __m128 DualW = _mm_shuffle_ps(Dual, Dual, 0xFF);
+				const __m128 Translation = _mm_mul_ps(Two, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(RealW, Dual), _mm_mul_ps(DualW, Real)), Cross(Real, Dual)));
+
+				const __m128 Position = LoadVector3(Source);
+				const __m128 Rotated = _mm_add_ps(Position, _mm_mul_ps(Two, Cross(Real, MultiplyAdd(RealW, Position, Cross(Real, Position)))));
+				StoreVector3(Destination, _mm_add_ps(Rotated, Translation));
+
+				if (Normal)
+				{
+					const __m128 Direction = LoadVector3(Source + Stream.NormalOffset);
+					StoreVector3(Destination + Stream.NormalOffset, _mm_add_ps(Direction, _mm_mul_ps(Two, Cross(Real, MultiplyAdd(RealW, Direction, Cross(Real, Direction))))));
+				}
+			}
+		}
+	}
+
+
+
+	uint32_t Skeleton::AddJoint(uint32_t Parent, const float* InverseBind)
+	{
+		const uint32_t Joint = static_cast<uint32_t>(this->Parent.size());
+		this->Parent.push_back(Parent < Joint ? Parent : Invalid);
+		this->InverseBind.insert(this->InverseBind.end(), InverseBind, InverseBind + 16);
+		return Joint;
+	}
+
+	uint32_t Skeleton::GetParent(uint32_t Joint) const
+	{
+		return this->Parent[Joint];
+	}
+
+	const float* Skeleton::GetInverseBind(uint32_t Joint) const
+	{
+		return this->InverseBind.data() + Joint * 16;
+	}
+
+	size_t Skeleton::GetJointCount() const
+	{
+		return this->Parent.size();
+	}
+
+
+
+	SkeletonPose::SkeletonPose(size_t JointCount)
+	{
+		this->Resize(JointCount);
+	}
+
+	void SkeletonPose::Resize(size_t JointCount)
+	{
+		this->TranslationX.resize(JointCount, 0.0f);
+		this->TranslationY.resize(JointCount, 0.0f);
+		this->TranslationZ.resize(JointCount, 0.0f);
+		this->RotationX.resize(JointCount, 0.0f);
+		this->RotationY.resize(JointCount, 0.0f);
+		this->RotationZ.resize(JointCount, 0.0f);
+		this->RotationW.resize(JointCount, 1.0f);
+		this->ScaleX.resize(JointCount, 1.0f);
+		this->ScaleY.resize(JointCount, 1.0f);
+		this->ScaleZ.resize(JointCount, 1.0f);
+		this->Model.resize(JointCount * 16, 0.0f);
+		this->SkinMatrix.resize(JointCount * 16, 0.0f);
+		this->SkinDualQuaternion.resize(JointCount * 8, 0.0f);
+	}
+
+	void SkeletonPose::SetLocal(uint32_t Joint, const JOINT_TRANSFORM_STRUCT& Local)
+	{
+		this->TranslationX[Joint] = Local.Translation[0];
+		this->TranslationY[Joint] = Local.Translation[1];
+		this->TranslationZ[Joint] = Local.Translation[2];
+		this->RotationX[Joint] = Local.Rotation[0];
+		this->RotationY[Joint] = Local.Rotation[1];
+		this->RotationZ[Joint] = Local.Rotation[2];
+		this->RotationW[Joint] = Local.Rotation[3];
+		this->ScaleX[Joint] = Local.Scale[0];
+		this->ScaleY[Joint] = Local.Scale[1];
+		this->ScaleZ[Joint] = Local.Scale[2];
+	}
+
+	JOINT_TRANSFORM_STRUCT SkeletonPose::GetLocal(uint32_t Joint) const
+	{
+		return {
+			{ this->TranslationX[Joint], this->TranslationY[Joint], this->TranslationZ[Joint] },
+			{ this->RotationX[Joint], this->RotationY[Joint], this->RotationZ[Joint], this->RotationW[Joint] },
+			{ this->ScaleX[Joint], this->ScaleY[Joint], this->ScaleZ[Joint] },
+		};
+	}
+
+	void SkeletonPose::Blend(const SkeletonPose& Other, float Weight)
+	{
+		std::vector<float>* const Target[10] = {
+			&this->TranslationX, &this->TranslationY, &this->TranslationZ,
+			&this->RotationX, &this->RotationY, &this->RotationZ, &this->RotationW,
+			&this->ScaleX, &this->ScaleY, &this->ScaleZ,
+		};
+		const std::vector<float>* const Source[10] = {
+			&Other.TranslationX, &Other.TranslationY, &Other.TranslationZ,
+			&Other.RotationX, &Other.RotationY, &Other.RotationZ, &Other.RotationW,
+			&Other.ScaleX, &Other.ScaleY, &Other.ScaleZ,
+		};
+
+		constexpr size_t LaneCount = sizeof(ANIMATION_LANE) / sizeof(float);
+		const size_t Count = (std::min)(this->GetJointCount(), Other.GetJointCount());
+
+		for (size_t Base = 0; Base < Count; Base += LaneCount)
+		{
+			const size_t Lanes = (std::min)(LaneCount, Count - Base);
+
+			ANIMATION_LANE From[10];
+			ANIMATION_LANE To[10];
+			for (size_t Channel = 0; Channel < 10; Channel++)
+			{
+				LoadLanes(Target[Channel]->data() + Base, Lanes, From[Channel]);
+				LoadLanes(Source[Channel]->data() + Base, Lanes, To[Channel]);
+			}
+
+			InterpolateGroup(From, To, Weight);
+
+			for (size_t Channel = 0; Channel < 10; Channel++)
+			{
+				StoreLanes(Target[Channel]->data() + Base, Lanes, From[Channel]);
+			}
+		}
+	}
+
+	void SkeletonPose::Update(const Skeleton& Skeleton)
+	{
+		const size_t JointCount = (std::min)(Skeleton.GetJointCount(), this->TranslationX.size());
+
+		for (size_t Joint = 0; Joint < JointCount; Joint++)
+		{
+			const float X = this->RotationX[Joint];
+			const float Y = this->RotationY[Joint];
+			const float Z = this->RotationZ[Joint];
+			const float W = this->RotationW[Joint];
+			const float ScaleX = this->ScaleX[Joint];
+			const float ScaleY = this->ScaleY[Joint];
+			const float ScaleZ = this->ScaleZ[Joint];
+
+			const float Local[16] = {
+				(1.0f - 2.0f * (Y * Y + Z * Z)) * ScaleX, 2.0f * (X * Y + Z * W) * ScaleX, 2.0f * (X * Z - Y * W) * ScaleX, 0.0f,
+				2.0f * (X * Y - Z * W) * ScaleY, (1.0f - 2.0f * (X * X + Z * Z)) * ScaleY, 2.0f * (Y * Z + X * W) * ScaleY, 0.0f,
+				2.0f * (X * Z + Y * W) * ScaleZ, 2.0f * (Y * Z - X * W) * ScaleZ, (1.0f - 2.0f * (X * X + Y * Y)) * ScaleZ, 0.0f,
+				this->TranslationX[Joint], this->TranslationY[Joint], this->TranslationZ[Joint], 1.0f,
+			};
+
+			float* const Model = this->Model.data() + Joint * 16;
+			const uint32_t Parent = Skeleton.GetParent(static_cast<uint32_t>(Joint));
+
+			if (Parent == Skeleton::Invalid)
+			{
+				memcpy(Model, Local, sizeof(Local));
+			}
+			else
+			{
+				MultiplyMatrix(Local, this->Model.data() + Parent * 16, Model);
+			}
+
+			float* const Skin = this->SkinMatrix.data() + Joint * 16;
+			MultiplyMatrix(Skeleton.GetInverseBind(static_cast<uint32_t>(Joint)), Model, Skin);
+
+			float* const DualQuaternion = this->SkinDualQuaternion.data() + Joint * 8;
+			ExtractRotation(Skin, DualQuaternion);
+
+			const float* const Rotation = DualQuaternion;
+			const float* const Translation = Skin + 12;
+			DualQuaternion[4] = 0.5f * (Translation[0] * Rotation[3] + Translation[1] * Rotation[2] - Translation[2] * Rotation[1]);
+			DualQuaternion[5] = 0.5f * (-Translation[0] * Rotation[2] + Translation[1] * Rotation[3] + Translation[2] * Rotation[0]);
+			DualQuaternion[6] = 0.5f * (Translation[0] * Rotation[1] - Translation[1] * Rotation[0] + Translation[2] * Rotation[3]);
+			DualQuaternion[7] = -0.5f * (Translation[0] * Rotation[0] + Translation[1] * Rotation[1] + Translation[2] * Rotation[2]);
+		}
+	}
+
+	const float* SkeletonPose::GetModel(uint32_t Joint) const
+	{
+		return this->Model.data() + Joint * 16;
+	}
+
+	const float* SkeletonPose::GetSkinMatrix() const
+	{
+		return this->SkinMatrix.data();
+	}
+
+	const float* SkeletonPose::GetSkinDualQuaternion() const
+	{
+		return this->SkinDualQuaternion.data();
+	}
+
+	size_t SkeletonPose::GetJointCount() const
+	{
+		return this->TranslationX.size();
+	}
+
+
+
+	void AnimationClip::Build(const JOINT_TRANSFORM_STRUCT* Sample, size_t JointCount, size_t FrameCount, float SampleRate)
+	{
+		this->JointCount = FrameCount ? JointCount : 0;
+		this->PaddedCount = (this->JointCount + ClipPadding - 1) / ClipPadding * ClipPadding;
+		this->FrameCount = this->JointCount ? FrameCount : 0;
+		this->SampleRate = SampleRate;
+
+		const size_t Padded = this->PaddedCount;
+		this->Minimum.assign(Padded * 6, 0.0f);
+		this->Range.assign(Padded * 6, 0.0f);
+
+		this->AnimatedTranslation = false;
+		this->AnimatedScale = false;
+
+		for (size_t Joint = 0; Joint < this->JointCount; Joint++)
+		{
+			for (size_t Component = 0; Component < 6; Component++)
+			{
+				float Low = FLT_MAX;
+				float High = -FLT_MAX;
+
+				for (size_t Frame = 0; Frame < this->FrameCount; Frame++)
+				{
+					const JOINT_TRANSFORM_STRUCT& Current = Sample[Frame * JointCount + Joint];
+					const float Value = Component < 3 ? Current.Translation[Component] : Current.Scale[Component - 3];
+					Low = (std::min)(Low, Value);
+					High = (std::max)(High, Value);
+				}
+
+				this->Minimum[Component * Padded + Joint] = Low;
+				this->Range[Component * Padded + Joint] = (High - Low) / 65535.0f;
+
+				if (High > Low)
+				{
+					(Component < 3 ? this->AnimatedTranslation : this->AnimatedScale) = true;
+				}
+			}
+		}
+
+		this->FrameSize = Padded * (3 + (this->AnimatedTranslation ? 3 : 0) + (this->AnimatedScale ? 3 : 0));
+		this->Frame.assign(this->FrameSize * this->FrameCount, 0);
+
+		for (size_t Frame = 0; Frame < this->FrameCount; Frame++)
+		{
+			uint16_t* const Word = this->Frame.data() + Frame * this->FrameSize;
+
+			for (size_t Joint = 0; Joint < Padded; Joint++)
+			{
+				const float Identity[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+				const float* const Rotation = Joint < this->JointCount ? Sample[Frame * JointCount + Joint].Rotation : Identity;
+
+				uint16_t Encoded[3];
+				EncodeRotation(Rotation, Encoded);
+				Word[Joint] = Encoded[0];
+				Word[Padded + Joint] = Encoded[1];
+				Word[Padded * 2 + Joint] = Encoded[2];
+			}
+
+			uint16_t* Track = Word + Padded * 3;
+			for (size_t Component = 0; Component < 6; Component++)
+			{
+				if (!(Component < 3 ? this->AnimatedTranslation : this->AnimatedScale))
+				{
+					continue;
+				}
+
+				for (size_t Joint = 0; Joint < this->JointCount; Joint++)
+				{
+					const JOINT_TRANSFORM_STRUCT& Current = Sample[Frame * JointCount + Joint];
+					const float Value = Component < 3 ? Current.Translation[Component] : Current.Scale[Component - 3];
+					Track[Joint] = EncodeValue(Value, this->Minimum[Component * Padded + Joint], this->Range[Component * Padded + Joint]);
+				}
+				Track += Padded;
+			}
+		}
+	}
+
+	void AnimationClip::Sample(float Time, SkeletonPose& Pose, bool Loop) const
+	{
+		if (!this->FrameCount)
+		{
+			return;
+		}
+
+		const float Duration = this->GetDuration();
+		if (Loop && Duration > 0.0f)
+		{
+			Time = std::fmod(Time, Duration);
+			Time += Time < 0.0f ? Duration : 0.0f;
+		}
+
+		const float Position = (std::min)((std::max)(Time * this->SampleRate, 0.0f), static_cast<float>(this->FrameCount - 1));
+		const size_t Frame0 = static_cast<size_t>(Position);
+		const size_t Frame1 = (std::min)(Frame0 + 1, this->FrameCount - 1);
+		const float Alpha = Position - static_cast<float>(Frame0);
+
+		const CLIP_SOURCE_STRUCT Source = {
+			this->Frame.data(), this->Minimum.data(), this->Range.data(),
+			this->FrameSize, this->PaddedCount, this->AnimatedTranslation, this->AnimatedScale,
+		};
+
+		float* const Target[10] = {
+			Pose.TranslationX.data(), Pose.TranslationY.data(), Pose.TranslationZ.data(),
+			Pose.RotationX.data(), Pose.RotationY.data(), Pose.RotationZ.data(), Pose.RotationW.data(),
+			Pose.ScaleX.data(), Pose.ScaleY.data(), Pose.ScaleZ.data(),
+		};
+
+		constexpr size_t LaneCount = sizeof(ANIMATION_LANE) / sizeof(float);
+		const size_t Count = (std::min)(this->JointCount, Pose.GetJointCount());
+
+		for (size_t Base = 0; Base < Count; Base += LaneCount)
+		{
+			ANIMATION_LANE From[10];
+			ANIMATION_LANE To[10];
+			DecodeGroup(Source, Frame0, Base, From);
+			DecodeGroup(Source, Frame1, Base, To);
+			InterpolateGroup(From, To, Alpha);
+
+			const size_t Lanes = (std::min)(LaneCount, Count - Base);
+			for (size_t Channel = 0; Channel < 10; Channel++)
+			{
+				StoreLanes(Target[Channel] + Base, Lanes, From[Channel]);
+			}
+		}
+	}
+
+	float AnimationClip::GetDuration() const
+	{
+		return this->FrameCount > 1 && this->SampleRate > 0.0f ? (this->FrameCount - 1) / this->SampleRate : 0.0f;
+	}
+
+	size_t AnimationClip::GetJointCount() const
+	{
+		return this->JointCount;
+	}
+
+	size_t AnimationClip::GetFrameCount() const
+	{
+		return this->FrameCount;
+	}
+
+	size_t AnimationClip::GetMemorySize() const
+	{
+		return sizeof(*this) + this->Frame.size() * sizeof(uint16_t) + (this->Minimum.size() + this->Range.size()) * sizeof(float);
+	}
+
+
+
+	void SkinLinear(const SKIN_STREAM_STRUCT& Stream, const float* SkinMatrix, ThreadPool* Pool)
+	{
+		SkinParallel(Stream.Count, Pool, [&](size_t First, size_t Last)
+		{
+			SkinLinearBlock(Stream, SkinMatrix, First, Last);
+		});
+	}
+
+	void SkinDualQuaternion(const SKIN_STREAM_STRUCT& Stream, const float* DualQuaternion, ThreadPool* Pool)
+	{
+		SkinParallel(Stream.Count, Pool, [&](size_t First, size_t Last)
+		{
+			SkinDualQuaternionBlock(Stream, DualQuaternion, First, Last);
+		});
+	}
+}
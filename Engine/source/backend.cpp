@@ -0,0 +1,539 @@
+﻿#include "source/backend.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace Engine
+{
+	namespace
+	{
+		const uint64_t StartTimestamp = GetTimestamp();
+	}
+
+
+
+	double GetTimer()
+	{
+		return (GetTimestamp() - StartTimestamp) * 1e-9;
+	}
+
+
+
+	void Backend::Submit(uint64_t Key, const DRAW_COMMAND_STRUCT& Command)
+	{
+		const SIZE_T Offset = this->ConstantData.size();
+
+		if (Command.ConstantData && Command.ConstantDataSize)
+		{
+			this->ConstantData.resize(Offset + Command.ConstantDataSize);
+			memcpy(this->ConstantData.data() + Offset, Command.ConstantData, Command.ConstantDataSize);
+		}
+
+		this->Queue.Submit(Key, static_cast<uint32_t>(this->Command.size()));
+		this->Command.push_back(Command);
+		this->ConstantOffset.push_back(Offset);
+	}
+
+	void Backend::Flush()
+	{
+		this->Queue.Sort();
+
+		DRAW_COMMAND_STRUCT Last = {};
+
+		const RENDER_PACKET_STRUCT* Packet = this->Queue.GetPacket();
+		for (size_t Index = 0; Index < this->Queue.GetCount(); Index++)
+		{
+			const uint32_t CommandIndex = Packet[Index].Command;
+			const DRAW_COMMAND_STRUCT& Current = this->Command[CommandIndex];
+
+			if (Current.VertexShader && Current.VertexShader != Last.VertexShader)
+			{
+				Current.VertexShader->Set();
+			}
+
+			if (Current.PixelShader && Current.PixelShader != Last.PixelShader)
+			{
+				Current.PixelShader->Set();
+			}
+
+			if (Current.ConstantBuffer)
+			{
+				if (Current.ConstantData && Current.ConstantDataSize)
+				{
+					Current.ConstantBuffer->Update(this->ConstantData.data() + this->ConstantOffset[CommandIndex]);
+				}
+
+				if (Current.ConstantBuffer != Last.ConstantBuffer)
+				{
+					Current.ConstantBuffer->SetVertexShader();
+				}
+			}
+			else if (Current.ConstantData && Current.ConstantDataSize && this->ObjectConstant)
+			{
+				const CONSTANT_SLICE_STRUCT Slice = this->ObjectConstant->Allocate(this->ConstantData.data() + this->ConstantOffset[CommandIndex], Current.ConstantDataSize);
+				this->ObjectConstant->SetVertexShader(CONSTANT_SLOT_OBJECT, Slice);
+			}
+
+			if (Current.Texture && Current.Texture != Last.Texture)
+			{
+				Current.Texture->Set();
+			}
+
+			if (Current.VertexBuffer && Current.VertexBuffer != Last.VertexBuffer)
+			{
+				Current.VertexBuffer->Set();
+			}
+
+			if (Current.IndexBuffer && Current.IndexBuffer != Last.IndexBuffer)
+			{
+				Current.IndexBuffer->Set();
+			}
+
+			if (Current.InstanceBuffer)
+			{
+				if (Current.InstanceBuffer != Last.InstanceBuffer)
+				{
+					Current.InstanceBuffer->Set();
+				}
+
+				this->DrawInstanced(Current.IndexCount, Current.InstanceCount, Current.StartIndex, Current.BaseVertex);
+			}
+			else
+			{
+				this->Draw(Current.IndexCount, Current.StartIndex, Current.BaseVertex);
+			}
+
+			Last = Current;
+		}
+
+		this->Queue.Clear();
+		this->Command.clear();
+		this->ConstantOffset.clear();
+		this->ConstantData.clear();
+	}
+
+	APPLICATION_STATISTICS_STRUCT Backend::GetFrameStatistics()
+	{
+		APPLICATION_STATISTICS_STRUCT Statistics = {};
+		std::vector<float> Sample;
+
+		{
+			std::lock_guard<std::mutex> Lock(this->StatisticsMutex);
+			Statistics.FrameCount = this->FrameCount;
+			Statistics.Frame = this->LastFrame;
+			Sample = this->FrameTime;
+
+			if (!Sample.empty())
+			{
+				Statistics.FrameTime = Sample[(this->FrameCount - 1) % FrameWindow];
+			}
+		}
+
+		Statistics.Total = this->Counter->Read();
+		Statistics.ResourceCount = Statistics.Total.CreateCount - Statistics.Total.DestroyCount;
+		Statistics.SampleCount = static_cast<UINT>(Sample.size());
+
+		if (!Sample.empty())
+		{
+			auto Percentile = [&Sample](double Fraction)
+			{
+				const size_t Index = (std::min)(static_cast<size_t>(Fraction * Sample.size()), Sample.size() - 1);
+				std::nth_element(Sample.begin(), Sample.begin() + Index, Sample.end());
+				return static_cast<double>(Sample[Index]);
+			};
+
+			Statistics.FrameTimeP50 = Percentile(0.50);
+			Statistics.FrameTimeP95 = Percentile(0.95);
+			Statistics.FrameTimeP99 = Percentile(0.99);
+			Statistics.FrameTimeMax = *std::max_element(Sample.begin(), Sample.end());
+		}
+
+		return Statistics;
+	}
+
+	void Backend::SetStatisticsFile(const char* FileName, float Interval)
+	{
+		std::lock_guard<std::mutex> Lock(this->StatisticsMutex);
+		this->StatisticsFile = FileName ? FileName : "";
+		this->StatisticsInterval = static_cast<uint64_t>((std::max)(Interval, 0.0f) * 1e9);
+		this->NextSave = 0;
+	}
+
+	InputQueue& Backend::GetInputQueue()
+	{
+		return this->InputEvent;
+	}
+
+	void Backend::EndFrame()
+	{
+		const uint64_t Timestamp = GetTimestamp();
+		const APPLICATION_COUNTER_STRUCT Total = this->Counter->Read();
+
+		bool Save = false;
+
+		{
+			std::lock_guard<std::mutex> Lock(this->StatisticsMutex);
+
+			if (this->FrameTimestamp)
+			{
+				const float Time = static_cast<float>((Timestamp - this->FrameTimestamp) * 1e-9);
+				if (this->FrameTime.size() < FrameWindow)
+				{
+					this->FrameTime.push_back(Time);
+				}
+				else
+				{
+					this->FrameTime[this->FrameCount % FrameWindow] = Time;
+				}
+				this->FrameCount++;
+			}
+			this->FrameTimestamp = Timestamp;
+
+			this->LastFrame = {
+				Total.DrawCount - this->FrameStart.DrawCount,
+				Total.IndexCount - this->FrameStart.IndexCount,
+				Total.InstanceCount - this->FrameStart.InstanceCount,
+				Total.BindCount - this->FrameStart.BindCount,
+				Total.ConstantBytes - this->FrameStart.ConstantBytes,
+				Total.CreateCount - this->FrameStart.CreateCount,
+				Total.DestroyCount - this->FrameStart.DestroyCount,
+				Total.CreateTime - this->FrameStart.CreateTime,
+			};
+			this->FrameStart = Total;
+
+			if (!this->StatisticsFile.empty() && Timestamp >= this->NextSave)
+			{
+				this->NextSave = Timestamp + this->StatisticsInterval;
+				Save = true;
+			}
+		}
+
+		if (Save)
+		{
+			this->SaveStatistics(this->GetFrameStatistics());
+		}
+	}
+
+	void Backend::SaveStatistics(const APPLICATION_STATISTICS_STRUCT& Statistics)
+	{
+		std::string FileName;
+		{
+			std::lock_guard<std::mutex> Lock(this->StatisticsMutex);
+			FileName = this->StatisticsFile;
+		}
+
+		const std::string Temporary = FileName + ".tmp";
+		FILE* File = fopen(Temporary.c_str(), "w");
+		if (!File)
+		{
+			return;
+		}
+
+		const struct
+		{
+			const char* Name;
+			const char* Type;
+			double Value;
+		} Metric[] = {
+			{ "engine_frames_total", "counter", static_cast<double>(Statistics.FrameCount) },
+			{ "engine_draw_calls_total", "counter", static_cast<double>(Statistics.Total.DrawCount) },
+			{ "engine_indices_total", "counter", static_cast<double>(Statistics.Total.IndexCount) },
+			{ "engine_instances_total", "counter", static_cast<double>(Statistics.Total.InstanceCount) },
+			{ "engine_binds_total", "counter", static_cast<double>(Statistics.Total.BindCount) },
+			{ "engine_constant_bytes_total", "counter", static_cast<double>(Statistics.Total.ConstantBytes) },
+			{ "engine_resources_created_total", "counter", static_cast<double>(Statistics.Total.CreateCount) },
+			{ "engine_resources_destroyed_total", "counter", static_cast<double>(Statistics.Total.DestroyCount) },
+			{ "engine_resource_create_seconds_total", "counter", Statistics.Total.CreateTime * 1e-9 },
+			{ "engine_resources", "gauge", static_cast<double>(Statistics.ResourceCount) },
+			{ "engine_frame_draw_calls", "gauge", static_cast<double>(Statistics.Frame.DrawCount) },
+			{ "engine_frame_indices", "gauge", static_cast<double>(Statistics.Frame.IndexCount) },
+			{ "engine_frame_binds", "gauge", static_cast<double>(Statistics.Frame.BindCount) },
+			{ "engine_frame_constant_bytes", "gauge", static_cast<double>(Statistics.Frame.ConstantBytes) },
+		};
+
+		for (const auto& Current : Metric)
+		{
+			fprintf(File, "# TYPE %s %s\n%s %.17g\n", Current.Name, Current.Type, Current.Name, Current.Value);
+		}
+
+		fprintf(File, "# TYPE engine_frame_time_seconds summary\n");
+		fprintf(File, "engine_frame_time_seconds{quantile=\"0.5\"} %.9f\n", Statistics.FrameTimeP50);
+		fprintf(File, "engine_frame_time_seconds{quantile=\"0.95\"} %.9f\n", Statistics.FrameTimeP95);
+		fprintf(File, "engine_frame_time_seconds{quantile=\"0.99\"} %.9f\n", Statistics.FrameTimeP99);
+		fprintf(File, "engine_frame_time_seconds{quantile=\"1\"} %.9f\n", Statistics.FrameTimeMax);
+		fprintf(File, "engine_frame_time_seconds_count %u\n", Statistics.SampleCount);
+
+		if (fclose(File) != 0)
+		{
+			remove(Temporary.c_str());
+			return;
+		}
+
+		if (rename(Temporary.c_str(), FileName.c_str()) != 0)
+		{
+			remove(FileName.c_str());
+			rename(Temporary.c_str(), FileName.c_str());
+		}
+	}
+
+	std::shared_ptr<IApplication> IApplication::Create(LPCTSTR Title, INT X, INT Y, UINT Width, UINT Height, DWORD Style)
+	{
+#ifdef _WIN32
+		return IApplication::Create(APPLICATION_BACKEND_DIRECT3D11, Title, X, Y, Width, Height, Style);
+#else
+		return IApplication::Create(APPLICATION_BACKEND_NULL, Title, X, Y, Width, Height, Style);
+#endif
+	}
+
+	std::shared_ptr<IApplication> IApplication::Create(APPLICATION_BACKEND Backend, LPCTSTR Title, INT X, INT Y, UINT Width, UINT Height, DWORD Style)
+	{
+		std::shared_ptr<Engine::Backend> App;
+
+		switch (Backend)
+		{
+			case APPLICATION_BACKEND_DIRECT3D11:
+			{
+#ifdef _WIN32
+				App = CreateDirect3D11Application(Title, X, Y, Width, Height, Style);
+				break;
+#else
+				(void)Title;
+				(void)X;
+				(void)Y;
+				(void)Style;
+				throw E_NOTIMPL;
+#endif
+			}
+
+			case APPLICATION_BACKEND_NULL:
+			{
+				App = CreateNullApplication(Width, Height);
+				break;
+			}
+
+			case APPLICATION_BACKEND_SOFTWARE:
+			{
+				App = CreateSoftwareApplication(Width, Height);
+				break;
+			}
+
+			default:
+			{
+				throw E_INVALIDARG;
+			}
+		}
+
+		App->ObjectConstant = App->CreateConstantAllocator(1 << 20);
+		return App;
+	}
+
+
+
+	std::shared_ptr<ICommandList> ICommandList::Create(std::shared_ptr<IApplication> App)
+	{
+		return static_cast<Backend*>(App.get())->CreateCommandList();
+	}
+
+	std::shared_ptr<IVertexShader> IVertexShader::Create(std::shared_ptr<IApplication> App, LPCVOID Data, SIZE_T Size)
+	{
+		Backend* const Current = static_cast<Backend*>(App.get());
+		const uint64_t Start = GetTimestamp();
+		return Current->Track(Current->CreateVertexShader(Data, Size), Start);
+	}
+
+	std::shared_ptr<IPixelShader> IPixelShader::Create(std::shared_ptr<IApplication> App, LPCVOID Data, SIZE_T Size)
+	{
+		Backend* const Current = static_cast<Backend*>(App.get());
+		const uint64_t Start = GetTimestamp();
+		return Current->Track(Current->CreatePixelShader(Data, Size), Start);
+	}
+
+	std::shared_ptr<IConstantBuffer> IConstantBuffer::Create(std::shared_ptr<IApplication> App, SIZE_T Size)
+	{
+		Backend* const Current = static_cast<Backend*>(App.get());
+		const uint64_t Start = GetTimestamp();
+		return Current->Track(Current->CreateConstantBuffer(Size), Start);
+	}
+
+	std::shared_ptr<IConstantAllocator> IConstantAllocator::Create(std::shared_ptr<IApplication> App, SIZE_T Capacity)
+	{
+		Backend* const Current = static_cast<Backend*>(App.get());
+		const uint64_t Start = GetTimestamp();
+		return Current->Track(Current->CreateConstantAllocator(Capacity), Start);
+	}
+
+	std::shared_ptr<IVertexBuffer> IVertexBuffer::Create(std::shared_ptr<IApplication> App, LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement)
+	{
+		Backend* const Current = static_cast<Backend*>(App.get());
+		const uint64_t Start = GetTimestamp();
+		return Current->Track(Current->CreateVertexBuffer(Data, CountElement, SizeElement), Start);
+	}
+
+	std::shared_ptr<IIndexBuffer> IIndexBuffer::Create(std::shared_ptr<IApplication> App, LPCVOID Data, SIZE_T CountElement)
+	{
+		Backend* const Current = static_cast<Backend*>(App.get());
+		const uint64_t Start = GetTimestamp();
+		return Current->Track(Current->CreateIndexBuffer(Data, CountElement), Start);
+	}
+
+	std::shared_ptr<IDynamicVertexBuffer> IDynamicVertexBuffer::Create(std::shared_ptr<IApplication> App, SIZE_T CountElement, SIZE_T SizeElement)
+	{
+		Backend* const Current = static_cast<Backend*>(App.get());
+		const uint64_t Start = GetTimestamp();
+		return Current->Track(Current->CreateDynamicVertexBuffer(CountElement, SizeElement), Start);
+	}
+
+	std::shared_ptr<IDynamicIndexBuffer> IDynamicIndexBuffer::Create(std::shared_ptr<IApplication> App, SIZE_T CountElement)
+	{
+		Backend* const Current = static_cast<Backend*>(App.get());
+		const uint64_t Start = GetTimestamp();
+		return Current->Track(Current->CreateDynamicIndexBuffer(CountElement), Start);
+	}
+
+	std::shared_ptr<IGeometryPool> IGeometryPool::Create(std::shared_ptr<IApplication> App, SIZE_T VertexCount, SIZE_T SizeElement, SIZE_T IndexCount)
+	{
+		Backend* const Current = static_cast<Backend*>(App.get());
+		const uint64_t Start = GetTimestamp();
+		return Current->Track(Current->CreateGeometryPool(VertexCount, SizeElement, IndexCount), Start);
+	}
+
+	std::shared_ptr<IInstanceBuffer> IInstanceBuffer::Create(std::shared_ptr<IApplication> App, LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement)
+	{
+		Backend* const Current = static_cast<Backend*>(App.get());
+		const uint64_t Start = GetTimestamp();
+		return Current->Track(Current->CreateInstanceBuffer(Data, CountElement, SizeElement), Start);
+	}
+
+	std::shared_ptr<ITexture> ITexture::Create(std::shared_ptr<IApplication> App, LPCVOID Data, UINT Width, UINT Height)
+	{
+		Backend* const Current = static_cast<Backend*>(App.get());
+		const uint64_t Start = GetTimestamp();
+		return Current->Track(Current->CreateTexture(Data, Width, Height), Start);
+	}
+
+	std::shared_ptr<INullApplication> INullApplication::Get(std::shared_ptr<IApplication> App)
+	{
+		return std::dynamic_pointer_cast<INullApplication>(App);
+	}
+
+	std::shared_ptr<ISoftwareApplication> ISoftwareApplication::Get(std::shared_ptr<IApplication> App)
+	{
+		return std::dynamic_pointer_cast<ISoftwareApplication>(App);
+	}
+
+
+
+	GeometryAllocator::GeometryAllocator(UINT VertexCount, UINT IndexCount) : VertexAllocator(VertexCount), IndexAllocator(IndexCount)
+	{
+	}
+
+	UINT GeometryAllocator::Add(UINT VertexCount, UINT IndexCount)
+	{
+		const OFFSET_ALLOCATION_STRUCT VertexAllocation = this->VertexAllocator.Allocate(VertexCount);
+		if (VertexAllocation.Offset == OffsetAllocator::Invalid)
+		{
+			return Invalid;
+		}
+
+		const OFFSET_ALLOCATION_STRUCT IndexAllocation = this->IndexAllocator.Allocate(IndexCount);
+		if (IndexAllocation.Offset == OffsetAllocator::Invalid)
+		{
+			this->VertexAllocator.Free(VertexAllocation);
+			return Invalid;
+		}
+
+		UINT Mesh = static_cast<UINT>(this->Mesh.size());
+		if (!this->FreeMesh.empty())
+		{
+			Mesh = this->FreeMesh.back();
+			this->FreeMesh.pop_back();
+		}
+		else
+		{
+			this->Mesh.push_back({});
+		}
+
+		this->Mesh[Mesh] = { VertexAllocation, IndexAllocation, VertexCount, IndexCount, true };
+		this->MeshCount++;
+
+		return Mesh;
+	}
+
+	void GeometryAllocator::Remove(UINT Mesh)
+	{
+		if (Mesh >= this->Mesh.size() || !this->Mesh[Mesh].Used)
+		{
+			return;
+		}
+
+		this->VertexAllocator.Free(this->Mesh[Mesh].Vertex);
+		this->IndexAllocator.Free(this->Mesh[Mesh].Index);
+		this->Mesh[Mesh].Used = false;
+		this->FreeMesh.push_back(Mesh);
+		this->MeshCount--;
+	}
+
+	GEOMETRY_MESH_STRUCT GeometryAllocator::GetMesh(UINT Mesh) const
+	{
+		if (Mesh >= this->Mesh.size() || !this->Mesh[Mesh].Used)
+		{
+			throw E_INVALIDARG;
+		}
+
+		const MESH_STRUCT& Current = this->Mesh[Mesh];
+		return { static_cast<INT>(Current.Vertex.Offset), Current.Index.Offset, Current.IndexCount };
+	}
+
+	std::vector<GEOMETRY_MOVE_STRUCT> GeometryAllocator::Compact()
+	{
+		std::vector<UINT> Order;
+		for (UINT Mesh = 0; Mesh < this->Mesh.size(); Mesh++)
+		{
+			if (this->Mesh[Mesh].Used)
+			{
+				Order.push_back(Mesh);
+			}
+		}
+
+		std::sort(Order.begin(), Order.end(), [this](UINT Left, UINT Right)
+		{
+			return this->Mesh[Left].Vertex.Offset < this->Mesh[Right].Vertex.Offset;
+		});
+
+		this->VertexAllocator.Reset();
+		this->IndexAllocator.Reset();
+
+		std::vector<GEOMETRY_MOVE_STRUCT> Move;
+		Move.reserve(Order.size());
+
+		for (const UINT Mesh : Order)
+		{
+			MESH_STRUCT& Current = this->Mesh[Mesh];
+
+			const OFFSET_ALLOCATION_STRUCT VertexAllocation = this->VertexAllocator.Allocate(Current.VertexCount);
+			const OFFSET_ALLOCATION_STRUCT IndexAllocation = this->IndexAllocator.Allocate(Current.IndexCount);
+
+			Move.push_back({ Current.Vertex.Offset, VertexAllocation.Offset, Current.VertexCount, Current.Index.Offset, IndexAllocation.Offset, Current.IndexCount });
+
+			Current.Vertex = VertexAllocation;
+			Current.Index = IndexAllocation;
+		}
+
+		return Move;
+	}
+
+	GEOMETRY_REPORT_STRUCT GeometryAllocator::GetReport() const
+	{
+		return { this->MeshCount, this->VertexAllocator.GetReport(), this->IndexAllocator.GetReport() };
+	}
+
+	UINT GeometryAllocator::GetVertexCapacity() const
+	{
+		return this->VertexAllocator.GetSize();
+	}
+
+	UINT GeometryAllocator::GetIndexCapacity() const
+	{
+		return this->IndexAllocator.GetSize();
+	}
+}
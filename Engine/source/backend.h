@@ -0,0 +1,191 @@
+﻿#ifndef _BACKEND_H_
+#define _BACKEND_H_
+
+#include "include/engine.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Engine
+{
+	template<class Class, typename... Param>
+	inline std::shared_ptr<Class> CreateInterface(Param... Parameters)
+	{
+		return std::make_shared<Class>(Parameters...);
+	}
+
+
+
+	// Relaxed atomic counters shared by an application and the resources and
+	// command lists it created, which may be used from other threads.
+	class BackendCounter
+	{
+	public:
+		void Draw(UINT IndexCount, UINT InstanceCount)
+		{
+			this->DrawCount.fetch_add(1, std::memory_order_relaxed);
+			this->IndexCount.fetch_add(static_cast<uint64_t>(IndexCount) * InstanceCount, std::memory_order_relaxed);
+			this->InstanceCount.fetch_add(InstanceCount, std::memory_order_relaxed);
+		}
+
+		void Bind()
+		{
+			this->BindCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void Upload(SIZE_T Size)
+		{
+			this->ConstantBytes.fetch_add(Size, std::memory_order_relaxed);
+		}
+
+		void Create(uint64_t Time)
+		{
+			this->CreateCount.fetch_add(1, std::memory_order_relaxed);
+			this->CreateTime.fetch_add(Time, std::memory_order_relaxed);
+		}
+
+		void Destroy()
+		{
+			this->DestroyCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		APPLICATION_COUNTER_STRUCT Read() const
+		{
+			return {
+				this->DrawCount.load(std::memory_order_relaxed),
+				this->IndexCount.load(std::memory_order_relaxed),
+				this->InstanceCount.load(std::memory_order_relaxed),
+				this->BindCount.load(std::memory_order_relaxed),
+				this->ConstantBytes.load(std::memory_order_relaxed),
+				this->CreateCount.load(std::memory_order_relaxed),
+				this->DestroyCount.load(std::memory_order_relaxed),
+				this->CreateTime.load(std::memory_order_relaxed),
+			};
+		}
+	private:
+		std::atomic<uint64_t> DrawCount{ 0 };
+		std::atomic<uint64_t> IndexCount{ 0 };
+		std::atomic<uint64_t> InstanceCount{ 0 };
+		std::atomic<uint64_t> BindCount{ 0 };
+		std::atomic<uint64_t> ConstantBytes{ 0 };
+		std::atomic<uint64_t> CreateCount{ 0 };
+		std::atomic<uint64_t> DestroyCount{ 0 };
+		std::atomic<uint64_t> CreateTime{ 0 };
+	};
+
+
+
+	class Backend : public IApplication, public std::enable_shared_from_this<Backend>
+	{
+	public:
+		void Submit(uint64_t Key, const DRAW_COMMAND_STRUCT& Command) override;
+		void Flush() override;
+		APPLICATION_STATISTICS_STRUCT GetFrameStatistics() override;
+		void SetStatisticsFile(const char* FileName, float Interval) override;
+		InputQueue& GetInputQueue() override;
+
+		// Counts the resource as created since Start and as destroyed once the last reference is released.
+		template<class Class>
+		std::shared_ptr<Class> Track(std::shared_ptr<Class> Resource, uint64_t Start)
+		{
+			std::shared_ptr<BackendCounter> Counter = this->Counter;
+			Counter->Create(GetTimestamp() - Start);
+			Class* const Pointer = Resource.get();
+			return std::shared_ptr<Class>(Pointer, [Resource, Counter](Class*) mutable
+			{
+				Resource.reset();
+				Counter->Destroy();
+			});
+		}
+
+		virtual std::shared_ptr<ICommandList> CreateCommandList() = 0;
+		virtual std::shared_ptr<IVertexShader> CreateVertexShader(LPCVOID Data, SIZE_T Size) = 0;
+		virtual std::shared_ptr<IPixelShader> CreatePixelShader(LPCVOID Data, SIZE_T Size) = 0;
+		virtual std::shared_ptr<IConstantBuffer> CreateConstantBuffer(SIZE_T Size) = 0;
+		virtual std::shared_ptr<IConstantAllocator> CreateConstantAllocator(SIZE_T Capacity) = 0;
+		virtual std::shared_ptr<IVertexBuffer> CreateVertexBuffer(LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement) = 0;
+		virtual std::shared_ptr<IIndexBuffer> CreateIndexBuffer(LPCVOID Data, SIZE_T CountElement) = 0;
+		virtual std::shared_ptr<IDynamicVertexBuffer> CreateDynamicVertexBuffer(SIZE_T CountElement, SIZE_T SizeElement) = 0;
+		virtual std::shared_ptr<IDynamicIndexBuffer> CreateDynamicIndexBuffer(SIZE_T CountElement) = 0;
+		virtual std::shared_ptr<IGeometryPool> CreateGeometryPool(SIZE_T VertexCount, SIZE_T SizeElement, SIZE_T IndexCount) = 0;
+		virtual std::shared_ptr<IInstanceBuffer> CreateInstanceBuffer(LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement) = 0;
+		virtual std::shared_ptr<ITexture> CreateTexture(LPCVOID Data, UINT Width, UINT Height) = 0;
+	protected:
+		// Closes the frame; every backend calls it at the end of EndDraw.
+		void EndFrame();
+
+		InputQueue InputEvent;
+		std::shared_ptr<BackendCounter> Counter = std::make_shared<BackendCounter>();
+	private:
+		friend class IApplication;
+
+		void SaveStatistics(const APPLICATION_STATISTICS_STRUCT& Statistics);
+
+		static constexpr size_t FrameWindow = 1024;
+
+		std::mutex StatisticsMutex;
+		APPLICATION_COUNTER_STRUCT FrameStart = {};
+		APPLICATION_COUNTER_STRUCT LastFrame = {};
+		uint64_t FrameCount = 0;
+		uint64_t FrameTimestamp = 0;
+		std::vector<float> FrameTime;
+		std::string StatisticsFile;
+		uint64_t StatisticsInterval = 0;
+		uint64_t NextSave = 0;
+
+		RenderQueue Queue;
+		std::vector<DRAW_COMMAND_STRUCT> Command;
+		std::vector<SIZE_T> ConstantOffset;
+		std::vector<BYTE> ConstantData;
+		std::shared_ptr<IConstantAllocator> ObjectConstant;
+	};
+
+	std::shared_ptr<Backend> CreateDirect3D11Application(LPCTSTR Title, INT X, INT Y, UINT Width, UINT Height, DWORD Style);
+	std::shared_ptr<Backend> CreateNullApplication(UINT Width, UINT Height);
+	std::shared_ptr<Backend> CreateSoftwareApplication(UINT Width, UINT Height);
+
+
+
+	struct GEOMETRY_MOVE_STRUCT
+	{
+		UINT SourceVertex;
+		UINT DestinationVertex;
+		UINT VertexCount;
+		UINT SourceIndex;
+		UINT DestinationIndex;
+		UINT IndexCount;
+	};
+
+	class GeometryAllocator
+	{
+	public:
+		static constexpr UINT Invalid = 0xFFFFFFFF;
+
+		GeometryAllocator(UINT VertexCount, UINT IndexCount);
+		UINT Add(UINT VertexCount, UINT IndexCount);
+		void Remove(UINT Mesh);
+		GEOMETRY_MESH_STRUCT GetMesh(UINT Mesh) const;
+		std::vector<GEOMETRY_MOVE_STRUCT> Compact();
+		GEOMETRY_REPORT_STRUCT GetReport() const;
+		UINT GetVertexCapacity() const;
+		UINT GetIndexCapacity() const;
+	private:
+		struct MESH_STRUCT
+		{
+			OFFSET_ALLOCATION_STRUCT Vertex;
+			OFFSET_ALLOCATION_STRUCT Index;
+			UINT VertexCount;
+			UINT IndexCount;
+			bool Used;
+		};
+
+		OffsetAllocator VertexAllocator;
+		OffsetAllocator IndexAllocator;
+		std::vector<MESH_STRUCT> Mesh;
+		std::vector<UINT> FreeMesh;
+		UINT MeshCount = 0;
+	};
+}
+
+#endif
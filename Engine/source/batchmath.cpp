@@ -0,0 +1,299 @@
+﻿#include "include/batchmath.h"
+#include <cstring>
+#include <immintrin.h>
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr size_t BatchGrain = 4096;
+
+		inline __m128 MultiplyAdd(__m128 A, __m128 B, __m128 C)
+		{
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+			return _mm_fmadd_ps(A, B, C);
+#else
+			return _mm_add_ps(_mm_mul_ps(A, B), C);
+#endif
+		}
+
+#if defined(__AVX2__)
+		inline __m256 MultiplyAdd(__m256 A, __m256 B, __m256 C)
+		{
+#if defined(__FMA__) || defined(_MSC_VER)
+			return _mm256_fmadd_ps(A, B, C);
+#else
+			return _mm256_add_ps(_mm256_mul_ps(A, B), C);
+#endif
+		}
+#endif
+
+		template<class Function>
+		void BatchParallel(size_t Count, ThreadPool* Pool, const Function& Block)
+		{
+			if (!Pool || Count <= BatchGrain)
+			{
+				Block(0, Count);
+				return;
+			}
+
+			Pool->ParallelFor(Count, BatchGrain, Block);
+		}
+
+		inline void StoreMatrix(float* Output, __m128 Row0, __m128 Row1, __m128 Row2, __m128 Row3, bool Transpose)
+		{
+			if (Transpose)
+			{
+				_MM_TRANSPOSE4_PS(Row0, Row1, Row2, Row3);
+			}
+
+			_mm_storeu_ps(Output + 0, Row0);
+			_mm_storeu_ps(Output + 4, Row1);
+			_mm_storeu_ps(Output + 8, Row2);
+			_mm_storeu_ps(Output + 12, Row3);
+		}
+
+		void MultiplyMatricesBlock(const float* Left, const float* Right, float* Output, size_t First, size_t Last, bool Transpose)
+		{
+			size_t Index = First;
+
+#if defined(__AVX512F__)
+			// GCC 12 flags the undefined source operand of its own broadcast and permute intrinsics.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+			const __m512 Right0 = _mm512_broadcast_f32x4(_mm_loadu_ps(Right + 0));
+			const __m512 Right1 = _mm512_broadcast_f32x4(_mm_loadu_ps(Right + 4));
+			const __m512 Right2 = _mm512_broadcast_f32x4(_mm_loadu_ps(Right + 8));
+			const __m512 Right3 = _mm512_broadcast_f32x4(_mm_loadu_ps(Right + 12));
+			const __m512i TransposeIndex = _mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+
+			for (; Index < Last; Index++)
+			{
+				const __m512 Matrix = _mm512_loadu_ps(Left + Index * 16);
+
+				__m512 Result = _mm512_mul_ps(_mm512_permute_ps(Matrix, 0x00), Right0);
+				Result = _mm512_fmadd_ps(_mm512_permute_ps(Matrix, 0x55), Right1, Result);
+				Result = _mm512_fmadd_ps(_mm512_permute_ps(Matrix, 0xAA), Right2, Result);
+				Result = _mm512_fmadd_ps(_mm512_permute_ps(Matrix, 0xFF), Right3, Result);
+
+				_mm512_storeu_ps(Output + Index * 16, Transpose ? _mm512_permutexvar_ps(TransposeIndex, Result) : Result);
+			}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#elif defined(__AVX2__)
+			const __m256 Right0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(Right + 0));
+			const __m256 Right1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(Right + 4));
+			const __m256 Right2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(Right + 8));
+			const __m256 Right3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(Right + 12));
+			const __m256i TransposeIndex = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+			for (; Index < Last; Index++)
+			{
+				const __m256 Row01 = _mm256_loadu_ps(Left + Index * 16);
+				const __m256 Row23 = _mm256_loadu_ps(Left + Index * 16 + 8);
+
+				__m256 Result01 = _mm256_mul_ps(_mm256_permute_ps(Row01, 0x00), Right0);
+				__m256 Result23 = _mm256_mul_ps(_mm256_permute_ps(Row23, 0x00), Right0);
+				Result01 = MultiplyAdd(_mm256_permute_ps(Row01, 0x55), Right1, Result01);
+				Result23 = MultiplyAdd(_mm256_permute_ps(Row23, 0x55), Right1, Result23);
+				Result01 = MultiplyAdd(_mm256_permute_ps(Row01, 0xAA), Right2, Result01);
+				Result23 = MultiplyAdd(_mm256_permute_ps(Row23, 0xAA), Right2, Result23);
+				Result01 = MultiplyAdd(_mm256_permute_ps(Row01, 0xFF), Right3, Result01);
+				Result23 = MultiplyAdd(_mm256_permute_ps(Row23, 0xFF), Right3, Result23);
+
+				if (Transpose)
+				{
+					const __m256 Low = _mm256_unpacklo_ps(Result01, Result23);
+					const __m256 High = _mm256_unpackhi_ps(Result01, Result23);
+					Result01 = _mm256_permutevar8x32_ps(Low, TransposeIndex);
+					Result23 = _mm256_permutevar8x32_ps(High, TransposeIndex);
+				}
+
+				_mm256_storeu_ps(Output + Index * 16, Result01);
+				_mm256_storeu_ps(Output + Index * 16 + 8, Result23);
+			}
+#else
+			const __m128 Right0 = _mm_loadu_ps(Right + 0);
+			const __m128 Right1 = _mm_loadu_ps(Right + 4);
+			const __m128 Right2 = _mm_loadu_ps(Right + 8);
+			const __m128 Right3 = _mm_loadu_ps(Right + 12);
+
+			for (; Index < Last; Index++)
+			{
+				const float* const Matrix = Left + Index * 16;
+				__m128 Row[4];
+
+				for (size_t Current = 0; Current < 4; Current++)
+				{
+					const __m128 Source = _mm_loadu_ps(Matrix + Current * 4);
+					Row[Current] = _mm_mul_ps(_mm_shuffle_ps(Source, Source, 0x00), Right0);
+					Row[Current] = MultiplyAdd(_mm_shuffle_ps(Source, Source, 0x55), Right1, Row[Current]);
+					Row[Current] = MultiplyAdd(_mm_shuffle_ps(Source, Source, 0xAA), Right2, Row[Current]);
+					Row[Current] = MultiplyAdd(_mm_shuffle_ps(Source, Source, 0xFF), Right3, Row[Current]);
+				}
+
+				StoreMatrix(Output + Index * 16, Row[0], Row[1], Row[2], Row[3], Transpose);
+			}
+#endif
+		}
+
+		void TransformPointsBlock(const float* Matrix, const float* X, const float* Y, const float* Z, float* OutputX, float* OutputY, float* OutputZ, size_t First, size_t Last)
+		{
+			size_t Index = First;
+
+#if defined(__AVX512F__)
+			for (; Index + 16 <= Last; Index += 16)
+			{
+				const __m512 PointX = _mm512_loadu_ps(X + Index);
+				const __m512 PointY = _mm512_loadu_ps(Y + Index);
+				const __m512 PointZ = _mm512_loadu_ps(Z + Index);
+
+				for (size_t Column = 0; Column < 3; Column++)
+				{
+					__m512 Result = _mm512_fmadd_ps(PointX, _mm512_set1_ps(Matrix[Column]), _mm512_set1_ps(Matrix[12 + Column]));
+					Result = _mm512_fmadd_ps(PointY, _mm512_set1_ps(Matrix[4 + Column]), Result);
+					Result = _mm512_fmadd_ps(PointZ, _mm512_set1_ps(Matrix[8 + Column]), Result);
+					_mm512_storeu_ps((Column == 0 ? OutputX : Column == 1 ? OutputY : OutputZ) + Index, Result);
+				}
+			}
+#endif
+
+#if defined(__AVX2__)
+			for (; Index + 8 <= Last; Index += 8)
+			{
+				const __m256 PointX = _mm256_loadu_ps(X + Index);
+				const __m256 PointY = _mm256_loadu_ps(Y + Index);
+				const __m256 PointZ = _mm256_loadu_ps(Z + Index);
+
+				for (size_t Column = 0; Column < 3; Column++)
+				{
+					__m256 Result = MultiplyAdd(PointX, _mm256_set1_ps(Matrix[Column]), _mm256_set1_ps(Matrix[12 + Column]));
+					Result = MultiplyAdd(PointY, _mm256_set1_ps(Matrix[4 + Column]), Result);
+					Result = MultiplyAdd(PointZ, _mm256_set1_ps(Matrix[8 + Column]), Result);
+					_mm256_storeu_ps((Column == 0 ? OutputX : Column == 1 ? OutputY : OutputZ) + Index, Result);
+				}
+			}
+#endif
+
+			for (; Index + 4 <= Last; Index += 4)
+			{
+				const __m128 PointX = _mm_loadu_ps(X + Index);
+				const __m128 PointY = _mm_loadu_ps(Y + Index);
+				const __m128 PointZ = _mm_loadu_ps(Z + Index);
+
+				for (size_t Column = 0; Column < 3; Column++)
+				{
+					__m128 Result = MultiplyAdd(PointX, _mm_set1_ps(Matrix[Column]), _mm_set1_ps(Matrix[12 + Column]));
+					Result = MultiplyAdd(PointY, _mm_set1_ps(Matrix[4 + Column]), Result);
+					Result = MultiplyAdd(PointZ, _mm_set1_ps(Matrix[8 + Column]), Result);
+					_mm_storeu_ps((Column == 0 ? OutputX : Column == 1 ? OutputY : OutputZ) + Index, Result);
+				}
+			}
+
+			for (; Index < Last; Index++)
+			{
+				const float PointX = X[Index];
+				const float PointY = Y[Index];
+				const float PointZ = Z[Index];
+
+				OutputX[Index] = PointX * Matrix[0] + PointY * Matrix[4] + PointZ * Matrix[8] + Matrix[12];
+				OutputY[Index] = PointX * Matrix[1] + PointY * Matrix[5] + PointZ * Matrix[9] + Matrix[13];
+				OutputZ[Index] = PointX * Matrix[2] + PointY * Matrix[6] + PointZ * Matrix[10] + Matrix[14];
+			}
+		}
+
+		// Box strides of zero reuse the first box for every matrix.
+		void TransformBoundingBoxesBlock(const BOUNDING_BOX_STRUCT* Box, size_t BoxStride, const float* World, BOUNDING_BOX_STRUCT* Output, size_t First, size_t Last)
+		{
+#if defined(__AVX2__)
+			// The low lane accumulates the center from the rows and the high
+			// lane the extent from their absolute values.
+			const __m256i BoxMask = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 0, 0);
+			const __m256 AbsoluteMask = _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, -1, 0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF));
+			const __m256 TranslationMask = _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, -1, 0, 0, 0, 0));
+			const __m256i Coefficient0 = _mm256_setr_epi32(0, 0, 0, 0, 3, 3, 3, 3);
+			const __m256i Coefficient1 = _mm256_setr_epi32(1, 1, 1, 1, 4, 4, 4, 4);
+			const __m256i Coefficient2 = _mm256_setr_epi32(2, 2, 2, 2, 5, 5, 5, 5);
+			const __m256i Pack = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+
+			for (size_t Index = First; Index < Last; Index++)
+			{
+				const float* const Matrix = World + Index * 16;
+				const __m256 Source = _mm256_maskload_ps(Box[Index * BoxStride].Center, BoxMask);
+
+				__m256 Result = _mm256_and_ps(_mm256_broadcast_ps(reinterpret_cast<const __m128*>(Matrix + 12)), TranslationMask);
+				Result = MultiplyAdd(_mm256_permutevar8x32_ps(Source, Coefficient0), _mm256_and_ps(_mm256_broadcast_ps(reinterpret_cast<const __m128*>(Matrix + 0)), AbsoluteMask), Result);
+				Result = MultiplyAdd(_mm256_permutevar8x32_ps(Source, Coefficient1), _mm256_and_ps(_mm256_broadcast_ps(reinterpret_cast<const __m128*>(Matrix + 4)), AbsoluteMask), Result);
+				Result = MultiplyAdd(_mm256_permutevar8x32_ps(Source, Coefficient2), _mm256_and_ps(_mm256_broadcast_ps(reinterpret_cast<const __m128*>(Matrix + 8)), AbsoluteMask), Result);
+
+				_mm256_maskstore_ps(Output[Index].Center, BoxMask, _mm256_permutevar8x32_ps(Result, Pack));
+			}
+#else
+			const __m128 AbsoluteMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+			for (size_t Index = First; Index < Last; Index++)
+			{
+				const float* const Matrix = World + Index * 16;
+				const BOUNDING_BOX_STRUCT& Source = Box[Index * BoxStride];
+
+				const __m128 Row0 = _mm_loadu_ps(Matrix + 0);
+				const __m128 Row1 = _mm_loadu_ps(Matrix + 4);
+				const __m128 Row2 = _mm_loadu_ps(Matrix + 8);
+
+				__m128 Center = _mm_loadu_ps(Matrix + 12);
+				Center = MultiplyAdd(_mm_set1_ps(Source.Center[0]), Row0, Center);
+				Center = MultiplyAdd(_mm_set1_ps(Source.Center[1]), Row1, Center);
+				Center = MultiplyAdd(_mm_set1_ps(Source.Center[2]), Row2, Center);
+
+				__m128 Extent = _mm_mul_ps(_mm_set1_ps(Source.Extent[0]), _mm_and_ps(Row0, AbsoluteMask));
+				Extent = MultiplyAdd(_mm_set1_ps(Source.Extent[1]), _mm_and_ps(Row1, AbsoluteMask), Extent);
+				Extent = MultiplyAdd(_mm_set1_ps(Source.Extent[2]), _mm_and_ps(Row2, AbsoluteMask), Extent);
+
+				float Result[8];
+				_mm_storeu_ps(Result + 0, Center);
+				_mm_storeu_ps(Result + 4, Extent);
+				memcpy(Output[Index].Center, Result + 0, sizeof(Output[Index].Center));
+				memcpy(Output[Index].Extent, Result + 4, sizeof(Output[Index].Extent));
+			}
+#endif
+		}
+	}
+
+
+
+	void MultiplyMatrices(const float* Left, const float* Right, float* Output, size_t Count, bool Transpose, ThreadPool* Pool)
+	{
+		BatchParallel(Count, Pool, [&](size_t First, size_t Last)
+		{
+			MultiplyMatricesBlock(Left, Right, Output, First, Last, Transpose);
+		});
+	}
+
+	void TransformPoints(const float* Matrix, const float* X, const float* Y, const float* Z, float* OutputX, float* OutputY, float* OutputZ, size_t Count, ThreadPool* Pool)
+	{
+		BatchParallel(Count, Pool, [&](size_t First, size_t Last)
+		{
+			TransformPointsBlock(Matrix, X, Y, Z, OutputX, OutputY, OutputZ, First, Last);
+		});
+	}
+
+	void TransformBoundingBoxes(const BOUNDING_BOX_STRUCT* Box, const float* World, BOUNDING_BOX_STRUCT* Output, size_t Count, ThreadPool* Pool)
+	{
+		BatchParallel(Count, Pool, [&](size_t First, size_t Last)
+		{
+			TransformBoundingBoxesBlock(Box, 1, World, Output, First, Last);
+		});
+	}
+
+	void TransformBoundingBoxes(const BOUNDING_BOX_STRUCT& Box, const float* World, BOUNDING_BOX_STRUCT* Output, size_t Count, ThreadPool* Pool)
+	{
+		BatchParallel(Count, Pool, [&](size_t First, size_t Last)
+		{
+			TransformBoundingBoxesBlock(&Box, 0, World, Output, First, Last);
+		});
+	}
+}
@@ -0,0 +1,545 @@
+﻿#include "include/broadphase.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <immintrin.h>
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr size_t SweepBlockSize = 1024;
+		constexpr size_t CellBlockSize = 512;
+		constexpr int32_t CellLimit = 0xFFFFF;
+		constexpr uint64_t EmptySlot = ~0ull;
+		constexpr size_t MinimumSlotCount = 1024;
+
+		template<class Function>
+		void ForEachBlock(size_t BlockCount, ThreadPool* Pool, const Function& Block)
+		{
+			if (!Pool || BlockCount <= 1)
+			{
+				for (size_t Index = 0; Index < BlockCount; Index++)
+				{
+					Block(Index);
+				}
+				return;
+			}
+
+			Pool->Dispatch(BlockCount, Block);
+		}
+
+		inline BROADPHASE_PAIR_STRUCT MakePair(uint32_t First, uint32_t Second)
+		{
+			return First < Second ? BROADPHASE_PAIR_STRUCT{ First, Second } : BROADPHASE_PAIR_STRUCT{ Second, First };
+		}
+
+		inline uint64_t MakeCellKey(int32_t X, int32_t Y, int32_t Z)
+		{
+			const uint64_t Mask = 0x1FFFFF;
+			return ((static_cast<uint64_t>(X + CellLimit) & Mask) << 42) | ((static_cast<uint64_t>(Y + CellLimit) & Mask) << 21) | (static_cast<uint64_t>(Z + CellLimit) & Mask);
+		}
+
+		inline size_t HashCellKey(uint64_t Key, size_t Mask)
+		{
+			return static_cast<size_t>((Key * 0x9E3779B97F4A7C15ull) >> 32) & Mask;
+		}
+	}
+
+
+
+	void Broadphase::Build(const BOUNDING_BOX_STRUCT* Box, size_t Count)
+	{
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			this->Min[Axis].resize(Count);
+			this->Max[Axis].resize(Count);
+
+			for (size_t Object = 0; Object < Count; Object++)
+			{
+				this->Min[Axis][Object] = Box[Object].Center[Axis] - Box[Object].Extent[Axis];
+				this->Max[Axis][Object] = Box[Object].Center[Axis] + Box[Object].Extent[Axis];
+			}
+		}
+	}
+
+	void Broadphase::Update(uint32_t Object, const BOUNDING_BOX_STRUCT& Box)
+	{
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			this->Min[Axis][Object] = Box.Center[Axis] - Box.Extent[Axis];
+			this->Max[Axis][Object] = Box.Center[Axis] + Box.Extent[Axis];
+		}
+	}
+
+	size_t Broadphase::GetObjectCount() const
+	{
+		return this->Min[0].size();
+	}
+
+	bool Broadphase::Overlap(uint32_t First, uint32_t Second) const
+	{
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			if (this->Min[Axis][First] > this->Max[Axis][Second] || this->Min[Axis][Second] > this->Max[Axis][First])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	size_t Broadphase::Gather(std::vector<BROADPHASE_PAIR_STRUCT>& Pair) const
+	{
+		size_t Count = 0;
+		for (const std::vector<BROADPHASE_PAIR_STRUCT>& Block : this->BlockPair)
+		{
+			Count += Block.size();
+		}
+
+		Pair.clear();
+		Pair.reserve(Count);
+		for (const std::vector<BROADPHASE_PAIR_STRUCT>& Block : this->BlockPair)
+		{
+			Pair.insert(Pair.end(), Block.begin(), Block.end());
+		}
+		return Count;
+	}
+
+
+
+	void SweepAndPrune::Build(const BOUNDING_BOX_STRUCT* Box, size_t Count)
+	{
+		Broadphase::Build(Box, Count);
+
+		float Variance[3] = {};
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			double Sum = 0.0;
+			double Square = 0.0;
+			for (size_t Object = 0; Object < Count; Object++)
+			{
+				const double Center = this->Min[Axis][Object] + this->Max[Axis][Object];
+				Sum += Center;
+				Square += Center * Center;
+			}
+			Variance[Axis] = Count ? static_cast<float>(Square / Count - (Sum / Count) * (Sum / Count)) : 0.0f;
+		}
+		this->Axis = Variance[0] >= Variance[2] ? 0 : 2;
+		this->Axis = Variance[1] > Variance[this->Axis] ? 1 : this->Axis;
+
+		this->Order.resize(Count);
+		std::iota(this->Order.begin(), this->Order.end(), 0);
+
+		const float* const Key = this->Min[this->Axis].data();
+		std::sort(this->Order.begin(), this->Order.end(), [Key](uint32_t Left, uint32_t Right)
+		{
+			return Key[Left] < Key[Right];
+		});
+	}
+
+	void SweepAndPrune::Sort()
+	{
+		float* const Key = this->SortedMin[this->Axis].data();
+		uint32_t* const Order = this->Order.data();
+		const size_t Count = this->Order.size();
+		const size_t Budget = Count * 16;
+		size_t Moved = 0;
+
+		for (size_t Index = 1; Index < Count; Index++)
+		{
+			const uint32_t Object = Order[Index];
+			const float Value = Key[Index];
+
+			size_t Target = Index;
+			while (Target > 0 && Key[Target - 1] > Value)
+			{
+				Key[Target] = Key[Target - 1];
+				Order[Target] = Order[Target - 1];
+				Target--;
+			}
+			Key[Target] = Value;
+			Order[Target] = Object;
+
+			Moved += Index - Target;
+			if (Moved > Budget)
+			{
+				const float* const Minimum = this->Min[this->Axis].data();
+				std::sort(this->Order.begin(), this->Order.end(), [Minimum](uint32_t Left, uint32_t Right)
+				{
+					return Minimum[Left] < Minimum[Right];
+				});
+				return;
+			}
+		}
+	}
+
+	size_t SweepAndPrune::FindPairs(std::vector<BROADPHASE_PAIR_STRUCT>& Pair, ThreadPool* Pool)
+	{
+		const size_t Count = this->Order.size();
+		const size_t BlockCount = (Count + SweepBlockSize - 1) / SweepBlockSize;
+		const uint32_t A = this->Axis;
+		const uint32_t B = (A + 1) % 3;
+		const uint32_t C = (A + 2) % 3;
+
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			this->SortedMin[Axis].resize(Count);
+			this->SortedMax[Axis].resize(Count);
+		}
+
+		for (size_t Index = 0; Index < Count; Index++)
+		{
+			this->SortedMin[A][Index] = this->Min[A][this->Order[Index]];
+		}
+
+		this->Sort();
+
+		ForEachBlock(BlockCount, Pool, [&](size_t Block)
+		{
+			const size_t Last = (std::min)((Block + 1) * SweepBlockSize, Count);
+			for (size_t Index = Block * SweepBlockSize; Index < Last; Index++)
+			{
+				const uint32_t Object = this->Order[Index];
+				this->SortedMin[A][Index] = this->Min[A][Object];
+				this->SortedMax[A][Index] = this->Max[A][Object];
+				this->SortedMin[B][Index] = this->Min[B][Object];
+				this->SortedMax[B][Index] = this->Max[B][Object];
+				this->SortedMin[C][Index] = this->Min[C][Object];
+				this->SortedMax[C][Index] = this->Max[C][Object];
+			}
+		});
+
+		this->BlockPair.resize(BlockCount);
+
+		ForEachBlock(BlockCount, Pool, [&](size_t Block)
+		{
+			std::vector<BROADPHASE_PAIR_STRUCT>& Output = this->BlockPair[Block];
+			Output.clear();
+
+			const float* const MinA = this->SortedMin[A].data();
+			const float* const MinB = this->SortedMin[B].data();
+			const float* const MaxB = this->SortedMax[B].data();
+			const float* const MinC = this->SortedMin[C].data();
+			const float* const MaxC = this->SortedMax[C].data();
+			const uint32_t* const Order = this->Order.data();
+
+			const size_t Last = (std::min)((Block + 1) * SweepBlockSize, Count);
+			for (size_t Index = Block * SweepBlockSize; Index < Last; Index++)
+			{
+				const float End = this->SortedMax[A][Index];
+				size_t Other = Index + 1;
+				bool Open = true;
+
+#if defined(__AVX2__)
+				const __m256 EndA = _mm256_set1_ps(End);
+				const __m256 LowB = _mm256_set1_ps(MinB[Index]);
+				const __m256 HighB = _mm256_set1_ps(MaxB[Index]);
+				const __m256 LowC = _mm256_set1_ps(MinC[Index]);
+				const __m256 HighC = _mm256_set1_ps(MaxC[Index]);
+
+				for (; Open && Other + 8 <= Count; Other += 8)
+				{
+					const __m256 Inside = _mm256_cmp_ps(_mm256_loadu_ps(MinA + Other), EndA, _CMP_LE_OQ);
+					__m256 Hit = _mm256_and_ps(Inside, _mm256_cmp_ps(_mm256_loadu_ps(MinB + Other), HighB, _CMP_LE_OQ));
+					Hit = _mm256_and_ps(Hit, _mm256_cmp_ps(_mm256_loadu_ps(MaxB + Other), LowB, _CMP_GE_OQ));
+					Hit = _mm256_and_ps(Hit, _mm256_cmp_ps(_mm256_loadu_ps(MinC + Other), HighC, _CMP_LE_OQ));
+					Hit = _mm256_and_ps(Hit, _mm256_cmp_ps(_mm256_loadu_ps(MaxC + Other), LowC, _CMP_GE_OQ));
+
+					const int Mask = _mm256_movemask_ps(Hit);
+					for (uint32_t Lane = 0; Mask >> Lane; Lane++)
+					{
+						if (Mask & (1 << Lane))
+						{
+							Output.push_back(MakePair(Order[Index], Order[Other + Lane]));
+						}
+					}
+					Open = _mm256_movemask_ps(Inside) == 0xFF;
+				}
+#else
+				const __m128 EndA = _mm_set1_ps(End);
+				const __m128 LowB = _mm_set1_ps(MinB[Index]);
+				const __m128 HighB = _mm_set1_ps(MaxB[Index]);
+				const __m128 LowC = _mm_set1_ps(MinC[Index]);
+				const __m128 HighC = _mm_set1_ps(MaxC[Index]);
+
+				for (; Open && Other + 4 <= Count; Other += 4)
+				{
+					const __m128 Inside = _mm_cmple_ps(_mm_loadu_ps(MinA + Other), EndA);
+					__m128 Hit = _mm_and_ps(Inside, _mm_cmple_ps(_mm_loadu_ps(MinB + Other), HighB));
+					Hit = _mm_and_ps(Hit, _mm_cmpge_ps(_mm_loadu_ps(MaxB + Other), LowB));
+					Hit = _mm_and_ps(Hit, _mm_cmple_ps(_mm_loadu_ps(MinC + Other), HighC));
+					Hit = _mm_and_ps(Hit, _mm_cmpge_ps(_mm_loadu_ps(MaxC + Other), LowC));
+
+					const int Mask = _mm_movemask_ps(Hit);
+					for (uint32_t Lane = 0; Mask >> Lane; Lane++)
+					{
+						if (Mask & (1 << Lane))
+						{
+							Output.push_back(MakePair(Order[Index], Order[Other + Lane]));
+						}
+					}
+					Open = _mm_movemask_ps(Inside) == 0xF;
+				}
+#endif
+
+				for (; Open && Other < Count && MinA[Other] <= End; Other++)
+				{
+					if (MinB[Other] <= MaxB[Index] && MaxB[Other] >= MinB[Index] && MinC[Other] <= MaxC[Index] && MaxC[Other] >= MinC[Index])
+					{
+						Output.push_back(MakePair(Order[Index], Order[Other]));
+					}
+				}
+			}
+		});
+
+		return this->Gather(Pair);
+	}
+
+	uint32_t SweepAndPrune::GetAxis() const
+	{
+		return this->Axis;
+	}
+
+
+
+	SpatialHash::SpatialHash(float CellSize) : CellSize(CellSize), Automatic(CellSize <= 0.0f)
+	{
+	}
+
+	void SpatialHash::Build(const BOUNDING_BOX_STRUCT* Box, size_t Count)
+	{
+		Broadphase::Build(Box, Count);
+
+		if (this->Automatic)
+		{
+			double Size = 0.0;
+			for (size_t Object = 0; Object < Count; Object++)
+			{
+				Size += 2.0f * (std::max)((std::max)(Box[Object].Extent[0], Box[Object].Extent[1]), Box[Object].Extent[2]);
+			}
+			this->CellSize = Count && Size > 0.0 ? static_cast<float>(2.0 * Size / Count) : 1.0f;
+		}
+		this->InverseCellSize = 1.0f / this->CellSize;
+
+		this->Cell.clear();
+		this->FreeCell.clear();
+		this->SlotKey.assign(MinimumSlotCount, EmptySlot);
+		this->SlotCell.assign(MinimumSlotCount, 0);
+		this->SlotCount = 0;
+		this->Range.resize(Count * 6);
+
+		for (uint32_t Object = 0; Object < Count; Object++)
+		{
+			this->ComputeRange(Object, &this->Range[Object * 6]);
+			this->InsertObject(Object, &this->Range[Object * 6]);
+		}
+	}
+
+	void SpatialHash::Update(uint32_t Object, const BOUNDING_BOX_STRUCT& Box)
+	{
+		Broadphase::Update(Object, Box);
+
+		int32_t* const Current = &this->Range[Object * 6];
+		int32_t Next[6];
+		this->ComputeRange(Object, Next);
+
+		if (!std::equal(Next, Next + 6, Current))
+		{
+			this->RemoveObject(Object, Current);
+			std::copy(Next, Next + 6, Current);
+			this->InsertObject(Object, Current);
+		}
+	}
+
+	size_t SpatialHash::FindPairs(std::vector<BROADPHASE_PAIR_STRUCT>& Pair, ThreadPool* Pool)
+	{
+		const size_t BlockCount = (this->Cell.size() + CellBlockSize - 1) / CellBlockSize;
+		this->BlockPair.resize(BlockCount);
+
+		ForEachBlock(BlockCount, Pool, [&](size_t Block)
+		{
+			std::vector<BROADPHASE_PAIR_STRUCT>& Output = this->BlockPair[Block];
+			Output.clear();
+
+			const size_t Last = (std::min)((Block + 1) * CellBlockSize, this->Cell.size());
+			for (size_t Index = Block * CellBlockSize; Index < Last; Index++)
+			{
+				const CELL_STRUCT& Current = this->Cell[Index];
+
+				for (size_t First = 0; First < Current.Object.size(); First++)
+				{
+					const uint32_t Object = Current.Object[First];
+					const int32_t* const RangeFirst = &this->Range[Object * 6];
+
+					for (size_t Second = First + 1; Second < Current.Object.size(); Second++)
+					{
+						const uint32_t Other = Current.Object[Second];
+						const int32_t* const RangeSecond = &this->Range[Other * 6];
+
+						if ((std::max)(RangeFirst[0], RangeSecond[0]) == Current.Coordinate[0] &&
+							(std::max)(RangeFirst[1], RangeSecond[1]) == Current.Coordinate[1] &&
+							(std::max)(RangeFirst[2], RangeSecond[2]) == Current.Coordinate[2] &&
+							this->Overlap(Object, Other))
+						{
+							Output.push_back(MakePair(Object, Other));
+						}
+					}
+				}
+			}
+		});
+
+		return this->Gather(Pair);
+	}
+
+	float SpatialHash::GetCellSize() const
+	{
+		return this->CellSize;
+	}
+
+	size_t SpatialHash::GetCellCount() const
+	{
+		return this->SlotCount;
+	}
+
+	void SpatialHash::ComputeRange(uint32_t Object, int32_t* Range) const
+	{
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			const float Low = std::floor(this->Min[Axis][Object] * this->InverseCellSize);
+			const float High = std::floor(this->Max[Axis][Object] * this->InverseCellSize);
+			Range[Axis] = static_cast<int32_t>((std::min)((std::max)(Low, static_cast<float>(-CellLimit)), static_cast<float>(CellLimit)));
+			Range[Axis + 3] = static_cast<int32_t>((std::min)((std::max)(High, static_cast<float>(-CellLimit)), static_cast<float>(CellLimit)));
+		}
+	}
+
+	void SpatialHash::InsertObject(uint32_t Object, const int32_t* Range)
+	{
+		for (int32_t X = Range[0]; X <= Range[3]; X++)
+		{
+			for (int32_t Y = Range[1]; Y <= Range[4]; Y++)
+			{
+				for (int32_t Z = Range[2]; Z <= Range[5]; Z++)
+				{
+					const uint64_t Key = MakeCellKey(X, Y, Z);
+					size_t Slot = this->FindSlot(Key);
+
+					if (this->SlotKey[Slot] == EmptySlot)
+					{
+						if ((this->SlotCount + 1) * 2 > this->SlotKey.size())
+						{
+							this->Grow();
+							Slot = this->FindSlot(Key);
+						}
+
+						uint32_t Index;
+						if (this->FreeCell.empty())
+						{
+							Index = static_cast<uint32_t>(this->Cell.size());
+							this->Cell.emplace_back();
+						}
+						else
+						{
+							Index = this->FreeCell.back();
+							this->FreeCell.pop_back();
+						}
+
+						CELL_STRUCT& Created = this->Cell[Index];
+						Created.Coordinate[0] = X;
+						Created.Coordinate[1] = Y;
+						Created.Coordinate[2] = Z;
+
+						this->SlotKey[Slot] = Key;
+						this->SlotCell[Slot] = Index;
+						this->SlotCount++;
+					}
+
+					this->Cell[this->SlotCell[Slot]].Object.push_back(Object);
+				}
+			}
+		}
+	}
+
+	void SpatialHash::RemoveObject(uint32_t Object, const int32_t* Range)
+	{
+		for (int32_t X = Range[0]; X <= Range[3]; X++)
+		{
+			for (int32_t Y = Range[1]; Y <= Range[4]; Y++)
+			{
+				for (int32_t Z = Range[2]; Z <= Range[5]; Z++)
+				{
+					const size_t Slot = this->FindSlot(MakeCellKey(X, Y, Z));
+					if (this->SlotKey[Slot] == EmptySlot)
+					{
+						continue;
+					}
+
+					std::vector<uint32_t>& List = this->Cell[this->SlotCell[Slot]].Object;
+					const auto Position = std::find(List.begin(), List.end(), Object);
+					if (Position != List.end())
+					{
+						*Position = List.back();
+						List.pop_back();
+					}
+
+					if (List.empty())
+					{
+						this->FreeCell.push_back(this->SlotCell[Slot]);
+						this->ReleaseSlot(Slot);
+					}
+				}
+			}
+		}
+	}
+
+	size_t SpatialHash::FindSlot(uint64_t Key) const
+	{
+		const size_t Mask = this->SlotKey.size() - 1;
+		size_t Slot = HashCellKey(Key, Mask);
+
+		while (this->SlotKey[Slot] != Key && this->SlotKey[Slot] != EmptySlot)
+		{
+			Slot = (Slot + 1) & Mask;
+		}
+		return Slot;
+	}
+
+	// Backward shift deletion keeps every probe sequence free of holes.
+	void SpatialHash::ReleaseSlot(size_t Slot)
+	{
+		const size_t Mask = this->SlotKey.size() - 1;
+		size_t Hole = Slot;
+
+		for (size_t Next = (Hole + 1) & Mask; this->SlotKey[Next] != EmptySlot; Next = (Next + 1) & Mask)
+		{
+			const size_t Home = HashCellKey(this->SlotKey[Next], Mask);
+			if (((Next - Home) & Mask) >= ((Next - Hole) & Mask))
+			{
+				this->SlotKey[Hole] = this->SlotKey[Next];
+				this->SlotCell[Hole] = this->SlotCell[Next];
+				Hole = Next;
+			}
+		}
+
+		this->SlotKey[Hole] = EmptySlot;
+		this->SlotCount--;
+	}
+
+	void SpatialHash::Grow()
+	{
+		std::vector<uint64_t> Key(this->SlotKey.size() * 2, EmptySlot);
+		std::vector<uint32_t> Index(Key.size(), 0);
+		Key.swap(this->SlotKey);
+		Index.swap(this->SlotCell);
+
+		for (size_t Slot = 0; Slot < Key.size(); Slot++)
+		{
+			if (Key[Slot] != EmptySlot)
+			{
+				const size_t Target = this->FindSlot(Key[Slot]);
+				this->SlotKey[Target] = Key[Slot];
+				this->SlotCell[Target] = Index[Slot];
+			}
+		}
+	}
+}
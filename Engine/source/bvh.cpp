@@ -0,0 +1,982 @@
+﻿#include "include/bvh.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <immintrin.h>
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr uint32_t LeafBit = 0x80000000;
+		constexpr uint32_t ReleasedWide = 0xFFFFFFFE;
+		constexpr size_t BinCount = 16;
+
+		float GetArea(const float* Min, const float* Max)
+		{
+			const float X = Max[0] - Min[0];
+			const float Y = Max[1] - Min[1];
+			const float Z = Max[2] - Min[2];
+			return X * Y + Y * Z + Z * X;
+		}
+
+		float GetUnionArea(const float* MinA, const float* MaxA, const float* MinB, const float* MaxB)
+		{
+			float Min[3];
+			float Max[3];
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				Min[Axis] = std::min(MinA[Axis], MinB[Axis]);
+				Max[Axis] = std::max(MaxA[Axis], MaxB[Axis]);
+			}
+			return GetArea(Min, Max);
+		}
+
+		struct BIN_STRUCT
+		{
+			float Min[3];
+			float Max[3];
+			size_t Count;
+		};
+	}
+
+
+
+	struct SceneBVH::BUILD_STRUCT
+	{
+		float Min[3];
+		float Max[3];
+		float Centroid[3];
+		uint32_t Object;
+	};
+
+
+
+	void SceneBVH::Build(const BOUNDING_BOX_STRUCT* Box, size_t Count)
+	{
+		this->Clear();
+
+		this->Node.reserve(Count * 2);
+		this->Leaf.resize(Count);
+
+		std::vector<BUILD_STRUCT> Record(Count);
+		for (size_t Index = 0; Index < Count; Index++)
+		{
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				Record[Index].Min[Axis] = Box[Index].Center[Axis] - Box[Index].Extent[Axis];
+				Record[Index].Max[Axis] = Box[Index].Center[Axis] + Box[Index].Extent[Axis];
+				Record[Index].Centroid[Axis] = Box[Index].Center[Axis];
+			}
+			Record[Index].Object = static_cast<uint32_t>(Index);
+		}
+
+		if (Count > 0)
+		{
+			this->Root = this->BuildRange(Record.data(), Count, Invalid);
+		}
+		this->ObjectCount = Count;
+	}
+
+	uint32_t SceneBVH::Insert(const BOUNDING_BOX_STRUCT& Box)
+	{
+		uint32_t Object = static_cast<uint32_t>(this->Leaf.size());
+		if (!this->FreeObject.empty())
+		{
+			Object = this->FreeObject.back();
+			this->FreeObject.pop_back();
+		}
+		else
+		{
+			this->Leaf.push_back(Invalid);
+		}
+
+		const uint32_t Leaf = this->AllocateNode();
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			this->Node[Leaf].Min[Axis] = Box.Center[Axis] - Box.Extent[Axis];
+			this->Node[Leaf].Max[Axis] = Box.Center[Axis] + Box.Extent[Axis];
+		}
+		this->Node[Leaf].Object = Object;
+		this->Leaf[Object] = Leaf;
+
+		this->InsertLeaf(Leaf);
+		this->ObjectCount++;
+		this->StructureDirty = true;
+		return Object;
+	}
+
+	void SceneBVH::Remove(uint32_t Object)
+	{
+		if (Object >= this->Leaf.size() || this->Leaf[Object] == Invalid)
+		{
+			return;
+		}
+
+		const uint32_t Leaf = this->Leaf[Object];
+		this->RemoveLeaf(Leaf);
+		this->FreeNode(Leaf);
+
+		this->Leaf[Object] = Invalid;
+		this->FreeObject.push_back(Object);
+		this->ObjectCount--;
+		this->StructureDirty = true;
+	}
+
+	void SceneBVH::Update(uint32_t Object, const BOUNDING_BOX_STRUCT& Box)
+	{
+		if (Object >= this->Leaf.size() || this->Leaf[Object] == Invalid)
+		{
+			return;
+		}
+
+		const uint32_t Leaf = this->Leaf[Object];
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			this->Node[Leaf].Min[Axis] = Box.Center[Axis] - Box.Extent[Axis];
+			this->Node[Leaf].Max[Axis] = Box.Center[Axis] + Box.Extent[Axis];
+		}
+
+		for (uint32_t Index = this->Node[Leaf].Parent; Index != Invalid && !this->Node[Index].Dirty; Index = this->Node[Index].Parent)
+		{
+			this->Node[Index].Dirty = true;
+		}
+	}
+
+	void SceneBVH::Refit()
+	{
+		if (this->Root != Invalid)
+		{
+			this->RefitNode(this->Root);
+		}
+	}
+
+	void SceneBVH::Clear()
+	{
+		this->Node.clear();
+		this->FreeList.clear();
+		this->Leaf.clear();
+		this->FreeObject.clear();
+		this->Wide.clear();
+		this->WideParent.clear();
+		this->FreeWide.clear();
+		this->Rotated.clear();
+		this->Root = Invalid;
+		this->ObjectCount = 0;
+		this->StructureDirty = true;
+	}
+
+	size_t SceneBVH::QueryFrustum(const FRUSTUM_STRUCT& Frustum, std::vector<uint32_t>& Result)
+	{
+		Result.clear();
+		if (!this->Prepare())
+		{
+			return 0;
+		}
+
+		__m128 Plane[6][4];
+		__m128 PlaneAbs[6][3];
+		for (size_t Index = 0; Index < 6; Index++)
+		{
+			for (size_t Axis = 0; Axis < 4; Axis++)
+			{
+				Plane[Index][Axis] = _mm_set1_ps(Frustum.Plane[Index][Axis]);
+			}
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				PlaneAbs[Index][Axis] = _mm_set1_ps(std::fabs(Frustum.Plane[Index][Axis]));
+			}
+		}
+
+		const __m128 Half = _mm_set1_ps(0.5f);
+		std::vector<uint32_t>& Stack = this->Stack;
+		Stack.assign(1, 0);
+
+		while (!Stack.empty())
+		{
+			const WIDE_NODE_STRUCT& Wide = this->Wide[Stack.back()];
+			Stack.pop_back();
+
+			const __m128 MinX = _mm_load_ps(Wide.MinX);
+			const __m128 MinY = _mm_load_ps(Wide.MinY);
+			const __m128 MinZ = _mm_load_ps(Wide.MinZ);
+			const __m128 MaxX = _mm_load_ps(Wide.MaxX);
+			const __m128 MaxY = _mm_load_ps(Wide.MaxY);
+			const __m128 MaxZ = _mm_load_ps(Wide.MaxZ);
+
+			const __m128 CenterX = _mm_mul_ps(_mm_add_ps(MinX, MaxX), Half);
+			const __m128 CenterY = _mm_mul_ps(_mm_add_ps(MinY, MaxY), Half);
+			const __m128 CenterZ = _mm_mul_ps(_mm_add_ps(MinZ, MaxZ), Half);
+			const __m128 ExtentX = _mm_mul_ps(_mm_sub_ps(MaxX, MinX), Half);
+			const __m128 ExtentY = _mm_mul_ps(_mm_sub_ps(MaxY, MinY), Half);
+			const __m128 ExtentZ = _mm_mul_ps(_mm_sub_ps(MaxZ, MinZ), Half);
+
+			__m128 Outside = _mm_setzero_ps();
+			__m128 Straddle = _mm_setzero_ps();
+			for (size_t Index = 0; Index < 6; Index++)
+			{
+				const __m128 Distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(CenterX, Plane[Index][0]), _mm_mul_ps(CenterY, Plane[Index][1])),
+					_mm_add_ps(_mm_mul_ps(CenterZ, Plane[Index][2]), Plane[Index][3]));
+				const __m128 Radius = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(ExtentX, PlaneAbs[Index][0]), _mm_mul_ps(ExtentY, PlaneAbs[Index][1])),
+					_mm_mul_ps(ExtentZ, PlaneAbs[Index][2]));
+				Outside = _mm_or_ps(Outside, _mm_cmplt_ps(_mm_add_ps(Distance, Radius), _mm_setzero_ps()));
+				Straddle = _mm_or_ps(Straddle, _mm_cmplt_ps(_mm_sub_ps(Distance, Radius), _mm_setzero_ps()));
+			}
+
+			const int Valid = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(Wide.Child)), _mm_set1_epi32(-1)))) ^ 0xF;
+			const int Visible = ~_mm_movemask_ps(Outside) & Valid;
+			const int Partial = _mm_movemask_ps(Straddle);
+
+			for (int Slot = 0; Slot < 4; Slot++)
+			{
+				if (!(Visible & (1 << Slot)))
+				{
+					continue;
+				}
+
+				const uint32_t Child = Wide.Child[Slot];
+				if (Child & LeafBit)
+				{
+					Result.push_back(Child & ~LeafBit);
+				}
+				else if (Partial & (1 << Slot))
+				{
+					Stack.push_back(Child);
+				}
+				else
+				{
+					this->CollectWide(Child, Result);
+				}
+			}
+		}
+
+		return Result.size();
+	}
+
+	size_t SceneBVH::QueryBox(const BOUNDING_BOX_STRUCT& Box, std::vector<uint32_t>& Result)
+	{
+		Result.clear();
+		if (!this->Prepare())
+		{
+			return 0;
+		}
+
+		const __m128 QueryMinX = _mm_set1_ps(Box.Center[0] - Box.Extent[0]);
+		const __m128 QueryMinY = _mm_set1_ps(Box.Center[1] - Box.Extent[1]);
+		const __m128 QueryMinZ = _mm_set1_ps(Box.Center[2] - Box.Extent[2]);
+		const __m128 QueryMaxX = _mm_set1_ps(Box.Center[0] + Box.Extent[0]);
+		const __m128 QueryMaxY = _mm_set1_ps(Box.Center[1] + Box.Extent[1]);
+		const __m128 QueryMaxZ = _mm_set1_ps(Box.Center[2] + Box.Extent[2]);
+
+		std::vector<uint32_t>& Stack = this->Stack;
+		Stack.assign(1, 0);
+
+		while (!Stack.empty())
+		{
+			const WIDE_NODE_STRUCT& Wide = this->Wide[Stack.back()];
+			Stack.pop_back();
+
+			__m128 Overlap = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(Wide.MinX), QueryMaxX), _mm_cmpge_ps(_mm_load_ps(Wide.MaxX), QueryMinX));
+			Overlap = _mm_and_ps(Overlap, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(Wide.MinY), QueryMaxY), _mm_cmpge_ps(_mm_load_ps(Wide.MaxY), QueryMinY)));
+			Overlap = _mm_and_ps(Overlap, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(Wide.MinZ), QueryMaxZ), _mm_cmpge_ps(_mm_load_ps(Wide.MaxZ), QueryMinZ)));
+
+			const int Mask = _mm_movemask_ps(Overlap);
+			for (int Slot = 0; Slot < 4; Slot++)
+			{
+				const uint32_t Child = Wide.Child[Slot];
+				if (!(Mask & (1 << Slot)) || Child == Invalid)
+				{
+					continue;
+				}
+
+				if (Child & LeafBit)
+				{
+					Result.push_back(Child & ~LeafBit);
+				}
+				else
+				{
+					Stack.push_back(Child);
+				}
+			}
+		}
+
+		return Result.size();
+	}
+
+	bool SceneBVH::Raycast(const float* Origin, const float* Direction, float MaxDistance, BVH_RAY_HIT_STRUCT& Hit, const std::function<float(uint32_t Object)>& Intersect)
+	{
+		Hit.Object = Invalid;
+		Hit.Distance = MaxDistance;
+		if (!this->Prepare())
+		{
+			return false;
+		}
+
+		__m128 RayOrigin[3];
+		__m128 RayInverse[3];
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			const float Component = std::fabs(Direction[Axis]) > 1e-20f ? Direction[Axis] : std::copysign(1e-20f, Direction[Axis]);
+			RayOrigin[Axis] = _mm_set1_ps(Origin[Axis]);
+			RayInverse[Axis] = _mm_set1_ps(1.0f / Component);
+		}
+
+		struct ENTRY_STRUCT
+		{
+			uint32_t Node;
+			float Distance;
+		};
+
+		std::vector<ENTRY_STRUCT> Stack(1, { 0, 0.0f });
+
+		while (!Stack.empty())
+		{
+			const ENTRY_STRUCT Entry = Stack.back();
+			Stack.pop_back();
+			if (Entry.Distance > Hit.Distance)
+			{
+				continue;
+			}
+
+			const WIDE_NODE_STRUCT& Wide = this->Wide[Entry.Node];
+
+			const __m128 NearX = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(Wide.MinX), RayOrigin[0]), RayInverse[0]);
+			const __m128 FarX = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(Wide.MaxX), RayOrigin[0]), RayInverse[0]);
+			const __m128 NearY = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(Wide.MinY), RayOrigin[1]), RayInverse[1]);
+			const __m128 FarY = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(Wide.MaxY), RayOrigin[1]), RayInverse[1]);
+			const __m128 NearZ = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(Wide.MinZ), RayOrigin[2]), RayInverse[2]);
+			const __m128 FarZ = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(Wide.MaxZ), RayOrigin[2]), RayInverse[2]);
+
+			const __m128 Enter = _mm_max_ps(_mm_max_ps(_mm_min_ps(NearX, FarX), _mm_min_ps(NearY, FarY)), _mm_max_ps(_mm_min_ps(NearZ, FarZ), _mm_setzero_ps()));
+			const __m128 Exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(NearX, FarX), _mm_max_ps(NearY, FarY)), _mm_min_ps(_mm_max_ps(NearZ, FarZ), _mm_set1_ps(Hit.Distance)));
+
+			alignas(16) float Distance[4];
+			_mm_store_ps(Distance, Enter);
+			const int Mask = _mm_movemask_ps(_mm_cmple_ps(Enter, Exit));
+
+			ENTRY_STRUCT Child[4];
+			size_t ChildCount = 0;
+			for (int Slot = 0; Slot < 4; Slot++)
+			{
+				if (!(Mask & (1 << Slot)) || Wide.Child[Slot] == Invalid)
+				{
+					continue;
+				}
+
+				if (Wide.Child[Slot] & LeafBit)
+				{
+					const uint32_t Object = Wide.Child[Slot] & ~LeafBit;
+					const float ObjectDistance = Intersect ? Intersect(Object) : Distance[Slot];
+					if (ObjectDistance >= 0.0f && ObjectDistance < Hit.Distance)
+					{
+						Hit.Object = Object;
+						Hit.Distance = ObjectDistance;
+					}
+				}
+				else
+				{
+					Child[ChildCount++] = { Wide.Child[Slot], Distance[Slot] };
+				}
+			}
+
+			for (size_t Index = 1; Index < ChildCount; Index++)
+			{
+				const ENTRY_STRUCT Current = Child[Index];
+				size_t Position = Index;
+				for (; Position > 0 && Child[Position - 1].Distance < Current.Distance; Position--)
+				{
+					Child[Position] = Child[Position - 1];
+				}
+				Child[Position] = Current;
+			}
+			Stack.insert(Stack.end(), Child, Child + ChildCount);
+		}
+
+		return Hit.Object != Invalid;
+	}
+
+	size_t SceneBVH::GetObjectCount() const
+	{
+		return this->ObjectCount;
+	}
+
+	float SceneBVH::GetCost() const
+	{
+		if (this->Root == Invalid)
+		{
+			return 0.0f;
+		}
+
+		float Cost = 0.0f;
+		for (uint32_t Index = 0; Index < this->Node.size(); Index++)
+		{
+			const NODE_STRUCT& Node = this->Node[Index];
+			if (Node.Object == Invalid && Node.Child[0] != Invalid)
+			{
+				Cost += GetArea(Node.Min, Node.Max);
+			}
+		}
+		return Cost / std::max(GetArea(this->Node[this->Root].Min, this->Node[this->Root].Max), FLT_MIN);
+	}
+
+
+
+	uint32_t SceneBVH::AllocateNode()
+	{
+		uint32_t Index = static_cast<uint32_t>(this->Node.size());
+		if (!this->FreeList.empty())
+		{
+			Index = this->FreeList.back();
+			this->FreeList.pop_back();
+		}
+		else
+		{
+			this->Node.emplace_back();
+		}
+
+		NODE_STRUCT& Node = this->Node[Index];
+		Node.Parent = Invalid;
+		Node.Child[0] = Invalid;
+		Node.Child[1] = Invalid;
+		Node.Object = Invalid;
+		Node.Wide = Invalid;
+		Node.Slot = Invalid;
+		Node.Dirty = false;
+		return Index;
+	}
+
+	void SceneBVH::FreeNode(uint32_t Node)
+	{
+		this->Node[Node].Parent = Invalid;
+		this->Node[Node].Child[0] = Invalid;
+		this->Node[Node].Child[1] = Invalid;
+		this->Node[Node].Object = Invalid;
+		this->FreeList.push_back(Node);
+	}
+
+	uint32_t SceneBVH::BuildRange(BUILD_STRUCT* Record, size_t Count, uint32_t Parent)
+	{
+		const uint32_t Index = this->AllocateNode();
+		this->Node[Index].Parent = Parent;
+
+		if (Count == 1)
+		{
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				this->Node[Index].Min[Axis] = Record->Min[Axis];
+				this->Node[Index].Max[Axis] = Record->Max[Axis];
+			}
+			this->Node[Index].Object = Record->Object;
+			this->Leaf[Record->Object] = Index;
+			return Index;
+		}
+
+		float CentroidMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float CentroidMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (size_t Entry = 0; Entry < Count; Entry++)
+		{
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				CentroidMin[Axis] = std::min(CentroidMin[Axis], Record[Entry].Centroid[Axis]);
+				CentroidMax[Axis] = std::max(CentroidMax[Axis], Record[Entry].Centroid[Axis]);
+			}
+		}
+
+		size_t Axis = 0;
+		for (size_t Component = 1; Component < 3; Component++)
+		{
+			if (CentroidMax[Component] - CentroidMin[Component] > CentroidMax[Axis] - CentroidMin[Axis])
+			{
+				Axis = Component;
+			}
+		}
+
+		size_t Split = 0;
+		const float Length = CentroidMax[Axis] - CentroidMin[Axis];
+
+		if (Length > 0.0f)
+		{
+			BIN_STRUCT Bin[BinCount];
+			for (BIN_STRUCT& Entry : Bin)
+			{
+				Entry = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX }, 0 };
+			}
+
+			const float Scale = BinCount / Length;
+			auto GetBin = [&](const BUILD_STRUCT& Entry)
+			{
+				return std::min(static_cast<size_t>((Entry.Centroid[Axis] - CentroidMin[Axis]) * Scale), BinCount - 1);
+			};
+
+			for (size_t Entry = 0; Entry < Count; Entry++)
+			{
+				BIN_STRUCT& Target = Bin[GetBin(Record[Entry])];
+				for (size_t Component = 0; Component < 3; Component++)
+				{
+					Target.Min[Component] = std::min(Target.Min[Component], Record[Entry].Min[Component]);
+					Target.Max[Component] = std::max(Target.Max[Component], Record[Entry].Max[Component]);
+				}
+				Target.Count++;
+			}
+
+			float RightArea[BinCount];
+			size_t RightCount[BinCount];
+			BIN_STRUCT Accumulate = Bin[BinCount - 1];
+			for (size_t Entry = BinCount - 1; Entry > 0; Entry--)
+			{
+				for (size_t Component = 0; Component < 3; Component++)
+				{
+					Accumulate.Min[Component] = std::min(Accumulate.Min[Component], Bin[Entry].Min[Component]);
+					Accumulate.Max[Component] = std::max(Accumulate.Max[Component], Bin[Entry].Max[Component]);
+				}
+				RightCount[Entry] = (Entry == BinCount - 1 ? 0 : RightCount[Entry + 1]) + Bin[Entry].Count;
+				RightArea[Entry] = RightCount[Entry] > 0 ? GetArea(Accumulate.Min, Accumulate.Max) : 0.0f;
+			}
+
+			float BestCost = FLT_MAX;
+			size_t BestBin = 0;
+			size_t LeftCount = 0;
+			Accumulate = Bin[0];
+			for (size_t Entry = 0; Entry + 1 < BinCount; Entry++)
+			{
+				for (size_t Component = 0; Component < 3; Component++)
+				{
+					Accumulate.Min[Component] = std::min(Accumulate.Min[Component], Bin[Entry].Min[Component]);
+					Accumulate.Max[Component] = std::max(Accumulate.Max[Component], Bin[Entry].Max[Component]);
+				}
+				LeftCount += Bin[Entry].Count;
+
+				if (LeftCount == 0 || RightCount[Entry + 1] == 0)
+				{
+					continue;
+				}
+
+				const float Cost = GetArea(Accumulate.Min, Accumulate.Max) * LeftCount + RightArea[Entry + 1] * RightCount[Entry + 1];
+				if (Cost < BestCost)
+				{
+					BestCost = Cost;
+					BestBin = Entry;
+				}
+			}
+
+			if (BestCost < FLT_MAX)
+			{
+				Split = std::partition(Record, Record + Count, [&](const BUILD_STRUCT& Entry) { return GetBin(Entry) <= BestBin; }) - Record;
+			}
+		}
+
+		if (Split == 0 || Split == Count)
+		{
+			Split = Count / 2;
+			std::nth_element(Record, Record + Split, Record + Count, [&](const BUILD_STRUCT& A, const BUILD_STRUCT& B) { return A.Centroid[Axis] < B.Centroid[Axis]; });
+		}
+
+		const uint32_t Left = this->BuildRange(Record, Split, Index);
+		const uint32_t Right = this->BuildRange(Record + Split, Count - Split, Index);
+		this->Node[Index].Child[0] = Left;
+		this->Node[Index].Child[1] = Right;
+		this->Combine(Index);
+		return Index;
+	}
+
+	void SceneBVH::InsertLeaf(uint32_t Leaf)
+	{
+		if (this->Root == Invalid)
+		{
+			this->Root = Leaf;
+			this->Node[Leaf].Parent = Invalid;
+			return;
+		}
+
+		const float* LeafMin = this->Node[Leaf].Min;
+		const float* LeafMax = this->Node[Leaf].Max;
+
+		uint32_t Sibling = this->Root;
+		while (this->Node[Sibling].Object == Invalid)
+		{
+			const NODE_STRUCT& Current = this->Node[Sibling];
+			const float Area = GetArea(Current.Min, Current.Max);
+			const float CombinedArea = GetUnionArea(Current.Min, Current.Max, LeafMin, LeafMax);
+
+			const float Cost = 2.0f * CombinedArea;
+			const float Inheritance = 2.0f * (CombinedArea - Area);
+
+			float ChildCost[2];
+			for (size_t Index = 0; Index < 2; Index++)
+			{
+				const NODE_STRUCT& Child = this->Node[Current.Child[Index]];
+				ChildCost[Index] = GetUnionArea(Child.Min, Child.Max, LeafMin, LeafMax) + Inheritance;
+				if (Child.Object == Invalid)
+				{
+					ChildCost[Index] -= GetArea(Child.Min, Child.Max);
+				}
+			}
+
+			if (Cost < ChildCost[0] && Cost < ChildCost[1])
+			{
+				break;
+			}
+			Sibling = Current.Child[ChildCost[0] < ChildCost[1] ? 0 : 1];
+		}
+
+		const uint32_t OldParent = this->Node[Sibling].Parent;
+		const uint32_t NewParent = this->AllocateNode();
+		this->Node[NewParent].Parent = OldParent;
+		this->Node[NewParent].Child[0] = Sibling;
+		this->Node[NewParent].Child[1] = Leaf;
+		this->Node[NewParent].Dirty = this->Node[Sibling].Dirty;
+		this->Node[Sibling].Parent = NewParent;
+		this->Node[Leaf].Parent = NewParent;
+
+		if (OldParent == Invalid)
+		{
+			this->Root = NewParent;
+		}
+		else
+		{
+			NODE_STRUCT& Parent = this->Node[OldParent];
+			Parent.Child[Parent.Child[0] == Sibling ? 0 : 1] = NewParent;
+		}
+
+		this->RefitUpward(NewParent);
+	}
+
+	void SceneBVH::RemoveLeaf(uint32_t Leaf)
+	{
+		if (Leaf == this->Root)
+		{
+			this->Root = Invalid;
+			return;
+		}
+
+		const uint32_t Parent = this->Node[Leaf].Parent;
+		const uint32_t GrandParent = this->Node[Parent].Parent;
+		const uint32_t Sibling = this->Node[Parent].Child[this->Node[Parent].Child[0] == Leaf ? 1 : 0];
+
+		this->Node[Sibling].Parent = GrandParent;
+		this->FreeNode(Parent);
+
+		if (GrandParent == Invalid)
+		{
+			this->Root = Sibling;
+			return;
+		}
+
+		NODE_STRUCT& Node = this->Node[GrandParent];
+		Node.Child[Node.Child[0] == Parent ? 0 : 1] = Sibling;
+		this->RefitUpward(GrandParent);
+	}
+
+	void SceneBVH::RefitUpward(uint32_t Node)
+	{
+		for (; Node != Invalid; Node = this->Node[Node].Parent)
+		{
+			this->Combine(Node);
+			this->Rotate(Node);
+		}
+	}
+
+	void SceneBVH::RefitNode(uint32_t Node)
+	{
+		NODE_STRUCT& Current = this->Node[Node];
+		if (Current.Object != Invalid || !Current.Dirty)
+		{
+			return;
+		}
+
+		this->RefitNode(Current.Child[0]);
+		this->RefitNode(Current.Child[1]);
+
+		this->Combine(Node);
+		this->Node[Node].Dirty = false;
+		if (this->Rotate(Node))
+		{
+			this->Rotated.push_back(Node);
+		}
+
+		this->StoreWide(this->Node[Node].Child[0]);
+		this->StoreWide(this->Node[Node].Child[1]);
+	}
+
+	bool SceneBVH::Rotate(uint32_t Node)
+	{
+		const NODE_STRUCT& Current = this->Node[Node];
+
+		float BestGain = 0.0f;
+		uint32_t BestSide = Invalid;
+		uint32_t BestGrandChild = Invalid;
+
+		for (uint32_t Side = 0; Side < 2; Side++)
+		{
+			const NODE_STRUCT& Move = this->Node[Current.Child[Side]];
+			const NODE_STRUCT& Other = this->Node[Current.Child[Side ^ 1]];
+			if (Other.Object != Invalid)
+			{
+				continue;
+			}
+
+			const float Area = GetArea(Other.Min, Other.Max);
+			for (uint32_t Index = 0; Index < 2; Index++)
+			{
+				const NODE_STRUCT& Keep = this->Node[Other.Child[Index ^ 1]];
+				const float Gain = Area - GetUnionArea(Move.Min, Move.Max, Keep.Min, Keep.Max);
+				if (Gain > BestGain)
+				{
+					BestGain = Gain;
+					BestSide = Side;
+					BestGrandChild = Index;
+				}
+			}
+		}
+
+		if (BestSide == Invalid)
+		{
+			return false;
+		}
+
+		const uint32_t Move = Current.Child[BestSide];
+		const uint32_t Other = Current.Child[BestSide ^ 1];
+		const uint32_t GrandChild = this->Node[Other].Child[BestGrandChild];
+
+		this->Node[Node].Child[BestSide] = GrandChild;
+		this->Node[GrandChild].Parent = Node;
+		this->Node[Other].Child[BestGrandChild] = Move;
+		this->Node[Move].Parent = Other;
+		this->Node[Other].Dirty = this->Node[Other].Dirty || this->Node[Move].Dirty;
+
+		this->Combine(Other);
+		return true;
+	}
+
+	void SceneBVH::Combine(uint32_t Node)
+	{
+		NODE_STRUCT& Current = this->Node[Node];
+		const NODE_STRUCT& Left = this->Node[Current.Child[0]];
+		const NODE_STRUCT& Right = this->Node[Current.Child[1]];
+
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			Current.Min[Axis] = std::min(Left.Min[Axis], Right.Min[Axis]);
+			Current.Max[Axis] = std::max(Left.Max[Axis], Right.Max[Axis]);
+		}
+	}
+
+	bool SceneBVH::Prepare()
+	{
+		if (this->Root == Invalid)
+		{
+			return false;
+		}
+
+		if (this->Node[this->Root].Dirty)
+		{
+			this->Refit();
+		}
+
+		if (this->StructureDirty)
+		{
+			for (NODE_STRUCT& Node : this->Node)
+			{
+				Node.Wide = Invalid;
+				Node.Slot = Invalid;
+			}
+
+			this->Wide.clear();
+			this->WideParent.clear();
+			this->FreeWide.clear();
+			this->Wide.reserve(this->ObjectCount / 2 + 1);
+			this->WideParent.reserve(this->ObjectCount / 2 + 1);
+			this->FlattenNode(this->Root, Invalid);
+			this->StructureDirty = false;
+		}
+		else if (!this->Rotated.empty())
+		{
+			// Collapse again the wide subtree around each rotation, outermost
+			// first; a nested subtree whose root lost its wide node was rebuilt
+			// with the enclosing one and is skipped.
+			struct REGION_STRUCT
+			{
+				uint32_t Depth;
+				uint32_t Wide;
+				uint32_t Node;
+			};
+
+			std::vector<REGION_STRUCT> Region;
+			Region.reserve(this->Rotated.size());
+			for (uint32_t Node : this->Rotated)
+			{
+				while (this->Node[Node].Wide == Invalid)
+				{
+					Node = this->Node[Node].Parent;
+				}
+
+				uint32_t Depth = 0;
+				for (uint32_t Wide = this->Node[Node].Wide; this->WideParent[Wide] != Invalid; Wide = this->WideParent[Wide])
+				{
+					Depth++;
+				}
+				Region.push_back({ Depth, this->Node[Node].Wide, Node });
+			}
+
+			std::sort(Region.begin(), Region.end(), [](const REGION_STRUCT& A, const REGION_STRUCT& B) { return A.Depth < B.Depth || (A.Depth == B.Depth && A.Wide < B.Wide); });
+			for (size_t Index = 0; Index < Region.size(); Index++)
+			{
+				const REGION_STRUCT& Current = Region[Index];
+				if ((Index > 0 && Current.Wide == Region[Index - 1].Wide) || this->Node[Current.Node].Wide != Current.Wide)
+				{
+					continue;
+				}
+
+				this->ReleaseWide(Current.Wide, false);
+				this->FlattenNode(Current.Node, this->WideParent[Current.Wide], Current.Wide);
+			}
+		}
+
+		this->Rotated.clear();
+		return true;
+	}
+
+	uint32_t SceneBVH::FlattenNode(uint32_t Node, uint32_t Parent, uint32_t Index)
+	{
+		if (Index == Invalid)
+		{
+			if (!this->FreeWide.empty())
+			{
+				Index = this->FreeWide.back();
+				this->FreeWide.pop_back();
+			}
+			else
+			{
+				Index = static_cast<uint32_t>(this->Wide.size());
+				this->Wide.emplace_back();
+				this->WideParent.push_back(Invalid);
+			}
+		}
+		this->WideParent[Index] = Parent;
+		this->Node[Node].Wide = Index;
+
+		uint32_t Source[4] = { Node, Invalid, Invalid, Invalid };
+		size_t SourceCount = 1;
+
+		if (this->Node[Node].Object == Invalid)
+		{
+			Source[0] = this->Node[Node].Child[0];
+			Source[1] = this->Node[Node].Child[1];
+			SourceCount = 2;
+
+			while (SourceCount < 4)
+			{
+				size_t Best = SourceCount;
+				float BestArea = -1.0f;
+				for (size_t Slot = 0; Slot < SourceCount; Slot++)
+				{
+					const NODE_STRUCT& Candidate = this->Node[Source[Slot]];
+					const float Area = GetArea(Candidate.Min, Candidate.Max);
+					if (Candidate.Object == Invalid && Area > BestArea)
+					{
+						Best = Slot;
+						BestArea = Area;
+					}
+				}
+
+				if (Best == SourceCount)
+				{
+					break;
+				}
+
+				const uint32_t Expand = Source[Best];
+				Source[Best] = this->Node[Expand].Child[0];
+				Source[SourceCount++] = this->Node[Expand].Child[1];
+			}
+		}
+
+		uint32_t Child[4] = { Invalid, Invalid, Invalid, Invalid };
+		for (size_t Slot = 0; Slot < SourceCount; Slot++)
+		{
+			NODE_STRUCT& Entry = this->Node[Source[Slot]];
+			Entry.Slot = (Index << 2) | static_cast<uint32_t>(Slot);
+			Child[Slot] = Entry.Object != Invalid ? (Entry.Object | LeafBit) : this->FlattenNode(Source[Slot], Index);
+		}
+
+		WIDE_NODE_STRUCT& Wide = this->Wide[Index];
+		for (size_t Slot = 0; Slot < 4; Slot++)
+		{
+			const bool Used = Slot < SourceCount;
+			const NODE_STRUCT* Entry = Used ? &this->Node[Source[Slot]] : nullptr;
+			Wide.MinX[Slot] = Used ? Entry->Min[0] : 0.0f;
+			Wide.MinY[Slot] = Used ? Entry->Min[1] : 0.0f;
+			Wide.MinZ[Slot] = Used ? Entry->Min[2] : 0.0f;
+			Wide.MaxX[Slot] = Used ? Entry->Max[0] : 0.0f;
+			Wide.MaxY[Slot] = Used ? Entry->Max[1] : 0.0f;
+			Wide.MaxZ[Slot] = Used ? Entry->Max[2] : 0.0f;
+			Wide.Child[Slot] = Child[Slot];
+			Wide.Source[Slot] = Source[Slot];
+		}
+		return Index;
+	}
+
+	void SceneBVH::ReleaseWide(uint32_t Index, bool Free)
+	{
+		const WIDE_NODE_STRUCT& Wide = this->Wide[Index];
+		for (size_t Slot = 0; Slot < 4 && Wide.Source[Slot] != Invalid; Slot++)
+		{
+			NODE_STRUCT& Source = this->Node[Wide.Source[Slot]];
+			if (Source.Slot == ((Index << 2) | static_cast<uint32_t>(Slot)))
+			{
+				Source.Slot = Invalid;
+			}
+
+			const uint32_t Child = Wide.Child[Slot];
+			if (!(Child & LeafBit))
+			{
+				if (Source.Wide == Child)
+				{
+					Source.Wide = Invalid;
+				}
+				this->ReleaseWide(Child, true);
+			}
+		}
+
+		if (Free)
+		{
+			this->WideParent[Index] = ReleasedWide;
+			this->FreeWide.push_back(Index);
+		}
+	}
+
+	void SceneBVH::StoreWide(uint32_t Node)
+	{
+		const NODE_STRUCT& Source = this->Node[Node];
+		if (Source.Slot == Invalid || this->StructureDirty)
+		{
+			return;
+		}
+
+		WIDE_NODE_STRUCT& Wide = this->Wide[Source.Slot >> 2];
+		const size_t Slot = Source.Slot & 3;
+		Wide.MinX[Slot] = Source.Min[0];
+		Wide.MinY[Slot] = Source.Min[1];
+		Wide.MinZ[Slot] = Source.Min[2];
+		Wide.MaxX[Slot] = Source.Max[0];
+		Wide.MaxY[Slot] = Source.Max[1];
+		Wide.MaxZ[Slot] = Source.Max[2];
+	}
+
+	void SceneBVH::CollectWide(uint32_t Node, std::vector<uint32_t>& Result) const
+	{
+		const WIDE_NODE_STRUCT& Wide = this->Wide[Node];
+		for (size_t Slot = 0; Slot < 4 && Wide.Child[Slot] != Invalid; Slot++)
+		{
+			if (Wide.Child[Slot] & LeafBit)
+			{
+				Result.push_back(Wide.Child[Slot] & ~LeafBit);
+			}
+			else
+			{
+				this->CollectWide(Wide.Child[Slot], Result);
+			}
+		}
+	}
+}
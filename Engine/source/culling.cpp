@@ -0,0 +1,302 @@
+﻿#include "include/culling.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <immintrin.h>
+
+namespace Engine
+{
+	FRUSTUM_STRUCT ExtractFrustum(const float* ViewProjection)
+	{
+		float Column[4][4];
+		for (size_t Row = 0; Row < 4; Row++)
+		{
+			for (size_t Index = 0; Index < 4; Index++)
+			{
+				Column[Index][Row] = ViewProjection[Row * 4 + Index];
+			}
+		}
+
+		FRUSTUM_STRUCT Frustum;
+		for (size_t Index = 0; Index < 4; Index++)
+		{
+			Frustum.Plane[0][Index] = Column[3][Index] + Column[0][Index];
+			Frustum.Plane[1][Index] = Column[3][Index] - Column[0][Index];
+			Frustum.Plane[2][Index] = Column[3][Index] + Column[1][Index];
+			Frustum.Plane[3][Index] = Column[3][Index] - Column[1][Index];
+			Frustum.Plane[4][Index] = Column[2][Index];
+			Frustum.Plane[5][Index] = Column[3][Index] - Column[2][Index];
+		}
+
+		for (float* Plane : Frustum.Plane)
+		{
+			const float Length = std::sqrt(Plane[0] * Plane[0] + Plane[1] * Plane[1] + Plane[2] * Plane[2]);
+			if (Length > 0.0f)
+			{
+				for (size_t Index = 0; Index < 4; Index++)
+				{
+					Plane[Index] /= Length;
+				}
+			}
+		}
+
+		return Frustum;
+	}
+
+	BOUNDING_BOX_STRUCT ComputeBoundingBox(const void* Vertex, size_t Count, size_t Stride)
+	{
+		if (Count == 0)
+		{
+			return {};
+		}
+
+		float Min[3];
+		float Max[3];
+		memcpy(Min, Vertex, sizeof(Min));
+		memcpy(Max, Vertex, sizeof(Max));
+
+		for (size_t Index = 1; Index < Count; Index++)
+		{
+			float Position[3];
+			memcpy(Position, static_cast<const uint8_t*>(Vertex) + Index * Stride, sizeof(Position));
+
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				Min[Axis] = std::min(Min[Axis], Position[Axis]);
+				Max[Axis] = std::max(Max[Axis], Position[Axis]);
+			}
+		}
+
+		BOUNDING_BOX_STRUCT Box;
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			Box.Center[Axis] = (Min[Axis] + Max[Axis]) * 0.5f;
+			Box.Extent[Axis] = (Max[Axis] - Min[Axis]) * 0.5f;
+		}
+		return Box;
+	}
+
+	BOUNDING_BOX_STRUCT TransformBoundingBox(const BOUNDING_BOX_STRUCT& Box, const float* World)
+	{
+		BOUNDING_BOX_STRUCT Result;
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			Result.Center[Axis] = World[12 + Axis];
+			Result.Extent[Axis] = 0.0f;
+
+			for (size_t Row = 0; Row < 3; Row++)
+			{
+				Result.Center[Axis] += Box.Center[Row] * World[Row * 4 + Axis];
+				Result.Extent[Axis] += Box.Extent[Row] * std::fabs(World[Row * 4 + Axis]);
+			}
+		}
+		return Result;
+	}
+
+
+
+	namespace
+	{
+		constexpr size_t CullBlockSize = 16384;
+
+		size_t CullBoxBlock(const FRUSTUM_STRUCT& Frustum, const CULL_BOX_STRUCT& Box, size_t First, size_t Last, uint32_t* Visible)
+		{
+			size_t Count = 0;
+			size_t Index = First;
+
+#if defined(__AVX2__)
+			for (; Index + 8 <= Last; Index += 8)
+			{
+				const __m256 CenterX = _mm256_loadu_ps(Box.CenterX + Index);
+				const __m256 CenterY = _mm256_loadu_ps(Box.CenterY + Index);
+				const __m256 CenterZ = _mm256_loadu_ps(Box.CenterZ + Index);
+				const __m256 ExtentX = _mm256_loadu_ps(Box.ExtentX + Index);
+				const __m256 ExtentY = _mm256_loadu_ps(Box.ExtentY + Index);
+				const __m256 ExtentZ = _mm256_loadu_ps(Box.ExtentZ + Index);
+
+				__m256 Outside = _mm256_setzero_ps();
+				for (const float* Plane : Frustum.Plane)
+				{
+					const __m256 Distance = _mm256_add_ps(
+						_mm256_add_ps(_mm256_mul_ps(CenterX, _mm256_set1_ps(Plane[0])), _mm256_mul_ps(CenterY, _mm256_set1_ps(Plane[1]))),
+						_mm256_add_ps(_mm256_mul_ps(CenterZ, _mm256_set1_ps(Plane[2])), _mm256_set1_ps(Plane[3])));
+					const __m256 Radius = _mm256_add_ps(
+						_mm256_add_ps(_mm256_mul_ps(ExtentX, _mm256_set1_ps(std::fabs(Plane[0]))), _mm256_mul_ps(ExtentY, _mm256_set1_ps(std::fabs(Plane[1])))),
+						_mm256_mul_ps(ExtentZ, _mm256_set1_ps(std::fabs(Plane[2]))));
+					Outside = _mm256_or_ps(Outside, _mm256_cmp_ps(_mm256_add_ps(Distance, Radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+				}
+
+				const int Mask = ~_mm256_movemask_ps(Outside);
+				for (int Bit = 0; Bit < 8; Bit++)
+				{
+					Visible[Count] = static_cast<uint32_t>(Index + Bit);
+					Count += (Mask >> Bit) & 1;
+				}
+			}
+#endif
+
+			for (; Index + 4 <= Last; Index += 4)
+			{
+				const __m128 CenterX = _mm_loadu_ps(Box.CenterX + Index);
+				const __m128 CenterY = _mm_loadu_ps(Box.CenterY + Index);
+				const __m128 CenterZ = _mm_loadu_ps(Box.CenterZ + Index);
+				const __m128 ExtentX = _mm_loadu_ps(Box.ExtentX + Index);
+				const __m128 ExtentY = _mm_loadu_ps(Box.ExtentY + Index);
+				const __m128 ExtentZ = _mm_loadu_ps(Box.ExtentZ + Index);
+
+				__m128 Outside = _mm_setzero_ps();
+				for (const float* Plane : Frustum.Plane)
+				{
+					const __m128 Distance = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(CenterX, _mm_set1_ps(Plane[0])), _mm_mul_ps(CenterY, _mm_set1_ps(Plane[1]))),
+						_mm_add_ps(_mm_mul_ps(CenterZ, _mm_set1_ps(Plane[2])), _mm_set1_ps(Plane[3])));
+					const __m128 Radius = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(ExtentX, _mm_set1_ps(std::fabs(Plane[0]))), _mm_mul_ps(ExtentY, _mm_set1_ps(std::fabs(Plane[1])))),
+						_mm_mul_ps(ExtentZ, _mm_set1_ps(std::fabs(Plane[2]))));
+					Outside = _mm_or_ps(Outside, _mm_cmplt_ps(_mm_add_ps(Distance, Radius), _mm_setzero_ps()));
+				}
+
+				const int Mask = ~_mm_movemask_ps(Outside);
+				for (int Bit = 0; Bit < 4; Bit++)
+				{
+					Visible[Count] = static_cast<uint32_t>(Index + Bit);
+					Count += (Mask >> Bit) & 1;
+				}
+			}
+
+			for (; Index < Last; Index++)
+			{
+				bool Inside = true;
+				for (const float* Plane : Frustum.Plane)
+				{
+					const float Distance = Box.CenterX[Index] * Plane[0] + Box.CenterY[Index] * Plane[1] + Box.CenterZ[Index] * Plane[2] + Plane[3];
+					const float Radius = Box.ExtentX[Index] * std::fabs(Plane[0]) + Box.ExtentY[Index] * std::fabs(Plane[1]) + Box.ExtentZ[Index] * std::fabs(Plane[2]);
+					Inside = Inside && !(Distance + Radius < 0.0f);
+				}
+
+				if (Inside)
+				{
+					Visible[Count++] = static_cast<uint32_t>(Index);
+				}
+			}
+
+			return Count;
+		}
+
+		size_t CullSphereBlock(const FRUSTUM_STRUCT& Frustum, const CULL_SPHERE_STRUCT& Sphere, size_t First, size_t Last, uint32_t* Visible)
+		{
+			size_t Count = 0;
+			size_t Index = First;
+
+#if defined(__AVX2__)
+			for (; Index + 8 <= Last; Index += 8)
+			{
+				const __m256 CenterX = _mm256_loadu_ps(Sphere.CenterX + Index);
+				const __m256 CenterY = _mm256_loadu_ps(Sphere.CenterY + Index);
+				const __m256 CenterZ = _mm256_loadu_ps(Sphere.CenterZ + Index);
+				const __m256 Radius = _mm256_loadu_ps(Sphere.Radius + Index);
+
+				__m256 Outside = _mm256_setzero_ps();
+				for (const float* Plane : Frustum.Plane)
+				{
+					const __m256 Distance = _mm256_add_ps(
+						_mm256_add_ps(_mm256_mul_ps(CenterX, _mm256_set1_ps(Plane[0])), _mm256_mul_ps(CenterY, _mm256_set1_ps(Plane[1]))),
+						_mm256_add_ps(_mm256_mul_ps(CenterZ, _mm256_set1_ps(Plane[2])), _mm256_set1_ps(Plane[3])));
+					Outside = _mm256_or_ps(Outside, _mm256_cmp_ps(_mm256_add_ps(Distance, Radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+				}
+
+				const int Mask = ~_mm256_movemask_ps(Outside);
+				for (int Bit = 0; Bit < 8; Bit++)
+				{
+					Visible[Count] = static_cast<uint32_t>(Index + Bit);
+					Count += (Mask >> Bit) & 1;
+				}
+			}
+#endif
+
+			for (; Index + 4 <= Last; Index += 4)
+			{
+				const __m128 CenterX = _mm_loadu_ps(Sphere.CenterX + Index);
+				const __m128 CenterY = _mm_loadu_ps(Sphere.CenterY + Index);
+				const __m128 CenterZ = _mm_loadu_ps(Sphere.CenterZ + Index);
+				const __m128 Radius = _mm_loadu_ps(Sphere.Radius + Index);
+
+				__m128 Outside = _mm_setzero_ps();
+				for (const float* Plane : Frustum.Plane)
+				{
+					const __m128 Distance = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(CenterX, _mm_set1_ps(Plane[0])), _mm_mul_ps(CenterY, _mm_set1_ps(Plane[1]))),
+						_mm_add_ps(_mm_mul_ps(CenterZ, _mm_set1_ps(Plane[2])), _mm_set1_ps(Plane[3])));
+					Outside = _mm_or_ps(Outside, _mm_cmplt_ps(_mm_add_ps(Distance, Radius), _mm_setzero_ps()));
+				}
+
+				const int Mask = ~_mm_movemask_ps(Outside);
+				for (int Bit = 0; Bit < 4; Bit++)
+				{
+					Visible[Count] = static_cast<uint32_t>(Index + Bit);
+					Count += (Mask >> Bit) & 1;
+				}
+			}
+
+			for (; Index < Last; Index++)
+			{
+				bool Inside = true;
+				for (const float* Plane : Frustum.Plane)
+				{
+					const float Distance = Sphere.CenterX[Index] * Plane[0] + Sphere.CenterY[Index] * Plane[1] + Sphere.CenterZ[Index] * Plane[2] + Plane[3];
+					Inside = Inside && !(Distance + Sphere.Radius[Index] < 0.0f);
+				}
+
+				if (Inside)
+				{
+					Visible[Count++] = static_cast<uint32_t>(Index);
+				}
+			}
+
+			return Count;
+		}
+
+		template<class Function>
+		size_t CullParallel(size_t Count, uint32_t* Visible, ThreadPool* Pool, const Function& Block)
+		{
+			const size_t BlockCount = (Count + CullBlockSize - 1) / CullBlockSize;
+
+			if (!Pool || BlockCount <= 1)
+			{
+				return Block(0, Count, Visible);
+			}
+
+			std::vector<size_t> BlockVisible(BlockCount);
+			Pool->Dispatch(BlockCount, [&](size_t Index)
+			{
+				const size_t First = Index * CullBlockSize;
+				BlockVisible[Index] = Block(First, std::min(First + CullBlockSize, Count), Visible + First);
+			});
+
+			size_t Result = BlockVisible[0];
+			for (size_t Index = 1; Index < BlockCount; Index++)
+			{
+				memmove(Visible + Result, Visible + Index * CullBlockSize, BlockVisible[Index] * sizeof(uint32_t));
+				Result += BlockVisible[Index];
+			}
+			return Result;
+		}
+	}
+
+	size_t CullBox(const FRUSTUM_STRUCT& Frustum, const CULL_BOX_STRUCT& Box, uint32_t* Visible, ThreadPool* Pool)
+	{
+		return CullParallel(Box.Count, Visible, Pool, [&](size_t First, size_t Last, uint32_t* Output)
+		{
+			return CullBoxBlock(Frustum, Box, First, Last, Output);
+		});
+	}
+
+	size_t CullSphere(const FRUSTUM_STRUCT& Frustum, const CULL_SPHERE_STRUCT& Sphere, uint32_t* Visible, ThreadPool* Pool)
+	{
+		return CullParallel(Sphere.Count, Visible, Pool, [&](size_t First, size_t Last, uint32_t* Output)
+		{
+			return CullSphereBlock(Frustum, Sphere, First, Last, Output);
+		});
+	}
+}
@@ -0,0 +1,316 @@
+﻿#include "include/ecs.h"
+#include "include/platform.h"
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr size_t ChunkAlignment = 64;
+		constexpr size_t ArrayAlignment = 16;
+
+		size_t AlignUp(size_t Value, size_t Alignment)
+		{
+			return (Value + Alignment - 1) & ~(Alignment - 1);
+		}
+	}
+
+
+
+	uint32_t AllocateComponentType()
+	{
+		static std::atomic<uint32_t> Next(0);
+
+		const uint32_t Type = Next++;
+		if (Type >= MaxComponentType)
+		{
+			throw E_OUTOFMEMORY;
+		}
+		return Type;
+	}
+
+
+
+	EntityWorld::~EntityWorld()
+	{
+		for (const std::unique_ptr<ARCHETYPE_STRUCT>& Archetype : this->Archetype)
+		{
+			for (uint8_t* Chunk : Archetype->Chunk)
+			{
+				operator delete(Chunk, std::align_val_t(ChunkAlignment));
+			}
+		}
+	}
+
+	void EntityWorld::Destroy(ENTITY_STRUCT Entity)
+	{
+		if (!this->IsAlive(Entity))
+		{
+			return;
+		}
+
+		RECORD_STRUCT& Record = this->Record[Entity.Index];
+		this->RemoveRow(Record.Archetype, Record.Chunk, Record.Row);
+
+		Record.Archetype = nullptr;
+		Record.Generation++;
+		this->FreeIndex.push_back(Entity.Index);
+		this->EntityCount--;
+	}
+
+	bool EntityWorld::IsAlive(ENTITY_STRUCT Entity) const
+	{
+		return Entity.Index < this->Record.size() && this->Record[Entity.Index].Archetype && this->Record[Entity.Index].Generation == Entity.Generation;
+	}
+
+	void EntityWorld::RunSystems(ThreadPool* Pool)
+	{
+		const size_t WaveCount = this->GetSystemWaveCount();
+
+		std::vector<std::pair<const SYSTEM_STRUCT*, std::pair<ARCHETYPE_STRUCT*, size_t>>> Work;
+		for (uint32_t Wave = 0; Wave < WaveCount; Wave++)
+		{
+			Work.clear();
+			for (const SYSTEM_STRUCT& System : this->System)
+			{
+				if (System.Wave != Wave)
+				{
+					continue;
+				}
+
+				for (const std::unique_ptr<ARCHETYPE_STRUCT>& Archetype : this->Archetype)
+				{
+					if ((Archetype->Mask & System.Mask) == System.Mask)
+					{
+						for (size_t Chunk = 0; Chunk < Archetype->Chunk.size(); Chunk++)
+						{
+							Work.push_back({ &System, { Archetype.get(), Chunk } });
+						}
+					}
+				}
+			}
+
+			auto Execute = [&](size_t Index)
+			{
+				Work[Index].first->Execute(*Work[Index].second.first, Work[Index].second.second);
+			};
+
+			if (Pool)
+			{
+				Pool->Dispatch(Work.size(), Execute);
+			}
+			else
+			{
+				for (size_t Index = 0; Index < Work.size(); Index++)
+				{
+					Execute(Index);
+				}
+			}
+		}
+	}
+
+	size_t EntityWorld::GetEntityCount() const
+	{
+		return this->EntityCount;
+	}
+
+	size_t EntityWorld::GetArchetypeCount() const
+	{
+		return this->Archetype.size();
+	}
+
+	size_t EntityWorld::GetSystemWaveCount() const
+	{
+		uint32_t WaveCount = 0;
+		for (const SYSTEM_STRUCT& System : this->System)
+		{
+			WaveCount = std::max(WaveCount, System.Wave + 1);
+		}
+		return WaveCount;
+	}
+
+
+
+	ARCHETYPE_STRUCT* EntityWorld::GetArchetype(uint64_t Mask)
+	{
+		const auto Found = this->ArchetypeMap.find(Mask);
+		if (Found != this->ArchetypeMap.end())
+		{
+			return Found->second;
+		}
+
+		std::unique_ptr<ARCHETYPE_STRUCT> Archetype = std::make_unique<ARCHETYPE_STRUCT>();
+		Archetype->Mask = Mask;
+		Archetype->EntityCount = 0;
+		memset(Archetype->Offset, 0, sizeof(Archetype->Offset));
+
+		size_t RowSize = sizeof(uint32_t);
+		for (uint32_t Type = 0; Type < MaxComponentType; Type++)
+		{
+			if (Mask & (1ull << Type))
+			{
+				Archetype->Component.push_back(Type);
+				RowSize += this->ComponentSize[Type];
+			}
+		}
+
+		for (size_t Capacity = EntityChunkSize / RowSize; Capacity > 0; Capacity--)
+		{
+			size_t Offset = AlignUp(Capacity * sizeof(uint32_t), ArrayAlignment);
+			for (const uint32_t Type : Archetype->Component)
+			{
+				Offset = AlignUp(Offset, std::max<size_t>(this->ComponentAlignment[Type], ArrayAlignment));
+				Archetype->Offset[Type] = static_cast<uint32_t>(Offset);
+				Offset += Capacity * this->ComponentSize[Type];
+			}
+
+			if (Offset <= EntityChunkSize)
+			{
+				Archetype->Capacity = static_cast<uint32_t>(Capacity);
+				break;
+			}
+		}
+
+		if (Archetype->Capacity == 0)
+		{
+			throw E_OUTOFMEMORY;
+		}
+
+		ARCHETYPE_STRUCT* Result = Archetype.get();
+		this->ArchetypeMap[Mask] = Result;
+		this->Archetype.push_back(std::move(Archetype));
+		return Result;
+	}
+
+	ENTITY_STRUCT EntityWorld::Allocate(uint64_t Mask)
+	{
+		ARCHETYPE_STRUCT* Archetype = this->GetArchetype(Mask);
+
+		uint32_t Index = static_cast<uint32_t>(this->Record.size());
+		if (!this->FreeIndex.empty())
+		{
+			Index = this->FreeIndex.back();
+			this->FreeIndex.pop_back();
+		}
+		else
+		{
+			this->Record.push_back({ nullptr, 0, 0, 0 });
+		}
+
+		this->Insert(Archetype, Index);
+		this->EntityCount++;
+		return { Index, this->Record[Index].Generation };
+	}
+
+	void EntityWorld::Insert(ARCHETYPE_STRUCT* Archetype, uint32_t Index)
+	{
+		if (Archetype->Chunk.empty() || Archetype->Count.back() == Archetype->Capacity)
+		{
+			Archetype->Chunk.push_back(static_cast<uint8_t*>(operator new(EntityChunkSize, std::align_val_t(ChunkAlignment))));
+			Archetype->Count.push_back(0);
+		}
+
+		const uint32_t Chunk = static_cast<uint32_t>(Archetype->Chunk.size() - 1);
+		const uint32_t Row = Archetype->Count[Chunk]++;
+		reinterpret_cast<uint32_t*>(Archetype->Chunk[Chunk])[Row] = Index;
+		Archetype->EntityCount++;
+
+		RECORD_STRUCT& Record = this->Record[Index];
+		Record.Archetype = Archetype;
+		Record.Chunk = Chunk;
+		Record.Row = Row;
+	}
+
+	void EntityWorld::RemoveRow(ARCHETYPE_STRUCT* Archetype, uint32_t Chunk, uint32_t Row)
+	{
+		const uint32_t LastChunk = static_cast<uint32_t>(Archetype->Chunk.size() - 1);
+		const uint32_t LastRow = Archetype->Count[LastChunk] - 1;
+
+		if (Chunk != LastChunk || Row != LastRow)
+		{
+			uint8_t* Target = Archetype->Chunk[Chunk];
+			const uint8_t* Source = Archetype->Chunk[LastChunk];
+
+			for (const uint32_t Type : Archetype->Component)
+			{
+				const size_t Size = this->ComponentSize[Type];
+				memcpy(Target + Archetype->Offset[Type] + Row * Size, Source + Archetype->Offset[Type] + LastRow * Size, Size);
+			}
+
+			const uint32_t Moved = reinterpret_cast<const uint32_t*>(Source)[LastRow];
+			reinterpret_cast<uint32_t*>(Target)[Row] = Moved;
+			this->Record[Moved].Chunk = Chunk;
+			this->Record[Moved].Row = Row;
+		}
+
+		Archetype->EntityCount--;
+		if (--Archetype->Count[LastChunk] == 0)
+		{
+			operator delete(Archetype->Chunk[LastChunk], std::align_val_t(ChunkAlignment));
+			Archetype->Chunk.pop_back();
+			Archetype->Count.pop_back();
+		}
+	}
+
+	void EntityWorld::Move(ENTITY_STRUCT Entity, uint64_t Mask)
+	{
+		if (!this->IsAlive(Entity))
+		{
+			throw E_INVALIDARG;
+		}
+
+		const RECORD_STRUCT Source = this->Record[Entity.Index];
+		if (Source.Archetype->Mask == Mask)
+		{
+			return;
+		}
+
+		ARCHETYPE_STRUCT* Target = this->GetArchetype(Mask);
+		this->Insert(Target, Entity.Index);
+
+		const RECORD_STRUCT& Destination = this->Record[Entity.Index];
+		for (const uint32_t Type : Source.Archetype->Component)
+		{
+			if (Mask & (1ull << Type))
+			{
+				const size_t Size = this->ComponentSize[Type];
+				memcpy(Target->Chunk[Destination.Chunk] + Target->Offset[Type] + Destination.Row * Size, Source.Archetype->Chunk[Source.Chunk] + Source.Archetype->Offset[Type] + Source.Row * Size, Size);
+			}
+		}
+
+		this->RemoveRow(Source.Archetype, Source.Chunk, Source.Row);
+	}
+
+	void* EntityWorld::GetComponent(ENTITY_STRUCT Entity, uint32_t Type)
+	{
+		if (!this->IsAlive(Entity))
+		{
+			return nullptr;
+		}
+
+		const RECORD_STRUCT& Record = this->Record[Entity.Index];
+		if (!(Record.Archetype->Mask & (1ull << Type)))
+		{
+			return nullptr;
+		}
+
+		return Record.Archetype->Chunk[Record.Chunk] + Record.Archetype->Offset[Type] + Record.Row * this->ComponentSize[Type];
+	}
+
+	void EntityWorld::AddSystem(uint64_t Mask, uint64_t Write, std::function<void(ARCHETYPE_STRUCT& Archetype, size_t Chunk)>&& Execute)
+	{
+		SYSTEM_STRUCT System = { Mask, Mask & ~Write, Write, 0, std::move(Execute) };
+
+		for (const SYSTEM_STRUCT& Previous : this->System)
+		{
+			if ((Previous.Write & Mask) || (Write & Previous.Mask))
+			{
+				System.Wave = std::max(System.Wave, Previous.Wave + 1);
+			}
+		}
+
+		this->System.push_back(std::move(System));
+	}
+}
@@ -1,22 +1,20 @@
-﻿#include "include/engine.h"
+﻿#ifdef _WIN32
+#include "source/backend.h"
 #include <windows.h>
 #include <windowsx.h>
 #include <hidsdi.h>
 #include <wrl/client.h>
-#include <ctime>
+#include <d3d11_1.h>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "d3dcompiler.lib")
 
 namespace Engine
 {
-	float GetTimer()
-	{
-		return clock() / 1000.0f;
-	}
-
-
-
 	inline void Check(HRESULT ErrorCode)
 	{
 		if (FAILED(ErrorCode))
@@ -25,15 +23,33 @@ namespace Engine
 		}
 	}
 
-	template<class Class, typename... Param>
-	inline std::shared_ptr<Class> CreateInterface(Param... Parameters)
+	class CommandContext : public ICommandContext
 	{
-		return std::make_shared<Class>(Parameters...);
+	public:
+		void Draw(UINT IndexCount, UINT StartIndex, INT BaseVertex) override
+		{
+			this->Counter->Draw(IndexCount, 1);
+			this->D3D11DeviceContext->DrawIndexed(IndexCount, StartIndex, BaseVertex);
+		}
+
+		void DrawInstanced(UINT IndexCount, UINT InstanceCount, UINT StartIndex, INT BaseVertex) override
+		{
+			this->Counter->Draw(IndexCount, InstanceCount);
+			this->D3D11DeviceContext->DrawIndexedInstanced(IndexCount, InstanceCount, StartIndex, BaseVertex, 0);
+		}
+	public:
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> D3D11DeviceContext;
+		std::shared_ptr<BackendCounter> Counter;
+	};
+
+	inline ID3D11DeviceContext* GetDeviceContext(ICommandContext* Context)
+	{
+		return static_cast<CommandContext*>(Context)->D3D11DeviceContext.Get();
 	}
 
 
 
-	class Application : public IApplication
+	class Application : public Backend
 	{
 	public:
 		Application(LPCTSTR Title, INT X, INT Y, UINT Width, UINT Height, DWORD Style)
@@ -197,13 +213,42 @@ namespace Engine
 
 		bool EndDraw(UINT SyncInterval) override
 		{
-			return SUCCEEDED(SwapChain->Present(SyncInterval, 0));
+			this->Flush();
+			this->SignalFence();
+			const bool Result = SUCCEEDED(SwapChain->Present(SyncInterval, 0));
+			this->EndFrame();
+			return Result;
+		}
+
+		void Draw(UINT IndexCount, UINT StartIndex, INT BaseVertex) override
+		{
+			this->ImmediateContext.Draw(IndexCount, StartIndex, BaseVertex);
 		}
 
-		void Draw(UINT IndexCount) override
+		void DrawInstanced(UINT IndexCount, UINT InstanceCount, UINT StartIndex, INT BaseVertex) override
 		{
-			this->DeviceContext->DrawIndexed(IndexCount, 0, 0);
+			this->ImmediateContext.DrawInstanced(IndexCount, InstanceCount, StartIndex, BaseVertex);
 		}
+
+		ICommandContext* GetContext() override
+		{
+			return &this->ImmediateContext;
+		}
+
+		void Execute(ICommandList* const* List, UINT Count) override;
+
+		std::shared_ptr<ICommandList> CreateCommandList() override;
+		std::shared_ptr<IVertexShader> CreateVertexShader(LPCVOID Data, SIZE_T Size) override;
+		std::shared_ptr<IPixelShader> CreatePixelShader(LPCVOID Data, SIZE_T Size) override;
+		std::shared_ptr<IConstantBuffer> CreateConstantBuffer(SIZE_T Size) override;
+		std::shared_ptr<IConstantAllocator> CreateConstantAllocator(SIZE_T Capacity) override;
+		std::shared_ptr<IVertexBuffer> CreateVertexBuffer(LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement) override;
+		std::shared_ptr<IIndexBuffer> CreateIndexBuffer(LPCVOID Data, SIZE_T CountElement) override;
+		std::shared_ptr<IDynamicVertexBuffer> CreateDynamicVertexBuffer(SIZE_T CountElement, SIZE_T SizeElement) override;
+		std::shared_ptr<IDynamicIndexBuffer> CreateDynamicIndexBuffer(SIZE_T CountElement) override;
+		std::shared_ptr<IGeometryPool> CreateGeometryPool(SIZE_T VertexCount, SIZE_T SizeElement, SIZE_T IndexCount) override;
+		std::shared_ptr<IInstanceBuffer> CreateInstanceBuffer(LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement) override;
+		std::shared_ptr<ITexture> CreateTexture(LPCVOID Data, UINT Width, UINT Height) override;
 	private:
 		LRESULT WndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 		{
@@ -235,6 +280,7 @@ namespace Engine
 						{
 							this->Mouse.x += RawInput.data.mouse.lLastX;
 							this->Mouse.y += RawInput.data.mouse.lLastY;
+							this->InputEvent.Push({ GetTimestamp(), INPUT_EVENT_MOUSE_MOVE, 0, static_cast<int32_t>(RawInput.data.mouse.lLastX), static_cast<int32_t>(RawInput.data.mouse.lLastY) });
 							break;
 						}
 					}
@@ -265,12 +311,17 @@ namespace Engine
 
 				case WM_KEYDOWN:
 				{
+					if (!(lParam & (1 << 30)))
+					{
+						this->InputEvent.Push({ GetTimestamp(), INPUT_EVENT_KEY_DOWN, static_cast<uint8_t>(wParam), 0, 0 });
+					}
 					this->KeyState[static_cast<BYTE>(wParam)] = true;
 					return 0;
 				}
 
 				case WM_KEYUP:
 				{
+					this->InputEvent.Push({ GetTimestamp(), INPUT_EVENT_KEY_UP, static_cast<uint8_t>(wParam), 0, 0 });
 					this->KeyState[static_cast<BYTE>(wParam)] = false;
 					return 0;
 				}
@@ -300,11 +351,52 @@ namespace Engine
 			return Object->WndProc(hWnd, uMsg, wParam, lParam);
 		}
 	private:
+		// Issues the queued draws before a dynamic buffer they read is discarded.
+		std::function<void()> GetFlush()
+		{
+			const std::weak_ptr<Backend> Owner = this->weak_from_this();
+			return [Owner]()
+			{
+				if (const std::shared_ptr<Backend> App = Owner.lock())
+				{
+					App->Flush();
+				}
+			};
+		}
+
+		void SignalFence()
+		{
+			const uint64_t Current = this->Fence->Current;
+			this->DeviceContext->End(this->FenceQuery[Current % ARRAYSIZE(this->FenceQuery)].Get());
+			this->Fence->Current = Current + 1;
+
+			while (this->Fence->Completed < this->Fence->Current)
+			{
+				const bool Blocking = (this->Fence->Current - this->Fence->Completed >= ARRAYSIZE(this->FenceQuery));
+				const HRESULT Result = this->DeviceContext->GetData(this->FenceQuery[this->Fence->Completed % ARRAYSIZE(this->FenceQuery)].Get(), nullptr, 0, (Blocking ? 0 : D3D11_ASYNC_GETDATA_DONOTFLUSH));
+
+				if (Result == S_OK)
+				{
+					this->Fence->Completed++;
+				}
+				else if (!Blocking || FAILED(Result))
+				{
+					break;
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
 		HRESULT CreateDevice(UINT BufferCount, UINT Width, UINT Height, UINT SampleCount)
 		{
 			try
 			{
 				Check(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION, this->Device.ReleaseAndGetAddressOf(), nullptr, this->DeviceContext.ReleaseAndGetAddressOf()));
+				this->ImmediateContext.D3D11DeviceContext = this->DeviceContext;
+				this->ImmediateContext.Counter = this->Counter;
 
 				DXGI_SWAP_CHAIN_DESC SwapChainDesc = {};
 				SwapChainDesc.BufferCount = 1;
@@ -331,6 +423,13 @@ namespace Engine
 
 				Check(this->CreateView());
 
+				D3D11_QUERY_DESC QueryDesc = {};
+				QueryDesc.Query = D3D11_QUERY_EVENT;
+				for (Microsoft::WRL::ComPtr<ID3D11Query>& Query : this->FenceQuery)
+				{
+					Check(this->Device->CreateQuery(&QueryDesc, Query.ReleaseAndGetAddressOf()));
+				}
+
 				this->DeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 			}
 			catch (const HRESULT ErrorCode)
@@ -370,12 +469,12 @@ namespace Engine
 
 				this->DeviceContext->OMSetRenderTargets(1, this->RenderTargetView.GetAddressOf(), this->DepthStencilView.Get());
 
-				D3D11_VIEWPORT ViewPort = {};
-				ViewPort.Width = static_cast<FLOAT>(BackBufferDesc.Width);
-				ViewPort.Height = static_cast<FLOAT>(BackBufferDesc.Height);
-				ViewPort.MinDepth = D3D11_MIN_DEPTH;
-				ViewPort.MaxDepth = D3D11_MAX_DEPTH;
-				this->DeviceContext->RSSetViewports(1, &ViewPort);
+				this->ViewPort = {};
+				this->ViewPort.Width = static_cast<FLOAT>(BackBufferDesc.Width);
+				this->ViewPort.Height = static_cast<FLOAT>(BackBufferDesc.Height);
+				this->ViewPort.MinDepth = D3D11_MIN_DEPTH;
+				this->ViewPort.MaxDepth = D3D11_MAX_DEPTH;
+				this->DeviceContext->RSSetViewports(1, &this->ViewPort);
 			}
 			catch (const HRESULT ErrorCode)
 			{
@@ -397,22 +496,88 @@ namespace Engine
 		Microsoft::WRL::ComPtr<IDXGISwapChain> SwapChain;
 		Microsoft::WRL::ComPtr<ID3D11RenderTargetView> RenderTargetView;
 		Microsoft::WRL::ComPtr<ID3D11DepthStencilView> DepthStencilView;
+		D3D11_VIEWPORT ViewPort = {};
+		Microsoft::WRL::ComPtr<ID3D11Query> FenceQuery[3];
+		CommandContext ImmediateContext;
+		std::shared_ptr<FRAME_FENCE_STRUCT> Fence = std::make_shared<FRAME_FENCE_STRUCT>();
 	protected:
+		friend class CommandList;
 		friend class VertexShader;
 		friend class PixelShader;
 		friend class ConstantBuffer;
+		friend class ConstantAllocator;
 		friend class VertexBuffer;
 		friend class IndexBuffer;
+		friend class DynamicVertexBuffer;
+		friend class DynamicIndexBuffer;
+		friend class GeometryPool;
+		friend class InstanceBuffer;
 		friend class Texture;
 	};
 
-	std::shared_ptr<IApplication> IApplication::Create(LPCTSTR Title, INT X, INT Y, UINT Width, UINT Height, DWORD Style)
+	std::shared_ptr<Backend> CreateDirect3D11Application(LPCTSTR Title, INT X, INT Y, UINT Width, UINT Height, DWORD Style)
 	{
 		return CreateInterface<Application>(Title, X, Y, Width, Height, Style);
 	}
 
 
 
+	class CommandList : public ICommandList
+	{
+	public:
+		CommandList(std::shared_ptr<Application> App)
+		{
+			Check(App->Device->CreateDeferredContext(0, this->Context.D3D11DeviceContext.GetAddressOf()));
+			this->Context.Counter = App->Counter;
+			this->App = App;
+		}
+
+		ICommandContext* Begin() override
+		{
+			ID3D11DeviceContext* const DeviceContext = this->Context.D3D11DeviceContext.Get();
+
+			this->D3D11CommandList.Reset();
+
+			DeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			DeviceContext->OMSetRenderTargets(1, this->App->RenderTargetView.GetAddressOf(), this->App->DepthStencilView.Get());
+
+			DeviceContext->RSSetViewports(1, &this->App->ViewPort);
+
+			return &this->Context;
+		}
+
+		void End() override
+		{
+			Check(this->Context.D3D11DeviceContext->FinishCommandList(false, this->D3D11CommandList.ReleaseAndGetAddressOf()));
+		}
+	private:
+		friend class Application;
+
+		std::shared_ptr<Application> App;
+		CommandContext Context;
+		Microsoft::WRL::ComPtr<ID3D11CommandList> D3D11CommandList;
+	};
+
+	std::shared_ptr<ICommandList> Application::CreateCommandList()
+	{
+		return CreateInterface<CommandList>(std::static_pointer_cast<Application>(this->shared_from_this()));
+	}
+
+	void Application::Execute(ICommandList* const* List, UINT Count)
+	{
+		for (UINT Index = 0; Index < Count; Index++)
+		{
+			CommandList* const Current = static_cast<CommandList*>(List[Index]);
+
+			if (Current && Current->D3D11CommandList)
+			{
+				this->DeviceContext->ExecuteCommandList(Current->D3D11CommandList.Get(), true);
+			}
+		}
+	}
+
+
+
 	class VertexShader : public IVertexShader
 	{
 	public:
@@ -433,7 +598,18 @@ namespace Engine
 				InputElementDesc[Index].SemanticName = SignatureParameterDesc.SemanticName;
 				InputElementDesc[Index].SemanticIndex = SignatureParameterDesc.SemanticIndex;
 				InputElementDesc[Index].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-				InputElementDesc[Index].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+
+				if (strncmp(SignatureParameterDesc.SemanticName, "INSTANCE", 8) == 0)
+				{
+					InputElementDesc[Index].InputSlot = 1;
+					InputElementDesc[Index].InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+					InputElementDesc[Index].InstanceDataStepRate = 1;
+				}
+				else
+				{
+					InputElementDesc[Index].InputSlot = 0;
+					InputElementDesc[Index].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+				}
 
 				if (SignatureParameterDesc.Mask == 1)
 				{
@@ -460,22 +636,35 @@ namespace Engine
 			Check(App->Device->CreateInputLayout(InputElementDesc, ShaderDesc.InputParameters, Data, Size, this->D3D11InputLayout.GetAddressOf()));
 			Check(App->Device->CreateVertexShader(Data, Size, nullptr, this->D3D11VertexShader.GetAddressOf()));
 			this->D3D11DeviceContext = App->DeviceContext;
+			this->Counter = App->Counter;
 		}
 
 		void Set() override
 		{
-			this->D3D11DeviceContext->IASetInputLayout(this->D3D11InputLayout.Get());
-			this->D3D11DeviceContext->VSSetShader(this->D3D11VertexShader.Get(), nullptr, 0);
+			this->Bind(this->D3D11DeviceContext.Get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetDeviceContext(Context));
+		}
+	private:
+		void Bind(ID3D11DeviceContext* DeviceContext)
+		{
+			this->Counter->Bind();
+			DeviceContext->IASetInputLayout(this->D3D11InputLayout.Get());
+			DeviceContext->VSSetShader(this->D3D11VertexShader.Get(), nullptr, 0);
 		}
 	private:
+		std::shared_ptr<BackendCounter> Counter;
 		Microsoft::WRL::ComPtr<ID3D11DeviceContext> D3D11DeviceContext;
 		Microsoft::WRL::ComPtr<ID3D11InputLayout> D3D11InputLayout;
 		Microsoft::WRL::ComPtr<ID3D11VertexShader> D3D11VertexShader;
 	};
 
-	std::shared_ptr<IVertexShader> IVertexShader::Create(std::shared_ptr<IApplication> App, LPCVOID Data, SIZE_T Size)
+	std::shared_ptr<IVertexShader> Application::CreateVertexShader(LPCVOID Data, SIZE_T Size)
 	{
-		return CreateInterface<VertexShader>(static_cast<Application*>(App.get()), Data, Size);
+		return CreateInterface<VertexShader>(this, Data, Size);
 	}
 
 
@@ -487,20 +676,33 @@ namespace Engine
 		{
 			Check(App->Device->CreatePixelShader(Data, Size, nullptr, this->D3D11PixelShader.GetAddressOf()));
 			this->D3D11DeviceContext = App->DeviceContext;
+			this->Counter = App->Counter;
 		}
 
 		void Set() override
 		{
-			this->D3D11DeviceContext->PSSetShader(this->D3D11PixelShader.Get(), nullptr, 0);
+			this->Bind(this->D3D11DeviceContext.Get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetDeviceContext(Context));
+		}
+	private:
+		void Bind(ID3D11DeviceContext* DeviceContext)
+		{
+			this->Counter->Bind();
+			DeviceContext->PSSetShader(this->D3D11PixelShader.Get(), nullptr, 0);
 		}
 	private:
+		std::shared_ptr<BackendCounter> Counter;
 		Microsoft::WRL::ComPtr<ID3D11DeviceContext> D3D11DeviceContext;
 		Microsoft::WRL::ComPtr<ID3D11PixelShader> D3D11PixelShader;
 	};
 
-	std::shared_ptr<IPixelShader> IPixelShader::Create(std::shared_ptr<IApplication> App, LPCVOID Data, SIZE_T Size)
+	std::shared_ptr<IPixelShader> Application::CreatePixelShader(LPCVOID Data, SIZE_T Size)
 	{
-		return CreateInterface<PixelShader>(static_cast<Application*>(App.get()), Data, Size);
+		return CreateInterface<PixelShader>(this, Data, Size);
 	}
 
 
@@ -514,31 +716,171 @@ namespace Engine
 			BufferDesc.ByteWidth = DataSize;
 			BufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
 			Check(App->Device->CreateBuffer(&BufferDesc, nullptr, this->D3D11Buffer.GetAddressOf()));
+			this->Size = DataSize;
 			this->D3D11DeviceContext = App->DeviceContext;
+			this->Counter = App->Counter;
 		}
 
 		void Update(LPCVOID Data) override
 		{
+			this->Counter->Upload(this->Size);
 			this->D3D11DeviceContext->UpdateSubresource(this->D3D11Buffer.Get(), 0, nullptr, Data, 0, 0);
 		}
 
-		void SetVertexShader() override
+		void Update(ICommandContext* Context, LPCVOID Data) override
+		{
+			this->Counter->Upload(this->Size);
+			GetDeviceContext(Context)->UpdateSubresource(this->D3D11Buffer.Get(), 0, nullptr, Data, 0, 0);
+		}
+
+		void SetVertexShader(UINT Slot) override
 		{
-			this->D3D11DeviceContext->VSSetConstantBuffers(0, 1, this->D3D11Buffer.GetAddressOf());
+			this->Counter->Bind();
+			this->D3D11DeviceContext->VSSetConstantBuffers(Slot, 1, this->D3D11Buffer.GetAddressOf());
 		}
 
-		void SetPixelShader() override
+		void SetVertexShader(ICommandContext* Context, UINT Slot) override
 		{
-			this->D3D11DeviceContext->PSSetConstantBuffers(0, 1, this->D3D11Buffer.GetAddressOf());
+			this->Counter->Bind();
+			GetDeviceContext(Context)->VSSetConstantBuffers(Slot, 1, this->D3D11Buffer.GetAddressOf());
+		}
+
+		void SetPixelShader(UINT Slot) override
+		{
+			this->Counter->Bind();
+			this->D3D11DeviceContext->PSSetConstantBuffers(Slot, 1, this->D3D11Buffer.GetAddressOf());
+		}
+
+		void SetPixelShader(ICommandContext* Context, UINT Slot) override
+		{
+			this->Counter->Bind();
+			GetDeviceContext(Context)->PSSetConstantBuffers(Slot, 1, this->D3D11Buffer.GetAddressOf());
 		}
 	private:
+		std::shared_ptr<BackendCounter> Counter;
 		Microsoft::WRL::ComPtr<ID3D11DeviceContext> D3D11DeviceContext;
 		Microsoft::WRL::ComPtr<ID3D11Buffer> D3D11Buffer;
+
+		SIZE_T Size = 0;
 	};
 
-	std::shared_ptr<IConstantBuffer> IConstantBuffer::Create(std::shared_ptr<IApplication> App, SIZE_T DataSize)
+	std::shared_ptr<IConstantBuffer> Application::CreateConstantBuffer(SIZE_T DataSize)
 	{
-		return CreateInterface<ConstantBuffer>(static_cast<Application*>(App.get()), DataSize);
+		return CreateInterface<ConstantBuffer>(this, DataSize);
+	}
+
+
+
+	class ConstantAllocator : public IConstantAllocator
+	{
+	public:
+		ConstantAllocator(Application* App, SIZE_T Capacity) : Ring(App->Fence, Capacity, ConstantAlignment, QueryNoOverwrite(App))
+		{
+			this->D3D11DeviceContext = App->DeviceContext;
+			if (QueryOffsetting(App))
+			{
+				Check(App->DeviceContext.As(&this->D3D11DeviceContext1));
+			}
+
+			D3D11_BUFFER_DESC BufferDesc = {};
+			BufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+			BufferDesc.ByteWidth = static_cast<UINT>(this->D3D11DeviceContext1 ? this->Ring.GetCapacity() : (std::min)(this->Ring.GetCapacity(), MaxConstantSize));
+			BufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+			BufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+			Check(App->Device->CreateBuffer(&BufferDesc, nullptr, this->D3D11Buffer.GetAddressOf()));
+
+			this->Size = BufferDesc.ByteWidth;
+			this->Counter = App->Counter;
+		}
+
+		CONSTANT_SLICE_STRUCT Allocate(LPCVOID Data, SIZE_T Size) override
+		{
+			bool Discard = true;
+			SIZE_T Offset = 0;
+
+			if (this->D3D11DeviceContext1)
+			{
+				Offset = this->Ring.Allocate(Size, Discard);
+			}
+			else if (Size > this->Size)
+			{
+				throw E_INVALIDARG;
+			}
+			this->Counter->Upload(Size);
+
+			D3D11_MAPPED_SUBRESOURCE MappedSubresource = {};
+			Check(this->D3D11DeviceContext->Map(this->D3D11Buffer.Get(), 0, (Discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE), 0, &MappedSubresource));
+			CopyMemory(static_cast<BYTE*>(MappedSubresource.pData) + Offset, Data, Size);
+			this->D3D11DeviceContext->Unmap(this->D3D11Buffer.Get(), 0);
+
+			return { static_cast<UINT>(Offset / 16), static_cast<UINT>(AlignUp(Size, ConstantAlignment) / 16) };
+		}
+
+		void SetVertexShader(UINT Slot, const CONSTANT_SLICE_STRUCT& Slice) override
+		{
+			this->Counter->Bind();
+			if (this->D3D11DeviceContext1)
+			{
+				this->D3D11DeviceContext1->VSSetConstantBuffers1(Slot, 1, this->D3D11Buffer.GetAddressOf(), &Slice.FirstConstant, &Slice.NumConstants);
+			}
+			else
+			{
+				this->D3D11DeviceContext->VSSetConstantBuffers(Slot, 1, this->D3D11Buffer.GetAddressOf());
+			}
+		}
+
+		void SetPixelShader(UINT Slot, const CONSTANT_SLICE_STRUCT& Slice) override
+		{
+			this->Counter->Bind();
+			if (this->D3D11DeviceContext1)
+			{
+				this->D3D11DeviceContext1->PSSetConstantBuffers1(Slot, 1, this->D3D11Buffer.GetAddressOf(), &Slice.FirstConstant, &Slice.NumConstants);
+			}
+			else
+			{
+				this->D3D11DeviceContext->PSSetConstantBuffers(Slot, 1, this->D3D11Buffer.GetAddressOf());
+			}
+		}
+	private:
+		// Without constant buffer offsetting every allocation discards one plain
+		// constant buffer and is bound whole, which is only valid because slices
+		// are bound right after they are allocated.
+		static bool QueryOffsetting(Application* App)
+		{
+			D3D11_FEATURE_DATA_D3D11_OPTIONS Options = {};
+			Microsoft::WRL::ComPtr<ID3D11DeviceContext1> DeviceContext1;
+			if (FAILED(App->Device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &Options, sizeof(Options))) || FAILED(App->DeviceContext.As(&DeviceContext1)))
+			{
+				return false;
+			}
+			return Options.ConstantBufferOffsetting;
+		}
+
+		static bool QueryNoOverwrite(Application* App)
+		{
+			D3D11_FEATURE_DATA_D3D11_OPTIONS Options = {};
+			if (FAILED(App->Device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &Options, sizeof(Options))))
+			{
+				return false;
+			}
+			return Options.MapNoOverwriteOnDynamicConstantBuffer;
+		}
+	private:
+		static constexpr SIZE_T ConstantAlignment = 256;
+		static constexpr SIZE_T MaxConstantSize = D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT * 16;
+
+		std::shared_ptr<BackendCounter> Counter;
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> D3D11DeviceContext;
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext1> D3D11DeviceContext1;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> D3D11Buffer;
+
+		FencedRing Ring;
+		SIZE_T Size = 0;
+	};
+
+	std::shared_ptr<IConstantAllocator> Application::CreateConstantAllocator(SIZE_T Capacity)
+	{
+		return CreateInterface<ConstantAllocator>(this, Capacity);
 	}
 
 
@@ -559,23 +901,36 @@ namespace Engine
 			Check(App->Device->CreateBuffer(&BufferDesc, &SubresourceData, this->D3D11Buffer.GetAddressOf()));
 			this->Stride = SizeElement;
 			this->D3D11DeviceContext = App->DeviceContext;
+			this->Counter = App->Counter;
 		}
 
 		void Set() override
 		{
+			this->Bind(this->D3D11DeviceContext.Get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetDeviceContext(Context));
+		}
+	private:
+		void Bind(ID3D11DeviceContext* DeviceContext)
+		{
+			this->Counter->Bind();
 			UINT Offset = 0;
-			this->D3D11DeviceContext->IASetVertexBuffers(0, 1, this->D3D11Buffer.GetAddressOf(), &this->Stride, &Offset);
+			DeviceContext->IASetVertexBuffers(0, 1, this->D3D11Buffer.GetAddressOf(), &this->Stride, &Offset);
 		}
 	private:
+		std::shared_ptr<BackendCounter> Counter;
 		Microsoft::WRL::ComPtr<ID3D11DeviceContext> D3D11DeviceContext;
 		Microsoft::WRL::ComPtr<ID3D11Buffer> D3D11Buffer;
 
 		UINT Stride = 0;
 	};
 
-	std::shared_ptr<IVertexBuffer> IVertexBuffer::Create(std::shared_ptr<IApplication> App, LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement)
+	std::shared_ptr<IVertexBuffer> Application::CreateVertexBuffer(LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement)
 	{
-		return CreateInterface<VertexBuffer>(static_cast<Application*>(App.get()), Data, CountElement, SizeElement);
+		return CreateInterface<VertexBuffer>(this, Data, CountElement, SizeElement);
 	}
 
 
@@ -598,27 +953,410 @@ namespace Engine
 			this->Count = CountElement;
 
 			this->D3D11DeviceContext = App->DeviceContext;
+			this->Counter = App->Counter;
+		}
+
+		void Set() override
+		{
+			this->Bind(this->D3D11DeviceContext.Get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetDeviceContext(Context));
+		}
+
+		unsigned int GetIndexCount() override
+		{
+			return this->Count;
+		}
+	private:
+		void Bind(ID3D11DeviceContext* DeviceContext)
+		{
+			this->Counter->Bind();
+			DeviceContext->IASetIndexBuffer(this->D3D11Buffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+		}
+	private:
+		std::shared_ptr<BackendCounter> Counter;
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> D3D11DeviceContext;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> D3D11Buffer;
+
+		UINT Count = 0;
+	};
+
+	std::shared_ptr<IIndexBuffer> Application::CreateIndexBuffer(LPCVOID Data, SIZE_T CountElement)
+	{
+		return CreateInterface<IndexBuffer>(this, Data, CountElement);
+	}
+
+
+
+	class DynamicVertexBuffer : public IDynamicVertexBuffer
+	{
+	public:
+		DynamicVertexBuffer(Application* App, SIZE_T CountElement, SIZE_T SizeElement) : Ring(App->Fence, CountElement * SizeElement, SizeElement, true, App->GetFlush())
+		{
+			D3D11_BUFFER_DESC BufferDesc = {};
+			BufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+			BufferDesc.ByteWidth = this->Ring.GetCapacity();
+			BufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+			BufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+			Check(App->Device->CreateBuffer(&BufferDesc, nullptr, this->D3D11Buffer.GetAddressOf()));
+			this->Stride = SizeElement;
+			this->D3D11DeviceContext = App->DeviceContext;
+			this->Counter = App->Counter;
+		}
+
+		void Set() override
+		{
+			this->Bind(this->D3D11DeviceContext.Get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetDeviceContext(Context));
+		}
+
+		INT Allocate(LPCVOID Data, SIZE_T CountElement) override
+		{
+			const SIZE_T Size = CountElement * this->Stride;
+
+			bool Discard = true;
+			const SIZE_T Offset = this->Ring.Allocate(Size, Discard);
+
+			D3D11_MAPPED_SUBRESOURCE MappedSubresource = {};
+			Check(this->D3D11DeviceContext->Map(this->D3D11Buffer.Get(), 0, (Discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE), 0, &MappedSubresource));
+			CopyMemory(static_cast<BYTE*>(MappedSubresource.pData) + Offset, Data, Size);
+			this->D3D11DeviceContext->Unmap(this->D3D11Buffer.Get(), 0);
+
+			return static_cast<INT>(Offset / this->Stride);
+		}
+	private:
+		void Bind(ID3D11DeviceContext* DeviceContext)
+		{
+			this->Counter->Bind();
+			UINT Offset = 0;
+			DeviceContext->IASetVertexBuffers(0, 1, this->D3D11Buffer.GetAddressOf(), &this->Stride, &Offset);
+		}
+	private:
+		std::shared_ptr<BackendCounter> Counter;
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> D3D11DeviceContext;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> D3D11Buffer;
+
+		FencedRing Ring;
+		UINT Stride = 0;
+	};
+
+	std::shared_ptr<IDynamicVertexBuffer> Application::CreateDynamicVertexBuffer(SIZE_T CountElement, SIZE_T SizeElement)
+	{
+		return CreateInterface<DynamicVertexBuffer>(this, CountElement, SizeElement);
+	}
+
+
+
+	class DynamicIndexBuffer : public IDynamicIndexBuffer
+	{
+	public:
+		DynamicIndexBuffer(Application* App, SIZE_T CountElement) : Ring(App->Fence, CountElement * sizeof(UINT), sizeof(UINT), true, App->GetFlush())
+		{
+			D3D11_BUFFER_DESC BufferDesc = {};
+			BufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+			BufferDesc.ByteWidth = this->Ring.GetCapacity();
+			BufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+			BufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+			Check(App->Device->CreateBuffer(&BufferDesc, nullptr, this->D3D11Buffer.GetAddressOf()));
+			this->D3D11DeviceContext = App->DeviceContext;
+			this->Counter = App->Counter;
 		}
 
 		void Set() override
 		{
-			this->D3D11DeviceContext->IASetIndexBuffer(this->D3D11Buffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+			this->Bind(this->D3D11DeviceContext.Get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetDeviceContext(Context));
 		}
 
 		unsigned int GetIndexCount() override
 		{
 			return this->Count;
 		}
+
+		UINT Allocate(LPCVOID Data, SIZE_T CountElement) override
+		{
+			const SIZE_T Size = CountElement * sizeof(UINT);
+
+			bool Discard = true;
+			const SIZE_T Offset = this->Ring.Allocate(Size, Discard);
+
+			D3D11_MAPPED_SUBRESOURCE MappedSubresource = {};
+			Check(this->D3D11DeviceContext->Map(this->D3D11Buffer.Get(), 0, (Discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE), 0, &MappedSubresource));
+			CopyMemory(static_cast<BYTE*>(MappedSubresource.pData) + Offset, Data, Size);
+			this->D3D11DeviceContext->Unmap(this->D3D11Buffer.Get(), 0);
+
+			this->Count = CountElement;
+
+			return static_cast<UINT>(Offset / sizeof(UINT));
+		}
+	private:
+		void Bind(ID3D11DeviceContext* DeviceContext)
+		{
+			this->Counter->Bind();
+			DeviceContext->IASetIndexBuffer(this->D3D11Buffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+		}
+	private:
+		std::shared_ptr<BackendCounter> Counter;
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> D3D11DeviceContext;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> D3D11Buffer;
+
+		FencedRing Ring;
+		UINT Count = 0;
+	};
+
+	std::shared_ptr<IDynamicIndexBuffer> Application::CreateDynamicIndexBuffer(SIZE_T CountElement)
+	{
+		return CreateInterface<DynamicIndexBuffer>(this, CountElement);
+	}
+
+
+
+	class GeometryPool : public IGeometryPool
+	{
+	public:
+		GeometryPool(Application* App, SIZE_T VertexCount, SIZE_T SizeElement, SIZE_T IndexCount) : Allocator(static_cast<UINT>(VertexCount), static_cast<UINT>(IndexCount)), VertexView(this), IndexView(this)
+		{
+			this->D3D11Device = App->Device;
+			this->D3D11DeviceContext = App->DeviceContext;
+			this->Counter = App->Counter;
+			this->Stride = SizeElement;
+
+			Check(this->CreateBuffer(this->D3D11VertexBuffer, VertexCount * SizeElement, D3D11_BIND_VERTEX_BUFFER));
+			Check(this->CreateBuffer(this->D3D11IndexBuffer, IndexCount * sizeof(UINT), D3D11_BIND_INDEX_BUFFER));
+		}
+
+		UINT Add(LPCVOID Vertex, SIZE_T VertexCount, LPCVOID Index, SIZE_T IndexCount) override
+		{
+			const UINT Mesh = this->Allocator.Add(static_cast<UINT>(VertexCount), static_cast<UINT>(IndexCount));
+			if (Mesh == GeometryAllocator::Invalid)
+			{
+				throw E_OUTOFMEMORY;
+			}
+
+			const GEOMETRY_MESH_STRUCT Current = this->Allocator.GetMesh(Mesh);
+
+			const D3D11_BOX VertexBox = { static_cast<UINT>(Current.BaseVertex) * this->Stride, 0, 0, (static_cast<UINT>(Current.BaseVertex) + static_cast<UINT>(VertexCount)) * this->Stride, 1, 1 };
+			this->D3D11DeviceContext->UpdateSubresource(this->D3D11VertexBuffer.Get(), 0, &VertexBox, Vertex, 0, 0);
+
+			const D3D11_BOX IndexBox = { Current.StartIndex * static_cast<UINT>(sizeof(UINT)), 0, 0, (Current.StartIndex + static_cast<UINT>(IndexCount)) * static_cast<UINT>(sizeof(UINT)), 1, 1 };
+			this->D3D11DeviceContext->UpdateSubresource(this->D3D11IndexBuffer.Get(), 0, &IndexBox, Index, 0, 0);
+
+			return Mesh;
+		}
+
+		void Remove(UINT Mesh) override
+		{
+			this->Allocator.Remove(Mesh);
+		}
+
+		GEOMETRY_MESH_STRUCT GetMesh(UINT Mesh) override
+		{
+			return this->Allocator.GetMesh(Mesh);
+		}
+
+		void Compact() override
+		{
+			Microsoft::WRL::ComPtr<ID3D11Buffer> VertexBuffer;
+			Microsoft::WRL::ComPtr<ID3D11Buffer> IndexBuffer;
+			Check(this->CreateBuffer(VertexBuffer, this->Allocator.GetVertexCapacity() * this->Stride, D3D11_BIND_VERTEX_BUFFER));
+			Check(this->CreateBuffer(IndexBuffer, this->Allocator.GetIndexCapacity() * sizeof(UINT), D3D11_BIND_INDEX_BUFFER));
+
+			for (const GEOMETRY_MOVE_STRUCT& Move : this->Allocator.Compact())
+			{
+				const D3D11_BOX VertexBox = { Move.SourceVertex * this->Stride, 0, 0, (Move.SourceVertex + Move.VertexCount) * this->Stride, 1, 1 };
+				this->D3D11DeviceContext->CopySubresourceRegion(VertexBuffer.Get(), 0, Move.DestinationVertex * this->Stride, 0, 0, this->D3D11VertexBuffer.Get(), 0, &VertexBox);
+
+				const D3D11_BOX IndexBox = { Move.SourceIndex * static_cast<UINT>(sizeof(UINT)), 0, 0, (Move.SourceIndex + Move.IndexCount) * static_cast<UINT>(sizeof(UINT)), 1, 1 };
+				this->D3D11DeviceContext->CopySubresourceRegion(IndexBuffer.Get(), 0, Move.DestinationIndex * static_cast<UINT>(sizeof(UINT)), 0, 0, this->D3D11IndexBuffer.Get(), 0, &IndexBox);
+			}
+
+			this->D3D11VertexBuffer = VertexBuffer;
+			this->D3D11IndexBuffer = IndexBuffer;
+		}
+
+		GEOMETRY_REPORT_STRUCT GetReport() override
+		{
+			return this->Allocator.GetReport();
+		}
+
+		IVertexBuffer* GetVertexBuffer() override
+		{
+			return &this->VertexView;
+		}
+
+		IIndexBuffer* GetIndexBuffer() override
+		{
+			return &this->IndexView;
+		}
+	private:
+		HRESULT CreateBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer>& Buffer, SIZE_T Size, UINT BindFlags)
+		{
+			D3D11_BUFFER_DESC BufferDesc = {};
+			BufferDesc.Usage = D3D11_USAGE_DEFAULT;
+			BufferDesc.ByteWidth = Size;
+			BufferDesc.BindFlags = BindFlags;
+			return this->D3D11Device->CreateBuffer(&BufferDesc, nullptr, Buffer.ReleaseAndGetAddressOf());
+		}
+	private:
+		class PoolVertexBuffer : public IVertexBuffer
+		{
+		public:
+			PoolVertexBuffer(GeometryPool* Pool) : Pool(Pool)
+			{
+			}
+
+			void Set() override
+			{
+				this->Bind(this->Pool->D3D11DeviceContext.Get());
+			}
+
+			void Set(ICommandContext* Context) override
+			{
+				this->Bind(GetDeviceContext(Context));
+			}
+		private:
+			void Bind(ID3D11DeviceContext* DeviceContext)
+			{
+				this->Pool->Counter->Bind();
+				UINT Offset = 0;
+				DeviceContext->IASetVertexBuffers(0, 1, this->Pool->D3D11VertexBuffer.GetAddressOf(), &this->Pool->Stride, &Offset);
+			}
+		private:
+			GeometryPool* Pool;
+		};
+
+		class PoolIndexBuffer : public IIndexBuffer
+		{
+		public:
+			PoolIndexBuffer(GeometryPool* Pool) : Pool(Pool)
+			{
+			}
+
+			void Set() override
+			{
+				this->Bind(this->Pool->D3D11DeviceContext.Get());
+			}
+
+			void Set(ICommandContext* Context) override
+			{
+				this->Bind(GetDeviceContext(Context));
+			}
+
+			unsigned int GetIndexCount() override
+			{
+				return this->Pool->Allocator.GetIndexCapacity();
+			}
+		private:
+			void Bind(ID3D11DeviceContext* DeviceContext)
+			{
+				this->Pool->Counter->Bind();
+				DeviceContext->IASetIndexBuffer(this->Pool->D3D11IndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+			}
+		private:
+			GeometryPool* Pool;
+		};
+	private:
+		Microsoft::WRL::ComPtr<ID3D11Device> D3D11Device;
+		std::shared_ptr<BackendCounter> Counter;
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> D3D11DeviceContext;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> D3D11VertexBuffer;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> D3D11IndexBuffer;
+
+		GeometryAllocator Allocator;
+		UINT Stride = 0;
+
+		PoolVertexBuffer VertexView;
+		PoolIndexBuffer IndexView;
+	};
+
+	std::shared_ptr<IGeometryPool> Application::CreateGeometryPool(SIZE_T VertexCount, SIZE_T SizeElement, SIZE_T IndexCount)
+	{
+		return CreateInterface<GeometryPool>(this, VertexCount, SizeElement, IndexCount);
+	}
+
+
+
+	class InstanceBuffer : public IInstanceBuffer
+	{
+	public:
+		InstanceBuffer(Application* App, LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement)
+		{
+			D3D11_BUFFER_DESC BufferDesc = {};
+			BufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+			BufferDesc.ByteWidth = CountElement * SizeElement;
+			BufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+			BufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+			D3D11_SUBRESOURCE_DATA SubresourceData = {};
+			SubresourceData.pSysMem = Data;
+
+			Check(App->Device->CreateBuffer(&BufferDesc, (Data ? &SubresourceData : nullptr), this->D3D11Buffer.GetAddressOf()));
+
+			this->Stride = SizeElement;
+			this->Capacity = CountElement;
+			this->Count = (Data ? CountElement : 0);
+
+			this->D3D11DeviceContext = App->DeviceContext;
+			this->Counter = App->Counter;
+		}
+
+		void Update(LPCVOID Data, SIZE_T CountElement) override
+		{
+			this->Count = min(CountElement, static_cast<SIZE_T>(this->Capacity));
+
+			D3D11_MAPPED_SUBRESOURCE MappedSubresource = {};
+			Check(this->D3D11DeviceContext->Map(this->D3D11Buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedSubresource));
+			CopyMemory(MappedSubresource.pData, Data, this->Count * this->Stride);
+			this->D3D11DeviceContext->Unmap(this->D3D11Buffer.Get(), 0);
+		}
+
+		void Set() override
+		{
+			this->Bind(this->D3D11DeviceContext.Get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetDeviceContext(Context));
+		}
+
+		unsigned int GetInstanceCount() override
+		{
+			return this->Count;
+		}
+	private:
+		void Bind(ID3D11DeviceContext* DeviceContext)
+		{
+			this->Counter->Bind();
+			UINT Offset = 0;
+			DeviceContext->IASetVertexBuffers(1, 1, this->D3D11Buffer.GetAddressOf(), &this->Stride, &Offset);
+		}
 	private:
+		std::shared_ptr<BackendCounter> Counter;
 		Microsoft::WRL::ComPtr<ID3D11DeviceContext> D3D11DeviceContext;
 		Microsoft::WRL::ComPtr<ID3D11Buffer> D3D11Buffer;
 
+		UINT Stride = 0;
+		UINT Capacity = 0;
 		UINT Count = 0;
 	};
 
-	std::shared_ptr<IIndexBuffer> IIndexBuffer::Create(std::shared_ptr<IApplication> App, LPCVOID Data, SIZE_T CountElement)
+	std::shared_ptr<IInstanceBuffer> Application::CreateInstanceBuffer(LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement)
 	{
-		return CreateInterface<IndexBuffer>(static_cast<Application*>(App.get()), Data, CountElement);
+		return CreateInterface<InstanceBuffer>(this, Data, CountElement, SizeElement);
 	}
 
 
@@ -651,19 +1389,33 @@ namespace Engine
 			App->DeviceContext->GenerateMips(D3D11ShaderResourceView.Get());
 
 			this->D3D11DeviceContext = App->DeviceContext;
+			this->Counter = App->Counter;
 		}
 
 		void Set() override
 		{
-			this->D3D11DeviceContext->PSSetShaderResources(0, 1, this->D3D11ShaderResourceView.GetAddressOf());
+			this->Bind(this->D3D11DeviceContext.Get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetDeviceContext(Context));
+		}
+	private:
+		void Bind(ID3D11DeviceContext* DeviceContext)
+		{
+			this->Counter->Bind();
+			DeviceContext->PSSetShaderResources(0, 1, this->D3D11ShaderResourceView.GetAddressOf());
 		}
 	private:
+		std::shared_ptr<BackendCounter> Counter;
 		Microsoft::WRL::ComPtr<ID3D11DeviceContext> D3D11DeviceContext;
 		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> D3D11ShaderResourceView;
 	};
 
-	std::shared_ptr<ITexture> ITexture::Create(std::shared_ptr<IApplication> App, LPCVOID Data, UINT Width, UINT Height)
+	std::shared_ptr<ITexture> Application::CreateTexture(LPCVOID Data, UINT Width, UINT Height)
 	{
-		return CreateInterface<Texture>(static_cast<Application*>(App.get()), Data, Width, Height);
+		return CreateInterface<Texture>(this, Data, Width, Height);
 	}
 }
+#endif
\ No newline at end of file
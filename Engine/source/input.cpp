@@ -0,0 +1,152 @@
+﻿#include "include/input.h"
+#include <cstring>
+
+namespace Engine
+{
+	InputQueue::InputQueue(size_t Capacity)
+	{
+		size_t Size = 2;
+		while (Size < Capacity)
+		{
+			Size <<= 1;
+		}
+
+		this->Event.resize(Size);
+		this->Mask = Size - 1;
+	}
+
+	bool InputQueue::Push(const INPUT_EVENT_STRUCT& Event)
+	{
+		const size_t Tail = this->Tail.load(std::memory_order_relaxed);
+
+		if (Tail - this->CachedHead > this->Mask)
+		{
+			this->CachedHead = this->Head.load(std::memory_order_acquire);
+			if (Tail - this->CachedHead > this->Mask)
+			{
+				this->DropCount.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+		}
+
+		this->Event[Tail & this->Mask] = Event;
+		this->Tail.store(Tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool InputQueue::Pop(INPUT_EVENT_STRUCT& Event)
+	{
+		const size_t Head = this->Head.load(std::memory_order_relaxed);
+
+		if (Head == this->CachedTail)
+		{
+			this->CachedTail = this->Tail.load(std::memory_order_acquire);
+			if (Head == this->CachedTail)
+			{
+				return false;
+			}
+		}
+
+		Event = this->Event[Head & this->Mask];
+		this->Head.store(Head + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t InputQueue::GetCapacity() const
+	{
+		return this->Event.size();
+	}
+
+	uint64_t InputQueue::GetDropCount() const
+	{
+		return this->DropCount.load(std::memory_order_relaxed);
+	}
+
+
+
+	size_t InputState::Update(InputQueue& Queue, uint64_t Timestamp)
+	{
+		memset(this->KeyPressed, 0, sizeof(this->KeyPressed));
+		memset(this->KeyReleased, 0, sizeof(this->KeyReleased));
+		this->MouseX = 0;
+		this->MouseY = 0;
+		this->EventCount = 0;
+		this->MaxLatency = 0;
+		this->TotalLatency = 0;
+
+		INPUT_EVENT_STRUCT Event;
+		while (Queue.Pop(Event))
+		{
+			switch (Event.Type)
+			{
+				case INPUT_EVENT_KEY_DOWN:
+				{
+					this->KeyPressed[Event.KeyCode] |= !this->KeyState[Event.KeyCode];
+					this->KeyState[Event.KeyCode] = true;
+					break;
+				}
+
+				case INPUT_EVENT_KEY_UP:
+				{
+					this->KeyReleased[Event.KeyCode] |= this->KeyState[Event.KeyCode];
+					this->KeyState[Event.KeyCode] = false;
+					break;
+				}
+
+				case INPUT_EVENT_MOUSE_MOVE:
+				{
+					this->MouseX += Event.X;
+					this->MouseY += Event.Y;
+					break;
+				}
+			}
+
+			const uint64_t Latency = Timestamp > Event.Timestamp ? Timestamp - Event.Timestamp : 0;
+			this->MaxLatency = Latency > this->MaxLatency ? Latency : this->MaxLatency;
+			this->TotalLatency += Latency;
+			this->EventCount++;
+		}
+
+		return this->EventCount;
+	}
+
+	int InputState::GetMouseDirectionX() const
+	{
+		return this->MouseX;
+	}
+
+	int InputState::GetMouseDirectionY() const
+	{
+		return this->MouseY;
+	}
+
+	bool InputState::GetKeyState(uint8_t KeyCode) const
+	{
+		return this->KeyState[KeyCode];
+	}
+
+	bool InputState::IsKeyPressed(uint8_t KeyCode) const
+	{
+		return this->KeyPressed[KeyCode];
+	}
+
+	bool InputState::IsKeyReleased(uint8_t KeyCode) const
+	{
+		return this->KeyReleased[KeyCode];
+	}
+
+	size_t InputState::GetEventCount() const
+	{
+		return this->EventCount;
+	}
+
+	uint64_t InputState::GetMaxLatency() const
+	{
+		return this->MaxLatency;
+	}
+
+	uint64_t InputState::GetMeanLatency() const
+	{
+		return this->EventCount ? this->TotalLatency / this->EventCount : 0;
+	}
+}
@@ -0,0 +1,825 @@
+﻿#include "include/meshbvh.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr size_t BinCount = 16;
+		constexpr uint32_t LeafSize = 4;
+		constexpr uint32_t MaxDepth = 48;
+		constexpr size_t StackSize = 128;
+
+		struct BIN_STRUCT
+		{
+			float Min[3];
+			float Max[3];
+			uint32_t Count;
+		};
+
+		float GetArea(const float* Min, const float* Max)
+		{
+			const float X = Max[0] - Min[0];
+			const float Y = Max[1] - Min[1];
+			const float Z = Max[2] - Min[2];
+			return X * Y + Y * Z + Z * X;
+		}
+
+		float Dot(const float* A, const float* B)
+		{
+			return A[0] * B[0] + A[1] * B[1] + A[2] * B[2];
+		}
+
+		void ClosestPointOnTriangle(const float* Point, const float* A, const float* B, const float* C, float* Result)
+		{
+			float AB[3], AC[3], AP[3];
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				AB[Axis] = B[Axis] - A[Axis];
+				AC[Axis] = C[Axis] - A[Axis];
+				AP[Axis] = Point[Axis] - A[Axis];
+			}
+
+			const float D1 = Dot(AB, AP);
+			const float D2 = Dot(AC, AP);
+			if (D1 <= 0.0f && D2 <= 0.0f)
+			{
+				memcpy(Result, A, sizeof(float) * 3);
+				return;
+			}
+
+			float BP[3];
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				BP[Axis] = Point[Axis] - B[Axis];
+			}
+
+			const float D3 = Dot(AB, BP);
+			const float D4 = Dot(AC, BP);
+			if (D3 >= 0.0f && D4 <= D3)
+			{
+				memcpy(Result, B, sizeof(float) * 3);
+				return;
+			}
+
+			const float VC = D1 * D4 - D3 * D2;
+			if (VC <= 0.0f && D1 >= 0.0f && D3 <= 0.0f)
+			{
+				const float V = D1 / (D1 - D3);
+				for (size_t Axis = 0; Axis < 3; Axis++)
+				{
+					Result[Axis] = A[Axis] + AB[Axis] * V;
+				}
+				return;
+			}
+
+			float CP[3];
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				CP[Axis] = Point[Axis] - C[Axis];
+			}
+
+			const float D5 = Dot(AB, CP);
+			const float D6 = Dot(AC, CP);
+			if (D6 >= 0.0f && D5 <= D6)
+			{
+				memcpy(Result, C, sizeof(float) * 3);
+				return;
+			}
+
+			const float VB = D5 * D2 - D1 * D6;
+			if (VB <= 0.0f && D2 >= 0.0f && D6 <= 0.0f)
+			{
+				const float W = D2 / (D2 - D6);
+				for (size_t Axis = 0; Axis < 3; Axis++)
+				{
+					Result[Axis] = A[Axis] + AC[Axis] * W;
+				}
+				return;
+			}
+
+			const float VA = D3 * D6 - D5 * D4;
+			if (VA <= 0.0f && (D4 - D3) >= 0.0f && (D5 - D6) >= 0.0f)
+			{
+				const float W = (D4 - D3) / ((D4 - D3) + (D5 - D6));
+				for (size_t Axis = 0; Axis < 3; Axis++)
+				{
+					Result[Axis] = B[Axis] + (C[Axis] - B[Axis]) * W;
+				}
+				return;
+			}
+
+			const float Denominator = 1.0f / (VA + VB + VC);
+			const float V = VB * Denominator;
+			const float W = VC * Denominator;
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				Result[Axis] = A[Axis] + AB[Axis] * V + AC[Axis] * W;
+			}
+		}
+	}
+
+
+
+	struct MeshBVH::BUILD_STRUCT
+	{
+		float Min[3];
+		float Max[3];
+		float Centroid[3];
+		uint32_t Triangle;
+	};
+
+	struct MeshBVH::TASK_STRUCT
+	{
+		uint32_t Node;
+		uint32_t First;
+		uint32_t Count;
+		uint32_t Depth;
+	};
+
+
+
+	void MeshBVH::Build(const void* Vertex, size_t VertexCount, size_t Stride, const uint32_t* Index, size_t IndexCount, ThreadPool* Pool)
+	{
+		this->Node.clear();
+		this->Pack.clear();
+		this->TriangleCount = IndexCount / 3;
+
+		if (this->TriangleCount == 0)
+		{
+			return;
+		}
+
+		auto GetPosition = [&](uint32_t Triangle, uint32_t Corner, float* Position)
+		{
+			const uint32_t VertexIndex = std::min(static_cast<size_t>(Index[Triangle * 3 + Corner]), VertexCount - 1);
+			memcpy(Position, static_cast<const uint8_t*>(Vertex) + VertexIndex * Stride, sizeof(float) * 3);
+		};
+
+		std::vector<BUILD_STRUCT> Record(this->TriangleCount);
+		for (uint32_t Triangle = 0; Triangle < this->TriangleCount; Triangle++)
+		{
+			float Corner[3][3];
+			for (uint32_t Vertex = 0; Vertex < 3; Vertex++)
+			{
+				GetPosition(Triangle, Vertex, Corner[Vertex]);
+			}
+
+			BUILD_STRUCT& Entry = Record[Triangle];
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				Entry.Min[Axis] = std::min({ Corner[0][Axis], Corner[1][Axis], Corner[2][Axis] });
+				Entry.Max[Axis] = std::max({ Corner[0][Axis], Corner[1][Axis], Corner[2][Axis] });
+				Entry.Centroid[Axis] = (Entry.Min[Axis] + Entry.Max[Axis]) * 0.5f;
+			}
+			Entry.Triangle = Triangle;
+		}
+
+		const size_t ThreadCount = Pool ? Pool->GetThreadCount() : 1;
+		const uint32_t TaskSize = ThreadCount > 1 ? static_cast<uint32_t>(std::max(this->TriangleCount / (ThreadCount * 4), static_cast<size_t>(1024))) : 0;
+
+		std::vector<TASK_STRUCT> Task;
+		this->Node.reserve(this->TriangleCount / 2 + 1);
+		this->Node.emplace_back();
+		this->BuildNode(this->Node, 0, Record.data(), 0, static_cast<uint32_t>(this->TriangleCount), 0, TaskSize, TaskSize > 0 ? &Task : nullptr);
+
+		if (!Task.empty())
+		{
+			std::vector<std::vector<NODE_STRUCT>> Local(Task.size());
+			Pool->Dispatch(Task.size(), [&](size_t Index)
+			{
+				const TASK_STRUCT& Current = Task[Index];
+				Local[Index].reserve(Current.Count / 2 + 1);
+				Local[Index].emplace_back();
+				this->BuildNode(Local[Index], 0, Record.data(), Current.First, Current.Count, Current.Depth, 0, nullptr);
+			});
+
+			for (size_t Index = 0; Index < Task.size(); Index++)
+			{
+				const uint32_t Base = static_cast<uint32_t>(this->Node.size()) - 1;
+				for (NODE_STRUCT& Entry : Local[Index])
+				{
+					if (Entry.Count == 0)
+					{
+						Entry.Offset += Base;
+					}
+				}
+
+				this->Node[Task[Index].Node] = Local[Index][0];
+				this->Node.insert(this->Node.end(), Local[Index].begin() + 1, Local[Index].end());
+			}
+		}
+
+		for (NODE_STRUCT& Entry : this->Node)
+		{
+			if (Entry.Count == 0)
+			{
+				continue;
+			}
+
+			PACK_STRUCT Current = {};
+			for (uint32_t Slot = 0; Slot < LeafSize; Slot++)
+			{
+				Current.Triangle[Slot] = Invalid;
+			}
+
+			for (uint32_t Slot = 0; Slot < Entry.Count; Slot++)
+			{
+				const uint32_t Triangle = Record[Entry.Offset + Slot].Triangle;
+
+				float Corner[3][3];
+				for (uint32_t Vertex = 0; Vertex < 3; Vertex++)
+				{
+					GetPosition(Triangle, Vertex, Corner[Vertex]);
+				}
+
+				Current.V0X[Slot] = Corner[0][0];
+				Current.V0Y[Slot] = Corner[0][1];
+				Current.V0Z[Slot] = Corner[0][2];
+				Current.E1X[Slot] = Corner[1][0] - Corner[0][0];
+				Current.E1Y[Slot] = Corner[1][1] - Corner[0][1];
+				Current.E1Z[Slot] = Corner[1][2] - Corner[0][2];
+				Current.E2X[Slot] = Corner[2][0] - Corner[0][0];
+				Current.E2Y[Slot] = Corner[2][1] - Corner[0][1];
+				Current.E2Z[Slot] = Corner[2][2] - Corner[0][2];
+				Current.Triangle[Slot] = Triangle;
+			}
+
+			Entry.Offset = static_cast<uint32_t>(this->Pack.size());
+			this->Pack.push_back(Current);
+		}
+	}
+
+	void MeshBVH::BuildNode(std::vector<NODE_STRUCT>& Target, uint32_t Node, BUILD_STRUCT* Record, uint32_t First, uint32_t Count, uint32_t Depth, uint32_t TaskSize, std::vector<TASK_STRUCT>* Task) const
+	{
+		float Min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float Max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		float CentroidMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float CentroidMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		BUILD_STRUCT* Range = Record + First;
+		for (uint32_t Index = 0; Index < Count; Index++)
+		{
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				Min[Axis] = std::min(Min[Axis], Range[Index].Min[Axis]);
+				Max[Axis] = std::max(Max[Axis], Range[Index].Max[Axis]);
+				CentroidMin[Axis] = std::min(CentroidMin[Axis], Range[Index].Centroid[Axis]);
+				CentroidMax[Axis] = std::max(CentroidMax[Axis], Range[Index].Centroid[Axis]);
+			}
+		}
+
+		memcpy(Target[Node].Min, Min, sizeof(Min));
+		memcpy(Target[Node].Max, Max, sizeof(Max));
+
+		if (Count <= LeafSize)
+		{
+			Target[Node].Offset = First;
+			Target[Node].Count = Count;
+			return;
+		}
+
+		if (Task && Count <= TaskSize)
+		{
+			Task->push_back({ Node, First, Count, Depth });
+			Target[Node].Offset = 0;
+			Target[Node].Count = 0;
+			return;
+		}
+
+		size_t Axis = 0;
+		for (size_t Component = 1; Component < 3; Component++)
+		{
+			if (CentroidMax[Component] - CentroidMin[Component] > CentroidMax[Axis] - CentroidMin[Axis])
+			{
+				Axis = Component;
+			}
+		}
+
+		uint32_t Split = 0;
+		const float Length = CentroidMax[Axis] - CentroidMin[Axis];
+
+		if (Length > 0.0f && Depth < MaxDepth)
+		{
+			BIN_STRUCT Bin[BinCount];
+			for (BIN_STRUCT& Entry : Bin)
+			{
+				Entry = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX }, 0 };
+			}
+
+			const float Scale = BinCount / Length;
+			auto GetBin = [&](const BUILD_STRUCT& Entry)
+			{
+				return std::min(static_cast<size_t>((Entry.Centroid[Axis] - CentroidMin[Axis]) * Scale), BinCount - 1);
+			};
+
+			for (uint32_t Index = 0; Index < Count; Index++)
+			{
+				BIN_STRUCT& Entry = Bin[GetBin(Range[Index])];
+				for (size_t Component = 0; Component < 3; Component++)
+				{
+					Entry.Min[Component] = std::min(Entry.Min[Component], Range[Index].Min[Component]);
+					Entry.Max[Component] = std::max(Entry.Max[Component], Range[Index].Max[Component]);
+				}
+				Entry.Count++;
+			}
+
+			float RightArea[BinCount];
+			uint32_t RightCount[BinCount];
+			BIN_STRUCT Accumulate = Bin[BinCount - 1];
+			for (size_t Index = BinCount - 1; Index > 0; Index--)
+			{
+				for (size_t Component = 0; Component < 3; Component++)
+				{
+					Accumulate.Min[Component] = std::min(Accumulate.Min[Component], Bin[Index].Min[Component]);
+					Accumulate.Max[Component] = std::max(Accumulate.Max[Component], Bin[Index].Max[Component]);
+				}
+				RightCount[Index] = (Index == BinCount - 1 ? 0 : RightCount[Index + 1]) + Bin[Index].Count;
+				RightArea[Index] = RightCount[Index] > 0 ? GetArea(Accumulate.Min, Accumulate.Max) : 0.0f;
+			}
+
+			float BestCost = FLT_MAX;
+			size_t BestBin = 0;
+			uint32_t LeftCount = 0;
+			Accumulate = Bin[0];
+			for (size_t Index = 0; Index + 1 < BinCount; Index++)
+			{
+				for (size_t Component = 0; Component < 3; Component++)
+				{
+					Accumulate.Min[Component] = std::min(Accumulate.Min[Component], Bin[Index].Min[Component]);
+					Accumulate.Max[Component] = std::max(Accumulate.Max[Component], Bin[Index].Max[Component]);
+				}
+				LeftCount += Bin[Index].Count;
+
+				if (LeftCount == 0 || RightCount[Index + 1] == 0)
+				{
+					continue;
+				}
+
+				const float Cost = GetArea(Accumulate.Min, Accumulate.Max) * LeftCount + RightArea[Index + 1] * RightCount[Index + 1];
+				if (Cost < BestCost)
+				{
+					BestCost = Cost;
+					BestBin = Index;
+				}
+			}
+
+			if (BestCost < FLT_MAX)
+			{
+				Split = static_cast<uint32_t>(std::partition(Range, Range + Count, [&](const BUILD_STRUCT& Entry) { return GetBin(Entry) <= BestBin; }) - Range);
+			}
+		}
+
+		if (Split == 0 || Split == Count)
+		{
+			Split = Count / 2;
+			std::nth_element(Range, Range + Split, Range + Count, [&](const BUILD_STRUCT& A, const BUILD_STRUCT& B) { return A.Centroid[Axis] < B.Centroid[Axis]; });
+		}
+
+		const uint32_t Child = static_cast<uint32_t>(Target.size());
+		Target.emplace_back();
+		Target.emplace_back();
+		Target[Node].Offset = Child;
+		Target[Node].Count = 0;
+
+		this->BuildNode(Target, Child, Record, First, Split, Depth + 1, TaskSize, Task);
+		this->BuildNode(Target, Child + 1, Record, First + Split, Count - Split, Depth + 1, TaskSize, Task);
+	}
+
+	bool MeshBVH::Raycast(const float* Origin, const float* Direction, float MaxDistance, MESH_RAY_HIT_STRUCT& Hit) const
+	{
+		Hit.Triangle = Invalid;
+		Hit.Distance = MaxDistance;
+		Hit.U = 0.0f;
+		Hit.V = 0.0f;
+
+		if (this->Node.empty())
+		{
+			return false;
+		}
+
+		float Inverse[3];
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			Inverse[Axis] = 1.0f / (std::fabs(Direction[Axis]) > 1e-20f ? Direction[Axis] : std::copysign(1e-20f, Direction[Axis]));
+		}
+
+		auto Enter = [&](const NODE_STRUCT& Box)
+		{
+			float Near = 0.0f;
+			float Far = Hit.Distance;
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				const float A = (Box.Min[Axis] - Origin[Axis]) * Inverse[Axis];
+				const float B = (Box.Max[Axis] - Origin[Axis]) * Inverse[Axis];
+				Near = std::max(Near, std::min(A, B));
+				Far = std::min(Far, std::max(A, B));
+			}
+			return Near <= Far ? Near : FLT_MAX;
+		};
+
+		const __m128 OriginX = _mm_set1_ps(Origin[0]);
+		const __m128 OriginY = _mm_set1_ps(Origin[1]);
+		const __m128 OriginZ = _mm_set1_ps(Origin[2]);
+		const __m128 DirectionX = _mm_set1_ps(Direction[0]);
+		const __m128 DirectionY = _mm_set1_ps(Direction[1]);
+		const __m128 DirectionZ = _mm_set1_ps(Direction[2]);
+		const __m128 Epsilon = _mm_set1_ps(1e-12f);
+		const __m128 Zero = _mm_setzero_ps();
+		const __m128 One = _mm_set1_ps(1.0f);
+
+		uint32_t Stack[StackSize];
+		size_t Size = 0;
+		uint32_t Current = Enter(this->Node[0]) < FLT_MAX ? 0 : Invalid;
+
+		while (Current != Invalid || Size > 0)
+		{
+			if (Current == Invalid)
+			{
+				Current = Stack[--Size];
+			}
+
+			const NODE_STRUCT& Entry = this->Node[Current];
+			if (Entry.Count > 0)
+			{
+				const PACK_STRUCT& Pack = this->Pack[Entry.Offset];
+
+				const __m128 E1X = _mm_load_ps(Pack.E1X), E1Y = _mm_load_ps(Pack.E1Y), E1Z = _mm_load_ps(Pack.E1Z);
+				const __m128 E2X = _mm_load_ps(Pack.E2X), E2Y = _mm_load_ps(Pack.E2Y), E2Z = _mm_load_ps(Pack.E2Z);
+
+				const __m128 PX = _mm_sub_ps(_mm_mul_ps(DirectionY, E2Z), _mm_mul_ps(DirectionZ, E2Y));
+				const __m128 PY = _mm_sub_ps(_mm_mul_ps(DirectionZ, E2X), _mm_mul_ps(DirectionX, E2Z));
+				const __m128 PZ = _mm_sub_ps(_mm_mul_ps(DirectionX, E2Y), _mm_mul_ps(DirectionY, E2X));
+				const __m128 Determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(E1X, PX), _mm_mul_ps(E1Y, PY)), _mm_mul_ps(E1Z, PZ));
+				const __m128 InverseDeterminant = _mm_div_ps(One, Determinant);
+
+				const __m128 TX = _mm_sub_ps(OriginX, _mm_load_ps(Pack.V0X));
+				const __m128 TY = _mm_sub_ps(OriginY, _mm_load_ps(Pack.V0Y));
+				const __m128 TZ = _mm_sub_ps(OriginZ, _mm_load_ps(Pack.V0Z));
+				const __m128 U = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(TX, PX), _mm_mul_ps(TY, PY)), _mm_mul_ps(TZ, PZ)), InverseDeterminant);
+
+				const __m128 QX = _mm_sub_ps(_mm_mul_ps(TY, E1Z), _mm_mul_ps(TZ, E1Y));
+				const __m128 QY = _mm_sub_ps(_mm_mul_ps(TZ, E1X), _mm_mul_ps(TX, E1Z));
+				const __m128 QZ = _mm_sub_ps(_mm_mul_ps(TX, E1Y), _mm_mul_ps(TY, E1X));
+				const __m128 V = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(DirectionX, QX), _mm_mul_ps(DirectionY, QY)), _mm_mul_ps(DirectionZ, QZ)), InverseDeterminant);
+				const __m128 T = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(E2X, QX), _mm_mul_ps(E2Y, QY)), _mm_mul_ps(E2Z, QZ)), InverseDeterminant);
+
+				__m128 Mask = _mm_cmpgt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), Determinant), Epsilon);
+				Mask = _mm_and_ps(Mask, _mm_and_ps(_mm_cmpge_ps(U, Zero), _mm_cmpge_ps(V, Zero)));
+				Mask = _mm_and_ps(Mask, _mm_cmple_ps(_mm_add_ps(U, V), One));
+				Mask = _mm_and_ps(Mask, _mm_and_ps(_mm_cmpge_ps(T, Zero), _mm_cmplt_ps(T, _mm_set1_ps(Hit.Distance))));
+
+				const int Bits = _mm_movemask_ps(Mask);
+				if (Bits)
+				{
+					alignas(16) float Distance[4], BarycentricU[4], BarycentricV[4];
+					_mm_store_ps(Distance, T);
+					_mm_store_ps(BarycentricU, U);
+					_mm_store_ps(BarycentricV, V);
+
+					for (int Slot = 0; Slot < 4; Slot++)
+					{
+						if ((Bits & (1 << Slot)) && Distance[Slot] < Hit.Distance)
+						{
+							Hit.Triangle = Pack.Triangle[Slot];
+							Hit.Distance = Distance[Slot];
+							Hit.U = BarycentricU[Slot];
+							Hit.V = BarycentricV[Slot];
+						}
+					}
+				}
+
+				Current = Invalid;
+				continue;
+			}
+
+			const float Left = Enter(this->Node[Entry.Offset]);
+			const float Right = Enter(this->Node[Entry.Offset + 1]);
+
+			if (Left == FLT_MAX && Right == FLT_MAX)
+			{
+				Current = Invalid;
+			}
+			else if (Left == FLT_MAX || Right == FLT_MAX)
+			{
+				Current = Left == FLT_MAX ? Entry.Offset + 1 : Entry.Offset;
+			}
+			else
+			{
+				const bool LeftFirst = Left <= Right;
+				Stack[Size++] = LeftFirst ? Entry.Offset + 1 : Entry.Offset;
+				Current = LeftFirst ? Entry.Offset : Entry.Offset + 1;
+			}
+		}
+
+		return Hit.Triangle != Invalid;
+	}
+
+	void MeshBVH::Raycast4(const MESH_RAY_PACKET_STRUCT& Packet, MESH_RAY_HIT_STRUCT* Hit) const
+	{
+		for (size_t Ray = 0; Ray < 4; Ray++)
+		{
+			Hit[Ray] = { Invalid, Packet.MaxDistance[Ray], 0.0f, 0.0f };
+		}
+
+		if (this->Node.empty())
+		{
+			return;
+		}
+
+		const __m128 OriginX = _mm_loadu_ps(Packet.OriginX);
+		const __m128 OriginY = _mm_loadu_ps(Packet.OriginY);
+		const __m128 OriginZ = _mm_loadu_ps(Packet.OriginZ);
+		const __m128 DirectionX = _mm_loadu_ps(Packet.DirectionX);
+		const __m128 DirectionY = _mm_loadu_ps(Packet.DirectionY);
+		const __m128 DirectionZ = _mm_loadu_ps(Packet.DirectionZ);
+		const __m128 Zero = _mm_setzero_ps();
+		const __m128 One = _mm_set1_ps(1.0f);
+		const __m128 Epsilon = _mm_set1_ps(1e-12f);
+		const __m128 Sign = _mm_set1_ps(-0.0f);
+
+		auto Reciprocal = [&](__m128 Value)
+		{
+			const __m128 Small = _mm_cmplt_ps(_mm_andnot_ps(Sign, Value), _mm_set1_ps(1e-20f));
+			const __m128 Safe = _mm_or_ps(_mm_and_ps(Small, _mm_or_ps(_mm_set1_ps(1e-20f), _mm_and_ps(Sign, Value))), _mm_andnot_ps(Small, Value));
+			return _mm_div_ps(One, Safe);
+		};
+
+		const __m128 InverseX = Reciprocal(DirectionX);
+		const __m128 InverseY = Reciprocal(DirectionY);
+		const __m128 InverseZ = Reciprocal(DirectionZ);
+
+		__m128 Distance = _mm_loadu_ps(Packet.MaxDistance);
+
+		auto Enter = [&](const NODE_STRUCT& Box, __m128& Near)
+		{
+			const __m128 AX = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(Box.Min[0]), OriginX), InverseX);
+			const __m128 BX = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(Box.Max[0]), OriginX), InverseX);
+			const __m128 AY = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(Box.Min[1]), OriginY), InverseY);
+			const __m128 BY = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(Box.Max[1]), OriginY), InverseY);
+			const __m128 AZ = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(Box.Min[2]), OriginZ), InverseZ);
+			const __m128 BZ = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(Box.Max[2]), OriginZ), InverseZ);
+
+			Near = _mm_max_ps(_mm_max_ps(_mm_min_ps(AX, BX), _mm_min_ps(AY, BY)), _mm_max_ps(_mm_min_ps(AZ, BZ), Zero));
+			const __m128 Far = _mm_min_ps(_mm_min_ps(_mm_max_ps(AX, BX), _mm_max_ps(AY, BY)), _mm_min_ps(_mm_max_ps(AZ, BZ), Distance));
+			return _mm_movemask_ps(_mm_cmple_ps(Near, Far));
+		};
+
+		__m128 Near;
+		if (!Enter(this->Node[0], Near))
+		{
+			return;
+		}
+
+		__m128i Triangle = _mm_set1_epi32(-1);
+		__m128 BarycentricU = Zero;
+		__m128 BarycentricV = Zero;
+
+		uint32_t Stack[StackSize];
+		size_t Size = 0;
+		Stack[Size++] = 0;
+
+		while (Size > 0)
+		{
+			const NODE_STRUCT& Entry = this->Node[Stack[--Size]];
+
+			if (Entry.Count == 0)
+			{
+				__m128 LeftNear, RightNear;
+				const int Left = Enter(this->Node[Entry.Offset], LeftNear);
+				const int Right = Enter(this->Node[Entry.Offset + 1], RightNear);
+
+				if (Left && Right)
+				{
+					alignas(16) float LeftDistance[4], RightDistance[4];
+					_mm_store_ps(LeftDistance, LeftNear);
+					_mm_store_ps(RightDistance, RightNear);
+
+					float LeftMin = FLT_MAX;
+					float RightMin = FLT_MAX;
+					for (int Ray = 0; Ray < 4; Ray++)
+					{
+						LeftMin = (Left & (1 << Ray)) ? std::min(LeftMin, LeftDistance[Ray]) : LeftMin;
+						RightMin = (Right & (1 << Ray)) ? std::min(RightMin, RightDistance[Ray]) : RightMin;
+					}
+
+					Stack[Size++] = LeftMin <= RightMin ? Entry.Offset + 1 : Entry.Offset;
+					Stack[Size++] = LeftMin <= RightMin ? Entry.Offset : Entry.Offset + 1;
+				}
+				else if (Left || Right)
+				{
+					Stack[Size++] = Left ? Entry.Offset : Entry.Offset + 1;
+				}
+				continue;
+			}
+
+			const PACK_STRUCT& Pack = this->Pack[Entry.Offset];
+			for (uint32_t Slot = 0; Slot < Entry.Count; Slot++)
+			{
+				const __m128 E1X = _mm_set1_ps(Pack.E1X[Slot]), E1Y = _mm_set1_ps(Pack.E1Y[Slot]), E1Z = _mm_set1_ps(Pack.E1Z[Slot]);
+				const __m128 E2X = _mm_set1_ps(Pack.E2X[Slot]), E2Y = _mm_set1_ps(Pack.E2Y[Slot]), E2Z = _mm_set1_ps(Pack.E2Z[Slot]);
+
+				const __m128 PX = _mm_sub_ps(_mm_mul_ps(DirectionY, E2Z), _mm_mul_ps(DirectionZ, E2Y));
+				const __m128 PY = _mm_sub_ps(_mm_mul_ps(DirectionZ, E2X), _mm_mul_ps(DirectionX, E2Z));
+				const __m128 PZ = _mm_sub_ps(_mm_mul_ps(DirectionX, E2Y), _mm_mul_ps(DirectionY, E2X));
+				const __m128 Determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(E1X, PX), _mm_mul_ps(E1Y, PY)), _mm_mul_ps(E1Z, PZ));
+				const __m128 InverseDeterminant = _mm_div_ps(One, Determinant);
+
+				const __m128 TX = _mm_sub_ps(OriginX, _mm_set1_ps(Pack.V0X[Slot]));
+				const __m128 TY = _mm_sub_ps(OriginY, _mm_set1_ps(Pack.V0Y[Slot]));
+				const __m128 TZ = _mm_sub_ps(OriginZ, _mm_set1_ps(Pack.V0Z[Slot]));
+				const __m128 U = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(TX, PX), _mm_mul_ps(TY, PY)), _mm_mul_ps(TZ, PZ)), InverseDeterminant);
+
+				const __m128 QX = _mm_sub_ps(_mm_mul_ps(TY, E1Z), _mm_mul_ps(TZ, E1Y));
+				const __m128 QY = _mm_sub_ps(_mm_mul_ps(TZ, E1X), _mm_mul_ps(TX, E1Z));
+				const __m128 QZ = _mm_sub_ps(_mm_mul_ps(TX, E1Y), _mm_mul_ps(TY, E1X));
+				const __m128 V = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(DirectionX, QX), _mm_mul_ps(DirectionY, QY)), _mm_mul_ps(DirectionZ, QZ)), InverseDeterminant);
+				const __m128 T = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(E2X, QX), _mm_mul_ps(E2Y, QY)), _mm_mul_ps(E2Z, QZ)), InverseDeterminant);
+
+				__m128 Mask = _mm_cmpgt_ps(_mm_andnot_ps(Sign, Determinant), Epsilon);
+				Mask = _mm_and_ps(Mask, _mm_and_ps(_mm_cmpge_ps(U, Zero), _mm_cmpge_ps(V, Zero)));
+				Mask = _mm_and_ps(Mask, _mm_cmple_ps(_mm_add_ps(U, V), One));
+				Mask = _mm_and_ps(Mask, _mm_and_ps(_mm_cmpge_ps(T, Zero), _mm_cmplt_ps(T, Distance)));
+
+				Distance = _mm_or_ps(_mm_and_ps(Mask, T), _mm_andnot_ps(Mask, Distance));
+				BarycentricU = _mm_or_ps(_mm_and_ps(Mask, U), _mm_andnot_ps(Mask, BarycentricU));
+				BarycentricV = _mm_or_ps(_mm_and_ps(Mask, V), _mm_andnot_ps(Mask, BarycentricV));
+				const __m128i Select = _mm_castps_si128(Mask);
+				Triangle = _mm_or_si128(_mm_and_si128(Select, _mm_set1_epi32(static_cast<int>(Pack.Triangle[Slot]))), _mm_andnot_si128(Select, Triangle));
+			}
+		}
+
+		alignas(16) float Result[3][4];
+		alignas(16) uint32_t ResultTriangle[4];
+		_mm_store_ps(Result[0], Distance);
+		_mm_store_ps(Result[1], BarycentricU);
+		_mm_store_ps(Result[2], BarycentricV);
+		_mm_store_si128(reinterpret_cast<__m128i*>(ResultTriangle), Triangle);
+
+		for (size_t Ray = 0; Ray < 4; Ray++)
+		{
+			Hit[Ray] = { ResultTriangle[Ray], Result[0][Ray], Result[1][Ray], Result[2][Ray] };
+		}
+	}
+
+	template<class Function>
+	void MeshBVH::QueryPack(const float* Center, float Radius, const Function& Callback) const
+	{
+		if (this->Node.empty())
+		{
+			return;
+		}
+
+		auto Overlap = [&](const NODE_STRUCT& Box)
+		{
+			float Distance = 0.0f;
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				const float Offset = Center[Axis] - std::min(std::max(Center[Axis], Box.Min[Axis]), Box.Max[Axis]);
+				Distance += Offset * Offset;
+			}
+			return Distance <= Radius * Radius;
+		};
+
+		uint32_t Stack[StackSize];
+		size_t Size = 0;
+		if (Overlap(this->Node[0]))
+		{
+			Stack[Size++] = 0;
+		}
+
+		while (Size > 0)
+		{
+			const NODE_STRUCT& Entry = this->Node[Stack[--Size]];
+			if (Entry.Count > 0)
+			{
+				const PACK_STRUCT& Pack = this->Pack[Entry.Offset];
+				for (uint32_t Slot = 0; Slot < Entry.Count; Slot++)
+				{
+					const float A[3] = { Pack.V0X[Slot], Pack.V0Y[Slot], Pack.V0Z[Slot] };
+					const float B[3] = { A[0] + Pack.E1X[Slot], A[1] + Pack.E1Y[Slot], A[2] + Pack.E1Z[Slot] };
+					const float C[3] = { A[0] + Pack.E2X[Slot], A[1] + Pack.E2Y[Slot], A[2] + Pack.E2Z[Slot] };
+					Callback(Pack.Triangle[Slot], A, B, C);
+				}
+				continue;
+			}
+
+			for (uint32_t Child = 0; Child < 2; Child++)
+			{
+				if (Overlap(this->Node[Entry.Offset + Child]))
+				{
+					Stack[Size++] = Entry.Offset + Child;
+				}
+			}
+		}
+	}
+
+	size_t MeshBVH::QuerySphere(const float* Center, float Radius, std::vector<uint32_t>& Triangle) const
+	{
+		Triangle.clear();
+		this->QueryPack(Center, Radius, [&](uint32_t Index, const float* A, const float* B, const float* C)
+		{
+			float Closest[3];
+			ClosestPointOnTriangle(Center, A, B, C, Closest);
+
+			const float Offset[3] = { Center[0] - Closest[0], Center[1] - Closest[1], Center[2] - Closest[2] };
+			if (Dot(Offset, Offset) <= Radius * Radius)
+			{
+				Triangle.push_back(Index);
+			}
+		});
+		return Triangle.size();
+	}
+
+	bool MeshBVH::ResolveSphere(float* Center, float Radius, size_t IterationCount) const
+	{
+		bool Moved = false;
+
+		for (size_t Iteration = 0; Iteration < IterationCount; Iteration++)
+		{
+			float Push[3] = {};
+			float Deepest = 0.0f;
+
+			this->QueryPack(Center, Radius, [&](uint32_t, const float* A, const float* B, const float* C)
+			{
+				float Closest[3];
+				ClosestPointOnTriangle(Center, A, B, C, Closest);
+
+				float Offset[3] = { Center[0] - Closest[0], Center[1] - Closest[1], Center[2] - Closest[2] };
+				const float Length = std::sqrt(Dot(Offset, Offset));
+				if (Length >= Radius || Radius - Length <= Deepest)
+				{
+					return;
+				}
+
+				if (Length > 1e-6f)
+				{
+					for (float& Component : Offset)
+					{
+						Component /= Length;
+					}
+				}
+				else
+				{
+					const float AB[3] = { B[0] - A[0], B[1] - A[1], B[2] - A[2] };
+					const float AC[3] = { C[0] - A[0], C[1] - A[1], C[2] - A[2] };
+					Offset[0] = AB[1] * AC[2] - AB[2] * AC[1];
+					Offset[1] = AB[2] * AC[0] - AB[0] * AC[2];
+					Offset[2] = AB[0] * AC[1] - AB[1] * AC[0];
+
+					const float Normal = std::sqrt(Dot(Offset, Offset));
+					if (Normal <= 0.0f)
+					{
+						return;
+					}
+					for (float& Component : Offset)
+					{
+						Component /= Normal;
+					}
+				}
+
+				Deepest = Radius - Length;
+				for (size_t Axis = 0; Axis < 3; Axis++)
+				{
+					Push[Axis] = Offset[Axis] * Deepest;
+				}
+			});
+
+			if (Deepest <= 0.0f)
+			{
+				break;
+			}
+
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				Center[Axis] += Push[Axis];
+			}
+			Moved = true;
+		}
+
+		return Moved;
+	}
+
+	BOUNDING_BOX_STRUCT MeshBVH::GetBounds() const
+	{
+		BOUNDING_BOX_STRUCT Box = {};
+		if (!this->Node.empty())
+		{
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				Box.Center[Axis] = (this->Node[0].Min[Axis] + this->Node[0].Max[Axis]) * 0.5f;
+				Box.Extent[Axis] = (this->Node[0].Max[Axis] - this->Node[0].Min[Axis]) * 0.5f;
+			}
+		}
+		return Box;
+	}
+
+	size_t MeshBVH::GetTriangleCount() const
+	{
+		return this->TriangleCount;
+	}
+}
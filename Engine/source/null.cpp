@@ -0,0 +1,861 @@
+﻿#include "source/backend.h"
+#include <cstring>
+#include <deque>
+#include <vector>
+
+namespace Engine
+{
+	enum NULL_COMMAND : UINT
+	{
+		NULL_COMMAND_VERTEX_SHADER = 0,
+		NULL_COMMAND_PIXEL_SHADER = 1,
+		NULL_COMMAND_VERTEX_CONSTANT = 2,
+		NULL_COMMAND_PIXEL_CONSTANT = 3,
+		NULL_COMMAND_VERTEX_BUFFER = 4,
+		NULL_COMMAND_INDEX_BUFFER = 5,
+		NULL_COMMAND_INSTANCE_BUFFER = 6,
+		NULL_COMMAND_TEXTURE = 7,
+		NULL_COMMAND_UPLOAD = 8,
+		NULL_COMMAND_DRAW = 9,
+	};
+
+	struct NULL_COMMAND_STRUCT
+	{
+		NULL_COMMAND Type;
+		const void* Object;
+		UINT Slot;
+		UINT IndexCount;
+		UINT InstanceCount;
+		SIZE_T Size;
+	};
+
+	class NullContext : public ICommandContext
+	{
+	public:
+		NullContext(bool Record, std::shared_ptr<BackendCounter> Counter)
+		{
+			this->Record = Record;
+			this->Counter = Counter;
+		}
+
+		void Draw(UINT IndexCount, UINT /*StartIndex*/, INT /*BaseVertex*/) override
+		{
+			this->Apply({ NULL_COMMAND_DRAW, nullptr, 0, IndexCount, 1, 0 });
+		}
+
+		void DrawInstanced(UINT IndexCount, UINT InstanceCount, UINT /*StartIndex*/, INT /*BaseVertex*/) override
+		{
+			this->Apply({ NULL_COMMAND_DRAW, nullptr, 0, IndexCount, InstanceCount, 0 });
+		}
+
+		void Apply(const NULL_COMMAND_STRUCT& Command)
+		{
+			if (this->Record)
+			{
+				this->Command.push_back(Command);
+				return;
+			}
+
+			switch (Command.Type)
+			{
+				case NULL_COMMAND_VERTEX_SHADER:
+				{
+					this->Statistics.VertexShader = Command.Object;
+					break;
+				}
+
+				case NULL_COMMAND_PIXEL_SHADER:
+				{
+					this->Statistics.PixelShader = Command.Object;
+					break;
+				}
+
+				case NULL_COMMAND_VERTEX_CONSTANT:
+				{
+					this->Statistics.VertexConstant[Command.Slot] = Command.Object;
+					break;
+				}
+
+				case NULL_COMMAND_PIXEL_CONSTANT:
+				{
+					this->Statistics.PixelConstant[Command.Slot] = Command.Object;
+					break;
+				}
+
+				case NULL_COMMAND_VERTEX_BUFFER:
+				{
+					this->Statistics.VertexBuffer = Command.Object;
+					break;
+				}
+
+				case NULL_COMMAND_INDEX_BUFFER:
+				{
+					this->Statistics.IndexBuffer = Command.Object;
+					break;
+				}
+
+				case NULL_COMMAND_INSTANCE_BUFFER:
+				{
+					this->Statistics.InstanceBuffer = Command.Object;
+					break;
+				}
+
+				case NULL_COMMAND_TEXTURE:
+				{
+					this->Statistics.Texture = Command.Object;
+					break;
+				}
+
+				case NULL_COMMAND_UPLOAD:
+				{
+					this->Statistics.UploadCount++;
+					this->Statistics.UploadBytes += Command.Size;
+					return;
+				}
+
+				case NULL_COMMAND_DRAW:
+				{
+					this->Counter->Draw(Command.IndexCount, Command.InstanceCount);
+					this->Statistics.DrawCount++;
+					this->Statistics.IndexCount += static_cast<uint64_t>(Command.IndexCount) * Command.InstanceCount;
+					this->Statistics.InstanceCount += Command.InstanceCount;
+					return;
+				}
+			}
+
+			this->Counter->Bind();
+			this->Statistics.BindCount++;
+		}
+
+		NULL_STATISTICS_STRUCT Statistics = {};
+		std::vector<NULL_COMMAND_STRUCT> Command;
+		std::shared_ptr<BackendCounter> Counter;
+	private:
+		bool Record = false;
+	};
+
+	inline NullContext* GetNullContext(ICommandContext* Context)
+	{
+		return static_cast<NullContext*>(Context);
+	}
+
+	inline UINT CheckConstantSlot(UINT Slot)
+	{
+		if (Slot > CONSTANT_SLOT_OBJECT)
+		{
+			throw E_INVALIDARG;
+		}
+		return Slot;
+	}
+
+
+
+	class NullRing
+	{
+	public:
+		NullRing(std::shared_ptr<NullContext> Immediate, SIZE_T Capacity, SIZE_T Alignment) : Ring(AlignUp(Capacity, Alignment), Alignment)
+		{
+			this->Immediate = Immediate;
+		}
+
+		SIZE_T Allocate(SIZE_T Size)
+		{
+			if (this->LastFrame != this->Immediate->Statistics.FrameCount)
+			{
+				this->Ring.Reset();
+				this->LastFrame = this->Immediate->Statistics.FrameCount;
+			}
+
+			SIZE_T Offset = this->Ring.Allocate(Size);
+			if (Offset == RingAllocator::Invalid)
+			{
+				this->Ring.Reset();
+				Offset = this->Ring.Allocate(Size);
+
+				if (Offset == RingAllocator::Invalid)
+				{
+					throw E_OUTOFMEMORY;
+				}
+			}
+
+			this->Immediate->Apply({ NULL_COMMAND_UPLOAD, nullptr, 0, 0, 0, Size });
+			return Offset;
+		}
+	private:
+		RingAllocator Ring;
+		std::shared_ptr<NullContext> Immediate;
+		uint64_t LastFrame = 0;
+	};
+
+
+
+	class NullApplication : public Backend, public INullApplication
+	{
+	public:
+		NullApplication(UINT Width, UINT Height)
+		{
+			this->Immediate = std::make_shared<NullContext>(false, this->Counter);
+			this->Width = Width;
+			this->Height = Height;
+		}
+
+		bool Run() override
+		{
+			if (this->Exit)
+			{
+				return false;
+			}
+
+			const NULL_INPUT_STRUCT Previous = this->Input;
+			this->Input = {};
+
+			if (this->Scripted)
+			{
+				if (this->Script.empty())
+				{
+					return false;
+				}
+
+				this->Input = this->Script.front();
+				this->Script.pop_front();
+			}
+
+			const uint64_t Timestamp = GetTimestamp();
+
+			for (UINT KeyCode = 0; KeyCode < sizeof(this->Input.KeyState); KeyCode++)
+			{
+				if (this->Input.KeyState[KeyCode] != Previous.KeyState[KeyCode])
+				{
+					this->InputEvent.Push({ Timestamp, this->Input.KeyState[KeyCode] ? INPUT_EVENT_KEY_DOWN : INPUT_EVENT_KEY_UP, static_cast<uint8_t>(KeyCode), 0, 0 });
+				}
+			}
+
+			if (this->Input.MouseDirectionX || this->Input.MouseDirectionY)
+			{
+				this->InputEvent.Push({ Timestamp, INPUT_EVENT_MOUSE_MOVE, 0, this->Input.MouseDirectionX, this->Input.MouseDirectionY });
+			}
+
+			return true;
+		}
+
+		void Quit() override
+		{
+			this->Exit = true;
+		}
+
+		int GetWidth() const override
+		{
+			return this->Width;
+		}
+
+		int GetHeight() const override
+		{
+			return this->Height;
+		}
+
+		int GetMouseDirectionX() const override
+		{
+			return this->Input.MouseDirectionX;
+		}
+
+		int GetMouseDirectionY() const override
+		{
+			return this->Input.MouseDirectionY;
+		}
+
+		bool GetKeyState(BYTE KeyCode) const override
+		{
+			return KeyCode < sizeof(this->Input.KeyState) && this->Input.KeyState[KeyCode];
+		}
+
+		bool ResizeBuffer(UINT /*BufferCount*/, UINT Width, UINT Height, UINT /*SampleCount*/) override
+		{
+			if (Width)
+			{
+				this->Width = Width;
+			}
+
+			if (Height)
+			{
+				this->Height = Height;
+			}
+
+			return true;
+		}
+
+		void BeginDraw(float /*R*/, float /*G*/, float /*B*/, float /*A*/) override
+		{
+		}
+
+		bool EndDraw(UINT /*SyncInterval*/) override
+		{
+			this->Flush();
+			this->Immediate->Statistics.FrameCount++;
+			this->EndFrame();
+			return true;
+		}
+
+		void Draw(UINT IndexCount, UINT StartIndex, INT BaseVertex) override
+		{
+			this->Immediate->Draw(IndexCount, StartIndex, BaseVertex);
+		}
+
+		void DrawInstanced(UINT IndexCount, UINT InstanceCount, UINT StartIndex, INT BaseVertex) override
+		{
+			this->Immediate->DrawInstanced(IndexCount, InstanceCount, StartIndex, BaseVertex);
+		}
+
+		ICommandContext* GetContext() override
+		{
+			return this->Immediate.get();
+		}
+
+		void Execute(ICommandList* const* List, UINT Count) override;
+
+		void PushInput(const NULL_INPUT_STRUCT& Input) override
+		{
+			this->Script.push_back(Input);
+			this->Scripted = true;
+		}
+
+		const NULL_STATISTICS_STRUCT& GetStatistics() const override
+		{
+			return this->Immediate->Statistics;
+		}
+
+		void ResetStatistics() override
+		{
+			NULL_STATISTICS_STRUCT& Statistics = this->Immediate->Statistics;
+			Statistics.DrawCount = 0;
+			Statistics.IndexCount = 0;
+			Statistics.InstanceCount = 0;
+			Statistics.BindCount = 0;
+			Statistics.UploadCount = 0;
+			Statistics.UploadBytes = 0;
+		}
+
+		std::shared_ptr<ICommandList> CreateCommandList() override;
+		std::shared_ptr<IVertexShader> CreateVertexShader(LPCVOID Data, SIZE_T Size) override;
+		std::shared_ptr<IPixelShader> CreatePixelShader(LPCVOID Data, SIZE_T Size) override;
+		std::shared_ptr<IConstantBuffer> CreateConstantBuffer(SIZE_T Size) override;
+		std::shared_ptr<IConstantAllocator> CreateConstantAllocator(SIZE_T Capacity) override;
+		std::shared_ptr<IVertexBuffer> CreateVertexBuffer(LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement) override;
+		std::shared_ptr<IIndexBuffer> CreateIndexBuffer(LPCVOID Data, SIZE_T CountElement) override;
+		std::shared_ptr<IDynamicVertexBuffer> CreateDynamicVertexBuffer(SIZE_T CountElement, SIZE_T SizeElement) override;
+		std::shared_ptr<IDynamicIndexBuffer> CreateDynamicIndexBuffer(SIZE_T CountElement) override;
+		std::shared_ptr<IGeometryPool> CreateGeometryPool(SIZE_T VertexCount, SIZE_T SizeElement, SIZE_T IndexCount) override;
+		std::shared_ptr<IInstanceBuffer> CreateInstanceBuffer(LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement) override;
+		std::shared_ptr<ITexture> CreateTexture(LPCVOID Data, UINT Width, UINT Height) override;
+	private:
+		std::shared_ptr<NullContext> CreateResource(SIZE_T Size)
+		{
+			this->Immediate->Statistics.ResourceCount++;
+
+			if (Size)
+			{
+				this->Immediate->Apply({ NULL_COMMAND_UPLOAD, nullptr, 0, 0, 0, Size });
+			}
+
+			return this->Immediate;
+		}
+	private:
+		std::shared_ptr<NullContext> Immediate;
+		std::deque<NULL_INPUT_STRUCT> Script;
+		NULL_INPUT_STRUCT Input = {};
+		UINT Width = 0;
+		UINT Height = 0;
+		bool Scripted = false;
+		bool Exit = false;
+	};
+
+	std::shared_ptr<Backend> CreateNullApplication(UINT Width, UINT Height)
+	{
+		return CreateInterface<NullApplication>(Width, Height);
+	}
+
+
+
+	class NullCommandList : public ICommandList
+	{
+	public:
+		NullCommandList(std::shared_ptr<BackendCounter> Counter) : Context(true, Counter)
+		{
+		}
+
+		ICommandContext* Begin() override
+		{
+			this->Context.Command.clear();
+			return &this->Context;
+		}
+
+		void End() override
+		{
+		}
+	private:
+		friend class NullApplication;
+
+		NullContext Context;
+	};
+
+	std::shared_ptr<ICommandList> NullApplication::CreateCommandList()
+	{
+		return CreateInterface<NullCommandList>(this->Counter);
+	}
+
+	void NullApplication::Execute(ICommandList* const* List, UINT Count)
+	{
+		for (UINT Index = 0; Index < Count; Index++)
+		{
+			NullCommandList* const Current = static_cast<NullCommandList*>(List[Index]);
+
+			if (Current)
+			{
+				for (const NULL_COMMAND_STRUCT& Command : Current->Context.Command)
+				{
+					this->Immediate->Apply(Command);
+				}
+			}
+		}
+	}
+
+
+
+	template<NULL_COMMAND Type>
+	class NullBindable
+	{
+	public:
+		NullBindable(std::shared_ptr<NullContext> Immediate)
+		{
+			this->Immediate = Immediate;
+		}
+	protected:
+		void Bind(NullContext* Context)
+		{
+			Context->Apply({ Type, this, 0, 0, 0, 0 });
+		}
+	protected:
+		std::shared_ptr<NullContext> Immediate;
+	};
+
+
+
+	class NullVertexShader : public IVertexShader, private NullBindable<NULL_COMMAND_VERTEX_SHADER>
+	{
+	public:
+		NullVertexShader(std::shared_ptr<NullContext> Immediate) : NullBindable(Immediate)
+		{
+		}
+
+		void Set() override
+		{
+			this->Bind(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetNullContext(Context));
+		}
+	};
+
+	std::shared_ptr<IVertexShader> NullApplication::CreateVertexShader(LPCVOID /*Data*/, SIZE_T /*Size*/)
+	{
+		return CreateInterface<NullVertexShader>(this->CreateResource(0));
+	}
+
+
+
+	class NullPixelShader : public IPixelShader, private NullBindable<NULL_COMMAND_PIXEL_SHADER>
+	{
+	public:
+		NullPixelShader(std::shared_ptr<NullContext> Immediate) : NullBindable(Immediate)
+		{
+		}
+
+		void Set() override
+		{
+			this->Bind(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetNullContext(Context));
+		}
+	};
+
+	std::shared_ptr<IPixelShader> NullApplication::CreatePixelShader(LPCVOID /*Data*/, SIZE_T /*Size*/)
+	{
+		return CreateInterface<NullPixelShader>(this->CreateResource(0));
+	}
+
+
+
+	class NullConstantBuffer : public IConstantBuffer
+	{
+	public:
+		NullConstantBuffer(std::shared_ptr<NullContext> Immediate, SIZE_T Size)
+		{
+			this->Immediate = Immediate;
+			this->Size = Size;
+		}
+
+		void Update(LPCVOID Data) override
+		{
+			this->Update(this->Immediate.get(), Data);
+		}
+
+		void Update(ICommandContext* Context, LPCVOID /*Data*/) override
+		{
+			this->Immediate->Counter->Upload(this->Size);
+			GetNullContext(Context)->Apply({ NULL_COMMAND_UPLOAD, this, 0, 0, 0, this->Size });
+		}
+
+		void SetVertexShader(UINT Slot) override
+		{
+			this->SetVertexShader(this->Immediate.get(), Slot);
+		}
+
+		void SetVertexShader(ICommandContext* Context, UINT Slot) override
+		{
+			GetNullContext(Context)->Apply({ NULL_COMMAND_VERTEX_CONSTANT, this, CheckConstantSlot(Slot), 0, 0, 0 });
+		}
+
+		void SetPixelShader(UINT Slot) override
+		{
+			this->SetPixelShader(this->Immediate.get(), Slot);
+		}
+
+		void SetPixelShader(ICommandContext* Context, UINT Slot) override
+		{
+			GetNullContext(Context)->Apply({ NULL_COMMAND_PIXEL_CONSTANT, this, CheckConstantSlot(Slot), 0, 0, 0 });
+		}
+	private:
+		std::shared_ptr<NullContext> Immediate;
+		SIZE_T Size = 0;
+	};
+
+	std::shared_ptr<IConstantBuffer> NullApplication::CreateConstantBuffer(SIZE_T Size)
+	{
+		return CreateInterface<NullConstantBuffer>(this->CreateResource(0), Size);
+	}
+
+
+
+	class NullConstantAllocator : public IConstantAllocator
+	{
+	public:
+		NullConstantAllocator(std::shared_ptr<NullContext> Immediate, SIZE_T Capacity) : Ring(Immediate, Capacity, ConstantAlignment)
+		{
+			this->Immediate = Immediate;
+		}
+
+		CONSTANT_SLICE_STRUCT Allocate(LPCVOID /*Data*/, SIZE_T Size) override
+		{
+			const SIZE_T Offset = this->Ring.Allocate(Size);
+			this->Immediate->Counter->Upload(Size);
+			return { static_cast<UINT>(Offset / 16), static_cast<UINT>(AlignUp(Size, ConstantAlignment) / 16) };
+		}
+
+		void SetVertexShader(UINT Slot, const CONSTANT_SLICE_STRUCT& /*Slice*/) override
+		{
+			this->Immediate->Apply({ NULL_COMMAND_VERTEX_CONSTANT, this, CheckConstantSlot(Slot), 0, 0, 0 });
+		}
+
+		void SetPixelShader(UINT Slot, const CONSTANT_SLICE_STRUCT& /*Slice*/) override
+		{
+			this->Immediate->Apply({ NULL_COMMAND_PIXEL_CONSTANT, this, CheckConstantSlot(Slot), 0, 0, 0 });
+		}
+	private:
+		static constexpr SIZE_T ConstantAlignment = 256;
+
+		std::shared_ptr<NullContext> Immediate;
+		NullRing Ring;
+	};
+
+	std::shared_ptr<IConstantAllocator> NullApplication::CreateConstantAllocator(SIZE_T Capacity)
+	{
+		return CreateInterface<NullConstantAllocator>(this->CreateResource(0), Capacity);
+	}
+
+
+
+	class NullVertexBuffer : public IVertexBuffer, private NullBindable<NULL_COMMAND_VERTEX_BUFFER>
+	{
+	public:
+		NullVertexBuffer(std::shared_ptr<NullContext> Immediate) : NullBindable(Immediate)
+		{
+		}
+
+		void Set() override
+		{
+			this->Bind(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetNullContext(Context));
+		}
+	};
+
+	std::shared_ptr<IVertexBuffer> NullApplication::CreateVertexBuffer(LPCVOID /*Data*/, SIZE_T CountElement, SIZE_T SizeElement)
+	{
+		return CreateInterface<NullVertexBuffer>(this->CreateResource(CountElement * SizeElement));
+	}
+
+
+
+	class NullIndexBuffer : public IIndexBuffer, private NullBindable<NULL_COMMAND_INDEX_BUFFER>
+	{
+	public:
+		NullIndexBuffer(std::shared_ptr<NullContext> Immediate, SIZE_T CountElement) : NullBindable(Immediate)
+		{
+			this->Count = CountElement;
+		}
+
+		void Set() override
+		{
+			this->Bind(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetNullContext(Context));
+		}
+
+		unsigned int GetIndexCount() override
+		{
+			return this->Count;
+		}
+	private:
+		UINT Count = 0;
+	};
+
+	std::shared_ptr<IIndexBuffer> NullApplication::CreateIndexBuffer(LPCVOID /*Data*/, SIZE_T CountElement)
+	{
+		return CreateInterface<NullIndexBuffer>(this->CreateResource(CountElement * sizeof(UINT)), CountElement);
+	}
+
+
+
+	class NullDynamicVertexBuffer : public IDynamicVertexBuffer, private NullBindable<NULL_COMMAND_VERTEX_BUFFER>
+	{
+	public:
+		NullDynamicVertexBuffer(std::shared_ptr<NullContext> Immediate, SIZE_T CountElement, SIZE_T SizeElement) : NullBindable(Immediate), Ring(Immediate, CountElement * SizeElement, SizeElement)
+		{
+			this->Stride = SizeElement;
+		}
+
+		void Set() override
+		{
+			this->Bind(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetNullContext(Context));
+		}
+
+		INT Allocate(LPCVOID /*Data*/, SIZE_T CountElement) override
+		{
+			return static_cast<INT>(this->Ring.Allocate(CountElement * this->Stride) / this->Stride);
+		}
+	private:
+		NullRing Ring;
+		UINT Stride = 0;
+	};
+
+	std::shared_ptr<IDynamicVertexBuffer> NullApplication::CreateDynamicVertexBuffer(SIZE_T CountElement, SIZE_T SizeElement)
+	{
+		return CreateInterface<NullDynamicVertexBuffer>(this->CreateResource(0), CountElement, SizeElement);
+	}
+
+
+
+	class NullDynamicIndexBuffer : public IDynamicIndexBuffer, private NullBindable<NULL_COMMAND_INDEX_BUFFER>
+	{
+	public:
+		NullDynamicIndexBuffer(std::shared_ptr<NullContext> Immediate, SIZE_T CountElement) : NullBindable(Immediate), Ring(Immediate, CountElement * sizeof(UINT), sizeof(UINT))
+		{
+			this->Count = CountElement;
+		}
+
+		void Set() override
+		{
+			this->Bind(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetNullContext(Context));
+		}
+
+		unsigned int GetIndexCount() override
+		{
+			return this->Count;
+		}
+
+		UINT Allocate(LPCVOID /*Data*/, SIZE_T CountElement) override
+		{
+			return static_cast<UINT>(this->Ring.Allocate(CountElement * sizeof(UINT)) / sizeof(UINT));
+		}
+	private:
+		NullRing Ring;
+		UINT Count = 0;
+	};
+
+	std::shared_ptr<IDynamicIndexBuffer> NullApplication::CreateDynamicIndexBuffer(SIZE_T CountElement)
+	{
+		return CreateInterface<NullDynamicIndexBuffer>(this->CreateResource(0), CountElement);
+	}
+
+
+
+	class NullGeometryPool : public IGeometryPool
+	{
+	public:
+		NullGeometryPool(std::shared_ptr<NullContext> Immediate, SIZE_T VertexCount, SIZE_T SizeElement, SIZE_T IndexCount) : Allocator(static_cast<UINT>(VertexCount), static_cast<UINT>(IndexCount)), VertexView(Immediate), IndexView(Immediate, this)
+		{
+			this->Immediate = Immediate;
+			this->Stride = SizeElement;
+		}
+
+		UINT Add(LPCVOID /*Vertex*/, SIZE_T VertexCount, LPCVOID /*Index*/, SIZE_T IndexCount) override
+		{
+			const UINT Mesh = this->Allocator.Add(static_cast<UINT>(VertexCount), static_cast<UINT>(IndexCount));
+			if (Mesh == GeometryAllocator::Invalid)
+			{
+				throw E_OUTOFMEMORY;
+			}
+
+			this->Immediate->Apply({ NULL_COMMAND_UPLOAD, this, 0, 0, 0, VertexCount * this->Stride });
+			this->Immediate->Apply({ NULL_COMMAND_UPLOAD, this, 0, 0, 0, IndexCount * sizeof(UINT) });
+
+			return Mesh;
+		}
+
+		void Remove(UINT Mesh) override
+		{
+			this->Allocator.Remove(Mesh);
+		}
+
+		GEOMETRY_MESH_STRUCT GetMesh(UINT Mesh) override
+		{
+			return this->Allocator.GetMesh(Mesh);
+		}
+
+		void Compact() override
+		{
+			this->Allocator.Compact();
+		}
+
+		GEOMETRY_REPORT_STRUCT GetReport() override
+		{
+			return this->Allocator.GetReport();
+		}
+
+		IVertexBuffer* GetVertexBuffer() override
+		{
+			return &this->VertexView;
+		}
+
+		IIndexBuffer* GetIndexBuffer() override
+		{
+			return &this->IndexView;
+		}
+	private:
+		class PoolIndexBuffer : public NullIndexBuffer
+		{
+		public:
+			PoolIndexBuffer(std::shared_ptr<NullContext> Immediate, NullGeometryPool* Pool) : NullIndexBuffer(Immediate, 0)
+			{
+				this->Pool = Pool;
+			}
+
+			unsigned int GetIndexCount() override
+			{
+				return this->Pool->Allocator.GetIndexCapacity();
+			}
+		private:
+			NullGeometryPool* Pool;
+		};
+	private:
+		std::shared_ptr<NullContext> Immediate;
+		GeometryAllocator Allocator;
+		UINT Stride = 0;
+
+		NullVertexBuffer VertexView;
+		PoolIndexBuffer IndexView;
+	};
+
+	std::shared_ptr<IGeometryPool> NullApplication::CreateGeometryPool(SIZE_T VertexCount, SIZE_T SizeElement, SIZE_T IndexCount)
+	{
+		return CreateInterface<NullGeometryPool>(this->CreateResource(0), VertexCount, SizeElement, IndexCount);
+	}
+
+
+
+	class NullInstanceBuffer : public IInstanceBuffer, private NullBindable<NULL_COMMAND_INSTANCE_BUFFER>
+	{
+	public:
+		NullInstanceBuffer(std::shared_ptr<NullContext> Immediate, LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement) : NullBindable(Immediate)
+		{
+			this->Stride = SizeElement;
+			this->Capacity = CountElement;
+			this->Count = (Data ? CountElement : 0);
+		}
+
+		void Update(LPCVOID /*Data*/, SIZE_T CountElement) override
+		{
+			this->Count = (CountElement < this->Capacity ? CountElement : this->Capacity);
+			this->Immediate->Apply({ NULL_COMMAND_UPLOAD, this, 0, 0, 0, this->Count * this->Stride });
+		}
+
+		void Set() override
+		{
+			this->Bind(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetNullContext(Context));
+		}
+
+		unsigned int GetInstanceCount() override
+		{
+			return this->Count;
+		}
+	private:
+		UINT Stride = 0;
+		UINT Capacity = 0;
+		UINT Count = 0;
+	};
+
+	std::shared_ptr<IInstanceBuffer> NullApplication::CreateInstanceBuffer(LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement)
+	{
+		return CreateInterface<NullInstanceBuffer>(this->CreateResource(Data ? CountElement * SizeElement : 0), Data, CountElement, SizeElement);
+	}
+
+
+
+	class NullTexture : public ITexture, private NullBindable<NULL_COMMAND_TEXTURE>
+	{
+	public:
+		NullTexture(std::shared_ptr<NullContext> Immediate) : NullBindable(Immediate)
+		{
+		}
+
+		void Set() override
+		{
+			this->Bind(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			this->Bind(GetNullContext(Context));
+		}
+	};
+
+	std::shared_ptr<ITexture> NullApplication::CreateTexture(LPCVOID /*Data*/, UINT Width, UINT Height)
+	{
+		return CreateInterface<NullTexture>(this->CreateResource(static_cast<SIZE_T>(Width) * Height * 4));
+	}
+}
@@ -0,0 +1,450 @@
+﻿#include "include/occlusion.h"
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <emmintrin.h>
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr float NearClip = 1e-5f;
+
+		inline void TransformPoint(const float* Matrix, float X, float Y, float Z, float* Output)
+		{
+			for (size_t Column = 0; Column < 4; Column++)
+			{
+				Output[Column] = X * Matrix[Column] + Y * Matrix[4 + Column] + Z * Matrix[8 + Column] + Matrix[12 + Column];
+			}
+		}
+
+		inline void Multiply(const float* Left, const float* Right, float* Output)
+		{
+			for (size_t Row = 0; Row < 4; Row++)
+			{
+				for (size_t Column = 0; Column < 4; Column++)
+				{
+					Output[Row * 4 + Column] =
+						Left[Row * 4 + 0] * Right[0 * 4 + Column] + Left[Row * 4 + 1] * Right[1 * 4 + Column] +
+						Left[Row * 4 + 2] * Right[2 * 4 + Column] + Left[Row * 4 + 3] * Right[3 * 4 + Column];
+				}
+			}
+		}
+
+		inline double GetSeconds(std::chrono::steady_clock::time_point Start)
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		}
+	}
+
+	OcclusionCuller::OcclusionCuller(uint32_t Width, uint32_t Height)
+	{
+		this->Resize(Width, Height);
+	}
+
+	void OcclusionCuller::Resize(uint32_t Width, uint32_t Height)
+	{
+		this->Width = std::max(Width, 1u);
+		this->Height = std::max(Height, 1u);
+		this->Pitch = (this->Width + 3) & ~3u;
+		this->TileCountX = (this->Width + TileSize - 1) / TileSize;
+		this->TileCountY = (this->Height + TileSize - 1) / TileSize;
+		this->Depth.assign(static_cast<size_t>(this->Pitch) * this->Height, 1.0f);
+		this->TileDepth.assign(static_cast<size_t>(this->TileCountX) * this->TileCountY, 1.0f);
+		this->Dirty = false;
+	}
+
+	void OcclusionCuller::Clear()
+	{
+		std::fill(this->Depth.begin(), this->Depth.end(), 1.0f);
+		std::fill(this->TileDepth.begin(), this->TileDepth.end(), 1.0f);
+		this->Dirty = false;
+	}
+
+	void OcclusionCuller::SetViewProjection(const float* ViewProjection)
+	{
+		memcpy(this->ViewProjection, ViewProjection, sizeof(this->ViewProjection));
+	}
+
+	void OcclusionCuller::RenderOccluder(const void* Vertex, size_t VertexStride, size_t VertexCount, const uint32_t* Index, size_t IndexCount, const float* World)
+	{
+		const auto Start = std::chrono::steady_clock::now();
+
+		float Matrix[16];
+		if (World)
+		{
+			Multiply(World, this->ViewProjection, Matrix);
+		}
+		else
+		{
+			memcpy(Matrix, this->ViewProjection, sizeof(Matrix));
+		}
+
+		std::vector<CLIP_VERTEX_STRUCT> Clip(VertexCount);
+		for (size_t Current = 0; Current < VertexCount; Current++)
+		{
+			float Position[3];
+			memcpy(Position, static_cast<const uint8_t*>(Vertex) + Current * VertexStride, sizeof(Position));
+			TransformPoint(Matrix, Position[0], Position[1], Position[2], &Clip[Current].X);
+		}
+
+		for (size_t Triangle = 0; Triangle + 3 <= IndexCount; Triangle += 3)
+		{
+			if (Index[Triangle] >= VertexCount || Index[Triangle + 1] >= VertexCount || Index[Triangle + 2] >= VertexCount)
+			{
+				continue;
+			}
+
+			CLIP_VERTEX_STRUCT Polygon[4];
+			CLIP_VERTEX_STRUCT Input[3] = { Clip[Index[Triangle]], Clip[Index[Triangle + 1]], Clip[Index[Triangle + 2]] };
+
+			size_t Count = 0;
+			for (size_t Corner = 0; Corner < 3; Corner++)
+			{
+				const CLIP_VERTEX_STRUCT& Current = Input[Corner];
+				const CLIP_VERTEX_STRUCT& Next = Input[(Corner + 1) % 3];
+
+				if (Current.Z >= 0.0f)
+				{
+					Polygon[Count++] = Current;
+				}
+
+				if ((Current.Z >= 0.0f) != (Next.Z >= 0.0f))
+				{
+					const float Factor = Current.Z / (Current.Z - Next.Z);
+					Polygon[Count++] = {
+						Current.X + (Next.X - Current.X) * Factor,
+						Current.Y + (Next.Y - Current.Y) * Factor,
+						0.0f,
+						Current.W + (Next.W - Current.W) * Factor,
+					};
+				}
+			}
+
+			for (size_t Corner = 2; Corner < Count; Corner++)
+			{
+				this->RasterTriangle(Polygon[0], Polygon[Corner - 1], Polygon[Corner]);
+			}
+
+			this->Report.OccluderTriangleCount++;
+		}
+
+		this->Dirty = true;
+		this->Report.RasterTime += GetSeconds(Start);
+	}
+
+	void OcclusionCuller::RasterTriangle(const CLIP_VERTEX_STRUCT& V0, const CLIP_VERTEX_STRUCT& V1, const CLIP_VERTEX_STRUCT& V2)
+	{
+		const CLIP_VERTEX_STRUCT* Vertex[3] = { &V0, &V1, &V2 };
+
+		float X[3];
+		float Y[3];
+		float Z[3];
+		for (size_t Corner = 0; Corner < 3; Corner++)
+		{
+			if (Vertex[Corner]->W < NearClip)
+			{
+				return;
+			}
+
+			const float InvW = 1.0f / Vertex[Corner]->W;
+			X[Corner] = (Vertex[Corner]->X * InvW * 0.5f + 0.5f) * this->Width;
+			Y[Corner] = (0.5f - Vertex[Corner]->Y * InvW * 0.5f) * this->Height;
+			Z[Corner] = Vertex[Corner]->Z * InvW;
+		}
+
+		float Area = (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+		if (Area < 0.0f)
+		{
+			std::swap(X[1], X[2]);
+			std::swap(Y[1], Y[2]);
+			std::swap(Z[1], Z[2]);
+			Area = -Area;
+		}
+
+		if (!(Area > 0.0f))
+		{
+			return;
+		}
+
+		const int MinX = std::max(static_cast<int>(std::ceil(std::min({ X[0], X[1], X[2] }) - 0.5f)), 0) & ~3;
+		const int MinY = std::max(static_cast<int>(std::ceil(std::min({ Y[0], Y[1], Y[2] }) - 0.5f)), 0);
+		const int MaxX = std::min(static_cast<int>(std::floor(std::max({ X[0], X[1], X[2] }) - 0.5f)), static_cast<int>(this->Width) - 1);
+		const int MaxY = std::min(static_cast<int>(std::floor(std::max({ Y[0], Y[1], Y[2] }) - 0.5f)), static_cast<int>(this->Height) - 1);
+
+		if (MinX > MaxX || MinY > MaxY)
+		{
+			return;
+		}
+
+		float EdgeA[3];
+		float EdgeB[3];
+		for (size_t Edge = 0; Edge < 3; Edge++)
+		{
+			const size_t I = (Edge + 1) % 3;
+			const size_t J = (Edge + 2) % 3;
+			EdgeA[Edge] = Y[I] - Y[J];
+			EdgeB[Edge] = X[J] - X[I];
+		}
+
+		const float InvArea = 1.0f / Area;
+		const __m128 Zero = _mm_setzero_ps();
+		const __m128 Lane = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+		const __m128 Right = _mm_set1_ps(static_cast<float>(MaxX) + 0.5f);
+		const __m128 Z0 = _mm_set1_ps(Z[0]);
+		const __m128 DeltaZ1 = _mm_set1_ps((Z[1] - Z[0]) * InvArea);
+		const __m128 DeltaZ2 = _mm_set1_ps((Z[2] - Z[0]) * InvArea);
+
+		for (int Row = MinY; Row <= MaxY; Row++)
+		{
+			const float PixelY = Row + 0.5f;
+
+			__m128 Edge[3];
+			__m128 Step[3];
+			for (size_t Index = 0; Index < 3; Index++)
+			{
+				const size_t I = (Index + 1) % 3;
+				const float Base = EdgeA[Index] * (MinX + 0.5f - X[I]) + EdgeB[Index] * (PixelY - Y[I]);
+				Edge[Index] = _mm_add_ps(_mm_set1_ps(Base), _mm_mul_ps(_mm_set1_ps(EdgeA[Index]), Lane));
+				Step[Index] = _mm_set1_ps(EdgeA[Index] * 4.0f);
+			}
+
+			float* const DepthRow = &this->Depth[static_cast<size_t>(Row) * this->Pitch];
+
+			for (int Column = MinX; Column <= MaxX; Column += 4)
+			{
+				__m128 Mask = _mm_cmple_ps(_mm_add_ps(_mm_set1_ps(Column + 0.5f), Lane), Right);
+				Mask = _mm_and_ps(Mask, _mm_cmpge_ps(Edge[0], Zero));
+				Mask = _mm_and_ps(Mask, _mm_cmpge_ps(Edge[1], Zero));
+				Mask = _mm_and_ps(Mask, _mm_cmpge_ps(Edge[2], Zero));
+
+				if (_mm_movemask_ps(Mask))
+				{
+					const __m128 Depth = _mm_add_ps(Z0, _mm_add_ps(_mm_mul_ps(Edge[1], DeltaZ1), _mm_mul_ps(Edge[2], DeltaZ2)));
+					const __m128 Old = _mm_loadu_ps(DepthRow + Column);
+					_mm_storeu_ps(DepthRow + Column, _mm_or_ps(_mm_and_ps(Mask, _mm_min_ps(Depth, Old)), _mm_andnot_ps(Mask, Old)));
+				}
+
+				for (size_t Index = 0; Index < 3; Index++)
+				{
+					Edge[Index] = _mm_add_ps(Edge[Index], Step[Index]);
+				}
+			}
+		}
+	}
+
+	void OcclusionCuller::UpdateHierarchy()
+	{
+		if (!this->Dirty)
+		{
+			return;
+		}
+
+		for (uint32_t TileY = 0; TileY < this->TileCountY; TileY++)
+		{
+			for (uint32_t TileX = 0; TileX < this->TileCountX; TileX++)
+			{
+				const uint32_t MinX = TileX * TileSize;
+				const uint32_t MaxX = std::min(MinX + TileSize, this->Width);
+				const uint32_t MinY = TileY * TileSize;
+				const uint32_t MaxY = std::min(MinY + TileSize, this->Height);
+
+				float Farthest = 0.0f;
+				for (uint32_t Y = MinY; Y < MaxY; Y++)
+				{
+					const float* const Row = &this->Depth[static_cast<size_t>(Y) * this->Pitch];
+					for (uint32_t X = MinX; X < MaxX; X++)
+					{
+						Farthest = std::max(Farthest, Row[X]);
+					}
+				}
+
+				this->TileDepth[TileY * this->TileCountX + TileX] = Farthest;
+			}
+		}
+
+		this->Dirty = false;
+	}
+
+	bool OcclusionCuller::TestBox(const BOUNDING_BOX_STRUCT& Box)
+	{
+		this->UpdateHierarchy();
+
+		const __m128 Sign = _mm_set_ps(1.0f, -1.0f, 1.0f, -1.0f);
+		const __m128 CornerX = _mm_add_ps(_mm_set1_ps(Box.Center[0]), _mm_mul_ps(_mm_set1_ps(Box.Extent[0]), Sign));
+		const __m128 CornerY = _mm_add_ps(_mm_set1_ps(Box.Center[1]), _mm_mul_ps(_mm_set1_ps(Box.Extent[1]), _mm_set_ps(1.0f, 1.0f, -1.0f, -1.0f)));
+
+		__m128 MinX = _mm_set1_ps(FLT_MAX);
+		__m128 MinY = _mm_set1_ps(FLT_MAX);
+		__m128 MaxX = _mm_set1_ps(-FLT_MAX);
+		__m128 MaxY = _mm_set1_ps(-FLT_MAX);
+		__m128 MinZ = _mm_set1_ps(FLT_MAX);
+		__m128 MinClipZ = _mm_set1_ps(FLT_MAX);
+		__m128 MinW = _mm_set1_ps(FLT_MAX);
+
+		const float* const Matrix = this->ViewProjection;
+		for (const float SignZ : { -1.0f, 1.0f })
+		{
+			const __m128 CornerZ = _mm_set1_ps(Box.Center[2] + Box.Extent[2] * SignZ);
+
+			__m128 Clip[4];
+			for (size_t Column = 0; Column < 4; Column++)
+			{
+				Clip[Column] = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(CornerX, _mm_set1_ps(Matrix[Column])), _mm_mul_ps(CornerY, _mm_set1_ps(Matrix[4 + Column]))),
+					_mm_add_ps(_mm_mul_ps(CornerZ, _mm_set1_ps(Matrix[8 + Column])), _mm_set1_ps(Matrix[12 + Column])));
+			}
+
+			MinClipZ = _mm_min_ps(MinClipZ, Clip[2]);
+			MinW = _mm_min_ps(MinW, Clip[3]);
+
+			const __m128 InvW = _mm_div_ps(_mm_set1_ps(1.0f), Clip[3]);
+			const __m128 ScreenX = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(Clip[0], InvW), _mm_set1_ps(0.5f)), _mm_set1_ps(0.5f)), _mm_set1_ps(static_cast<float>(this->Width)));
+			const __m128 ScreenY = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(0.5f), _mm_mul_ps(_mm_mul_ps(Clip[1], InvW), _mm_set1_ps(0.5f))), _mm_set1_ps(static_cast<float>(this->Height)));
+
+			MinX = _mm_min_ps(MinX, ScreenX);
+			MinY = _mm_min_ps(MinY, ScreenY);
+			MaxX = _mm_max_ps(MaxX, ScreenX);
+			MaxY = _mm_max_ps(MaxY, ScreenY);
+			MinZ = _mm_min_ps(MinZ, _mm_mul_ps(Clip[2], InvW));
+		}
+
+		alignas(16) float Value[7][4];
+		_mm_store_ps(Value[0], MinX);
+		_mm_store_ps(Value[1], MinY);
+		_mm_store_ps(Value[2], MaxX);
+		_mm_store_ps(Value[3], MaxY);
+		_mm_store_ps(Value[4], MinZ);
+		_mm_store_ps(Value[5], MinW);
+		_mm_store_ps(Value[6], MinClipZ);
+
+		float Bound[7];
+		for (size_t Index = 0; Index < 7; Index++)
+		{
+			Bound[Index] = (Index == 2 || Index == 3 ?
+				std::max({ Value[Index][0], Value[Index][1], Value[Index][2], Value[Index][3] }) :
+				std::min({ Value[Index][0], Value[Index][1], Value[Index][2], Value[Index][3] }));
+		}
+
+		this->Report.TestCount++;
+
+		// Boxes crossing the near plane project unbounded, so they are kept.
+		if (Bound[5] < NearClip || Bound[6] < 0.0f)
+		{
+			return true;
+		}
+
+		const float Right = static_cast<float>(this->Width);
+		const float Bottom = static_cast<float>(this->Height);
+		if (Bound[2] < 0.0f || Bound[3] < 0.0f || Bound[0] >= Right || Bound[1] >= Bottom)
+		{
+			this->Report.CullCount++;
+			return false;
+		}
+
+		// Clamped as floats before the cast, which also maps NaN bounds to the whole screen.
+		const int TileMinX = static_cast<int>(std::max(0.0f, Bound[0])) / static_cast<int>(TileSize);
+		const int TileMinY = static_cast<int>(std::max(0.0f, Bound[1])) / static_cast<int>(TileSize);
+		const int TileMaxX = static_cast<int>(std::min(Right - 1.0f, Bound[2])) / static_cast<int>(TileSize);
+		const int TileMaxY = static_cast<int>(std::min(Bottom - 1.0f, Bound[3])) / static_cast<int>(TileSize);
+
+		for (int TileY = TileMinY; TileY <= TileMaxY; TileY++)
+		{
+			for (int TileX = TileMinX; TileX <= TileMaxX; TileX++)
+			{
+				if (Bound[4] < this->TileDepth[TileY * this->TileCountX + TileX])
+				{
+					return true;
+				}
+			}
+		}
+
+		this->Report.CullCount++;
+		return false;
+	}
+
+	size_t OcclusionCuller::CullBox(const CULL_BOX_STRUCT& Box, const uint32_t* Candidate, size_t CandidateCount, uint32_t* Visible)
+	{
+		const auto Start = std::chrono::steady_clock::now();
+
+		this->UpdateHierarchy();
+
+		size_t Count = 0;
+		for (size_t Current = 0; Current < CandidateCount; Current++)
+		{
+			const uint32_t Index = (Candidate ? Candidate[Current] : static_cast<uint32_t>(Current));
+			const BOUNDING_BOX_STRUCT Bounds = {
+				{ Box.CenterX[Index], Box.CenterY[Index], Box.CenterZ[Index] },
+				{ Box.ExtentX[Index], Box.ExtentY[Index], Box.ExtentZ[Index] },
+			};
+
+			if (this->TestBox(Bounds))
+			{
+				Visible[Count++] = Index;
+			}
+		}
+
+		this->Report.TestTime += GetSeconds(Start);
+		return Count;
+	}
+
+	const float* OcclusionCuller::GetDepth() const
+	{
+		return this->Depth.data();
+	}
+
+	uint32_t OcclusionCuller::GetWidth() const
+	{
+		return this->Width;
+	}
+
+	uint32_t OcclusionCuller::GetHeight() const
+	{
+		return this->Height;
+	}
+
+	bool OcclusionCuller::SaveDepth(const char* FileName) const
+	{
+		std::ofstream File(FileName, std::ios::binary);
+		if (!File)
+		{
+			return false;
+		}
+
+		const uint8_t Header[18] = {
+			0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+			static_cast<uint8_t>(this->Width & 0xFF), static_cast<uint8_t>(this->Width >> 8),
+			static_cast<uint8_t>(this->Height & 0xFF), static_cast<uint8_t>(this->Height >> 8),
+			8, 0x20,
+		};
+		File.write(reinterpret_cast<const char*>(Header), sizeof(Header));
+
+		std::vector<uint8_t> Pixel(static_cast<size_t>(this->Width) * this->Height);
+		for (uint32_t Y = 0; Y < this->Height; Y++)
+		{
+			for (uint32_t X = 0; X < this->Width; X++)
+			{
+				const float Value = std::min(std::max(this->Depth[static_cast<size_t>(Y) * this->Pitch + X], 0.0f), 1.0f);
+				Pixel[static_cast<size_t>(Y) * this->Width + X] = static_cast<uint8_t>((1.0f - Value) * 255.0f + 0.5f);
+			}
+		}
+		File.write(reinterpret_cast<const char*>(Pixel.data()), Pixel.size());
+
+		return static_cast<bool>(File);
+	}
+
+	OCCLUSION_REPORT_STRUCT OcclusionCuller::GetReport() const
+	{
+		OCCLUSION_REPORT_STRUCT Result = this->Report;
+		Result.CullPercent = (Result.TestCount ? 100.0f * Result.CullCount / Result.TestCount : 0.0f);
+		return Result;
+	}
+
+	void OcclusionCuller::ResetReport()
+	{
+		this->Report = {};
+	}
+}
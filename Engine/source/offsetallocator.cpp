@@ -0,0 +1,340 @@
+﻿#include "include/offsetallocator.h"
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr uint32_t MantissaBits = 3;
+		constexpr uint32_t MantissaValue = 1 << MantissaBits;
+		constexpr uint32_t MantissaMask = MantissaValue - 1;
+
+		inline uint32_t CountLeadingZero(uint32_t Value)
+		{
+#ifdef _MSC_VER
+			unsigned long Index = 0;
+			return _BitScanReverse(&Index, Value) ? 31 - Index : 32;
+#else
+			return Value ? __builtin_clz(Value) : 32;
+#endif
+		}
+
+		inline uint32_t CountTrailingZero(uint32_t Value)
+		{
+#ifdef _MSC_VER
+			unsigned long Index = 0;
+			return _BitScanForward(&Index, Value) ? Index : 32;
+#else
+			return Value ? __builtin_ctz(Value) : 32;
+#endif
+		}
+
+		inline uint32_t FindLowestSetBitAfter(uint32_t Mask, uint32_t StartBit)
+		{
+			if (StartBit >= 32)
+			{
+				return OffsetAllocator::Invalid;
+			}
+
+			const uint32_t BitsAfter = Mask & ~((1u << StartBit) - 1);
+			return BitsAfter ? CountTrailingZero(BitsAfter) : OffsetAllocator::Invalid;
+		}
+
+		inline uint32_t SizeToBinRoundUp(uint32_t Size)
+		{
+			if (Size < MantissaValue)
+			{
+				return Size;
+			}
+
+			const uint32_t HighestBit = 31 - CountLeadingZero(Size);
+			const uint32_t MantissaStart = HighestBit - MantissaBits;
+			uint32_t Mantissa = (Size >> MantissaStart) & MantissaMask;
+
+			if (Size & ((1u << MantissaStart) - 1))
+			{
+				Mantissa++;
+			}
+
+			return ((MantissaStart + 1) << MantissaBits) + Mantissa;
+		}
+
+		inline uint32_t SizeToBinRoundDown(uint32_t Size)
+		{
+			if (Size < MantissaValue)
+			{
+				return Size;
+			}
+
+			const uint32_t HighestBit = 31 - CountLeadingZero(Size);
+			const uint32_t MantissaStart = HighestBit - MantissaBits;
+			const uint32_t Mantissa = (Size >> MantissaStart) & MantissaMask;
+
+			return ((MantissaStart + 1) << MantissaBits) | Mantissa;
+		}
+	}
+
+	OffsetAllocator::OffsetAllocator(uint32_t Size)
+	{
+		this->Size = Size;
+		this->Reset();
+	}
+
+	void OffsetAllocator::Reset()
+	{
+		this->FreeStorage = 0;
+		this->UsedBinsTop = 0;
+		std::fill(std::begin(this->UsedBins), std::end(this->UsedBins), static_cast<uint8_t>(0));
+		std::fill(std::begin(this->BinIndices), std::end(this->BinIndices), Invalid);
+		this->Node.clear();
+		this->FreeNode.clear();
+
+		if (this->Size)
+		{
+			this->InsertNodeIntoBin(this->Size, 0);
+		}
+	}
+
+	OFFSET_ALLOCATION_STRUCT OffsetAllocator::Allocate(uint32_t Size)
+	{
+		if (Size == 0 || Size > this->FreeStorage)
+		{
+			return { Invalid, Invalid };
+		}
+
+		const uint32_t MinBin = SizeToBinRoundUp(Size);
+		const uint32_t MinTopBin = MinBin >> 3;
+		const uint32_t MinLeafBin = MinBin & (BinsPerLeaf - 1);
+
+		uint32_t TopBin = MinTopBin;
+		uint32_t LeafBin = Invalid;
+
+		if (TopBin < TopBinCount && (this->UsedBinsTop & (1u << TopBin)))
+		{
+			LeafBin = FindLowestSetBitAfter(this->UsedBins[TopBin], MinLeafBin);
+		}
+
+		if (LeafBin == Invalid)
+		{
+			TopBin = FindLowestSetBitAfter(this->UsedBinsTop, MinTopBin + 1);
+			if (TopBin == Invalid)
+			{
+				return { Invalid, Invalid };
+			}
+
+			LeafBin = CountTrailingZero(this->UsedBins[TopBin]);
+		}
+
+		const uint32_t Bin = (TopBin << 3) | LeafBin;
+		const uint32_t Index = this->BinIndices[Bin];
+
+		NODE_STRUCT& Current = this->Node[Index];
+		const uint32_t TotalSize = Current.Size;
+		Current.Size = Size;
+		Current.Used = true;
+
+		this->BinIndices[Bin] = Current.BinNext;
+		if (Current.BinNext != Invalid)
+		{
+			this->Node[Current.BinNext].BinPrev = Invalid;
+		}
+		this->FreeStorage -= TotalSize;
+
+		if (this->BinIndices[Bin] == Invalid)
+		{
+			this->UsedBins[TopBin] &= ~(1u << LeafBin);
+			if (this->UsedBins[TopBin] == 0)
+			{
+				this->UsedBinsTop &= ~(1u << TopBin);
+			}
+		}
+
+		const uint32_t Offset = Current.Offset;
+		const uint32_t Remainder = TotalSize - Size;
+
+		if (Remainder > 0)
+		{
+			const uint32_t NeighborNext = this->Node[Index].NeighborNext;
+			const uint32_t Split = this->InsertNodeIntoBin(Remainder, Offset + Size);
+
+			if (NeighborNext != Invalid)
+			{
+				this->Node[NeighborNext].NeighborPrev = Split;
+			}
+
+			this->Node[Split].NeighborPrev = Index;
+			this->Node[Split].NeighborNext = NeighborNext;
+			this->Node[Index].NeighborNext = Split;
+		}
+
+		return { Offset, Index };
+	}
+
+	void OffsetAllocator::Free(OFFSET_ALLOCATION_STRUCT Allocation)
+	{
+		if (Allocation.Node == Invalid || Allocation.Node >= this->Node.size() || !this->Node[Allocation.Node].Used)
+		{
+			return;
+		}
+
+		const NODE_STRUCT Current = this->Node[Allocation.Node];
+		uint32_t Offset = Current.Offset;
+		uint32_t Size = Current.Size;
+		uint32_t NeighborPrev = Current.NeighborPrev;
+		uint32_t NeighborNext = Current.NeighborNext;
+
+		if (NeighborPrev != Invalid && !this->Node[NeighborPrev].Used)
+		{
+			const NODE_STRUCT& Prev = this->Node[NeighborPrev];
+			Offset = Prev.Offset;
+			Size += Prev.Size;
+
+			const uint32_t Merged = NeighborPrev;
+			this->RemoveNodeFromBin(Merged);
+			NeighborPrev = this->Node[Merged].NeighborPrev;
+			this->FreeNode.push_back(Merged);
+		}
+
+		if (NeighborNext != Invalid && !this->Node[NeighborNext].Used)
+		{
+			Size += this->Node[NeighborNext].Size;
+
+			const uint32_t Merged = NeighborNext;
+			this->RemoveNodeFromBin(Merged);
+			NeighborNext = this->Node[Merged].NeighborNext;
+			this->FreeNode.push_back(Merged);
+		}
+
+		this->Node[Allocation.Node].Used = false;
+		this->FreeNode.push_back(Allocation.Node);
+
+		const uint32_t Combined = this->InsertNodeIntoBin(Size, Offset);
+
+		if (NeighborPrev != Invalid)
+		{
+			this->Node[NeighborPrev].NeighborNext = Combined;
+			this->Node[Combined].NeighborPrev = NeighborPrev;
+		}
+
+		if (NeighborNext != Invalid)
+		{
+			this->Node[NeighborNext].NeighborPrev = Combined;
+			this->Node[Combined].NeighborNext = NeighborNext;
+		}
+	}
+
+	uint32_t OffsetAllocator::GetSize() const
+	{
+		return this->Size;
+	}
+
+	uint32_t OffsetAllocator::GetAllocationSize(OFFSET_ALLOCATION_STRUCT Allocation) const
+	{
+		if (Allocation.Node == Invalid || Allocation.Node >= this->Node.size())
+		{
+			return 0;
+		}
+		return this->Node[Allocation.Node].Size;
+	}
+
+	OFFSET_REPORT_STRUCT OffsetAllocator::GetReport() const
+	{
+		OFFSET_REPORT_STRUCT Report = {};
+		Report.TotalFree = this->FreeStorage;
+
+		for (uint32_t Bin = 0; Bin < LeafBinCount; Bin++)
+		{
+			for (uint32_t Index = this->BinIndices[Bin]; Index != Invalid; Index = this->Node[Index].BinNext)
+			{
+				Report.LargestFree = std::max(Report.LargestFree, this->Node[Index].Size);
+				Report.FreeRegionCount++;
+			}
+		}
+
+		Report.Fragmentation = (Report.TotalFree ? 1.0f - static_cast<float>(Report.LargestFree) / static_cast<float>(Report.TotalFree) : 0.0f);
+
+		return Report;
+	}
+
+	uint32_t OffsetAllocator::InsertNodeIntoBin(uint32_t Size, uint32_t Offset)
+	{
+		const uint32_t Bin = SizeToBinRoundDown(Size);
+		const uint32_t TopBin = Bin >> 3;
+		const uint32_t LeafBin = Bin & (BinsPerLeaf - 1);
+
+		if (this->BinIndices[Bin] == Invalid)
+		{
+			this->UsedBins[TopBin] |= 1u << LeafBin;
+			this->UsedBinsTop |= 1u << TopBin;
+		}
+
+		const uint32_t Head = this->BinIndices[Bin];
+		const uint32_t Index = this->NewNode();
+
+		this->Node[Index] = { Offset, Size, Invalid, Head, Invalid, Invalid, false };
+
+		if (Head != Invalid)
+		{
+			this->Node[Head].BinPrev = Index;
+		}
+
+		this->BinIndices[Bin] = Index;
+		this->FreeStorage += Size;
+
+		return Index;
+	}
+
+	void OffsetAllocator::RemoveNodeFromBin(uint32_t Index)
+	{
+		const NODE_STRUCT& Current = this->Node[Index];
+
+		if (Current.BinPrev != Invalid)
+		{
+			this->Node[Current.BinPrev].BinNext = Current.BinNext;
+			if (Current.BinNext != Invalid)
+			{
+				this->Node[Current.BinNext].BinPrev = Current.BinPrev;
+			}
+		}
+		else
+		{
+			const uint32_t Bin = SizeToBinRoundDown(Current.Size);
+			const uint32_t TopBin = Bin >> 3;
+			const uint32_t LeafBin = Bin & (BinsPerLeaf - 1);
+
+			this->BinIndices[Bin] = Current.BinNext;
+			if (Current.BinNext != Invalid)
+			{
+				this->Node[Current.BinNext].BinPrev = Invalid;
+			}
+
+			if (this->BinIndices[Bin] == Invalid)
+			{
+				this->UsedBins[TopBin] &= ~(1u << LeafBin);
+				if (this->UsedBins[TopBin] == 0)
+				{
+					this->UsedBinsTop &= ~(1u << TopBin);
+				}
+			}
+		}
+
+		this->FreeStorage -= Current.Size;
+	}
+
+	uint32_t OffsetAllocator::NewNode()
+	{
+		if (!this->FreeNode.empty())
+		{
+			const uint32_t Index = this->FreeNode.back();
+			this->FreeNode.pop_back();
+			return Index;
+		}
+
+		this->Node.push_back({});
+		return static_cast<uint32_t>(this->Node.size() - 1);
+	}
+}
@@ -0,0 +1,636 @@
+﻿#include "include/particle.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr size_t ParticleBlockSize = 16384;
+		constexpr size_t SortBlockSize = 65536;
+		constexpr uint32_t RadixBits = 11;
+		constexpr uint32_t RadixSize = 1 << RadixBits;
+		// Two passes over the upper 22 key bits: 13 mantissa bits are plenty to order blending.
+		constexpr uint32_t RadixShift = 10;
+		constexpr size_t ChannelCount = 9;
+		constexpr size_t BuildPrefetch = 16;
+
+		enum PARTICLE_CHANNEL : size_t
+		{
+			PARTICLE_CHANNEL_POSITION_X = 0,
+			PARTICLE_CHANNEL_POSITION_Y = 1,
+			PARTICLE_CHANNEL_POSITION_Z = 2,
+			PARTICLE_CHANNEL_VELOCITY_X = 3,
+			PARTICLE_CHANNEL_VELOCITY_Y = 4,
+			PARTICLE_CHANNEL_VELOCITY_Z = 5,
+			PARTICLE_CHANNEL_AGE = 6,
+			PARTICLE_CHANNEL_LIFETIME = 7,
+			PARTICLE_CHANNEL_SIZE = 8,
+		};
+
+		struct PARTICLE_STREAM_STRUCT
+		{
+			float* Channel[ChannelCount];
+			uint32_t* Color;
+		};
+
+		struct PARTICLE_UPDATE_STRUCT
+		{
+			float Delta;
+			float Drag;
+			float Acceleration[3];
+		};
+
+		template<class Stream>
+		PARTICLE_STREAM_STRUCT GetStream(Stream& Source)
+		{
+			return {
+				{
+					Source.PositionX.data(), Source.PositionY.data(), Source.PositionZ.data(),
+					Source.VelocityX.data(), Source.VelocityY.data(), Source.VelocityZ.data(),
+					Source.Age.data(), Source.Lifetime.data(), Source.Size.data(),
+				},
+				Source.Color.data(),
+			};
+		}
+
+		inline uint32_t Hash(uint32_t Value)
+		{
+			Value ^= Value >> 16;
+			Value *= 0x7FEB352Du;
+			Value ^= Value >> 15;
+			Value *= 0x846CA68Bu;
+			Value ^= Value >> 16;
+			return Value;
+		}
+
+		// Uniform in [-1, 1).
+		inline float RandomSigned(uint32_t Value)
+		{
+			return static_cast<float>(Hash(Value) >> 8) * (2.0f / 16777216.0f) - 1.0f;
+		}
+
+		// Back to front: the key of a farther particle is smaller.
+		inline uint32_t DepthKey(float Depth)
+		{
+			uint32_t Bits;
+			memcpy(&Bits, &Depth, sizeof(Bits));
+			return Bits ^ ~(static_cast<uint32_t>(static_cast<int32_t>(Bits) >> 31) | 0x80000000u);
+		}
+
+		// Vertex buffers are write only, so aligned output bypasses the cache.
+		inline void StoreVertex(float* Destination, __m128 Value, bool Stream)
+		{
+			if (Stream)
+			{
+				_mm_stream_ps(Destination, Value);
+			}
+			else
+			{
+				_mm_storeu_ps(Destination, Value);
+			}
+		}
+
+		inline __m128 MultiplyAdd(__m128 A, __m128 B, __m128 C)
+		{
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+			return _mm_fmadd_ps(A, B, C);
+#else
+			return _mm_add_ps(_mm_mul_ps(A, B), C);
+#endif
+		}
+
+#if defined(__AVX2__)
+		inline __m256 MultiplyAdd(__m256 A, __m256 B, __m256 C)
+		{
+#if defined(__FMA__) || defined(_MSC_VER)
+			return _mm256_fmadd_ps(A, B, C);
+#else
+			return _mm256_add_ps(_mm256_mul_ps(A, B), C);
+#endif
+		}
+
+		typedef __m256 PARTICLE_LANE;
+
+		// Lane permutation moving the lanes set in a mask to the front.
+		struct COMPACT_TABLE_STRUCT
+		{
+			COMPACT_TABLE_STRUCT()
+			{
+				for (uint32_t Mask = 0; Mask < 256; Mask++)
+				{
+					uint32_t Count = 0;
+					for (uint32_t Lane = 0; Lane < 8; Lane++)
+					{
+						if (Mask & (1 << Lane))
+						{
+							this->Lane[Mask][Count++] = Lane;
+						}
+					}
+					while (Count < 8)
+					{
+						this->Lane[Mask][Count++] = 0;
+					}
+				}
+			}
+
+			alignas(32) int32_t Lane[256][8];
+		};
+
+		const COMPACT_TABLE_STRUCT CompactTable;
+
+		inline PARTICLE_LANE Load(const float* Source) { return _mm256_loadu_ps(Source); }
+		inline void Store(float* Destination, PARTICLE_LANE Value) { _mm256_storeu_ps(Destination, Value); }
+		inline PARTICLE_LANE Broadcast(float Value) { return _mm256_set1_ps(Value); }
+		inline uint32_t LiveMask(PARTICLE_LANE Age, PARTICLE_LANE Lifetime) { return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(Age, Lifetime, _CMP_LT_OQ))); }
+#else
+		typedef __m128 PARTICLE_LANE;
+
+		inline PARTICLE_LANE Load(const float* Source) { return _mm_loadu_ps(Source); }
+		inline void Store(float* Destination, PARTICLE_LANE Value) { _mm_storeu_ps(Destination, Value); }
+		inline PARTICLE_LANE Broadcast(float Value) { return _mm_set1_ps(Value); }
+		inline uint32_t LiveMask(PARTICLE_LANE Age, PARTICLE_LANE Lifetime) { return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(Age, Lifetime))); }
+#endif
+
+		constexpr size_t LaneCount = sizeof(PARTICLE_LANE) / sizeof(float);
+
+		inline uint32_t CountBits(uint32_t Mask)
+		{
+			uint32_t Count = 0;
+			for (; Mask; Mask &= Mask - 1)
+			{
+				Count++;
+			}
+			return Count;
+		}
+
+		template<class Function>
+		void ForEachBlock(size_t BlockCount, ThreadPool* Pool, const Function& Block)
+		{
+			if (!Pool || BlockCount <= 1)
+			{
+				for (size_t Index = 0; Index < BlockCount; Index++)
+				{
+					Block(Index);
+				}
+				return;
+			}
+
+			Pool->Dispatch(BlockCount, Block);
+		}
+
+		size_t CountLive(const PARTICLE_STREAM_STRUCT& Source, size_t First, size_t Last, float Delta)
+		{
+			const float* const Age = Source.Channel[PARTICLE_CHANNEL_AGE];
+			const float* const Lifetime = Source.Channel[PARTICLE_CHANNEL_LIFETIME];
+			const PARTICLE_LANE Step = Broadcast(Delta);
+
+			size_t Live = 0;
+			size_t Index = First;
+#if defined(__AVX2__)
+			for (; Index + LaneCount <= Last; Index += LaneCount)
+			{
+				Live += _mm_popcnt_u32(LiveMask(_mm256_add_ps(Load(Age + Index), Step), Load(Lifetime + Index)));
+			}
+#else
+			for (; Index + LaneCount <= Last; Index += LaneCount)
+			{
+				Live += CountBits(LiveMask(_mm_add_ps(Load(Age + Index), Step), Load(Lifetime + Index)));
+			}
+#endif
+			for (; Index < Last; Index++)
+			{
+				Live += Age[Index] + Delta < Lifetime[Index];
+			}
+			return Live;
+		}
+
+		// Integrates the particles in [First, Last) of Source and writes the
+		// survivors to Target starting at Output. The caller passes End as
+		// Output plus the CountLive of the same range, which applies the same
+		// test, so exactly End - Output particles are written. Only the full
+		// lane stores of the AVX2 path, which spill past the survivors, need
+		// to check End.
+		void CompactBlock(const PARTICLE_STREAM_STRUCT& Source, const PARTICLE_STREAM_STRUCT& Target, size_t First, size_t Last, size_t Output, [[maybe_unused]] size_t End, const PARTICLE_UPDATE_STRUCT& Update)
+		{
+			const PARTICLE_LANE Delta = Broadcast(Update.Delta);
+			const PARTICLE_LANE Drag = Broadcast(Update.Drag);
+			const PARTICLE_LANE Acceleration[3] = {
+				Broadcast(Update.Acceleration[0] * Update.Delta),
+				Broadcast(Update.Acceleration[1] * Update.Delta),
+				Broadcast(Update.Acceleration[2] * Update.Delta),
+			};
+
+			size_t Index = First;
+			for (; Index + LaneCount <= Last; Index += LaneCount)
+			{
+				PARTICLE_LANE Value[ChannelCount];
+#if defined(__AVX2__)
+				Value[PARTICLE_CHANNEL_AGE] = _mm256_add_ps(Load(Source.Channel[PARTICLE_CHANNEL_AGE] + Index), Delta);
+#else
+				Value[PARTICLE_CHANNEL_AGE] = _mm_add_ps(Load(Source.Channel[PARTICLE_CHANNEL_AGE] + Index), Delta);
+#endif
+				Value[PARTICLE_CHANNEL_LIFETIME] = Load(Source.Channel[PARTICLE_CHANNEL_LIFETIME] + Index);
+
+				const uint32_t Mask = LiveMask(Value[PARTICLE_CHANNEL_AGE], Value[PARTICLE_CHANNEL_LIFETIME]);
+				if (!Mask)
+				{
+					continue;
+				}
+
+				for (size_t Axis = 0; Axis < 3; Axis++)
+				{
+					Value[PARTICLE_CHANNEL_VELOCITY_X + Axis] = MultiplyAdd(Load(Source.Channel[PARTICLE_CHANNEL_VELOCITY_X + Axis] + Index), Drag, Acceleration[Axis]);
+					Value[PARTICLE_CHANNEL_POSITION_X + Axis] = MultiplyAdd(Value[PARTICLE_CHANNEL_VELOCITY_X + Axis], Delta, Load(Source.Channel[PARTICLE_CHANNEL_POSITION_X + Axis] + Index));
+				}
+				Value[PARTICLE_CHANNEL_SIZE] = Load(Source.Channel[PARTICLE_CHANNEL_SIZE] + Index);
+
+#if defined(__AVX2__)
+				if (Output + LaneCount <= End)
+				{
+					const __m256i Permute = _mm256_load_si256(reinterpret_cast<const __m256i*>(CompactTable.Lane[Mask]));
+					for (size_t Channel = 0; Channel < ChannelCount; Channel++)
+					{
+						Store(Target.Channel[Channel] + Output, _mm256_permutevar8x32_ps(Value[Channel], Permute));
+					}
+					const __m256i Color = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Source.Color + Index));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(Target.Color + Output), _mm256_permutevar8x32_epi32(Color, Permute));
+					Output += _mm_popcnt_u32(Mask);
+					continue;
+				}
+#endif
+
+				float Lane[ChannelCount][LaneCount];
+				for (size_t Channel = 0; Channel < ChannelCount; Channel++)
+				{
+					Store(Lane[Channel], Value[Channel]);
+				}
+				for (uint32_t Remaining = Mask; Remaining; Remaining &= Remaining - 1)
+				{
+					uint32_t Bit = 0;
+					while (!(Remaining & (1u << Bit)))
+					{
+						Bit++;
+					}
+					for (size_t Channel = 0; Channel < ChannelCount; Channel++)
+					{
+						Target.Channel[Channel][Output] = Lane[Channel][Bit];
+					}
+					Target.Color[Output++] = Source.Color[Index + Bit];
+				}
+			}
+
+			for (; Index < Last; Index++)
+			{
+				const float Age = Source.Channel[PARTICLE_CHANNEL_AGE][Index] + Update.Delta;
+				if (!(Age < Source.Channel[PARTICLE_CHANNEL_LIFETIME][Index]))
+				{
+					continue;
+				}
+
+				for (size_t Axis = 0; Axis < 3; Axis++)
+				{
+					const float Velocity = Source.Channel[PARTICLE_CHANNEL_VELOCITY_X + Axis][Index] * Update.Drag + Update.Acceleration[Axis] * Update.Delta;
+					Target.Channel[PARTICLE_CHANNEL_VELOCITY_X + Axis][Output] = Velocity;
+					Target.Channel[PARTICLE_CHANNEL_POSITION_X + Axis][Output] = Source.Channel[PARTICLE_CHANNEL_POSITION_X + Axis][Index] + Velocity * Update.Delta;
+				}
+				Target.Channel[PARTICLE_CHANNEL_AGE][Output] = Age;
+				Target.Channel[PARTICLE_CHANNEL_LIFETIME][Output] = Source.Channel[PARTICLE_CHANNEL_LIFETIME][Index];
+				Target.Channel[PARTICLE_CHANNEL_SIZE][Output] = Source.Channel[PARTICLE_CHANNEL_SIZE][Index];
+				Target.Color[Output++] = Source.Color[Index];
+			}
+		}
+
+		// Also packs position and size into Packed, four floats per particle, so
+		// that Build reads one cache line per particle in sorted order.
+		void ComputeKey(const PARTICLE_STREAM_STRUCT& Source, const float* View, uint32_t* Key, uint32_t* Order, float* Packed, size_t First, size_t Last)
+		{
+			for (size_t Index = First; Index < Last; Index++)
+			{
+				_mm_storeu_ps(Packed + Index * 4, _mm_setr_ps(Source.Channel[PARTICLE_CHANNEL_POSITION_X][Index], Source.Channel[PARTICLE_CHANNEL_POSITION_Y][Index], Source.Channel[PARTICLE_CHANNEL_POSITION_Z][Index], Source.Channel[PARTICLE_CHANNEL_SIZE][Index]));
+			}
+
+			size_t Index = First;
+#if defined(__AVX2__)
+			const __m256 AxisX = _mm256_set1_ps(View[2]);
+			const __m256 AxisY = _mm256_set1_ps(View[6]);
+			const __m256 AxisZ = _mm256_set1_ps(View[10]);
+			const __m256 Offset = _mm256_set1_ps(View[14]);
+			const __m256i Sign = _mm256_set1_epi32(static_cast<int32_t>(0x80000000u));
+			const __m256i Ones = _mm256_set1_epi32(-1);
+			const __m256i Step = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+			for (; Index + 8 <= Last; Index += 8)
+			{
+				__m256 Depth = MultiplyAdd(Load(Source.Channel[PARTICLE_CHANNEL_POSITION_X] + Index), AxisX, Offset);
+				Depth = MultiplyAdd(Load(Source.Channel[PARTICLE_CHANNEL_POSITION_Y] + Index), AxisY, Depth);
+				Depth = MultiplyAdd(Load(Source.Channel[PARTICLE_CHANNEL_POSITION_Z] + Index), AxisZ, Depth);
+
+				const __m256i Bits = _mm256_castps_si256(Depth);
+				const __m256i Flip = _mm256_xor_si256(_mm256_or_si256(_mm256_srai_epi32(Bits, 31), Sign), Ones);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(Key + Index), _mm256_xor_si256(Bits, Flip));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(Order + Index), _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(Index)), Step));
+			}
+#endif
+			for (; Index < Last; Index++)
+			{
+				float Depth = Source.Channel[PARTICLE_CHANNEL_POSITION_X][Index] * View[2] + View[14];
+				Depth += Source.Channel[PARTICLE_CHANNEL_POSITION_Y][Index] * View[6];
+				Depth += Source.Channel[PARTICLE_CHANNEL_POSITION_Z][Index] * View[10];
+				Key[Index] = DepthKey(Depth);
+				Order[Index] = static_cast<uint32_t>(Index);
+			}
+		}
+	}
+
+
+
+	ParticleSystem::ParticleSystem(size_t Capacity) : Capacity(Capacity)
+	{
+		for (STREAM_STRUCT& Stream : this->Stream)
+		{
+			Stream.PositionX.resize(Capacity);
+			Stream.PositionY.resize(Capacity);
+			Stream.PositionZ.resize(Capacity);
+			Stream.VelocityX.resize(Capacity);
+			Stream.VelocityY.resize(Capacity);
+			Stream.VelocityZ.resize(Capacity);
+			Stream.Age.resize(Capacity);
+			Stream.Lifetime.resize(Capacity);
+			Stream.Size.resize(Capacity);
+			Stream.Color.resize(Capacity);
+		}
+	}
+
+	size_t ParticleSystem::Emit(const PARTICLE_EMITTER_STRUCT& Emitter, size_t Count, ThreadPool* Pool)
+	{
+		const size_t Added = (std::min)(Count, this->Capacity - this->Count);
+		const size_t Base = this->Count;
+		const uint32_t Seed = this->Seed;
+		const PARTICLE_STREAM_STRUCT Target = GetStream(this->Stream[this->Current]);
+
+		ForEachBlock((Added + ParticleBlockSize - 1) / ParticleBlockSize, Pool, [&](size_t Block)
+		{
+			const size_t First = Block * ParticleBlockSize;
+			const size_t Last = (std::min)(First + ParticleBlockSize, Added);
+
+			for (size_t Index = First; Index < Last; Index++)
+			{
+				const uint32_t Random = Seed + static_cast<uint32_t>(Index) * 8;
+				const size_t Particle = Base + Index;
+
+				for (size_t Axis = 0; Axis < 3; Axis++)
+				{
+					Target.Channel[PARTICLE_CHANNEL_POSITION_X + Axis][Particle] = Emitter.Position[Axis] + Emitter.PositionSpread[Axis] * RandomSigned(Random + static_cast<uint32_t>(Axis));
+					Target.Channel[PARTICLE_CHANNEL_VELOCITY_X + Axis][Particle] = Emitter.Velocity[Axis] + Emitter.VelocitySpread[Axis] * RandomSigned(Random + static_cast<uint32_t>(Axis) + 3);
+				}
+				Target.Channel[PARTICLE_CHANNEL_AGE][Particle] = 0.0f;
+				Target.Channel[PARTICLE_CHANNEL_LIFETIME][Particle] = Emitter.Lifetime + Emitter.LifetimeSpread * RandomSigned(Random + 6);
+				Target.Channel[PARTICLE_CHANNEL_SIZE][Particle] = Emitter.Size;
+				Target.Color[Particle] = Emitter.Color;
+			}
+		});
+
+		this->Seed += static_cast<uint32_t>(Added) * 8;
+		this->Count += Added;
+		this->Sorted = false;
+		return Added;
+	}
+
+	void ParticleSystem::Update(float Delta, const float* Acceleration, float Drag, ThreadPool* Pool)
+	{
+		const size_t BlockCount = (this->Count + ParticleBlockSize - 1) / ParticleBlockSize;
+		const PARTICLE_STREAM_STRUCT Source = GetStream(this->Stream[this->Current]);
+		const PARTICLE_STREAM_STRUCT Target = GetStream(this->Stream[this->Current ^ 1]);
+		const PARTICLE_UPDATE_STRUCT Update = {
+			Delta, (std::max)(1.0f - Drag * Delta, 0.0f),
+			{ Acceleration[0], Acceleration[1], Acceleration[2] },
+		};
+
+		this->BlockLive.resize(BlockCount + 1);
+
+		ForEachBlock(BlockCount, Pool, [&](size_t Block)
+		{
+			const size_t First = Block * ParticleBlockSize;
+			this->BlockLive[Block] = CountLive(Source, First, (std::min)(First + ParticleBlockSize, this->Count), Delta);
+		});
+
+		size_t Live = 0;
+		for (size_t Block = 0; Block < BlockCount; Block++)
+		{
+			const size_t Count = this->BlockLive[Block];
+			this->BlockLive[Block] = Live;
+			Live += Count;
+		}
+		this->BlockLive[BlockCount] = Live;
+
+		ForEachBlock(BlockCount, Pool, [&](size_t Block)
+		{
+			const size_t First = Block * ParticleBlockSize;
+			CompactBlock(Source, Target, First, (std::min)(First + ParticleBlockSize, this->Count), this->BlockLive[Block], this->BlockLive[Block + 1], Update);
+		});
+
+		this->Current ^= 1;
+		this->Count = Live;
+		this->Sorted = false;
+	}
+
+	void ParticleSystem::Sort(const float* View, ThreadPool* Pool)
+	{
+		const size_t Count = this->Count;
+		const PARTICLE_STREAM_STRUCT Source = GetStream(this->Stream[this->Current]);
+
+		for (size_t Buffer = 0; Buffer < 2; Buffer++)
+		{
+			this->Key[Buffer].resize(Count);
+			this->Order[Buffer].resize(Count);
+		}
+		this->Packed.resize(Count * 4);
+
+		ForEachBlock((Count + ParticleBlockSize - 1) / ParticleBlockSize, Pool, [&](size_t Block)
+		{
+			const size_t First = Block * ParticleBlockSize;
+			ComputeKey(Source, View, this->Key[0].data(), this->Order[0].data(), this->Packed.data(), First, (std::min)(First + ParticleBlockSize, Count));
+		});
+
+		const size_t BlockCount = Pool ? (std::max)((Count + SortBlockSize - 1) / SortBlockSize, static_cast<size_t>(1)) : 1;
+		const size_t BlockSize = (Count + BlockCount - 1) / BlockCount;
+		this->Histogram.resize(BlockCount * RadixSize);
+
+		size_t Input = 0;
+		for (uint32_t Shift = RadixShift; Shift < 32; Shift += RadixBits)
+		{
+			const uint32_t* const Key = this->Key[Input].data();
+			const uint32_t* const Order = this->Order[Input].data();
+			uint32_t* const KeyOutput = this->Key[Input ^ 1].data();
+			uint32_t* const OrderOutput = this->Order[Input ^ 1].data();
+
+			ForEachBlock(BlockCount, Pool, [&](size_t Block)
+			{
+				uint32_t* const Histogram = this->Histogram.data() + Block * RadixSize;
+				std::fill(Histogram, Histogram + RadixSize, 0);
+
+				const size_t Last = (std::min)((Block + 1) * BlockSize, Count);
+				for (size_t Index = Block * BlockSize; Index < Last; Index++)
+				{
+					Histogram[(Key[Index] >> Shift) & (RadixSize - 1)]++;
+				}
+			});
+
+			bool Uniform = false;
+			uint32_t Offset = 0;
+			for (uint32_t Digit = 0; Digit < RadixSize; Digit++)
+			{
+				const uint32_t Start = Offset;
+				for (size_t Block = 0; Block < BlockCount; Block++)
+				{
+					const uint32_t Size = this->Histogram[Block * RadixSize + Digit];
+					this->Histogram[Block * RadixSize + Digit] = Offset;
+					Offset += Size;
+				}
+				Uniform = Uniform || Offset - Start == Count;
+			}
+
+			if (Uniform)
+			{
+				continue;
+			}
+
+			ForEachBlock(BlockCount, Pool, [&](size_t Block)
+			{
+				uint32_t* const Histogram = this->Histogram.data() + Block * RadixSize;
+
+				const size_t Last = (std::min)((Block + 1) * BlockSize, Count);
+				for (size_t Index = Block * BlockSize; Index < Last; Index++)
+				{
+					const uint32_t Target = Histogram[(Key[Index] >> Shift) & (RadixSize - 1)]++;
+					KeyOutput[Target] = Key[Index];
+					OrderOutput[Target] = Order[Index];
+				}
+			});
+
+			Input ^= 1;
+		}
+
+		if (Input)
+		{
+			this->Key[0].swap(this->Key[1]);
+			this->Order[0].swap(this->Order[1]);
+		}
+
+		this->Sorted = true;
+	}
+
+	size_t ParticleSystem::Build(const float* View, PARTICLE_VERTEX_STRUCT* Vertex, uint32_t* Color, ThreadPool* Pool) const
+	{
+		const size_t Count = this->Count;
+		const STREAM_STRUCT& Source = this->Stream[this->Current];
+		const uint32_t* const Order = this->Sorted ? this->Order[0].data() : nullptr;
+		const float* const Packed = this->Packed.data();
+		const __m128 PositionMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		const bool Stream = (reinterpret_cast<uintptr_t>(Vertex) & 15) == 0;
+
+		const __m128 Right = _mm_setr_ps(View[0], View[4], View[8], 0.0f);
+		const __m128 Up = _mm_setr_ps(View[1], View[5], View[9], 0.0f);
+		const __m128 Corner[4] = {
+			_mm_sub_ps(Up, Right),
+			_mm_add_ps(Up, Right),
+			_mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(Up, Right)),
+			_mm_sub_ps(Right, Up),
+		};
+		const __m128 Low[4] = {
+			_mm_setr_ps(0.0f, 0.0f, 0.0f, 0.0f),
+			_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f),
+			_mm_setr_ps(0.0f, 0.0f, 0.0f, 0.0f),
+			_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f),
+		};
+		const __m128 High[4] = {
+			_mm_setr_ps(0.0f, -View[2], -View[6], -View[10]),
+			_mm_setr_ps(0.0f, -View[2], -View[6], -View[10]),
+			_mm_setr_ps(1.0f, -View[2], -View[6], -View[10]),
+			_mm_setr_ps(1.0f, -View[2], -View[6], -View[10]),
+		};
+
+		ForEachBlock((Count + ParticleBlockSize - 1) / ParticleBlockSize, Pool, [&](size_t Block)
+		{
+			const size_t First = Block * ParticleBlockSize;
+			const size_t Last = (std::min)(First + ParticleBlockSize, Count);
+
+			for (size_t Index = First; Index < Last; Index++)
+			{
+				const size_t Particle = Order ? Order[Index] : Index;
+				__m128 Position;
+				if (Order)
+				{
+					if (Index + BuildPrefetch < Last)
+					{
+						_mm_prefetch(reinterpret_cast<const char*>(Packed + Order[Index + BuildPrefetch] * 4), _MM_HINT_T0);
+						if (Color)
+						{
+							_mm_prefetch(reinterpret_cast<const char*>(Source.Color.data() + Order[Index + BuildPrefetch]), _MM_HINT_T0);
+						}
+					}
+					Position = _mm_loadu_ps(Packed + Particle * 4);
+				}
+				else
+				{
+					Position = _mm_setr_ps(Source.PositionX[Particle], Source.PositionY[Particle], Source.PositionZ[Particle], Source.Size[Particle]);
+				}
+				const __m128 Size = _mm_shuffle_ps(Position, Position, _MM_SHUFFLE(3, 3, 3, 3));
+				Position = _mm_and_ps(Position, PositionMask);
+				float* const Output = Vertex[Index * 4].Position;
+
+				for (size_t Current = 0; Current < 4; Current++)
+				{
+					StoreVertex(Output + Current * 8, _mm_add_ps(MultiplyAdd(Corner[Current], Size, Position), Low[Current]), Stream);
+					StoreVertex(Output + Current * 8 + 4, High[Current], Stream);
+				}
+
+				if (Color)
+				{
+					Color[Index] = Source.Color[Particle];
+				}
+			}
+
+			if (Stream)
+			{
+				_mm_sfence();
+			}
+		});
+
+		return Count;
+	}
+
+	void ParticleSystem::Clear()
+	{
+		this->Count = 0;
+		this->Sorted = false;
+	}
+
+	size_t ParticleSystem::GetCount() const
+	{
+		return this->Count;
+	}
+
+	size_t ParticleSystem::GetCapacity() const
+	{
+		return this->Capacity;
+	}
+
+	void ParticleSystem::BuildIndex(uint32_t* Index, size_t QuadCount)
+	{
+		for (size_t Quad = 0; Quad < QuadCount; Quad++)
+		{
+			const uint32_t Base = static_cast<uint32_t>(Quad * 4);
+			uint32_t* const Output = Index + Quad * 6;
+			Output[0] = Base + 0;
+			Output[1] = Base + 1;
+			Output[2] = Base + 2;
+			Output[3] = Base + 2;
+			Output[4] = Base + 1;
+			Output[5] = Base + 3;
+		}
+	}
+}
@@ -0,0 +1,162 @@
+﻿#include "include/pipeline.h"
+#include "include/profiler.h"
+#include <chrono>
+
+namespace Engine
+{
+	namespace
+	{
+		double GetSeconds(std::chrono::steady_clock::time_point Start)
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		}
+	}
+
+
+
+	FramePipeline::FramePipeline(UINT Depth, std::function<void(UINT Slot)> Render) : Depth(Depth), Render(std::move(Render))
+	{
+		if (this->Depth > 0)
+		{
+			this->Thread = std::thread(&FramePipeline::Worker, this);
+		}
+	}
+
+	FramePipeline::~FramePipeline()
+	{
+		if (this->Thread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> Lock(this->Mutex);
+				this->Exit = true;
+			}
+			this->Published.notify_one();
+			this->Thread.join();
+		}
+	}
+
+	UINT FramePipeline::Begin()
+	{
+		if (this->Depth == 0)
+		{
+			return 0;
+		}
+
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+		std::unique_lock<std::mutex> Lock(this->Mutex);
+		this->Rendered.wait(Lock, [this] { return this->WriteCount - this->RenderCount <= this->Depth || this->Error; });
+		this->Statistics.SimulationWaitTime += GetSeconds(Start);
+
+		this->Rethrow();
+		return static_cast<UINT>(this->WriteCount % (this->Depth + 1));
+	}
+
+	void FramePipeline::End()
+	{
+		if (this->Depth == 0)
+		{
+			const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+			{
+				PROFILE_SCOPE("Render");
+				this->Render(0);
+			}
+			this->Statistics.RenderTime += GetSeconds(Start);
+			this->Statistics.FrameCount++;
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> Lock(this->Mutex);
+			this->Rethrow();
+			this->WriteCount++;
+		}
+		this->Published.notify_one();
+	}
+
+	void FramePipeline::Flush()
+	{
+		if (this->Depth == 0)
+		{
+			return;
+		}
+
+		std::unique_lock<std::mutex> Lock(this->Mutex);
+		this->Rendered.wait(Lock, [this] { return this->RenderCount == this->WriteCount || this->Error; });
+		this->Rethrow();
+	}
+
+	UINT FramePipeline::GetDepth() const
+	{
+		return this->Depth;
+	}
+
+	PIPELINE_STATISTICS_STRUCT FramePipeline::GetStatistics()
+	{
+		std::lock_guard<std::mutex> Lock(this->Mutex);
+		return this->Statistics;
+	}
+
+	void FramePipeline::ResetStatistics()
+	{
+		std::lock_guard<std::mutex> Lock(this->Mutex);
+		this->Statistics = {};
+	}
+
+
+
+	void FramePipeline::Worker()
+	{
+		Profiler::SetThreadName("Render");
+
+		std::unique_lock<std::mutex> Lock(this->Mutex);
+
+		for (;;)
+		{
+			const std::chrono::steady_clock::time_point Idle = std::chrono::steady_clock::now();
+			this->Published.wait(Lock, [this] { return this->RenderCount != this->WriteCount || this->Exit; });
+			this->Statistics.RenderWaitTime += GetSeconds(Idle);
+
+			if (this->RenderCount == this->WriteCount)
+			{
+				break;
+			}
+
+			const UINT Slot = static_cast<UINT>(this->RenderCount % (this->Depth + 1));
+			Lock.unlock();
+
+			const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+			std::exception_ptr Error;
+			try
+			{
+				PROFILE_SCOPE("Render");
+				this->Render(Slot);
+			}
+			catch (...)
+			{
+				Error = std::current_exception();
+			}
+			const double Time = GetSeconds(Start);
+
+			Lock.lock();
+			this->Statistics.RenderTime += Time;
+			this->Statistics.FrameCount++;
+			this->RenderCount++;
+			if (Error && !this->Error)
+			{
+				this->Error = Error;
+			}
+			this->Rendered.notify_one();
+		}
+	}
+
+	void FramePipeline::Rethrow()
+	{
+		if (this->Error)
+		{
+			std::exception_ptr Error = this->Error;
+			this->Error = nullptr;
+			std::rethrow_exception(Error);
+		}
+	}
+}
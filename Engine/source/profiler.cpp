@@ -0,0 +1,403 @@
+﻿#include "include/profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr size_t EventCapacity = 1 << 16;
+		constexpr size_t MaxDepth = 64;
+
+		struct EVENT_STRUCT
+		{
+			std::atomic<const char*> Name;
+			std::atomic<uint64_t> Begin;
+			std::atomic<uint64_t> End;
+			std::atomic<uint32_t> Depth;
+		};
+
+		struct RECORD_STRUCT
+		{
+			const char* Name;
+			uint64_t Begin;
+			uint64_t End;
+			uint32_t Depth;
+			uint32_t Thread;
+		};
+
+		// Reused, buffered events included, by the next new thread once the owner exits.
+		struct THREAD_STRUCT
+		{
+			uint32_t Index = 0;
+			bool Active = true;
+			std::string Name;
+			const char* StackName[MaxDepth] = {};
+			uint64_t StackBegin[MaxDepth] = {};
+			uint32_t Depth = 0;
+			std::atomic<uint64_t> Head{ 0 };
+			EVENT_STRUCT Event[EventCapacity];
+		};
+
+		struct STATE_STRUCT
+		{
+			std::mutex Mutex;
+			std::vector<std::unique_ptr<THREAD_STRUCT>> Thread;
+			uint64_t FrameBegin = GetTimestamp();
+			uint64_t LastFrameBegin = 0;
+			uint64_t LastFrameEnd = 0;
+			std::atomic<bool> Enabled{ true };
+		};
+
+		STATE_STRUCT& GetState()
+		{
+			static STATE_STRUCT State;
+			return State;
+		}
+
+		class ThreadSlot
+		{
+		public:
+			~ThreadSlot()
+			{
+				if (this->Thread)
+				{
+					std::lock_guard<std::mutex> Lock(GetState().Mutex);
+					this->Thread->Active = false;
+				}
+			}
+
+			THREAD_STRUCT* Thread = nullptr;
+		};
+
+		THREAD_STRUCT* GetThread()
+		{
+			STATE_STRUCT& State = GetState();
+			thread_local ThreadSlot Current;
+			if (!Current.Thread)
+			{
+				std::lock_guard<std::mutex> Lock(State.Mutex);
+				for (const std::unique_ptr<THREAD_STRUCT>& Thread : State.Thread)
+				{
+					if (!Thread->Active)
+					{
+						Current.Thread = Thread.get();
+						Current.Thread->Active = true;
+						Current.Thread->Name.clear();
+						Current.Thread->Depth = 0;
+						return Current.Thread;
+					}
+				}
+
+				State.Thread.push_back(std::make_unique<THREAD_STRUCT>());
+				Current.Thread = State.Thread.back().get();
+				Current.Thread->Index = static_cast<uint32_t>(State.Thread.size() - 1);
+			}
+			return Current.Thread;
+		}
+
+		// The owner may overwrite a slot while it is being copied, so events
+		// that fell out of the window during the copy are dropped afterwards.
+		void Collect(THREAD_STRUCT& Thread, std::vector<RECORD_STRUCT>& Record)
+		{
+			const uint64_t Head = Thread.Head.load(std::memory_order_acquire);
+			const uint64_t First = Head > EventCapacity ? Head - EventCapacity : 0;
+			const size_t Start = Record.size();
+
+			for (uint64_t Index = First; Index < Head; Index++)
+			{
+				const EVENT_STRUCT& Event = Thread.Event[Index % EventCapacity];
+				Record.push_back({ Event.Name.load(std::memory_order_relaxed), Event.Begin.load(std::memory_order_relaxed), Event.End.load(std::memory_order_relaxed), Event.Depth.load(std::memory_order_relaxed), Thread.Index });
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const uint64_t Valid = Thread.Head.load(std::memory_order_relaxed);
+			if (Valid > First + EventCapacity)
+			{
+				const size_t Lost = static_cast<size_t>(std::min<uint64_t>(Valid - First - EventCapacity, Head - First));
+				Record.erase(Record.begin() + Start, Record.begin() + Start + Lost);
+			}
+		}
+
+		void WriteString(FILE* File, const char* String)
+		{
+			fputc('"', File);
+			for (const char* Current = String; *Current; Current++)
+			{
+				if (*Current == '"' || *Current == '\\')
+				{
+					fputc('\\', File);
+				}
+				if (static_cast<unsigned char>(*Current) >= 0x20)
+				{
+					fputc(*Current, File);
+				}
+			}
+			fputc('"', File);
+		}
+	}
+
+
+
+	uint64_t GetTimestamp()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	void Profiler::SetEnabled(bool Enabled)
+	{
+		GetState().Enabled.store(Enabled, std::memory_order_relaxed);
+	}
+
+	bool Profiler::IsEnabled()
+	{
+		return GetState().Enabled.load(std::memory_order_relaxed);
+	}
+
+	void Profiler::SetThreadName(const char* Name)
+	{
+		THREAD_STRUCT* Thread = GetThread();
+
+		std::lock_guard<std::mutex> Lock(GetState().Mutex);
+		Thread->Name = Name;
+	}
+
+	void Profiler::Begin(const char* Name)
+	{
+		THREAD_STRUCT* Thread = GetThread();
+
+		if (Thread->Depth < MaxDepth)
+		{
+			Thread->StackName[Thread->Depth] = IsEnabled() ? Name : nullptr;
+			Thread->StackBegin[Thread->Depth] = Thread->StackName[Thread->Depth] ? GetTimestamp() : 0;
+		}
+		Thread->Depth++;
+	}
+
+	void Profiler::End()
+	{
+		THREAD_STRUCT* Thread = GetThread();
+
+		if (Thread->Depth == 0)
+		{
+			return;
+		}
+
+		const uint32_t Depth = --Thread->Depth;
+		if (Depth >= MaxDepth || !Thread->StackName[Depth])
+		{
+			return;
+		}
+
+		const uint64_t Head = Thread->Head.load(std::memory_order_relaxed);
+		EVENT_STRUCT& Event = Thread->Event[Head % EventCapacity];
+		Event.Name.store(Thread->StackName[Depth], std::memory_order_relaxed);
+		Event.Begin.store(Thread->StackBegin[Depth], std::memory_order_relaxed);
+		Event.End.store(GetTimestamp(), std::memory_order_relaxed);
+		Event.Depth.store(Depth, std::memory_order_relaxed);
+		Thread->Head.store(Head + 1, std::memory_order_release);
+	}
+
+	void Profiler::NextFrame()
+	{
+		STATE_STRUCT& State = GetState();
+		const uint64_t Now = GetTimestamp();
+
+		std::lock_guard<std::mutex> Lock(State.Mutex);
+		State.LastFrameBegin = State.FrameBegin;
+		State.LastFrameEnd = Now;
+		State.FrameBegin = Now;
+	}
+
+	double Profiler::GetFrame(std::vector<PROFILE_NODE_STRUCT>& Node)
+	{
+		Node.clear();
+
+		STATE_STRUCT& State = GetState();
+		std::vector<RECORD_STRUCT> Record;
+		uint64_t FrameBegin = 0;
+		uint64_t FrameEnd = 0;
+
+		{
+			std::lock_guard<std::mutex> Lock(State.Mutex);
+			FrameBegin = State.LastFrameBegin;
+			FrameEnd = State.LastFrameEnd;
+
+			for (const std::unique_ptr<THREAD_STRUCT>& Thread : State.Thread)
+			{
+				Collect(*Thread, Record);
+			}
+		}
+
+		Record.erase(std::remove_if(Record.begin(), Record.end(), [FrameBegin, FrameEnd](const RECORD_STRUCT& Current)
+		{
+			return Current.Begin < FrameBegin || Current.Begin >= FrameEnd;
+		}), Record.end());
+
+		std::sort(Record.begin(), Record.end(), [](const RECORD_STRUCT& Left, const RECORD_STRUCT& Right)
+		{
+			if (Left.Thread != Right.Thread)
+			{
+				return Left.Thread < Right.Thread;
+			}
+			if (Left.Begin != Right.Begin)
+			{
+				return Left.Begin < Right.Begin;
+			}
+			return Left.Depth < Right.Depth;
+		});
+
+		std::vector<uint32_t> Stack;
+		uint32_t Thread = Invalid;
+
+		for (const RECORD_STRUCT& Current : Record)
+		{
+			if (Current.Thread != Thread)
+			{
+				Thread = Current.Thread;
+				Stack.clear();
+			}
+
+			const uint32_t Depth = (std::min)(Current.Depth, static_cast<uint32_t>(Stack.size()));
+			Stack.resize(Depth);
+
+			const uint32_t Parent = Depth ? Stack[Depth - 1] : Invalid;
+
+			uint32_t Found = Invalid;
+			for (size_t Index = Node.size(); Index-- > 0;)
+			{
+				if (Node[Index].Thread != Thread || (Parent != Invalid && Index <= Parent))
+				{
+					break;
+				}
+				if (Node[Index].Parent == Parent && Node[Index].Name == Current.Name)
+				{
+					Found = static_cast<uint32_t>(Index);
+					break;
+				}
+			}
+
+			if (Found == Invalid)
+			{
+				Found = static_cast<uint32_t>(Node.size());
+				Node.push_back({ Current.Name, Thread, Parent, Depth, 0, 0.0 });
+			}
+
+			Node[Found].Count++;
+			Node[Found].Time += (Current.End - Current.Begin) * 1e-9;
+			Stack.push_back(Found);
+		}
+
+		// Merging can append children of an earlier sibling after later ones, so restore depth-first order.
+		std::vector<uint32_t> FirstChild(Node.size(), Invalid);
+		std::vector<uint32_t> LastChild(Node.size(), Invalid);
+		std::vector<uint32_t> NextSibling(Node.size(), Invalid);
+		std::vector<uint32_t> Root;
+
+		for (uint32_t Index = 0; Index < Node.size(); Index++)
+		{
+			const uint32_t Parent = Node[Index].Parent;
+			if (Parent == Invalid)
+			{
+				Root.push_back(Index);
+			}
+			else if (FirstChild[Parent] == Invalid)
+			{
+				FirstChild[Parent] = LastChild[Parent] = Index;
+			}
+			else
+			{
+				NextSibling[LastChild[Parent]] = Index;
+				LastChild[Parent] = Index;
+			}
+		}
+
+		std::vector<PROFILE_NODE_STRUCT> Sorted;
+		std::vector<uint32_t> Remap(Node.size(), Invalid);
+		Sorted.reserve(Node.size());
+
+		for (const uint32_t First : Root)
+		{
+			Stack.assign(1, First);
+			while (!Stack.empty())
+			{
+				const uint32_t Index = Stack.back();
+				Stack.pop_back();
+
+				Remap[Index] = static_cast<uint32_t>(Sorted.size());
+				Sorted.push_back(Node[Index]);
+				if (Node[Index].Parent != Invalid)
+				{
+					Sorted.back().Parent = Remap[Node[Index].Parent];
+				}
+
+				const size_t Count = Stack.size();
+				for (uint32_t Child = FirstChild[Index]; Child != Invalid; Child = NextSibling[Child])
+				{
+					Stack.push_back(Child);
+				}
+				std::reverse(Stack.begin() + Count, Stack.end());
+			}
+		}
+
+		Node.swap(Sorted);
+
+		return (FrameEnd - FrameBegin) * 1e-9;
+	}
+
+	bool Profiler::SaveTrace(const char* FileName)
+	{
+		STATE_STRUCT& State = GetState();
+		std::vector<RECORD_STRUCT> Record;
+		std::vector<std::string> Name;
+
+		{
+			std::lock_guard<std::mutex> Lock(State.Mutex);
+			for (const std::unique_ptr<THREAD_STRUCT>& Thread : State.Thread)
+			{
+				Collect(*Thread, Record);
+				Name.push_back(Thread->Name);
+			}
+		}
+
+		FILE* File = fopen(FileName, "wb");
+		if (!File)
+		{
+			return false;
+		}
+
+		const uint64_t Origin = Record.empty() ? 0 : std::min_element(Record.begin(), Record.end(), [](const RECORD_STRUCT& Left, const RECORD_STRUCT& Right) { return Left.Begin < Right.Begin; })->Begin;
+
+		fputs("{\"traceEvents\":[", File);
+
+		bool First = true;
+		for (size_t Index = 0; Index < Name.size(); Index++)
+		{
+			if (Name[Index].empty())
+			{
+				continue;
+			}
+
+			fprintf(File, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", First ? "" : ",", static_cast<unsigned>(Index));
+			WriteString(File, Name[Index].c_str());
+			fputs("}}", File);
+			First = false;
+		}
+
+		for (const RECORD_STRUCT& Current : Record)
+		{
+			fprintf(File, "%s\n{\"name\":", First ? "" : ",");
+			WriteString(File, Current.Name);
+			fprintf(File, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", Current.Thread, (Current.Begin - Origin) * 1e-3, (Current.End - Current.Begin) * 1e-3);
+			First = false;
+		}
+
+		fputs("\n],\"displayTimeUnit\":\"ms\"}\n", File);
+		return fclose(File) == 0;
+	}
+}
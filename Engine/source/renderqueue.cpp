@@ -0,0 +1,112 @@
+﻿#include "include/renderqueue.h"
+#include <algorithm>
+
+namespace Engine
+{
+	inline uint64_t QuantizeDepth(float Depth)
+	{
+		constexpr uint32_t MaxDepth = (1u << 24) - 1;
+		const float Clamped = std::min(std::max(Depth, 0.0f), 1.0f);
+		return static_cast<uint64_t>(Clamped * static_cast<float>(MaxDepth)) & MaxDepth;
+	}
+
+	uint64_t MakeOpaqueKey(uint32_t Pass, uint32_t Shader, uint32_t Material, float Depth)
+	{
+		return (static_cast<uint64_t>(Pass & 0xF) << 60) |
+			(static_cast<uint64_t>(Shader & 0xFFF) << 48) |
+			(static_cast<uint64_t>(Material & 0xFFFF) << 32) |
+			(QuantizeDepth(Depth) << 8);
+	}
+
+	uint64_t MakeTransparentKey(uint32_t Pass, uint32_t Shader, uint32_t Material, float Depth)
+	{
+		return (static_cast<uint64_t>(Pass & 0xF) << 60) |
+			((~QuantizeDepth(Depth) & 0xFFFFFF) << 36) |
+			(static_cast<uint64_t>(Shader & 0xFFF) << 24) |
+			(static_cast<uint64_t>(Material & 0xFFFF) << 8);
+	}
+
+
+
+	void RenderQueue::Reserve(size_t Count)
+	{
+		this->Packet.reserve(Count);
+		this->Temp.reserve(Count);
+	}
+
+	void RenderQueue::Clear()
+	{
+		this->Packet.clear();
+	}
+
+	void RenderQueue::Submit(uint64_t Key, uint32_t Command)
+	{
+		this->Packet.push_back({ Key, Command });
+	}
+
+	void RenderQueue::Sort()
+	{
+		const size_t Count = this->Packet.size();
+		if (Count < 2)
+		{
+			return;
+		}
+
+		constexpr size_t RadixBits = 8;
+		constexpr size_t RadixSize = 1 << RadixBits;
+		constexpr size_t PassCount = sizeof(uint64_t) * 8 / RadixBits;
+
+		size_t Histogram[PassCount][RadixSize] = {};
+		for (const RENDER_PACKET_STRUCT& Item : this->Packet)
+		{
+			for (size_t Pass = 0; Pass < PassCount; Pass++)
+			{
+				Histogram[Pass][(Item.Key >> (Pass * RadixBits)) & (RadixSize - 1)]++;
+			}
+		}
+
+		this->Temp.resize(Count);
+		RENDER_PACKET_STRUCT* Source = this->Packet.data();
+		RENDER_PACKET_STRUCT* Destination = this->Temp.data();
+
+		for (size_t Pass = 0; Pass < PassCount; Pass++)
+		{
+			const size_t Shift = Pass * RadixBits;
+
+			if (Histogram[Pass][(Source[0].Key >> Shift) & (RadixSize - 1)] == Count)
+			{
+				continue;
+			}
+
+			size_t Offset[RadixSize];
+			size_t Sum = 0;
+			for (size_t Bucket = 0; Bucket < RadixSize; Bucket++)
+			{
+				Offset[Bucket] = Sum;
+				Sum += Histogram[Pass][Bucket];
+			}
+
+			for (size_t Index = 0; Index < Count; Index++)
+			{
+				Destination[Offset[(Source[Index].Key >> Shift) & (RadixSize - 1)]++] = Source[Index];
+			}
+
+			std::swap(Source, Destination);
+		}
+
+		if (Source != this->Packet.data())
+		{
+			this->Packet.swap(this->Temp);
+		}
+	}
+
+	size_t RenderQueue::GetCount() const
+	{
+		return this->Packet.size();
+	}
+
+	const RENDER_PACKET_STRUCT* RenderQueue::GetPacket() const
+	{
+		return this->Packet.data();
+	}
+}
@@ -0,0 +1,166 @@
+﻿#include "include/platform.h"
+#include "include/ringallocator.h"
+
+namespace Engine
+{
+	RingAllocator::RingAllocator(size_t Capacity, size_t Alignment)
+	{
+		this->Alignment = (Alignment ? Alignment : 1);
+		this->Capacity = Capacity / this->Alignment * this->Alignment;
+	}
+
+	size_t RingAllocator::Allocate(size_t Size)
+	{
+		const size_t AlignedSize = AlignUp((Size ? Size : 1), this->Alignment);
+
+		if (AlignedSize > this->Capacity)
+		{
+			return Invalid;
+		}
+
+		if (this->Used == 0)
+		{
+			this->Head = 0;
+			this->Tail = 0;
+		}
+
+		size_t Offset = Invalid;
+		size_t Waste = 0;
+
+		if (this->Head >= this->Tail && this->Used < this->Capacity)
+		{
+			if (this->Head + AlignedSize <= this->Capacity)
+			{
+				Offset = this->Head;
+			}
+			else if (AlignedSize <= this->Tail)
+			{
+				Waste = this->Capacity - this->Head;
+				Offset = 0;
+			}
+		}
+		else if (this->Head < this->Tail && this->Head + AlignedSize <= this->Tail)
+		{
+			Offset = this->Head;
+		}
+
+		if (Offset == Invalid)
+		{
+			return Invalid;
+		}
+
+		this->Head = Offset + AlignedSize;
+		if (this->Head == this->Capacity)
+		{
+			this->Head = 0;
+		}
+
+		this->Used += Waste + AlignedSize;
+		this->FrameSize += Waste + AlignedSize;
+
+		return Offset;
+	}
+
+	void RingAllocator::EndFrame(uint64_t Fence)
+	{
+		if (this->FrameSize == 0)
+		{
+			return;
+		}
+
+		this->Frame.push_back({ Fence, this->Head, this->FrameSize });
+		this->FrameSize = 0;
+	}
+
+	void RingAllocator::Retire(uint64_t FirstPendingFence)
+	{
+		while (!this->Frame.empty() && this->Frame.front().Fence < FirstPendingFence)
+		{
+			this->Tail = this->Frame.front().Head;
+			this->Used -= this->Frame.front().Size;
+			this->Frame.pop_front();
+		}
+	}
+
+	void RingAllocator::Reset()
+	{
+		this->Head = 0;
+		this->Tail = 0;
+		this->Used = 0;
+		this->FrameSize = 0;
+		this->Frame.clear();
+	}
+
+	size_t RingAllocator::GetCapacity() const
+	{
+		return this->Capacity;
+	}
+
+	size_t RingAllocator::GetAlignment() const
+	{
+		return this->Alignment;
+	}
+
+	size_t RingAllocator::GetUsed() const
+	{
+		return this->Used;
+	}
+
+	size_t RingAllocator::GetPendingFrameCount() const
+	{
+		return this->Frame.size();
+	}
+
+
+
+	FencedRing::FencedRing(std::shared_ptr<FRAME_FENCE_STRUCT> Fence, size_t Capacity, size_t Alignment, bool NoOverwrite, std::function<void()> Flush) : Ring(AlignUp(Capacity, Alignment), Alignment)
+	{
+		this->Fence = Fence;
+		this->Flush = Flush;
+		this->LastFence = Fence->Current;
+		this->NoOverwrite = NoOverwrite;
+	}
+
+	size_t FencedRing::Allocate(size_t Size, bool& Discard)
+	{
+		if (this->LastFence != this->Fence->Current)
+		{
+			this->Ring.EndFrame(this->LastFence);
+			this->LastFence = this->Fence->Current;
+		}
+		this->Ring.Retire(this->Fence->Completed);
+
+		Discard = (!this->NoOverwrite || this->Discard);
+
+		size_t Offset = (Discard ? RingAllocator::Invalid : this->Ring.Allocate(Size));
+		if (Offset == RingAllocator::Invalid)
+		{
+			if (this->Ring.GetUsed() && this->Flush)
+			{
+				this->Flush();
+			}
+
+			this->Ring.Reset();
+			Offset = this->Ring.Allocate(Size);
+			Discard = true;
+
+			if (Offset == RingAllocator::Invalid)
+			{
+				throw E_OUTOFMEMORY;
+			}
+		}
+		this->Discard = false;
+
+		return Offset;
+	}
+
+	size_t FencedRing::GetCapacity() const
+	{
+		return this->Ring.GetCapacity();
+	}
+
+	size_t FencedRing::GetUsed() const
+	{
+		return this->Ring.GetUsed();
+	}
+}
@@ -0,0 +1,1572 @@
+﻿#include "source/backend.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace Engine
+{
+	DirectX::XMFLOAT4 SampleTexture(const SOFTWARE_TEXTURE_STRUCT& Texture, float U, float V)
+	{
+		if (!Texture.Color || !Texture.Width || !Texture.Height)
+		{
+			return { 1.0f, 1.0f, 1.0f, 1.0f };
+		}
+
+		const float X = (std::min)((std::max)(U * Texture.Width - 0.5f, 0.0f), static_cast<float>(Texture.Width - 1));
+		const float Y = (std::min)((std::max)(V * Texture.Height - 0.5f, 0.0f), static_cast<float>(Texture.Height - 1));
+
+		const UINT X0 = static_cast<UINT>(X);
+		const UINT Y0 = static_cast<UINT>(Y);
+		const UINT X1 = (X0 + 1 < Texture.Width ? X0 + 1 : X0);
+		const UINT Y1 = (Y0 + 1 < Texture.Height ? Y0 + 1 : Y0);
+		const float FractionX = X - X0;
+		const float FractionY = Y - Y0;
+
+		const uint32_t Texel[4] = {
+			Texture.Color[Y0 * Texture.Width + X0],
+			Texture.Color[Y0 * Texture.Width + X1],
+			Texture.Color[Y1 * Texture.Width + X0],
+			Texture.Color[Y1 * Texture.Width + X1],
+		};
+
+		float Channel[4];
+		for (UINT Index = 0; Index < 4; Index++)
+		{
+			const UINT Shift = Index * 8;
+			const float Top = ((Texel[0] >> Shift) & 0xFF) * (1.0f - FractionX) + ((Texel[1] >> Shift) & 0xFF) * FractionX;
+			const float Bottom = ((Texel[2] >> Shift) & 0xFF) * (1.0f - FractionX) + ((Texel[3] >> Shift) & 0xFF) * FractionX;
+			Channel[Index] = (Top * (1.0f - FractionY) + Bottom * FractionY) / 255.0f;
+		}
+
+		return { Channel[0], Channel[1], Channel[2], Channel[3] };
+	}
+
+
+
+	struct SOFTWARE_STATE_STRUCT
+	{
+		const SOFTWARE_VERTEX_FUNCTION* VertexShader;
+		const SOFTWARE_PIXEL_FUNCTION* PixelShader;
+		const BYTE* VertexConstant[CONSTANT_SLOT_OBJECT + 1];
+		const BYTE* PixelConstant[CONSTANT_SLOT_OBJECT + 1];
+		const BYTE* Vertex;
+		UINT VertexStride;
+		UINT VertexCount;
+		const UINT* Index;
+		UINT IndexCount;
+		const BYTE* Instance;
+		UINT InstanceStride;
+		UINT InstanceCount;
+		const SOFTWARE_TEXTURE_STRUCT* Texture;
+	};
+
+	class SoftwareRasterizer
+	{
+	public:
+		SoftwareRasterizer(UINT Width, UINT Height)
+		{
+			this->Pool = std::make_unique<ThreadPool>();
+			this->Resize(Width, Height);
+		}
+
+		void Resize(UINT Width, UINT Height)
+		{
+			this->Width = (Width ? Width : 1);
+			this->Height = (Height ? Height : 1);
+			this->Pitch = static_cast<UINT>(AlignUp(this->Width, 4));
+			this->TileCountX = (this->Width + TileSize - 1) / TileSize;
+			this->TileCountY = (this->Height + TileSize - 1) / TileSize;
+
+			this->Color.assign(static_cast<size_t>(this->Width) * this->Height, 0);
+			this->Depth.assign(static_cast<size_t>(this->Pitch) * this->Height, 1.0f);
+
+			this->Chunk.clear();
+			this->ChunkCount = 0;
+			this->DrawList.clear();
+		}
+
+		void SetThreadCount(UINT ThreadCount)
+		{
+			this->Pool = std::make_unique<ThreadPool>(ThreadCount);
+		}
+
+		UINT GetThreadCount() const
+		{
+			return static_cast<UINT>(this->Pool->GetThreadCount());
+		}
+
+		UINT GetWidth() const
+		{
+			return this->Width;
+		}
+
+		UINT GetHeight() const
+		{
+			return this->Height;
+		}
+
+		const uint32_t* GetColor() const
+		{
+			return this->Color.data();
+		}
+
+		void Clear(float R, float G, float B, float A)
+		{
+			this->ClearColor = PackColor({ R, G, B, A });
+			this->ClearPending = true;
+		}
+
+		void Draw(const SOFTWARE_STATE_STRUCT& State, UINT IndexCount, UINT InstanceCount, UINT StartIndex, INT BaseVertex)
+		{
+			if (!State.VertexShader || !State.Vertex || !State.Index || IndexCount < 3 || InstanceCount == 0)
+			{
+				return;
+			}
+
+			if (StartIndex >= State.IndexCount)
+			{
+				return;
+			}
+			IndexCount = (std::min)(IndexCount, State.IndexCount - StartIndex);
+
+			const auto Start = std::chrono::steady_clock::now();
+
+			const UINT DrawIndex = static_cast<UINT>(this->DrawList.size());
+			this->DrawList.push_back({ State.PixelShader, (State.Texture ? *State.Texture : SOFTWARE_TEXTURE_STRUCT{}) });
+
+			const size_t TrianglePerInstance = IndexCount / 3;
+			const size_t TriangleCount = TrianglePerInstance * InstanceCount;
+			const size_t ChunkCount = (TriangleCount + ChunkSize - 1) / ChunkSize;
+
+			const size_t FirstChunk = this->ChunkCount;
+			this->ChunkCount += ChunkCount;
+
+			while (this->Chunk.size() < this->ChunkCount)
+			{
+				this->Chunk.push_back(std::make_unique<CHUNK_STRUCT>());
+				this->Chunk.back()->Bin.resize(static_cast<size_t>(this->TileCountX) * this->TileCountY);
+			}
+
+			this->Pool->Dispatch(ChunkCount, [&](size_t Index)
+			{
+				CHUNK_STRUCT& Current = *this->Chunk[FirstChunk + Index];
+				const size_t First = Index * ChunkSize;
+				const size_t Last = (std::min)(First + ChunkSize, TriangleCount);
+
+				for (size_t Triangle = First; Triangle < Last; Triangle++)
+				{
+					this->ProcessTriangle(Current, State, DrawIndex, Triangle / TrianglePerInstance, Triangle % TrianglePerInstance, StartIndex, BaseVertex);
+				}
+			});
+
+			for (size_t Index = FirstChunk; Index < this->ChunkCount; Index++)
+			{
+				this->Statistics.RasterTriangleCount += this->Chunk[Index]->Triangle.size();
+			}
+
+			this->Statistics.TriangleCount += TriangleCount;
+			this->Statistics.VertexTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		}
+
+		void Resolve()
+		{
+			const auto Start = std::chrono::steady_clock::now();
+
+			std::atomic<uint64_t> PixelCount(0);
+
+			this->Pool->Dispatch(static_cast<size_t>(this->TileCountX) * this->TileCountY, [&](size_t Tile)
+			{
+				PixelCount += this->RasterTile(Tile);
+			});
+
+			for (size_t Index = 0; Index < this->ChunkCount; Index++)
+			{
+				CHUNK_STRUCT& Current = *this->Chunk[Index];
+				Current.Triangle.clear();
+
+				for (std::vector<uint32_t>& Bin : Current.Bin)
+				{
+					Bin.clear();
+				}
+			}
+
+			this->ChunkCount = 0;
+			this->DrawList.clear();
+			this->ClearPending = false;
+
+			this->Statistics.FrameCount++;
+			this->Statistics.PixelCount += PixelCount;
+			this->Statistics.RasterTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		}
+
+		SOFTWARE_STATISTICS_STRUCT Statistics = {};
+	private:
+		static constexpr UINT TileSize = 64;
+		static constexpr size_t ChunkSize = 256;
+		static constexpr UINT AttributeCount = 5;
+		static constexpr UINT ClipVertexCount = 9;
+		static constexpr float GuardBand = 4.0f;
+
+		struct VERTEX_STRUCT
+		{
+			float Position[4];
+			float Attribute[AttributeCount];
+		};
+
+		struct TRIANGLE_STRUCT
+		{
+			float X[3];
+			float Y[3];
+			float Z[3];
+			float InvW[3];
+			float Attribute[3][AttributeCount];
+			float InvArea;
+			INT MinX;
+			INT MinY;
+			INT MaxX;
+			INT MaxY;
+			UINT Draw;
+		};
+
+		struct DRAW_STRUCT
+		{
+			const SOFTWARE_PIXEL_FUNCTION* PixelShader;
+			SOFTWARE_TEXTURE_STRUCT Texture;
+		};
+
+		struct CHUNK_STRUCT
+		{
+			std::vector<TRIANGLE_STRUCT> Triangle;
+			std::vector<std::vector<uint32_t>> Bin;
+		};
+
+		static uint32_t PackColor(const DirectX::XMFLOAT4& Color)
+		{
+			const float Channel[4] = { Color.x, Color.y, Color.z, Color.w };
+
+			uint32_t Result = 0;
+			for (UINT Index = 0; Index < 4; Index++)
+			{
+				const float Value = (std::min)((std::max)(Channel[Index], 0.0f), 1.0f);
+				Result |= static_cast<uint32_t>(Value * 255.0f + 0.5f) << (Index * 8);
+			}
+			return Result;
+		}
+
+		void ProcessTriangle(CHUNK_STRUCT& Chunk, const SOFTWARE_STATE_STRUCT& State, UINT DrawIndex, size_t Instance, size_t Triangle, UINT StartIndex, INT BaseVertex)
+		{
+			SOFTWARE_VERTEX_INPUT_STRUCT Input = {};
+			for (UINT Slot = 0; Slot <= CONSTANT_SLOT_OBJECT; Slot++)
+			{
+				Input.Constant[Slot] = State.VertexConstant[Slot];
+			}
+
+			if (State.Instance)
+			{
+				if (Instance >= State.InstanceCount)
+				{
+					return;
+				}
+				Input.Instance = State.Instance + Instance * State.InstanceStride;
+			}
+
+			VERTEX_STRUCT Vertex[ClipVertexCount];
+			for (UINT Corner = 0; Corner < 3; Corner++)
+			{
+				const int64_t Index = static_cast<int64_t>(State.Index[StartIndex + Triangle * 3 + Corner]) + BaseVertex;
+				if (Index < 0 || Index >= State.VertexCount)
+				{
+					return;
+				}
+				Input.Vertex = State.Vertex + Index * State.VertexStride;
+
+				SOFTWARE_VARYING_STRUCT Output = {};
+				(*State.VertexShader)(Input, Output);
+
+				Vertex[Corner] = {
+					{ Output.Position.x, Output.Position.y, Output.Position.z, Output.Position.w },
+					{ Output.TexCoord.x, Output.TexCoord.y, Output.Normal.x, Output.Normal.y, Output.Normal.z },
+				};
+			}
+
+			UINT OutsideMask = 0xFF;
+			UINT ClipMask = 0;
+			for (UINT Corner = 0; Corner < 3; Corner++)
+			{
+				const float* Position = Vertex[Corner].Position;
+				const UINT Outside =
+					(Position[0] > Position[3] ? 1 : 0) | (Position[0] < -Position[3] ? 2 : 0) |
+					(Position[1] > Position[3] ? 4 : 0) | (Position[1] < -Position[3] ? 8 : 0) |
+					(Position[2] > Position[3] ? 16 : 0) | (Position[2] < 0.0f ? 32 : 0);
+				OutsideMask &= Outside;
+
+				ClipMask |= (Position[2] < 0.0f ? 1 : 0);
+				ClipMask |= (std::fabs(Position[0]) > GuardBand * Position[3] || std::fabs(Position[1]) > GuardBand * Position[3] ? 2 : 0);
+			}
+
+			if (OutsideMask)
+			{
+				return;
+			}
+
+			if (!ClipMask)
+			{
+				this->SetupTriangle(Chunk, Vertex[0], Vertex[1], Vertex[2], DrawIndex);
+				return;
+			}
+
+			static const float Plane[5][4] = {
+				{ 0.0f, 0.0f, 1.0f, 0.0f },
+				{ -1.0f, 0.0f, 0.0f, GuardBand },
+				{ 1.0f, 0.0f, 0.0f, GuardBand },
+				{ 0.0f, -1.0f, 0.0f, GuardBand },
+				{ 0.0f, 1.0f, 0.0f, GuardBand },
+			};
+
+			VERTEX_STRUCT Clipped[ClipVertexCount];
+			VERTEX_STRUCT* Source = Vertex;
+			VERTEX_STRUCT* Destination = Clipped;
+			UINT Count = 3;
+
+			for (UINT PlaneIndex = 0; PlaneIndex < 5 && Count >= 3; PlaneIndex++)
+			{
+				Count = ClipPolygon(Source, Count, Destination, Plane[PlaneIndex]);
+				std::swap(Source, Destination);
+			}
+
+			for (UINT Corner = 2; Corner < Count; Corner++)
+			{
+				this->SetupTriangle(Chunk, Source[0], Source[Corner - 1], Source[Corner], DrawIndex);
+			}
+		}
+
+		static UINT ClipPolygon(const VERTEX_STRUCT* Source, UINT Count, VERTEX_STRUCT* Destination, const float* Plane)
+		{
+			UINT Result = 0;
+
+			for (UINT Index = 0; Index < Count; Index++)
+			{
+				const VERTEX_STRUCT& Current = Source[Index];
+				const VERTEX_STRUCT& Next = Source[(Index + 1) % Count];
+
+				const float CurrentDistance = Current.Position[0] * Plane[0] + Current.Position[1] * Plane[1] + Current.Position[2] * Plane[2] + Current.Position[3] * Plane[3];
+				const float NextDistance = Next.Position[0] * Plane[0] + Next.Position[1] * Plane[1] + Next.Position[2] * Plane[2] + Next.Position[3] * Plane[3];
+
+				if (CurrentDistance >= 0.0f)
+				{
+					Destination[Result++] = Current;
+				}
+
+				if ((CurrentDistance >= 0.0f) != (NextDistance >= 0.0f) && Result < ClipVertexCount)
+				{
+					const float Factor = CurrentDistance / (CurrentDistance - NextDistance);
+
+					VERTEX_STRUCT& Output = Destination[Result++];
+					for (UINT Component = 0; Component < 4; Component++)
+					{
+						Output.Position[Component] = Current.Position[Component] + (Next.Position[Component] - Current.Position[Component]) * Factor;
+					}
+					for (UINT Component = 0; Component < AttributeCount; Component++)
+					{
+						Output.Attribute[Component] = Current.Attribute[Component] + (Next.Attribute[Component] - Current.Attribute[Component]) * Factor;
+					}
+				}
+			}
+
+			return Result;
+		}
+
+		void SetupTriangle(CHUNK_STRUCT& Chunk, const VERTEX_STRUCT& V0, const VERTEX_STRUCT& V1, const VERTEX_STRUCT& V2, UINT DrawIndex)
+		{
+			const VERTEX_STRUCT* Vertex[3] = { &V0, &V1, &V2 };
+
+			TRIANGLE_STRUCT Triangle;
+			for (UINT Corner = 0; Corner < 3; Corner++)
+			{
+				const float* Position = Vertex[Corner]->Position;
+				const float InvW = 1.0f / Position[3];
+
+				Triangle.X[Corner] = std::floor(((Position[0] * InvW) * 0.5f + 0.5f) * this->Width * 256.0f + 0.5f) / 256.0f;
+				Triangle.Y[Corner] = std::floor((0.5f - (Position[1] * InvW) * 0.5f) * this->Height * 256.0f + 0.5f) / 256.0f;
+				Triangle.Z[Corner] = Position[2] * InvW;
+				Triangle.InvW[Corner] = InvW;
+
+				for (UINT Component = 0; Component < AttributeCount; Component++)
+				{
+					Triangle.Attribute[Corner][Component] = Vertex[Corner]->Attribute[Component] * InvW;
+				}
+			}
+
+			const float Area = (Triangle.X[1] - Triangle.X[0]) * (Triangle.Y[2] - Triangle.Y[0]) - (Triangle.X[2] - Triangle.X[0]) * (Triangle.Y[1] - Triangle.Y[0]);
+			if (!(Area > 0.0f))
+			{
+				return;
+			}
+			Triangle.InvArea = 1.0f / Area;
+
+			const float MinX = (std::min)({ Triangle.X[0], Triangle.X[1], Triangle.X[2] });
+			const float MinY = (std::min)({ Triangle.Y[0], Triangle.Y[1], Triangle.Y[2] });
+			const float MaxX = (std::max)({ Triangle.X[0], Triangle.X[1], Triangle.X[2] });
+			const float MaxY = (std::max)({ Triangle.Y[0], Triangle.Y[1], Triangle.Y[2] });
+
+			Triangle.MinX = (std::max)(static_cast<INT>(std::ceil(MinX - 0.5f)), 0);
+			Triangle.MinY = (std::max)(static_cast<INT>(std::ceil(MinY - 0.5f)), 0);
+			Triangle.MaxX = (std::min)(static_cast<INT>(std::floor(MaxX - 0.5f)), static_cast<INT>(this->Width) - 1);
+			Triangle.MaxY = (std::min)(static_cast<INT>(std::floor(MaxY - 0.5f)), static_cast<INT>(this->Height) - 1);
+
+			if (Triangle.MinX > Triangle.MaxX || Triangle.MinY > Triangle.MaxY)
+			{
+				return;
+			}
+			Triangle.Draw = DrawIndex;
+
+			const uint32_t TriangleIndex = static_cast<uint32_t>(Chunk.Triangle.size());
+			Chunk.Triangle.push_back(Triangle);
+
+			for (INT TileY = Triangle.MinY / static_cast<INT>(TileSize); TileY <= Triangle.MaxY / static_cast<INT>(TileSize); TileY++)
+			{
+				for (INT TileX = Triangle.MinX / static_cast<INT>(TileSize); TileX <= Triangle.MaxX / static_cast<INT>(TileSize); TileX++)
+				{
+					Chunk.Bin[TileY * this->TileCountX + TileX].push_back(TriangleIndex);
+				}
+			}
+		}
+
+		uint64_t RasterTile(size_t Tile)
+		{
+			const INT TileMinX = static_cast<INT>(Tile % this->TileCountX * TileSize);
+			const INT TileMinY = static_cast<INT>(Tile / this->TileCountX * TileSize);
+			const INT TileMaxX = (std::min)(TileMinX + static_cast<INT>(TileSize), static_cast<INT>(this->Width)) - 1;
+			const INT TileMaxY = (std::min)(TileMinY + static_cast<INT>(TileSize), static_cast<INT>(this->Height)) - 1;
+
+			if (this->ClearPending)
+			{
+				for (INT Y = TileMinY; Y <= TileMaxY; Y++)
+				{
+					std::fill_n(&this->Color[static_cast<size_t>(Y) * this->Width + TileMinX], TileMaxX - TileMinX + 1, this->ClearColor);
+					std::fill_n(&this->Depth[static_cast<size_t>(Y) * this->Pitch + TileMinX], TileMaxX - TileMinX + 1, 1.0f);
+				}
+			}
+
+			uint64_t PixelCount = 0;
+
+			for (size_t Index = 0; Index < this->ChunkCount; Index++)
+			{
+				const CHUNK_STRUCT& Current = *this->Chunk[Index];
+
+				for (const uint32_t Triangle : Current.Bin[Tile])
+				{
+					PixelCount += this->RasterTriangle(Current.Triangle[Triangle], TileMinX, TileMinY, TileMaxX, TileMaxY);
+				}
+			}
+
+			return PixelCount;
+		}
+
+		uint64_t RasterTriangle(const TRIANGLE_STRUCT& Triangle, INT TileMinX, INT TileMinY, INT TileMaxX, INT TileMaxY)
+		{
+			const DRAW_STRUCT& Draw = this->DrawList[Triangle.Draw];
+
+			const INT MinX = (std::max)(Triangle.MinX, TileMinX) & ~3;
+			const INT MinY = (std::max)(Triangle.MinY, TileMinY);
+			const INT MaxX = (std::min)(Triangle.MaxX, TileMaxX);
+			const INT MaxY = (std::min)(Triangle.MaxY, TileMaxY);
+
+			float EdgeA[3];
+			float EdgeB[3];
+			__m128 TopLeft[3];
+			for (UINT Edge = 0; Edge < 3; Edge++)
+			{
+				const UINT I = (Edge + 1) % 3;
+				const UINT J = (Edge + 2) % 3;
+				EdgeA[Edge] = Triangle.Y[I] - Triangle.Y[J];
+				EdgeB[Edge] = Triangle.X[J] - Triangle.X[I];
+
+				const bool IsTopLeft = (EdgeA[Edge] == 0.0f && EdgeB[Edge] > 0.0f) || EdgeA[Edge] > 0.0f;
+				TopLeft[Edge] = _mm_castsi128_ps(_mm_set1_epi32(IsTopLeft ? -1 : 0));
+			}
+
+			const __m128 Zero = _mm_setzero_ps();
+			const __m128 Lane = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+			const __m128 InvArea = _mm_set1_ps(Triangle.InvArea);
+			const __m128 Z0 = _mm_set1_ps(Triangle.Z[0]);
+			const __m128 DeltaZ1 = _mm_set1_ps(Triangle.Z[1] - Triangle.Z[0]);
+			const __m128 DeltaZ2 = _mm_set1_ps(Triangle.Z[2] - Triangle.Z[0]);
+			const __m128 Right = _mm_set1_ps(static_cast<float>(MaxX) + 0.5f);
+
+			uint64_t PixelCount = 0;
+
+			for (INT Y = MinY; Y <= MaxY; Y++)
+			{
+				const float PixelY = Y + 0.5f;
+
+				__m128 Edge[3];
+				__m128 Step[3];
+				for (UINT Index = 0; Index < 3; Index++)
+				{
+					const UINT I = (Index + 1) % 3;
+					const float Row = EdgeA[Index] * (MinX + 0.5f - Triangle.X[I]) + EdgeB[Index] * (PixelY - Triangle.Y[I]);
+					Edge[Index] = _mm_add_ps(_mm_set1_ps(Row), _mm_mul_ps(_mm_set1_ps(EdgeA[Index]), Lane));
+					Step[Index] = _mm_set1_ps(EdgeA[Index] * 4.0f);
+				}
+
+				float* const DepthRow = &this->Depth[static_cast<size_t>(Y) * this->Pitch];
+				uint32_t* const ColorRow = &this->Color[static_cast<size_t>(Y) * this->Width];
+
+				for (INT X = MinX; X <= MaxX; X += 4)
+				{
+					__m128 Mask = _mm_cmple_ps(_mm_add_ps(_mm_set1_ps(X + 0.5f), Lane), Right);
+					for (UINT Index = 0; Index < 3; Index++)
+					{
+						const __m128 Inside = _mm_or_ps(_mm_cmpgt_ps(Edge[Index], Zero), _mm_and_ps(_mm_cmpeq_ps(Edge[Index], Zero), TopLeft[Index]));
+						Mask = _mm_and_ps(Mask, Inside);
+					}
+
+					if (_mm_movemask_ps(Mask))
+					{
+						const __m128 B1 = _mm_mul_ps(Edge[1], InvArea);
+						const __m128 B2 = _mm_mul_ps(Edge[2], InvArea);
+						const __m128 Z = _mm_add_ps(Z0, _mm_add_ps(_mm_mul_ps(B1, DeltaZ1), _mm_mul_ps(B2, DeltaZ2)));
+
+						const __m128 OldDepth = _mm_loadu_ps(DepthRow + X);
+						Mask = _mm_and_ps(Mask, _mm_cmplt_ps(Z, OldDepth));
+
+						const int Visible = _mm_movemask_ps(Mask);
+						if (Visible)
+						{
+							_mm_storeu_ps(DepthRow + X, _mm_or_ps(_mm_and_ps(Mask, Z), _mm_andnot_ps(Mask, OldDepth)));
+
+							if (Draw.PixelShader)
+							{
+								alignas(16) float Weight1[4];
+								alignas(16) float Weight2[4];
+								alignas(16) float Depth[4];
+								_mm_store_ps(Weight1, B1);
+								_mm_store_ps(Weight2, B2);
+								_mm_store_ps(Depth, Z);
+
+								for (INT Index = 0; Index < 4; Index++)
+								{
+									if (Visible & (1 << Index))
+									{
+										ColorRow[X + Index] = PackColor(this->ShadePixel(Triangle, Draw, X + Index + 0.5f, PixelY, Depth[Index], Weight1[Index], Weight2[Index]));
+										PixelCount++;
+									}
+								}
+							}
+						}
+					}
+
+					for (UINT Index = 0; Index < 3; Index++)
+					{
+						Edge[Index] = _mm_add_ps(Edge[Index], Step[Index]);
+					}
+				}
+			}
+
+			return PixelCount;
+		}
+
+		static DirectX::XMFLOAT4 ShadePixel(const TRIANGLE_STRUCT& Triangle, const DRAW_STRUCT& Draw, float X, float Y, float Z, float B1, float B2)
+		{
+			const float B0 = 1.0f - B1 - B2;
+			const float InvW = B0 * Triangle.InvW[0] + B1 * Triangle.InvW[1] + B2 * Triangle.InvW[2];
+			const float W = 1.0f / InvW;
+
+			float Attribute[AttributeCount];
+			for (UINT Component = 0; Component < AttributeCount; Component++)
+			{
+				Attribute[Component] = (B0 * Triangle.Attribute[0][Component] + B1 * Triangle.Attribute[1][Component] + B2 * Triangle.Attribute[2][Component]) * W;
+			}
+
+			const SOFTWARE_VARYING_STRUCT Input = {
+				{ X, Y, Z, W },
+				{ Attribute[0], Attribute[1] },
+				{ Attribute[2], Attribute[3], Attribute[4] },
+			};
+
+			return (*Draw.PixelShader)(Input, Draw.Texture);
+		}
+	private:
+		std::unique_ptr<ThreadPool> Pool;
+		std::vector<uint32_t> Color;
+		std::vector<float> Depth;
+		std::vector<std::unique_ptr<CHUNK_STRUCT>> Chunk;
+		std::vector<DRAW_STRUCT> DrawList;
+		size_t ChunkCount = 0;
+		UINT Width = 0;
+		UINT Height = 0;
+		UINT Pitch = 0;
+		UINT TileCountX = 0;
+		UINT TileCountY = 0;
+		uint32_t ClearColor = 0;
+		bool ClearPending = false;
+	};
+
+
+
+	class SoftwareContext : public ICommandContext
+	{
+	public:
+		SoftwareContext(SoftwareRasterizer* Rasterizer, std::shared_ptr<BackendCounter> Counter)
+		{
+			this->Rasterizer = Rasterizer;
+			this->Counter = Counter;
+		}
+
+		void Draw(UINT IndexCount, UINT StartIndex, INT BaseVertex) override
+		{
+			this->DrawInstanced(IndexCount, 1, StartIndex, BaseVertex);
+		}
+
+		void DrawInstanced(UINT IndexCount, UINT InstanceCount, UINT StartIndex, INT BaseVertex) override
+		{
+			this->Counter->Draw(IndexCount, InstanceCount);
+			this->Apply([=](SoftwareContext& Context)
+			{
+				Context.Rasterizer->Draw(Context.State, IndexCount, InstanceCount, StartIndex, BaseVertex);
+			});
+		}
+
+		template<class Function>
+		void Apply(Function&& Command)
+		{
+			if (this->Rasterizer)
+			{
+				Command(*this);
+			}
+			else
+			{
+				this->Command.emplace_back(std::forward<Function>(Command));
+			}
+		}
+
+		template<class Function>
+		void Bind(Function&& Command)
+		{
+			this->Counter->Bind();
+			this->Apply(std::forward<Function>(Command));
+		}
+
+		SOFTWARE_STATE_STRUCT State = {};
+		std::vector<std::function<void(SoftwareContext& Context)>> Command;
+		SoftwareRasterizer* Rasterizer = nullptr;
+		std::shared_ptr<BackendCounter> Counter;
+		uint64_t Frame = 0;
+	};
+
+	inline SoftwareContext* GetSoftwareContext(ICommandContext* Context)
+	{
+		return static_cast<SoftwareContext*>(Context);
+	}
+
+	inline float Dot4(const float* Left, const float* Right)
+	{
+		return Left[0] * Right[0] + Left[1] * Right[1] + Left[2] * Right[2] + Left[3] * Right[3];
+	}
+
+	inline void TransformColumnMajor(float* Vector, const float* Matrix)
+	{
+		const float Input[4] = { Vector[0], Vector[1], Vector[2], Vector[3] };
+		for (UINT Column = 0; Column < 4; Column++)
+		{
+			Vector[Column] = Dot4(Input, Matrix + Column * 4);
+		}
+	}
+
+	void DefaultVertexFunction(const SOFTWARE_VERTEX_INPUT_STRUCT& Input, SOFTWARE_VARYING_STRUCT& Output)
+	{
+		const float* const Vertex = static_cast<const float*>(Input.Vertex);
+		float Position[4] = { Vertex[0], Vertex[1], Vertex[2], 1.0f };
+
+		if (Input.Instance)
+		{
+			TransformColumnMajor(Position, static_cast<const float*>(Input.Instance));
+		}
+
+		if (Input.Constant[CONSTANT_SLOT_OBJECT])
+		{
+			TransformColumnMajor(Position, reinterpret_cast<const float*>(Input.Constant[CONSTANT_SLOT_OBJECT]));
+		}
+
+		if (Input.Constant[CONSTANT_SLOT_FRAME])
+		{
+			const float* const Frame = static_cast<const float*>(Input.Constant[CONSTANT_SLOT_FRAME]);
+			TransformColumnMajor(Position, Frame);
+			TransformColumnMajor(Position, Frame + 16);
+		}
+
+		Output.Position = { Position[0], Position[1], Position[2], Position[3] };
+		Output.TexCoord = { Vertex[3], Vertex[4] };
+		Output.Normal = { Vertex[5], Vertex[6], Vertex[7] };
+	}
+
+	DirectX::XMFLOAT4 DefaultPixelFunction(const SOFTWARE_VARYING_STRUCT& Input, const SOFTWARE_TEXTURE_STRUCT& Texture)
+	{
+		return SampleTexture(Texture, Input.TexCoord.x, Input.TexCoord.y);
+	}
+
+
+
+	class SoftwareRing
+	{
+	public:
+		SoftwareRing(std::shared_ptr<SoftwareContext> Immediate, SIZE_T Capacity, SIZE_T Alignment) : Ring(AlignUp(Capacity, Alignment), Alignment), Data(AlignUp(Capacity, Alignment))
+		{
+			this->Immediate = Immediate;
+		}
+
+		SIZE_T Allocate(LPCVOID Source, SIZE_T Size)
+		{
+			if (this->LastFrame != this->Immediate->Frame)
+			{
+				this->Ring.Reset();
+				this->LastFrame = this->Immediate->Frame;
+			}
+
+			SIZE_T Offset = this->Ring.Allocate(Size);
+			if (Offset == RingAllocator::Invalid)
+			{
+				this->Ring.Reset();
+				Offset = this->Ring.Allocate(Size);
+
+				if (Offset == RingAllocator::Invalid)
+				{
+					throw E_OUTOFMEMORY;
+				}
+			}
+
+			memcpy(this->Data.data() + Offset, Source, Size);
+			return Offset;
+		}
+
+		const BYTE* GetData() const
+		{
+			return this->Data.data();
+		}
+
+		SIZE_T GetCapacity() const
+		{
+			return this->Data.size();
+		}
+	private:
+		RingAllocator Ring;
+		std::vector<BYTE> Data;
+		std::shared_ptr<SoftwareContext> Immediate;
+		uint64_t LastFrame = 0;
+	};
+
+
+
+	class SoftwareApplication : public Backend, public ISoftwareApplication
+	{
+	public:
+		SoftwareApplication(UINT Width, UINT Height) : Rasterizer(Width, Height)
+		{
+			this->Immediate = std::make_shared<SoftwareContext>(&this->Rasterizer, this->Counter);
+		}
+
+		bool Run() override
+		{
+			return !this->Exit;
+		}
+
+		void Quit() override
+		{
+			this->Exit = true;
+		}
+
+		int GetWidth() const override
+		{
+			return this->Rasterizer.GetWidth();
+		}
+
+		int GetHeight() const override
+		{
+			return this->Rasterizer.GetHeight();
+		}
+
+		int GetMouseDirectionX() const override
+		{
+			return 0;
+		}
+
+		int GetMouseDirectionY() const override
+		{
+			return 0;
+		}
+
+		bool GetKeyState(BYTE /*KeyCode*/) const override
+		{
+			return false;
+		}
+
+		bool ResizeBuffer(UINT /*BufferCount*/, UINT Width, UINT Height, UINT /*SampleCount*/) override
+		{
+			if ((Width && Width != this->Rasterizer.GetWidth()) || (Height && Height != this->Rasterizer.GetHeight()))
+			{
+				this->Rasterizer.Resize((Width ? Width : this->Rasterizer.GetWidth()), (Height ? Height : this->Rasterizer.GetHeight()));
+			}
+			return true;
+		}
+
+		void BeginDraw(float R, float G, float B, float A) override
+		{
+			this->Rasterizer.Clear(R, G, B, A);
+		}
+
+		bool EndDraw(UINT /*SyncInterval*/) override
+		{
+			this->Flush();
+			this->Rasterizer.Resolve();
+			this->Immediate->Frame++;
+			this->EndFrame();
+			return true;
+		}
+
+		void Draw(UINT IndexCount, UINT StartIndex, INT BaseVertex) override
+		{
+			this->Immediate->Draw(IndexCount, StartIndex, BaseVertex);
+		}
+
+		void DrawInstanced(UINT IndexCount, UINT InstanceCount, UINT StartIndex, INT BaseVertex) override
+		{
+			this->Immediate->DrawInstanced(IndexCount, InstanceCount, StartIndex, BaseVertex);
+		}
+
+		ICommandContext* GetContext() override
+		{
+			return this->Immediate.get();
+		}
+
+		void Execute(ICommandList* const* List, UINT Count) override;
+
+		std::shared_ptr<IVertexShader> CreateVertexShader(SOFTWARE_VERTEX_FUNCTION Function) override;
+		std::shared_ptr<IPixelShader> CreatePixelShader(SOFTWARE_PIXEL_FUNCTION Function) override;
+
+		void SetThreadCount(UINT ThreadCount) override
+		{
+			this->Rasterizer.SetThreadCount(ThreadCount);
+		}
+
+		UINT GetThreadCount() const override
+		{
+			return this->Rasterizer.GetThreadCount();
+		}
+
+		const uint32_t* GetColor() const override
+		{
+			return this->Rasterizer.GetColor();
+		}
+
+		bool SaveImage(const char* FileName) const override
+		{
+			std::ofstream File(FileName, std::ios::binary);
+			if (!File)
+			{
+				return false;
+			}
+
+			const UINT Width = this->Rasterizer.GetWidth();
+			const UINT Height = this->Rasterizer.GetHeight();
+
+			const BYTE Header[18] = {
+				0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				static_cast<BYTE>(Width & 0xFF), static_cast<BYTE>(Width >> 8),
+				static_cast<BYTE>(Height & 0xFF), static_cast<BYTE>(Height >> 8),
+				32, 0x28,
+			};
+			File.write(reinterpret_cast<const char*>(Header), sizeof(Header));
+
+			std::vector<BYTE> Pixel(static_cast<size_t>(Width) * Height * 4);
+			const uint32_t* const Color = this->Rasterizer.GetColor();
+			for (size_t Index = 0; Index < static_cast<size_t>(Width) * Height; Index++)
+			{
+				Pixel[Index * 4 + 0] = static_cast<BYTE>(Color[Index] >> 16);
+				Pixel[Index * 4 + 1] = static_cast<BYTE>(Color[Index] >> 8);
+				Pixel[Index * 4 + 2] = static_cast<BYTE>(Color[Index]);
+				Pixel[Index * 4 + 3] = static_cast<BYTE>(Color[Index] >> 24);
+			}
+			File.write(reinterpret_cast<const char*>(Pixel.data()), Pixel.size());
+
+			return static_cast<bool>(File);
+		}
+
+		const SOFTWARE_STATISTICS_STRUCT& GetStatistics() const override
+		{
+			return this->Rasterizer.Statistics;
+		}
+
+		void ResetStatistics() override
+		{
+			this->Rasterizer.Statistics = {};
+		}
+
+		std::shared_ptr<ICommandList> CreateCommandList() override;
+		std::shared_ptr<IVertexShader> CreateVertexShader(LPCVOID Data, SIZE_T Size) override;
+		std::shared_ptr<IPixelShader> CreatePixelShader(LPCVOID Data, SIZE_T Size) override;
+		std::shared_ptr<IConstantBuffer> CreateConstantBuffer(SIZE_T Size) override;
+		std::shared_ptr<IConstantAllocator> CreateConstantAllocator(SIZE_T Capacity) override;
+		std::shared_ptr<IVertexBuffer> CreateVertexBuffer(LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement) override;
+		std::shared_ptr<IIndexBuffer> CreateIndexBuffer(LPCVOID Data, SIZE_T CountElement) override;
+		std::shared_ptr<IDynamicVertexBuffer> CreateDynamicVertexBuffer(SIZE_T CountElement, SIZE_T SizeElement) override;
+		std::shared_ptr<IDynamicIndexBuffer> CreateDynamicIndexBuffer(SIZE_T CountElement) override;
+		std::shared_ptr<IGeometryPool> CreateGeometryPool(SIZE_T VertexCount, SIZE_T SizeElement, SIZE_T IndexCount) override;
+		std::shared_ptr<IInstanceBuffer> CreateInstanceBuffer(LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement) override;
+		std::shared_ptr<ITexture> CreateTexture(LPCVOID Data, UINT Width, UINT Height) override;
+	private:
+		SoftwareRasterizer Rasterizer;
+		std::shared_ptr<SoftwareContext> Immediate;
+		bool Exit = false;
+	};
+
+	std::shared_ptr<Backend> CreateSoftwareApplication(UINT Width, UINT Height)
+	{
+		return CreateInterface<SoftwareApplication>(Width, Height);
+	}
+
+
+
+	class SoftwareCommandList : public ICommandList
+	{
+	public:
+		SoftwareCommandList(std::shared_ptr<BackendCounter> Counter) : Context(nullptr, Counter)
+		{
+		}
+
+		ICommandContext* Begin() override
+		{
+			this->Context.Command.clear();
+			return &this->Context;
+		}
+
+		void End() override
+		{
+		}
+	private:
+		friend class SoftwareApplication;
+
+		SoftwareContext Context;
+	};
+
+	std::shared_ptr<ICommandList> SoftwareApplication::CreateCommandList()
+	{
+		return CreateInterface<SoftwareCommandList>(this->Counter);
+	}
+
+	void SoftwareApplication::Execute(ICommandList* const* List, UINT Count)
+	{
+		for (UINT Index = 0; Index < Count; Index++)
+		{
+			SoftwareCommandList* const Current = static_cast<SoftwareCommandList*>(List[Index]);
+
+			if (Current)
+			{
+				for (const std::function<void(SoftwareContext& Context)>& Command : Current->Context.Command)
+				{
+					Command(*this->Immediate);
+				}
+			}
+		}
+	}
+
+
+
+	class SoftwareVertexShader : public IVertexShader
+	{
+	public:
+		SoftwareVertexShader(std::shared_ptr<SoftwareContext> Immediate, SOFTWARE_VERTEX_FUNCTION Function)
+		{
+			this->Immediate = Immediate;
+			this->Function = Function;
+		}
+
+		void Set() override
+		{
+			this->Set(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			const SOFTWARE_VERTEX_FUNCTION* const Function = &this->Function;
+			GetSoftwareContext(Context)->Bind([=](SoftwareContext& Current)
+			{
+				Current.State.VertexShader = Function;
+			});
+		}
+	private:
+		std::shared_ptr<SoftwareContext> Immediate;
+		SOFTWARE_VERTEX_FUNCTION Function;
+	};
+
+	std::shared_ptr<IVertexShader> SoftwareApplication::CreateVertexShader(LPCVOID /*Data*/, SIZE_T /*Size*/)
+	{
+		return CreateInterface<SoftwareVertexShader>(this->Immediate, SOFTWARE_VERTEX_FUNCTION(DefaultVertexFunction));
+	}
+
+	std::shared_ptr<IVertexShader> SoftwareApplication::CreateVertexShader(SOFTWARE_VERTEX_FUNCTION Function)
+	{
+		const uint64_t Start = GetTimestamp();
+		return this->Track<IVertexShader>(CreateInterface<SoftwareVertexShader>(this->Immediate, Function), Start);
+	}
+
+
+
+	class SoftwarePixelShader : public IPixelShader
+	{
+	public:
+		SoftwarePixelShader(std::shared_ptr<SoftwareContext> Immediate, SOFTWARE_PIXEL_FUNCTION Function)
+		{
+			this->Immediate = Immediate;
+			this->Function = Function;
+		}
+
+		void Set() override
+		{
+			this->Set(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			const SOFTWARE_PIXEL_FUNCTION* const Function = &this->Function;
+			GetSoftwareContext(Context)->Bind([=](SoftwareContext& Current)
+			{
+				Current.State.PixelShader = Function;
+			});
+		}
+	private:
+		std::shared_ptr<SoftwareContext> Immediate;
+		SOFTWARE_PIXEL_FUNCTION Function;
+	};
+
+	std::shared_ptr<IPixelShader> SoftwareApplication::CreatePixelShader(LPCVOID /*Data*/, SIZE_T /*Size*/)
+	{
+		return CreateInterface<SoftwarePixelShader>(this->Immediate, SOFTWARE_PIXEL_FUNCTION(DefaultPixelFunction));
+	}
+
+	std::shared_ptr<IPixelShader> SoftwareApplication::CreatePixelShader(SOFTWARE_PIXEL_FUNCTION Function)
+	{
+		const uint64_t Start = GetTimestamp();
+		return this->Track<IPixelShader>(CreateInterface<SoftwarePixelShader>(this->Immediate, Function), Start);
+	}
+
+
+
+	class SoftwareConstantBuffer : public IConstantBuffer
+	{
+	public:
+		SoftwareConstantBuffer(std::shared_ptr<SoftwareContext> Immediate, SIZE_T Size) : Data(AlignUp(Size, 16))
+		{
+			this->Immediate = Immediate;
+			this->Size = Size;
+		}
+
+		void Update(LPCVOID Data) override
+		{
+			this->Immediate->Counter->Upload(this->Size);
+			memcpy(this->Data.data(), Data, this->Size);
+		}
+
+		void Update(ICommandContext* Context, LPCVOID Data) override
+		{
+			SoftwareContext* const Current = GetSoftwareContext(Context);
+
+			if (Current->Rasterizer)
+			{
+				this->Update(Data);
+				return;
+			}
+
+			std::vector<BYTE> Copy(static_cast<const BYTE*>(Data), static_cast<const BYTE*>(Data) + this->Size);
+			Current->Apply([this, Copy](SoftwareContext&)
+			{
+				this->Update(Copy.data());
+			});
+		}
+
+		void SetVertexShader(UINT Slot) override
+		{
+			this->SetVertexShader(this->Immediate.get(), Slot);
+		}
+
+		void SetVertexShader(ICommandContext* Context, UINT Slot) override
+		{
+			const BYTE* const Data = this->Data.data();
+			GetSoftwareContext(Context)->Bind([=](SoftwareContext& Current)
+			{
+				Current.State.VertexConstant[Slot] = Data;
+			});
+		}
+
+		void SetPixelShader(UINT Slot) override
+		{
+			this->SetPixelShader(this->Immediate.get(), Slot);
+		}
+
+		void SetPixelShader(ICommandContext* Context, UINT Slot) override
+		{
+			const BYTE* const Data = this->Data.data();
+			GetSoftwareContext(Context)->Bind([=](SoftwareContext& Current)
+			{
+				Current.State.PixelConstant[Slot] = Data;
+			});
+		}
+	private:
+		std::shared_ptr<SoftwareContext> Immediate;
+		std::vector<BYTE> Data;
+		SIZE_T Size = 0;
+	};
+
+	std::shared_ptr<IConstantBuffer> SoftwareApplication::CreateConstantBuffer(SIZE_T Size)
+	{
+		return CreateInterface<SoftwareConstantBuffer>(this->Immediate, Size);
+	}
+
+
+
+	class SoftwareConstantAllocator : public IConstantAllocator
+	{
+	public:
+		SoftwareConstantAllocator(std::shared_ptr<SoftwareContext> Immediate, SIZE_T Capacity) : Ring(Immediate, Capacity, ConstantAlignment)
+		{
+			this->Immediate = Immediate;
+		}
+
+		CONSTANT_SLICE_STRUCT Allocate(LPCVOID Data, SIZE_T Size) override
+		{
+			const SIZE_T Offset = this->Ring.Allocate(Data, Size);
+			this->Immediate->Counter->Upload(Size);
+			return { static_cast<UINT>(Offset / 16), static_cast<UINT>(AlignUp(Size, ConstantAlignment) / 16) };
+		}
+
+		void SetVertexShader(UINT Slot, const CONSTANT_SLICE_STRUCT& Slice) override
+		{
+			this->Immediate->Counter->Bind();
+			this->Immediate->State.VertexConstant[Slot] = this->Ring.GetData() + Slice.FirstConstant * 16;
+		}
+
+		void SetPixelShader(UINT Slot, const CONSTANT_SLICE_STRUCT& Slice) override
+		{
+			this->Immediate->Counter->Bind();
+			this->Immediate->State.PixelConstant[Slot] = this->Ring.GetData() + Slice.FirstConstant * 16;
+		}
+	private:
+		static constexpr SIZE_T ConstantAlignment = 256;
+
+		std::shared_ptr<SoftwareContext> Immediate;
+		SoftwareRing Ring;
+	};
+
+	std::shared_ptr<IConstantAllocator> SoftwareApplication::CreateConstantAllocator(SIZE_T Capacity)
+	{
+		return CreateInterface<SoftwareConstantAllocator>(this->Immediate, Capacity);
+	}
+
+
+
+	class SoftwareVertexBuffer : public IVertexBuffer
+	{
+	public:
+		SoftwareVertexBuffer(std::shared_ptr<SoftwareContext> Immediate, LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement) : Data(static_cast<const BYTE*>(Data), static_cast<const BYTE*>(Data) + CountElement * SizeElement)
+		{
+			this->Immediate = Immediate;
+			this->Stride = SizeElement;
+			this->Count = CountElement;
+		}
+
+		void Set() override
+		{
+			this->Set(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			const BYTE* const Data = this->Data.data();
+			const UINT Stride = this->Stride;
+			const UINT Count = this->Count;
+			GetSoftwareContext(Context)->Bind([=](SoftwareContext& Current)
+			{
+				Current.State.Vertex = Data;
+				Current.State.VertexStride = Stride;
+				Current.State.VertexCount = Count;
+			});
+		}
+	private:
+		std::shared_ptr<SoftwareContext> Immediate;
+		std::vector<BYTE> Data;
+		UINT Stride = 0;
+		UINT Count = 0;
+	};
+
+	std::shared_ptr<IVertexBuffer> SoftwareApplication::CreateVertexBuffer(LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement)
+	{
+		return CreateInterface<SoftwareVertexBuffer>(this->Immediate, Data, CountElement, SizeElement);
+	}
+
+
+
+	class SoftwareIndexBuffer : public IIndexBuffer
+	{
+	public:
+		SoftwareIndexBuffer(std::shared_ptr<SoftwareContext> Immediate, LPCVOID Data, SIZE_T CountElement) : Data(static_cast<const UINT*>(Data), static_cast<const UINT*>(Data) + CountElement)
+		{
+			this->Immediate = Immediate;
+		}
+
+		void Set() override
+		{
+			this->Set(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			const UINT* const Data = this->Data.data();
+			const UINT Count = static_cast<UINT>(this->Data.size());
+			GetSoftwareContext(Context)->Bind([=](SoftwareContext& Current)
+			{
+				Current.State.Index = Data;
+				Current.State.IndexCount = Count;
+			});
+		}
+
+		unsigned int GetIndexCount() override
+		{
+			return static_cast<UINT>(this->Data.size());
+		}
+	private:
+		std::shared_ptr<SoftwareContext> Immediate;
+		std::vector<UINT> Data;
+	};
+
+	std::shared_ptr<IIndexBuffer> SoftwareApplication::CreateIndexBuffer(LPCVOID Data, SIZE_T CountElement)
+	{
+		return CreateInterface<SoftwareIndexBuffer>(this->Immediate, Data, CountElement);
+	}
+
+
+
+	class SoftwareDynamicVertexBuffer : public IDynamicVertexBuffer
+	{
+	public:
+		SoftwareDynamicVertexBuffer(std::shared_ptr<SoftwareContext> Immediate, SIZE_T CountElement, SIZE_T SizeElement) : Ring(Immediate, CountElement * SizeElement, SizeElement)
+		{
+			this->Immediate = Immediate;
+			this->Stride = SizeElement;
+		}
+
+		void Set() override
+		{
+			this->Set(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			const BYTE* const Data = this->Ring.GetData();
+			const UINT Stride = this->Stride;
+			const UINT Count = static_cast<UINT>(this->Ring.GetCapacity() / this->Stride);
+			GetSoftwareContext(Context)->Bind([=](SoftwareContext& Current)
+			{
+				Current.State.Vertex = Data;
+				Current.State.VertexStride = Stride;
+				Current.State.VertexCount = Count;
+			});
+		}
+
+		INT Allocate(LPCVOID Data, SIZE_T CountElement) override
+		{
+			return static_cast<INT>(this->Ring.Allocate(Data, CountElement * this->Stride) / this->Stride);
+		}
+	private:
+		std::shared_ptr<SoftwareContext> Immediate;
+		SoftwareRing Ring;
+		UINT Stride = 0;
+	};
+
+	std::shared_ptr<IDynamicVertexBuffer> SoftwareApplication::CreateDynamicVertexBuffer(SIZE_T CountElement, SIZE_T SizeElement)
+	{
+		return CreateInterface<SoftwareDynamicVertexBuffer>(this->Immediate, CountElement, SizeElement);
+	}
+
+
+
+	class SoftwareDynamicIndexBuffer : public IDynamicIndexBuffer
+	{
+	public:
+		SoftwareDynamicIndexBuffer(std::shared_ptr<SoftwareContext> Immediate, SIZE_T CountElement) : Ring(Immediate, CountElement * sizeof(UINT), sizeof(UINT))
+		{
+			this->Immediate = Immediate;
+		}
+
+		void Set() override
+		{
+			this->Set(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			const UINT* const Data = reinterpret_cast<const UINT*>(this->Ring.GetData());
+			const UINT Count = this->GetIndexCount();
+			GetSoftwareContext(Context)->Bind([=](SoftwareContext& Current)
+			{
+				Current.State.Index = Data;
+				Current.State.IndexCount = Count;
+			});
+		}
+
+		unsigned int GetIndexCount() override
+		{
+			return static_cast<UINT>(this->Ring.GetCapacity() / sizeof(UINT));
+		}
+
+		UINT Allocate(LPCVOID Data, SIZE_T CountElement) override
+		{
+			return static_cast<UINT>(this->Ring.Allocate(Data, CountElement * sizeof(UINT)) / sizeof(UINT));
+		}
+	private:
+		std::shared_ptr<SoftwareContext> Immediate;
+		SoftwareRing Ring;
+	};
+
+	std::shared_ptr<IDynamicIndexBuffer> SoftwareApplication::CreateDynamicIndexBuffer(SIZE_T CountElement)
+	{
+		return CreateInterface<SoftwareDynamicIndexBuffer>(this->Immediate, CountElement);
+	}
+
+
+
+	class SoftwareGeometryPool : public IGeometryPool
+	{
+	public:
+		SoftwareGeometryPool(std::shared_ptr<SoftwareContext> Immediate, SIZE_T VertexCount, SIZE_T SizeElement, SIZE_T IndexCount) : Allocator(static_cast<UINT>(VertexCount), static_cast<UINT>(IndexCount)), Vertex(VertexCount * SizeElement), Index(IndexCount), VertexView(this), IndexView(this)
+		{
+			this->Immediate = Immediate;
+			this->Stride = SizeElement;
+		}
+
+		UINT Add(LPCVOID Vertex, SIZE_T VertexCount, LPCVOID Index, SIZE_T IndexCount) override
+		{
+			const UINT Mesh = this->Allocator.Add(static_cast<UINT>(VertexCount), static_cast<UINT>(IndexCount));
+			if (Mesh == GeometryAllocator::Invalid)
+			{
+				throw E_OUTOFMEMORY;
+			}
+
+			const GEOMETRY_MESH_STRUCT Current = this->Allocator.GetMesh(Mesh);
+			memcpy(this->Vertex.data() + static_cast<SIZE_T>(Current.BaseVertex) * this->Stride, Vertex, VertexCount * this->Stride);
+			memcpy(this->Index.data() + Current.StartIndex, Index, IndexCount * sizeof(UINT));
+
+			return Mesh;
+		}
+
+		void Remove(UINT Mesh) override
+		{
+			this->Allocator.Remove(Mesh);
+		}
+
+		GEOMETRY_MESH_STRUCT GetMesh(UINT Mesh) override
+		{
+			return this->Allocator.GetMesh(Mesh);
+		}
+
+		void Compact() override
+		{
+			std::vector<BYTE> Vertex(this->Vertex.size());
+			std::vector<UINT> Index(this->Index.size());
+
+			for (const GEOMETRY_MOVE_STRUCT& Move : this->Allocator.Compact())
+			{
+				memcpy(Vertex.data() + static_cast<SIZE_T>(Move.DestinationVertex) * this->Stride, this->Vertex.data() + static_cast<SIZE_T>(Move.SourceVertex) * this->Stride, static_cast<SIZE_T>(Move.VertexCount) * this->Stride);
+				memcpy(Index.data() + Move.DestinationIndex, this->Index.data() + Move.SourceIndex, Move.IndexCount * sizeof(UINT));
+			}
+
+			this->Vertex.swap(Vertex);
+			this->Index.swap(Index);
+		}
+
+		GEOMETRY_REPORT_STRUCT GetReport() override
+		{
+			return this->Allocator.GetReport();
+		}
+
+		IVertexBuffer* GetVertexBuffer() override
+		{
+			return &this->VertexView;
+		}
+
+		IIndexBuffer* GetIndexBuffer() override
+		{
+			return &this->IndexView;
+		}
+	private:
+		class PoolVertexBuffer : public IVertexBuffer
+		{
+		public:
+			PoolVertexBuffer(SoftwareGeometryPool* Pool) : Pool(Pool)
+			{
+			}
+
+			void Set() override
+			{
+				this->Set(this->Pool->Immediate.get());
+			}
+
+			void Set(ICommandContext* Context) override
+			{
+				const BYTE* const Data = this->Pool->Vertex.data();
+				const UINT Stride = this->Pool->Stride;
+				const UINT Count = static_cast<UINT>(this->Pool->Vertex.size() / this->Pool->Stride);
+				GetSoftwareContext(Context)->Bind([=](SoftwareContext& Current)
+				{
+					Current.State.Vertex = Data;
+					Current.State.VertexStride = Stride;
+					Current.State.VertexCount = Count;
+				});
+			}
+		private:
+			SoftwareGeometryPool* Pool;
+		};
+
+		class PoolIndexBuffer : public IIndexBuffer
+		{
+		public:
+			PoolIndexBuffer(SoftwareGeometryPool* Pool) : Pool(Pool)
+			{
+			}
+
+			void Set() override
+			{
+				this->Set(this->Pool->Immediate.get());
+			}
+
+			void Set(ICommandContext* Context) override
+			{
+				const UINT* const Data = this->Pool->Index.data();
+				const UINT Count = static_cast<UINT>(this->Pool->Index.size());
+				GetSoftwareContext(Context)->Bind([=](SoftwareContext& Current)
+				{
+					Current.State.Index = Data;
+					Current.State.IndexCount = Count;
+				});
+			}
+
+			unsigned int GetIndexCount() override
+			{
+				return this->Pool->Allocator.GetIndexCapacity();
+			}
+		private:
+			SoftwareGeometryPool* Pool;
+		};
+	private:
+		std::shared_ptr<SoftwareContext> Immediate;
+		GeometryAllocator Allocator;
+		std::vector<BYTE> Vertex;
+		std::vector<UINT> Index;
+		UINT Stride = 0;
+
+		PoolVertexBuffer VertexView;
+		PoolIndexBuffer IndexView;
+	};
+
+	std::shared_ptr<IGeometryPool> SoftwareApplication::CreateGeometryPool(SIZE_T VertexCount, SIZE_T SizeElement, SIZE_T IndexCount)
+	{
+		return CreateInterface<SoftwareGeometryPool>(this->Immediate, VertexCount, SizeElement, IndexCount);
+	}
+
+
+
+	class SoftwareInstanceBuffer : public IInstanceBuffer
+	{
+	public:
+		SoftwareInstanceBuffer(std::shared_ptr<SoftwareContext> Immediate, LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement) : Data(CountElement * SizeElement)
+		{
+			this->Immediate = Immediate;
+			this->Stride = SizeElement;
+			this->Capacity = CountElement;
+
+			if (Data)
+			{
+				memcpy(this->Data.data(), Data, this->Data.size());
+				this->Count = CountElement;
+			}
+		}
+
+		void Update(LPCVOID Data, SIZE_T CountElement) override
+		{
+			this->Count = (CountElement < this->Capacity ? CountElement : this->Capacity);
+			memcpy(this->Data.data(), Data, static_cast<SIZE_T>(this->Count) * this->Stride);
+		}
+
+		void Set() override
+		{
+			this->Set(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			const BYTE* const Data = this->Data.data();
+			const UINT Stride = this->Stride;
+			const UINT Capacity = this->Capacity;
+			GetSoftwareContext(Context)->Bind([=](SoftwareContext& Current)
+			{
+				Current.State.Instance = Data;
+				Current.State.InstanceStride = Stride;
+				Current.State.InstanceCount = Capacity;
+			});
+		}
+
+		unsigned int GetInstanceCount() override
+		{
+			return this->Count;
+		}
+	private:
+		std::shared_ptr<SoftwareContext> Immediate;
+		std::vector<BYTE> Data;
+		UINT Stride = 0;
+		UINT Capacity = 0;
+		UINT Count = 0;
+	};
+
+	std::shared_ptr<IInstanceBuffer> SoftwareApplication::CreateInstanceBuffer(LPCVOID Data, SIZE_T CountElement, SIZE_T SizeElement)
+	{
+		return CreateInterface<SoftwareInstanceBuffer>(this->Immediate, Data, CountElement, SizeElement);
+	}
+
+
+
+	class SoftwareTexture : public ITexture
+	{
+	public:
+		SoftwareTexture(std::shared_ptr<SoftwareContext> Immediate, LPCVOID Data, UINT Width, UINT Height) : Color(static_cast<const uint32_t*>(Data), static_cast<const uint32_t*>(Data) + static_cast<SIZE_T>(Width) * Height)
+		{
+			this->Immediate = Immediate;
+			this->Texture = { this->Color.data(), Width, Height };
+		}
+
+		void Set() override
+		{
+			this->Set(this->Immediate.get());
+		}
+
+		void Set(ICommandContext* Context) override
+		{
+			const SOFTWARE_TEXTURE_STRUCT* const Texture = &this->Texture;
+			GetSoftwareContext(Context)->Bind([=](SoftwareContext& Current)
+			{
+				Current.State.Texture = Texture;
+			});
+		}
+	private:
+		std::shared_ptr<SoftwareContext> Immediate;
+		std::vector<uint32_t> Color;
+		SOFTWARE_TEXTURE_STRUCT Texture;
+	};
+
+	std::shared_ptr<ITexture> SoftwareApplication::CreateTexture(LPCVOID Data, UINT Width, UINT Height)
+	{
+		return CreateInterface<SoftwareTexture>(this->Immediate, Data, Width, Height);
+	}
+}
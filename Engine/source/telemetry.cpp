@@ -0,0 +1,320 @@
+﻿#include "include/telemetry.h"
+#include "include/profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr uint32_t MaxCapacity = 4096;
+		constexpr size_t ReadAttempts = 1000;
+
+		size_t GetSegmentSize(uint32_t Capacity)
+		{
+			return sizeof(TELEMETRY_HEADER_STRUCT) + Capacity * sizeof(TELEMETRY_COUNTER_STRUCT);
+		}
+
+		std::string GetSegmentName(const char* Name)
+		{
+#ifdef _WIN32
+			return std::string("Local\\") + Name;
+#else
+			return std::string("/") + Name;
+#endif
+		}
+
+		void* MapSegment(const char* Name, size_t Size, bool Create, void*& Handle)
+		{
+			const std::string SegmentName = GetSegmentName(Name);
+#ifdef _WIN32
+			HANDLE Mapping = Create ?
+				CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(Size), SegmentName.c_str()) :
+				OpenFileMappingA(FILE_MAP_READ, FALSE, SegmentName.c_str());
+			if (!Mapping)
+			{
+				return nullptr;
+			}
+
+			void* Memory = MapViewOfFile(Mapping, Create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, Size);
+			if (!Memory)
+			{
+				CloseHandle(Mapping);
+				return nullptr;
+			}
+
+			Handle = Mapping;
+			return Memory;
+#else
+			const int File = Create ? shm_open(SegmentName.c_str(), O_CREAT | O_RDWR, 0644) : shm_open(SegmentName.c_str(), O_RDONLY, 0);
+			if (File < 0)
+			{
+				return nullptr;
+			}
+
+			if (Create && ftruncate(File, static_cast<off_t>(Size)) != 0)
+			{
+				close(File);
+				return nullptr;
+			}
+
+			if (!Create)
+			{
+				struct stat Status = {};
+				if (fstat(File, &Status) != 0 || static_cast<size_t>(Status.st_size) < Size)
+				{
+					close(File);
+					return nullptr;
+				}
+			}
+
+			void* Memory = mmap(nullptr, Size, Create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, File, 0);
+			close(File);
+
+			Handle = nullptr;
+			return Memory == MAP_FAILED ? nullptr : Memory;
+#endif
+		}
+
+		void UnmapSegment(void* Memory, size_t Size, void* Handle)
+		{
+#ifdef _WIN32
+			(void)Size;
+			UnmapViewOfFile(Memory);
+			CloseHandle(static_cast<HANDLE>(Handle));
+#else
+			(void)Handle;
+			munmap(Memory, Size);
+#endif
+		}
+	}
+
+
+
+	uint64_t GetProcessMemory()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS Counters = {};
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))
+		{
+			return 0;
+		}
+		return Counters.WorkingSetSize;
+#else
+		FILE* File = fopen("/proc/self/statm", "r");
+		if (!File)
+		{
+			return 0;
+		}
+
+		unsigned long long Total = 0;
+		unsigned long long Resident = 0;
+		const int Count = fscanf(File, "%llu %llu", &Total, &Resident);
+		fclose(File);
+
+		return Count == 2 ? Resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) : 0;
+#endif
+	}
+
+
+
+	TelemetryPublisher::TelemetryPublisher(const char* Name, uint32_t Capacity) : Name(Name)
+	{
+		Capacity = (std::min)(Capacity, MaxCapacity);
+
+		this->Size = GetSegmentSize(Capacity);
+		void* Memory = MapSegment(Name, this->Size, true, this->Handle);
+		if (!Memory)
+		{
+			return;
+		}
+
+		this->Header = static_cast<TELEMETRY_HEADER_STRUCT*>(Memory);
+		this->Counter = reinterpret_cast<TELEMETRY_COUNTER_STRUCT*>(this->Header + 1);
+
+		this->Header->Sequence.store(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		this->Header->Magic = Magic;
+		this->Header->Capacity = Capacity;
+		this->Header->Count.store(0, std::memory_order_relaxed);
+		this->Header->Frame.store(0, std::memory_order_relaxed);
+		this->Header->Timestamp.store(GetTimestamp(), std::memory_order_relaxed);
+		this->Header->Sequence.store(2, std::memory_order_release);
+	}
+
+	TelemetryPublisher::~TelemetryPublisher()
+	{
+		if (!this->Header)
+		{
+			return;
+		}
+
+		UnmapSegment(this->Header, this->Size, this->Handle);
+#ifndef _WIN32
+		shm_unlink(GetSegmentName(this->Name.c_str()).c_str());
+#endif
+	}
+
+	uint32_t TelemetryPublisher::Register(const char* Name)
+	{
+		if (!this->Header || this->Value.size() >= this->Header->Capacity)
+		{
+			return Invalid;
+		}
+
+		const uint32_t Index = static_cast<uint32_t>(this->Value.size());
+		this->Value.push_back(0.0);
+
+		const uint64_t Sequence = this->Header->Sequence.load(std::memory_order_relaxed);
+		this->Header->Sequence.store(Sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		TELEMETRY_COUNTER_STRUCT& Counter = this->Counter[Index];
+		const size_t Length = (std::min)(strlen(Name), sizeof(Counter.Name) - 1);
+		for (size_t Character = 0; Character < sizeof(Counter.Name); Character++)
+		{
+			Counter.Name[Character].store(Character < Length ? Name[Character] : '\0', std::memory_order_relaxed);
+		}
+		Counter.Value.store(0.0, std::memory_order_relaxed);
+		this->Header->Count.store(Index + 1, std::memory_order_relaxed);
+
+		this->Header->Sequence.store(Sequence + 2, std::memory_order_release);
+		return Index;
+	}
+
+	void TelemetryPublisher::Set(uint32_t Counter, double Value)
+	{
+		if (Counter < this->Value.size())
+		{
+			this->Value[Counter] = Value;
+		}
+	}
+
+	void TelemetryPublisher::Publish(uint64_t Frame)
+	{
+		if (!this->Header)
+		{
+			return;
+		}
+
+		const uint64_t Sequence = this->Header->Sequence.load(std::memory_order_relaxed);
+		this->Header->Sequence.store(Sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (size_t Index = 0; Index < this->Value.size(); Index++)
+		{
+			this->Counter[Index].Value.store(this->Value[Index], std::memory_order_relaxed);
+		}
+		this->Header->Frame.store(Frame, std::memory_order_relaxed);
+		this->Header->Timestamp.store(GetTimestamp(), std::memory_order_relaxed);
+
+		this->Header->Sequence.store(Sequence + 2, std::memory_order_release);
+	}
+
+	bool TelemetryPublisher::IsOpen() const
+	{
+		return this->Header != nullptr;
+	}
+
+
+
+	TelemetryReader::~TelemetryReader()
+	{
+		this->Close();
+	}
+
+	bool TelemetryReader::Open(const char* Name)
+	{
+		this->Close();
+
+		void* Handle = nullptr;
+		void* Memory = MapSegment(Name, sizeof(TELEMETRY_HEADER_STRUCT), false, Handle);
+		if (!Memory)
+		{
+			return false;
+		}
+
+		const TELEMETRY_HEADER_STRUCT* Header = static_cast<const TELEMETRY_HEADER_STRUCT*>(Memory);
+		const uint32_t Capacity = Header->Magic == TelemetryPublisher::Magic ? (std::min)(Header->Capacity, MaxCapacity) : 0;
+		UnmapSegment(Memory, sizeof(TELEMETRY_HEADER_STRUCT), Handle);
+
+		if (!Capacity)
+		{
+			return false;
+		}
+
+		this->Size = GetSegmentSize(Capacity);
+		Memory = MapSegment(Name, this->Size, false, this->Handle);
+		this->Header = static_cast<TELEMETRY_HEADER_STRUCT*>(Memory);
+		return this->Header != nullptr;
+	}
+
+	void TelemetryReader::Close()
+	{
+		if (this->Header)
+		{
+			UnmapSegment(this->Header, this->Size, this->Handle);
+			this->Header = nullptr;
+			this->Handle = nullptr;
+		}
+	}
+
+	bool TelemetryReader::Read(uint64_t& Frame, uint64_t& Timestamp, std::vector<TELEMETRY_VALUE_STRUCT>& Value)
+	{
+		if (!this->Header)
+		{
+			return false;
+		}
+
+		const TELEMETRY_COUNTER_STRUCT* const Counter = reinterpret_cast<const TELEMETRY_COUNTER_STRUCT*>(this->Header + 1);
+		const uint32_t Capacity = static_cast<uint32_t>((this->Size - sizeof(TELEMETRY_HEADER_STRUCT)) / sizeof(TELEMETRY_COUNTER_STRUCT));
+
+		for (size_t Attempt = 0; Attempt < ReadAttempts; Attempt++)
+		{
+			const uint64_t Sequence = this->Header->Sequence.load(std::memory_order_acquire);
+			if (Sequence & 1)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			const uint32_t Count = (std::min)(this->Header->Count.load(std::memory_order_relaxed), Capacity);
+			Value.resize(Count);
+
+			for (uint32_t Index = 0; Index < Count; Index++)
+			{
+				char Name[sizeof(Counter[Index].Name)];
+				for (size_t Character = 0; Character < sizeof(Name); Character++)
+				{
+					Name[Character] = Counter[Index].Name[Character].load(std::memory_order_relaxed);
+				}
+				Name[sizeof(Name) - 1] = '\0';
+
+				Value[Index].Name = Name;
+				Value[Index].Value = Counter[Index].Value.load(std::memory_order_relaxed);
+			}
+			Frame = this->Header->Frame.load(std::memory_order_relaxed);
+			Timestamp = this->Header->Timestamp.load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (this->Header->Sequence.load(std::memory_order_relaxed) == Sequence)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
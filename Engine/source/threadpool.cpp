@@ -0,0 +1,456 @@
+﻿#include "include/threadpool.h"
+#include "include/platform.h"
+#include "include/profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr size_t QueueCapacity = 4096;
+		constexpr size_t SpinCount = 64;
+
+		thread_local const ThreadPool* CurrentPool = nullptr;
+		thread_local void* CurrentWorker = nullptr;
+
+		void PinThread(std::thread& Thread, size_t Core)
+		{
+#ifdef _WIN32
+			SetThreadAffinityMask(Thread.native_handle(), static_cast<DWORD_PTR>(1) << (Core % (sizeof(DWORD_PTR) * 8)));
+#else
+			cpu_set_t Set;
+			CPU_ZERO(&Set);
+			CPU_SET(Core % CPU_SETSIZE, &Set);
+			pthread_setaffinity_np(Thread.native_handle(), sizeof(Set), &Set);
+#endif
+		}
+	}
+
+
+
+	struct ThreadPool::JOB_STRUCT
+	{
+		std::atomic<bool> Busy{ false };
+		bool Heap = false;
+		JOB_COUNTER_STRUCT* Counter = nullptr;
+		std::function<void()> Task;
+		const std::function<void(size_t First, size_t Last)>* Range = nullptr;
+		size_t First = 0;
+		size_t Last = 0;
+		size_t Grain = 0;
+	};
+
+	struct ThreadPool::WORKER_STRUCT
+	{
+		alignas(64) std::atomic<int64_t> Top{ 0 };
+		alignas(64) std::atomic<int64_t> Bottom{ 0 };
+		std::atomic<JOB_STRUCT*> Buffer[QueueCapacity];
+		JOB_STRUCT Job[QueueCapacity];
+		size_t NextJob = 0;
+		uint32_t Random = 0;
+
+		bool Push(JOB_STRUCT* Job)
+		{
+			const int64_t Bottom = this->Bottom.load(std::memory_order_relaxed);
+			const int64_t Top = this->Top.load(std::memory_order_acquire);
+			if (Bottom - Top >= static_cast<int64_t>(QueueCapacity))
+			{
+				return false;
+			}
+
+			this->Buffer[Bottom & (QueueCapacity - 1)].store(Job, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			this->Bottom.store(Bottom + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		JOB_STRUCT* Pop()
+		{
+			const int64_t Bottom = this->Bottom.load(std::memory_order_relaxed) - 1;
+			this->Bottom.store(Bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t Top = this->Top.load(std::memory_order_relaxed);
+
+			if (Top > Bottom)
+			{
+				this->Bottom.store(Bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			JOB_STRUCT* Job = this->Buffer[Bottom & (QueueCapacity - 1)].load(std::memory_order_relaxed);
+			if (Top == Bottom)
+			{
+				if (!this->Top.compare_exchange_strong(Top, Top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					Job = nullptr;
+				}
+				this->Bottom.store(Bottom + 1, std::memory_order_relaxed);
+			}
+			return Job;
+		}
+
+		JOB_STRUCT* Steal()
+		{
+			int64_t Top = this->Top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t Bottom = this->Bottom.load(std::memory_order_acquire);
+
+			if (Top >= Bottom)
+			{
+				return nullptr;
+			}
+
+			JOB_STRUCT* Job = this->Buffer[Top & (QueueCapacity - 1)].load(std::memory_order_relaxed);
+			if (!this->Top.compare_exchange_strong(Top, Top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return nullptr;
+			}
+			return Job;
+		}
+
+		bool IsEmpty() const
+		{
+			return this->Bottom.load(std::memory_order_relaxed) <= this->Top.load(std::memory_order_relaxed);
+		}
+	};
+
+
+
+	ThreadPool::ThreadPool(size_t ThreadCount, bool Pin) : SharedCount(0), Sleeping(0), Exit(false)
+	{
+		if (ThreadCount == 0)
+		{
+			ThreadCount = (std::max)(std::thread::hardware_concurrency(), 1u);
+		}
+
+		for (size_t Index = 0; Index < ThreadCount; Index++)
+		{
+			this->Workers.push_back(std::make_unique<WORKER_STRUCT>());
+			this->Workers.back()->Random = static_cast<uint32_t>(Index * 0x9E3779B9u + 1);
+		}
+
+		this->Owner = std::this_thread::get_id();
+
+		for (size_t Index = 1; Index < ThreadCount; Index++)
+		{
+			this->Thread.emplace_back(&ThreadPool::Worker, this, Index);
+			if (Pin)
+			{
+				PinThread(this->Thread.back(), Index);
+			}
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		WORKER_STRUCT* Worker = this->GetWorker();
+		while (JOB_STRUCT* Job = this->Find(Worker))
+		{
+			this->Run(Worker, Job);
+		}
+
+		{
+			std::lock_guard<std::mutex> Lock(this->SleepMutex);
+			this->Exit = true;
+		}
+		this->Wake.notify_all();
+
+		for (std::thread& Current : this->Thread)
+		{
+			Current.join();
+		}
+	}
+
+	void ThreadPool::Spawn(std::function<void()>&& Function, JOB_COUNTER_STRUCT* Counter)
+	{
+		WORKER_STRUCT* Worker = this->GetWorker();
+
+		JOB_STRUCT* Job = this->Allocate(Worker);
+		if (!Job)
+		{
+			Function();
+			return;
+		}
+
+		Job->Task = std::move(Function);
+		Job->Range = nullptr;
+		Job->Counter = Counter;
+		if (Counter)
+		{
+			Counter->Pending.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		this->Push(Worker, Job);
+	}
+
+	void ThreadPool::Wait(JOB_COUNTER_STRUCT& Counter)
+	{
+		WORKER_STRUCT* Worker = this->GetWorker();
+
+		size_t Idle = 0;
+		while (Counter.Pending.load(std::memory_order_acquire) > 0)
+		{
+			if (JOB_STRUCT* Job = this->Find(Worker))
+			{
+				this->Run(Worker, Job);
+				Idle = 0;
+			}
+			else if (++Idle > SpinCount)
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void ThreadPool::ParallelFor(size_t Count, size_t Grain, const std::function<void(size_t First, size_t Last)>& Function)
+	{
+		if (Count == 0)
+		{
+			return;
+		}
+
+		Grain = (std::max)(Grain, static_cast<size_t>(1));
+		if (this->Thread.empty() || Count <= Grain)
+		{
+			Function(0, Count);
+			return;
+		}
+
+		JOB_COUNTER_STRUCT Counter;
+		Counter.Pending = 1;
+
+		JOB_STRUCT Root;
+		Root.Busy = true;
+		Root.Counter = &Counter;
+		Root.Range = &Function;
+		Root.First = 0;
+		Root.Last = Count;
+		Root.Grain = Grain;
+
+		WORKER_STRUCT* Worker = this->GetWorker();
+		this->Run(Worker, &Root);
+		this->Wait(Counter);
+	}
+
+	void ThreadPool::Dispatch(size_t Count, const std::function<void(size_t Index)>& Function)
+	{
+		this->ParallelFor(Count, 1, [&Function](size_t First, size_t Last)
+		{
+			for (size_t Index = First; Index < Last; Index++)
+			{
+				Function(Index);
+			}
+		});
+	}
+
+	size_t ThreadPool::GetThreadCount() const
+	{
+		return this->Workers.size();
+	}
+
+
+
+	void ThreadPool::Worker(size_t Index)
+	{
+		WORKER_STRUCT* Worker = this->Workers[Index].get();
+		CurrentPool = this;
+		CurrentWorker = Worker;
+		Profiler::SetThreadName("Worker");
+
+		size_t Idle = 0;
+		while (!this->Exit.load(std::memory_order_relaxed))
+		{
+			if (JOB_STRUCT* Job = this->Find(Worker))
+			{
+				this->Run(Worker, Job);
+				Idle = 0;
+				continue;
+			}
+
+			if (++Idle < SpinCount)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> Lock(this->SleepMutex);
+			this->Sleeping.fetch_add(1, std::memory_order_seq_cst);
+			if (!this->HasWork() && !this->Exit)
+			{
+				this->Wake.wait_for(Lock, std::chrono::milliseconds(10));
+			}
+			this->Sleeping.fetch_sub(1, std::memory_order_relaxed);
+			Idle = 0;
+		}
+	}
+
+	ThreadPool::WORKER_STRUCT* ThreadPool::GetWorker() const
+	{
+		if (CurrentPool == this)
+		{
+			return static_cast<WORKER_STRUCT*>(CurrentWorker);
+		}
+		return std::this_thread::get_id() == this->Owner ? this->Workers[0].get() : nullptr;
+	}
+
+	ThreadPool::JOB_STRUCT* ThreadPool::Allocate(WORKER_STRUCT* Worker)
+	{
+		if (!Worker)
+		{
+			JOB_STRUCT* Job = new JOB_STRUCT();
+			Job->Busy = true;
+			Job->Heap = true;
+			return Job;
+		}
+
+		JOB_STRUCT* Job = &Worker->Job[Worker->NextJob++ & (QueueCapacity - 1)];
+		if (Job->Busy.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+
+		Job->Busy.store(true, std::memory_order_relaxed);
+		return Job;
+	}
+
+	void ThreadPool::Push(WORKER_STRUCT* Worker, JOB_STRUCT* Job)
+	{
+		if (!Worker || !Worker->Push(Job))
+		{
+			std::lock_guard<std::mutex> Lock(this->SharedMutex);
+			this->Shared.push_back(Job);
+			this->SharedCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (this->Sleeping.load(std::memory_order_relaxed) > 0)
+		{
+			std::lock_guard<std::mutex> Lock(this->SleepMutex);
+			this->Wake.notify_one();
+		}
+	}
+
+	ThreadPool::JOB_STRUCT* ThreadPool::Find(WORKER_STRUCT* Worker)
+	{
+		if (Worker)
+		{
+			if (JOB_STRUCT* Job = Worker->Pop())
+			{
+				return Job;
+			}
+		}
+
+		if (this->SharedCount.load(std::memory_order_relaxed) > 0)
+		{
+			std::lock_guard<std::mutex> Lock(this->SharedMutex);
+			if (!this->Shared.empty())
+			{
+				JOB_STRUCT* Job = this->Shared.front();
+				this->Shared.pop_front();
+				this->SharedCount.fetch_sub(1, std::memory_order_relaxed);
+				return Job;
+			}
+		}
+
+		const size_t Count = this->Workers.size();
+		uint32_t Random = Worker ? Worker->Random : static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+		Random ^= Random << 13;
+		Random ^= Random >> 17;
+		Random ^= Random << 5;
+		if (Worker)
+		{
+			Worker->Random = Random;
+		}
+
+		for (size_t Offset = 0; Offset < Count; Offset++)
+		{
+			WORKER_STRUCT* Victim = this->Workers[(Random + Offset) % Count].get();
+			if (Victim == Worker)
+			{
+				continue;
+			}
+
+			if (JOB_STRUCT* Job = Victim->Steal())
+			{
+				return Job;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void ThreadPool::Run(WORKER_STRUCT* Worker, JOB_STRUCT* Job)
+	{
+		JOB_COUNTER_STRUCT* Counter = Job->Counter;
+
+		if (Job->Range)
+		{
+			size_t Last = Job->Last;
+			while (Last - Job->First > Job->Grain)
+			{
+				const size_t Middle = Job->First + (Last - Job->First) / 2;
+
+				JOB_STRUCT* Child = this->Allocate(Worker);
+				if (!Child)
+				{
+					break;
+				}
+
+				Child->Task = nullptr;
+				Child->Range = Job->Range;
+				Child->First = Middle;
+				Child->Last = Last;
+				Child->Grain = Job->Grain;
+				Child->Counter = Counter;
+				Counter->Pending.fetch_add(1, std::memory_order_relaxed);
+
+				this->Push(Worker, Child);
+				Last = Middle;
+			}
+
+			(*Job->Range)(Job->First, Last);
+		}
+		else
+		{
+			Job->Task();
+			Job->Task = nullptr;
+		}
+
+		if (Job->Heap)
+		{
+			delete Job;
+		}
+		else
+		{
+			Job->Busy.store(false, std::memory_order_release);
+		}
+
+		if (Counter)
+		{
+			Counter->Pending.fetch_sub(1, std::memory_order_acq_rel);
+		}
+	}
+
+	bool ThreadPool::HasWork() const
+	{
+		if (this->SharedCount.load(std::memory_order_relaxed) > 0)
+		{
+			return true;
+		}
+
+		for (const std::unique_ptr<WORKER_STRUCT>& Worker : this->Workers)
+		{
+			if (!Worker->IsEmpty())
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
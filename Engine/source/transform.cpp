@@ -0,0 +1,282 @@
+﻿#include "include/transform.h"
+#include <algorithm>
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr uint32_t UpdateBatchSize = 4096;
+
+		template<class Type>
+		void Permute(std::vector<Type>& Data, const std::vector<uint32_t>& Order)
+		{
+			std::vector<Type> Result(Order.size());
+			for (size_t Index = 0; Index < Order.size(); Index++)
+			{
+				Result[Index] = Data[Order[Index]];
+			}
+			Data.swap(Result);
+		}
+	}
+
+
+
+	uint32_t TransformHierarchy::Create(const TRANSFORM_STRUCT& Local, uint32_t Parent)
+	{
+		uint32_t Transform = static_cast<uint32_t>(this->Index.size());
+		if (!this->FreeHandle.empty())
+		{
+			Transform = this->FreeHandle.back();
+			this->FreeHandle.pop_back();
+		}
+		else
+		{
+			this->Index.push_back(Invalid);
+		}
+
+		this->Index[Transform] = static_cast<uint32_t>(this->Handle.size());
+
+		this->PositionX.push_back(0.0f);
+		this->PositionY.push_back(0.0f);
+		this->PositionZ.push_back(0.0f);
+		this->RotationX.push_back(0.0f);
+		this->RotationY.push_back(0.0f);
+		this->RotationZ.push_back(0.0f);
+		this->RotationW.push_back(1.0f);
+		this->ScaleX.push_back(1.0f);
+		this->ScaleY.push_back(1.0f);
+		this->ScaleZ.push_back(1.0f);
+		this->Parent.push_back(Parent == Invalid ? Invalid : this->Index[Parent]);
+		this->Handle.push_back(Transform);
+		this->Stamp.push_back(0);
+		this->Dirty.push_back(1);
+		this->Alive.push_back(1);
+		this->World.push_back(DirectX::XMMatrixIdentity());
+
+		this->SetLocal(Transform, Local);
+		this->StructureDirty = true;
+		return Transform;
+	}
+
+	void TransformHierarchy::Destroy(uint32_t Transform)
+	{
+		this->Alive[this->Index[Transform]] = 0;
+		this->StructureDirty = true;
+	}
+
+	void TransformHierarchy::SetParent(uint32_t Transform, uint32_t Parent)
+	{
+		const uint32_t Current = this->Index[Transform];
+		const uint32_t Target = Parent == Invalid ? Invalid : this->Index[Parent];
+
+		for (uint32_t Ancestor = Target; Ancestor != Invalid; Ancestor = this->Parent[Ancestor])
+		{
+			if (Ancestor == Current)
+			{
+				throw E_INVALIDARG;
+			}
+		}
+
+		this->Parent[Current] = Target;
+		this->Dirty[Current] = 1;
+		this->StructureDirty = true;
+	}
+
+	void TransformHierarchy::SetLocal(uint32_t Transform, const TRANSFORM_STRUCT& Local)
+	{
+		const uint32_t Current = this->Index[Transform];
+		this->PositionX[Current] = Local.Position.x;
+		this->PositionY[Current] = Local.Position.y;
+		this->PositionZ[Current] = Local.Position.z;
+		this->RotationX[Current] = Local.Rotation.x;
+		this->RotationY[Current] = Local.Rotation.y;
+		this->RotationZ[Current] = Local.Rotation.z;
+		this->RotationW[Current] = Local.Rotation.w;
+		this->ScaleX[Current] = Local.Scale.x;
+		this->ScaleY[Current] = Local.Scale.y;
+		this->ScaleZ[Current] = Local.Scale.z;
+		this->Dirty[Current] = 1;
+	}
+
+	TRANSFORM_STRUCT TransformHierarchy::GetLocal(uint32_t Transform) const
+	{
+		const uint32_t Current = this->Index[Transform];
+		return {
+			{ this->PositionX[Current], this->PositionY[Current], this->PositionZ[Current] },
+			{ this->RotationX[Current], this->RotationY[Current], this->RotationZ[Current], this->RotationW[Current] },
+			{ this->ScaleX[Current], this->ScaleY[Current], this->ScaleZ[Current] },
+		};
+	}
+
+	uint32_t TransformHierarchy::GetParent(uint32_t Transform) const
+	{
+		const uint32_t Parent = this->Parent[this->Index[Transform]];
+		return Parent == Invalid ? Invalid : this->Handle[Parent];
+	}
+
+	const DirectX::XMMATRIX& TransformHierarchy::GetWorld(uint32_t Transform) const
+	{
+		return this->World[this->Index[Transform]];
+	}
+
+	void TransformHierarchy::Update(ThreadPool* Pool)
+	{
+		if (this->StructureDirty)
+		{
+			this->Sort();
+			this->StructureDirty = false;
+		}
+
+		this->Generation++;
+
+		for (size_t Level = 0; Level + 1 < this->LevelStart.size(); Level++)
+		{
+			const uint32_t First = this->LevelStart[Level];
+			const uint32_t Last = this->LevelStart[Level + 1];
+			const uint32_t BatchCount = (Last - First + UpdateBatchSize - 1) / UpdateBatchSize;
+
+			if (!Pool || BatchCount <= 1)
+			{
+				this->UpdateRange(First, Last);
+				continue;
+			}
+
+			Pool->Dispatch(BatchCount, [&](size_t Batch)
+			{
+				const uint32_t Begin = First + static_cast<uint32_t>(Batch) * UpdateBatchSize;
+				this->UpdateRange(Begin, std::min(Begin + UpdateBatchSize, Last));
+			});
+		}
+	}
+
+	size_t TransformHierarchy::GetCount() const
+	{
+		return this->Handle.size();
+	}
+
+	size_t TransformHierarchy::GetLevelCount() const
+	{
+		return this->LevelStart.empty() ? 0 : this->LevelStart.size() - 1;
+	}
+
+
+
+	void TransformHierarchy::Sort()
+	{
+		const uint32_t Count = static_cast<uint32_t>(this->Handle.size());
+
+		std::vector<uint32_t> Depth(Count, Invalid);
+		std::vector<uint32_t> Path;
+		uint32_t MaxDepth = 0;
+
+		for (uint32_t Current = 0; Current < Count; Current++)
+		{
+			uint32_t Node = Current;
+			while (Depth[Node] == Invalid && this->Parent[Node] != Invalid && Depth[this->Parent[Node]] == Invalid)
+			{
+				Path.push_back(Node);
+				Node = this->Parent[Node];
+			}
+			Path.push_back(Node);
+
+			while (!Path.empty())
+			{
+				Node = Path.back();
+				Path.pop_back();
+				if (Depth[Node] != Invalid)
+				{
+					continue;
+				}
+
+				const uint32_t Parent = this->Parent[Node];
+				Depth[Node] = Parent == Invalid ? 0 : Depth[Parent] + 1;
+				this->Alive[Node] = this->Alive[Node] && (Parent == Invalid || this->Alive[Parent]);
+				MaxDepth = std::max(MaxDepth, Depth[Node]);
+			}
+		}
+
+		this->LevelStart.assign(MaxDepth + 2, 0);
+		for (uint32_t Current = 0; Current < Count; Current++)
+		{
+			if (this->Alive[Current])
+			{
+				this->LevelStart[Depth[Current] + 1]++;
+			}
+			else
+			{
+				this->Index[this->Handle[Current]] = Invalid;
+				this->FreeHandle.push_back(this->Handle[Current]);
+			}
+		}
+
+		for (size_t Level = 1; Level < this->LevelStart.size(); Level++)
+		{
+			this->LevelStart[Level] += this->LevelStart[Level - 1];
+		}
+
+		std::vector<uint32_t> Order(this->LevelStart.back());
+		std::vector<uint32_t> Remap(Count, Invalid);
+		std::vector<uint32_t> Cursor(this->LevelStart.begin(), this->LevelStart.end() - 1);
+		for (uint32_t Current = 0; Current < Count; Current++)
+		{
+			if (this->Alive[Current])
+			{
+				Remap[Current] = Cursor[Depth[Current]]++;
+				Order[Remap[Current]] = Current;
+			}
+		}
+
+		Permute(this->PositionX, Order);
+		Permute(this->PositionY, Order);
+		Permute(this->PositionZ, Order);
+		Permute(this->RotationX, Order);
+		Permute(this->RotationY, Order);
+		Permute(this->RotationZ, Order);
+		Permute(this->RotationW, Order);
+		Permute(this->ScaleX, Order);
+		Permute(this->ScaleY, Order);
+		Permute(this->ScaleZ, Order);
+		Permute(this->Parent, Order);
+		Permute(this->Handle, Order);
+		Permute(this->Stamp, Order);
+		Permute(this->Dirty, Order);
+		Permute(this->Alive, Order);
+		Permute(this->World, Order);
+
+		for (uint32_t Current = 0; Current < Order.size(); Current++)
+		{
+			if (this->Parent[Current] != Invalid)
+			{
+				this->Parent[Current] = Remap[this->Parent[Current]];
+			}
+			this->Index[this->Handle[Current]] = Current;
+		}
+
+		while (this->LevelStart.size() > 1 && this->LevelStart[this->LevelStart.size() - 2] == this->LevelStart.back())
+		{
+			this->LevelStart.pop_back();
+		}
+	}
+
+	void TransformHierarchy::UpdateRange(uint32_t First, uint32_t Last)
+	{
+		for (uint32_t Current = First; Current < Last; Current++)
+		{
+			const uint32_t Parent = this->Parent[Current];
+			if (!this->Dirty[Current] && (Parent == Invalid || this->Stamp[Parent] != this->Generation))
+			{
+				continue;
+			}
+
+			DirectX::XMMATRIX Local = DirectX::XMMatrixRotationQuaternion(DirectX::XMVectorSet(this->RotationX[Current], this->RotationY[Current], this->RotationZ[Current], this->RotationW[Current]));
+			Local.r[0] = DirectX::XMVectorScale(Local.r[0], this->ScaleX[Current]);
+			Local.r[1] = DirectX::XMVectorScale(Local.r[1], this->ScaleY[Current]);
+			Local.r[2] = DirectX::XMVectorScale(Local.r[2], this->ScaleZ[Current]);
+			Local.r[3] = DirectX::XMVectorSet(this->PositionX[Current], this->PositionY[Current], this->PositionZ[Current], 1.0f);
+
+			this->World[Current] = Parent == Invalid ? Local : DirectX::XMMatrixMultiply(Local, this->World[Parent]);
+			this->Stamp[Current] = this->Generation;
+			this->Dirty[Current] = 0;
+		}
+	}
+}
@@ -22,27 +22,68 @@ int WINAPI _tWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 	try
 	{
 		std::shared_ptr<Engine::IApplication> App = Engine::IApplication::Create(_T("Game"), 50, 50, 640, 480);
+		App->SetStatisticsFile("statistics.prom", 5.0f);
+
+		Engine::TelemetryPublisher Telemetry("game_telemetry");
+		const uint32_t TelemetryFrameTime = Telemetry.Register("frame.time_ms");
+		const uint32_t TelemetryVisible = Telemetry.Register("frame.visible");
+		const uint32_t TelemetryDrawCount = Telemetry.Register("frame.draw_calls");
+		const uint32_t TelemetryFrameTimeP99 = Telemetry.Register("frame.time_p99_ms");
+		const uint32_t TelemetryResourceCount = Telemetry.Register("resource.count");
+		const uint32_t TelemetryResourceCreated = Telemetry.Register("resource.created");
+		const uint32_t TelemetryResourceCreateTime = Telemetry.Register("resource.create_ms");
+		const uint32_t TelemetryModelLoadTime = Telemetry.Register("loader.model_ms");
+		const uint32_t TelemetryImageLoadTime = Telemetry.Register("loader.image_ms");
+		const uint32_t TelemetryMemory = Telemetry.Register("memory.resident_mb");
+		const uint32_t TelemetryInputLatency = Telemetry.Register("input.latency_max_ms");
+		const uint32_t TelemetryInputDropped = Telemetry.Register("input.dropped");
 
 		struct CAMERA_STRUCT
 		{
 			DirectX::XMVECTOR Eye;
 			DirectX::XMVECTOR At;
 			DirectX::XMVECTOR Up;
-		} Camera = {
+			DirectX::XMFLOAT2 Mouse;
+		};
+
+		struct TRANSFORM_COMPONENT_STRUCT
+		{
+			uint32_t Transform;
+		};
+
+		struct RENDERABLE_STRUCT
+		{
+			uint32_t Object;
+		};
+
+		Engine::EntityWorld Entities;
+
+		const Engine::ENTITY_STRUCT CameraEntity = Entities.Create(CAMERA_STRUCT{
 			DirectX::XMVectorSet(0.0f, 0.0f, -3.0f, 0.0f),
 			DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
 			DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f),
-		};
+			{},
+		});
 
-		struct CONSTANT_BUFFER_STRUCT
+		struct FRAME_BUFFER_STRUCT
 		{
-			DirectX::XMMATRIX World;
 			DirectX::XMMATRIX View;
 			DirectX::XMMATRIX Projection;
-		} ConstantBufferStruct;
+		};
+
+		struct FRAME_SNAPSHOT_STRUCT
+		{
+			FRAME_BUFFER_STRUCT FrameBuffer;
+			std::vector<DirectX::XMMATRIX> VisibleWorld;
+			float Depth;
+		};
+
+		struct OBJECT_BUFFER_STRUCT
+		{
+			DirectX::XMMATRIX World;
+		} ObjectBufferStruct;
 
 		POINT Size = {};
-		DirectX::XMFLOAT2 Mouse = {};
 
 		std::shared_ptr<Engine::IVertexShader> VertexShader;
 		std::shared_ptr<Engine::IPixelShader> PixelShader;
@@ -50,8 +91,25 @@ int WINAPI _tWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 
 		std::shared_ptr<Engine::IVertexBuffer> VertexBuffer;
 		std::shared_ptr<Engine::IIndexBuffer> IndexBuffer;
+		std::shared_ptr<Engine::IInstanceBuffer> InstanceBuffer;
 		std::shared_ptr<Engine::ITexture> Texture;
 
+		Engine::BOUNDING_BOX_STRUCT ModelBox = {};
+		Engine::MeshBVH ModelMesh;
+
+		Engine::ThreadPool Pool;
+		Engine::TransformHierarchy Transforms;
+
+		struct FOREST_STRUCT
+		{
+			uint32_t Root;
+			std::vector<Engine::ENTITY_STRUCT> Entity;
+			std::vector<DirectX::XMMATRIX> VisibleWorld;
+			std::vector<uint32_t> Visible;
+			std::vector<uint32_t> Nearby;
+			Engine::SceneBVH Scene;
+		} Forest;
+
 		{
 			HRSRC hRsrc = FindResource(nullptr, MAKEINTRESOURCE(IDR_VERTEX_SHADER), RT_RCDATA);
 			HGLOBAL hResData = LoadResource(nullptr, hRsrc);
@@ -72,92 +130,274 @@ int WINAPI _tWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 			FreeResource(hResData);
 		}
 
-		ConstantBuffer = Engine::IConstantBuffer::Create(App, sizeof(ConstantBufferStruct));
-
-		VertexShader->Set();
-		PixelShader->Set();
-		ConstantBuffer->SetVertexShader();
+		ConstantBuffer = Engine::IConstantBuffer::Create(App, sizeof(FRAME_BUFFER_STRUCT));
+		ConstantBuffer->SetVertexShader(Engine::CONSTANT_SLOT_FRAME);
 
 		{
+			const uint64_t Start = Engine::GetTimestamp();
+
 			ResourceLoader::Model Model;
 			if (!Model.Load("cube.obj"))
 			{
 				Assert(E_FAIL);
 			}
 
+			Telemetry.Set(TelemetryModelLoadTime, (Engine::GetTimestamp() - Start) * 1e-6);
+
 			VertexBuffer = Engine::IVertexBuffer::Create(App, Model.GetVertex(), Model.GetVertexCount(), sizeof(ResourceLoader::VERTEX_STRUCT));
 			IndexBuffer = Engine::IIndexBuffer::Create(App, Model.GetIndex(), Model.GetIndexCount());
+
+			ModelBox = Engine::ComputeBoundingBox(Model.GetVertex(), Model.GetVertexCount(), sizeof(ResourceLoader::VERTEX_STRUCT));
+			ModelMesh.Build(Model.GetVertex(), Model.GetVertexCount(), sizeof(ResourceLoader::VERTEX_STRUCT), Model.GetIndex(), Model.GetIndexCount());
+		}
+
+		{
+			constexpr int ForestSize = 32;
+			constexpr float ForestSpacing = 3.0f;
+
+			Forest.Root = Transforms.Create({ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f } });
+			Forest.Entity.reserve(ForestSize * ForestSize);
+
+			for (int Z = 0; Z < ForestSize; Z++)
+			{
+				for (int X = 0; X < ForestSize; X++)
+				{
+					const float OffsetX = (X - ForestSize / 2) * ForestSpacing;
+					const float OffsetZ = Z * ForestSpacing;
+					const uint32_t Transform = Transforms.Create({ { OffsetX, 0.0f, OffsetZ }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f } }, Forest.Root);
+					Forest.Entity.push_back(Entities.Create(TRANSFORM_COMPONENT_STRUCT{ Transform }, RENDERABLE_STRUCT{ static_cast<uint32_t>(Forest.Entity.size()) }));
+				}
+			}
+
+			Transforms.Update(&Pool);
+
+			std::vector<Engine::BOUNDING_BOX_STRUCT> Bounds(Forest.Entity.size());
+			std::vector<DirectX::XMFLOAT4X4> World(Forest.Entity.size());
+			Forest.VisibleWorld.resize(Forest.Entity.size());
+
+			Entities.Each<const TRANSFORM_COMPONENT_STRUCT, const RENDERABLE_STRUCT>([&](const TRANSFORM_COMPONENT_STRUCT& Transform, const RENDERABLE_STRUCT& Renderable)
+			{
+				DirectX::XMStoreFloat4x4(&World[Renderable.Object], Transforms.GetWorld(Transform.Transform));
+				Forest.VisibleWorld[Renderable.Object] = DirectX::XMMatrixTranspose(Transforms.GetWorld(Transform.Transform));
+			});
+
+			Engine::TransformBoundingBoxes(ModelBox, &World[0].m[0][0], Bounds.data(), World.size(), &Pool);
+
+			Forest.Scene.Build(Bounds.data(), Bounds.size());
+
+			InstanceBuffer = Engine::IInstanceBuffer::Create(App, Forest.VisibleWorld.data(), Forest.VisibleWorld.size(), sizeof(DirectX::XMMATRIX));
 		}
 
 		{
 			Microsoft::WRL::ComPtr<ID3DBlob> ImageSource;
 			Assert(D3DReadFileToBlob(_T("cube.tga"), ImageSource.GetAddressOf()));
 
+			const uint64_t Start = Engine::GetTimestamp();
+
 			ResourceLoader::Image Image;
 			if (!Image.Load(ImageSource->GetBufferPointer(), ImageSource->GetBufferSize()))
 			{
 				Assert(E_FAIL);
 			}
 
+			Telemetry.Set(TelemetryImageLoadTime, (Engine::GetTimestamp() - Start) * 1e-6);
+
 			Texture = Engine::ITexture::Create(App, Image.GetColor(), Image.GetWidth(), Image.GetHeight());
 		}
 
-		VertexBuffer->Set();
-		IndexBuffer->Set();
-		Texture->Set();
+		ObjectBufferStruct.World = DirectX::XMMatrixTranspose(DirectX::XMMatrixIdentity());
+
+		Engine::SnapshotPipeline<FRAME_SNAPSHOT_STRUCT> Pipeline(1, [&](const FRAME_SNAPSHOT_STRUCT& Snapshot)
+		{
+			App->BeginDraw(0.5f, 0.5f, 0.5f, 1.0f);
+
+			ConstantBuffer->Update(&Snapshot.FrameBuffer);
+			InstanceBuffer->Update(Snapshot.VisibleWorld.data(), Snapshot.VisibleWorld.size());
+
+			const Engine::DRAW_COMMAND_STRUCT DrawCommand = {
+				VertexShader.get(), PixelShader.get(),
+				nullptr, &ObjectBufferStruct, sizeof(ObjectBufferStruct),
+				Texture.get(), VertexBuffer.get(), IndexBuffer.get(),
+				IndexBuffer->GetIndexCount(),
+				InstanceBuffer.get(), InstanceBuffer->GetInstanceCount(),
+			};
+
+			App->Submit(Engine::MakeOpaqueKey(Engine::RENDER_PASS_OPAQUE, 0, 0, Snapshot.Depth), DrawCommand);
+
+			App->EndDraw(0);
+		});
+
+		Engine::Profiler::SetThreadName("Main");
+
+		uint64_t FrameIndex = 0;
+		uint64_t FrameTimestamp = Engine::GetTimestamp();
+		uint64_t SimulationTimestamp = FrameTimestamp;
+		uint64_t TelemetryTimestamp = 0;
+		Engine::InputState Input;
 
 		while (App->Run())
 		{
-			if (App->GetKeyState(VK_ESCAPE))
+			Engine::Profiler::NextFrame();
+
+			if (Input.Update(App->GetInputQueue(), Engine::GetTimestamp()))
+			{
+				Telemetry.Set(TelemetryInputLatency, Input.GetMaxLatency() * 1e-6);
+			}
+
+			if (Input.GetKeyState(VK_ESCAPE))
 			{
 				App->Quit();
 			}
 
+			if (Input.IsKeyPressed('P'))
+			{
+				Engine::Profiler::SaveTrace("trace.json");
+			}
+
 			if (App->GetWidth() != Size.x || App->GetHeight() != Size.y)
 			{
 				Size.x = App->GetWidth();
 				Size.y = App->GetHeight();
 
+				Pipeline.Flush();
 				App->ResizeBuffer(0, Size.x, Size.y, 4);
 			}
 
-			App->BeginDraw(0.5f, 0.5f, 0.5f, 1.0f);
+			FRAME_SNAPSHOT_STRUCT& Snapshot = Pipeline.Begin();
+
+			PROFILE_SCOPE("Simulation");
 
-			const float Time = Engine::GetTimer();
+			CAMERA_STRUCT& Camera = *Entities.Get<CAMERA_STRUCT>(CameraEntity);
 
-			static float LastTime = Time;
-			const float Delta = Time - LastTime;
-			LastTime = Time;
+			const uint64_t SimulationStart = Engine::GetTimestamp();
+			const float Delta = static_cast<float>((SimulationStart - SimulationTimestamp) * 1e-9);
+			SimulationTimestamp = SimulationStart;
 
-			const float Speed = 3.0f * static_cast<float>(Delta);
+			const float Speed = 3.0f * Delta;
 			DirectX::XMVECTOR SpeedVector = DirectX::XMVectorSet(Speed, Speed, Speed, Speed);
 
-			Mouse.x += static_cast<float>(App->GetMouseDirectionX()) * 0.003f;
-			Mouse.y += static_cast<float>(App->GetMouseDirectionY()) * 0.003f;
+			Camera.Mouse.x += static_cast<float>(Input.GetMouseDirectionX()) * 0.003f;
+			Camera.Mouse.y += static_cast<float>(Input.GetMouseDirectionY()) * 0.003f;
 			constexpr float MinRadian = DirectX::XMConvertToRadians(-80.0f);
 			constexpr float MaxRadian = DirectX::XMConvertToRadians(80.0f);
-			Mouse.y = min(max(Mouse.y, MinRadian), MaxRadian);
+			Camera.Mouse.y = min(max(Camera.Mouse.y, MinRadian), MaxRadian);
 
-			Camera.At = DirectX::XMVector3Transform(DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), DirectX::XMMatrixRotationRollPitchYaw(Mouse.y, Mouse.x, 0.0f));
+			Camera.At = DirectX::XMVector3Transform(DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), DirectX::XMMatrixRotationRollPitchYaw(Camera.Mouse.y, Camera.Mouse.x, 0.0f));
 
-			DirectX::XMVECTOR Forward = DirectX::XMVector3Transform(DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), DirectX::XMMatrixRotationRollPitchYaw(0.0f, Mouse.x, 0.0f));
-			DirectX::XMVECTOR Left = DirectX::XMVector3Transform(DirectX::XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), DirectX::XMMatrixRotationRollPitchYaw(0.0f, Mouse.x, 0.0f));
+			DirectX::XMVECTOR Forward = DirectX::XMVector3Transform(DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), DirectX::XMMatrixRotationRollPitchYaw(0.0f, Camera.Mouse.x, 0.0f));
+			DirectX::XMVECTOR Left = DirectX::XMVector3Transform(DirectX::XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), DirectX::XMMatrixRotationRollPitchYaw(0.0f, Camera.Mouse.x, 0.0f));
 
-			if (App->GetKeyState('W')) Camera.Eye = DirectX::XMVectorAdd(Camera.Eye, DirectX::XMVectorMultiply(SpeedVector, Forward));
-			if (App->GetKeyState('S')) Camera.Eye = DirectX::XMVectorSubtract(Camera.Eye, DirectX::XMVectorMultiply(SpeedVector, Forward));
-			if (App->GetKeyState('D')) Camera.Eye = DirectX::XMVectorAdd(Camera.Eye, DirectX::XMVectorMultiply(SpeedVector, Left));
-			if (App->GetKeyState('A')) Camera.Eye = DirectX::XMVectorSubtract(Camera.Eye, DirectX::XMVectorMultiply(SpeedVector, Left));
-			if (App->GetKeyState('E')) Camera.Eye = DirectX::XMVectorAdd(Camera.Eye, DirectX::XMVectorMultiply(SpeedVector, Camera.Up));
-			if (App->GetKeyState('Q')) Camera.Eye = DirectX::XMVectorSubtract(Camera.Eye, DirectX::XMVectorMultiply(SpeedVector, Camera.Up));
+			if (Input.GetKeyState('W')) Camera.Eye = DirectX::XMVectorAdd(Camera.Eye, DirectX::XMVectorMultiply(SpeedVector, Forward));
+			if (Input.GetKeyState('S')) Camera.Eye = DirectX::XMVectorSubtract(Camera.Eye, DirectX::XMVectorMultiply(SpeedVector, Forward));
+			if (Input.GetKeyState('D')) Camera.Eye = DirectX::XMVectorAdd(Camera.Eye, DirectX::XMVectorMultiply(SpeedVector, Left));
+			if (Input.GetKeyState('A')) Camera.Eye = DirectX::XMVectorSubtract(Camera.Eye, DirectX::XMVectorMultiply(SpeedVector, Left));
+			if (Input.GetKeyState('E')) Camera.Eye = DirectX::XMVectorAdd(Camera.Eye, DirectX::XMVectorMultiply(SpeedVector, Camera.Up));
+			if (Input.GetKeyState('Q')) Camera.Eye = DirectX::XMVectorSubtract(Camera.Eye, DirectX::XMVectorMultiply(SpeedVector, Camera.Up));
 
-			ConstantBufferStruct.World = DirectX::XMMatrixTranspose(DirectX::XMMatrixIdentity());
-			ConstantBufferStruct.View = DirectX::XMMatrixTranspose(DirectX::XMMatrixLookAtLH(Camera.Eye, DirectX::XMVectorAdd(Camera.Eye, Camera.At), Camera.Up));
-			ConstantBufferStruct.Projection = DirectX::XMMatrixTranspose(DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV2, App->GetWidth() / static_cast<float>(App->GetHeight()), 0.01f, 1000.0f));
+			{
+				PROFILE_SCOPE("Transforms");
+				Transforms.Update(&Pool);
+			}
 
-			ConstantBuffer->Update(&ConstantBufferStruct);
-			App->Draw(IndexBuffer->GetIndexCount());
+			{
+				PROFILE_SCOPE("Collision");
 
-			App->EndDraw(0);
+				constexpr float CameraRadius = 0.25f;
+
+				DirectX::XMFLOAT3 Eye;
+				DirectX::XMStoreFloat3(&Eye, Camera.Eye);
+
+				const Engine::BOUNDING_BOX_STRUCT EyeBox = { { Eye.x, Eye.y, Eye.z }, { CameraRadius, CameraRadius, CameraRadius } };
+				Forest.Scene.QueryBox(EyeBox, Forest.Nearby);
+
+				for (const uint32_t Object : Forest.Nearby)
+				{
+					const DirectX::XMMATRIX World = Transforms.GetWorld(Entities.Get<TRANSFORM_COMPONENT_STRUCT>(Forest.Entity[Object])->Transform);
+
+					DirectX::XMFLOAT3 Local;
+					DirectX::XMStoreFloat3(&Local, DirectX::XMVector3Transform(Camera.Eye, DirectX::XMMatrixInverse(nullptr, World)));
+
+					if (ModelMesh.ResolveSphere(&Local.x, CameraRadius))
+					{
+						Camera.Eye = DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&Local), World);
+					}
+				}
+			}
+
+			const DirectX::XMMATRIX View = DirectX::XMMatrixLookAtLH(Camera.Eye, DirectX::XMVectorAdd(Camera.Eye, Camera.At), Camera.Up);
+			const DirectX::XMMATRIX Projection = DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV2, App->GetWidth() / static_cast<float>(App->GetHeight()), 0.01f, 1000.0f);
+
+			Snapshot.FrameBuffer.View = DirectX::XMMatrixTranspose(View);
+			Snapshot.FrameBuffer.Projection = DirectX::XMMatrixTranspose(Projection);
+
+			{
+				DirectX::XMFLOAT4X4 ViewProjection;
+				DirectX::XMStoreFloat4x4(&ViewProjection, DirectX::XMMatrixMultiply(View, Projection));
+
+				if (Input.IsKeyPressed('F'))
+				{
+					DirectX::XMFLOAT3 Origin;
+					DirectX::XMFLOAT3 Direction;
+					DirectX::XMStoreFloat3(&Origin, Camera.Eye);
+					DirectX::XMStoreFloat3(&Direction, DirectX::XMVector3Normalize(Camera.At));
+
+					auto Intersect = [&](uint32_t Object)
+					{
+						const DirectX::XMMATRIX Inverse = DirectX::XMMatrixInverse(nullptr, Transforms.GetWorld(Entities.Get<TRANSFORM_COMPONENT_STRUCT>(Forest.Entity[Object])->Transform));
+
+						DirectX::XMFLOAT3 LocalOrigin;
+						DirectX::XMFLOAT3 LocalDirection;
+						DirectX::XMStoreFloat3(&LocalOrigin, DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&Origin), Inverse));
+						DirectX::XMStoreFloat3(&LocalDirection, DirectX::XMVector3TransformNormal(DirectX::XMLoadFloat3(&Direction), Inverse));
+
+						Engine::MESH_RAY_HIT_STRUCT MeshHit;
+						return ModelMesh.Raycast(&LocalOrigin.x, &LocalDirection.x, 1000.0f, MeshHit) ? MeshHit.Distance : -1.0f;
+					};
+
+					Engine::BVH_RAY_HIT_STRUCT Hit;
+					if (Forest.Scene.Raycast(&Origin.x, &Direction.x, 1000.0f, Hit, Intersect))
+					{
+						Forest.Scene.Remove(Hit.Object);
+						Transforms.Destroy(Entities.Get<TRANSFORM_COMPONENT_STRUCT>(Forest.Entity[Hit.Object])->Transform);
+						Entities.Destroy(Forest.Entity[Hit.Object]);
+					}
+				}
+
+				PROFILE_SCOPE("Culling");
+
+				const size_t VisibleCount = Forest.Scene.QueryFrustum(Engine::ExtractFrustum(&ViewProjection.m[0][0]), Forest.Visible);
+				Telemetry.Set(TelemetryVisible, static_cast<double>(VisibleCount));
+
+				Snapshot.VisibleWorld.clear();
+				for (size_t Index = 0; Index < VisibleCount; Index++)
+				{
+					Snapshot.VisibleWorld.push_back(DirectX::XMMatrixTranspose(Transforms.GetWorld(Entities.Get<TRANSFORM_COMPONENT_STRUCT>(Forest.Entity[Forest.Visible[Index]])->Transform)));
+				}
+			}
+
+			Snapshot.Depth = DirectX::XMVectorGetX(DirectX::XMVector3Length(Camera.Eye)) / 1000.0f;
+
+			Pipeline.End();
+
+			const uint64_t Timestamp = Engine::GetTimestamp();
+			Telemetry.Set(TelemetryFrameTime, (Timestamp - FrameTimestamp) * 1e-6);
+			FrameTimestamp = Timestamp;
+
+			if (Timestamp - TelemetryTimestamp >= 250000000)
+			{
+				TelemetryTimestamp = Timestamp;
+
+				const Engine::APPLICATION_STATISTICS_STRUCT Statistics = App->GetFrameStatistics();
+				Telemetry.Set(TelemetryDrawCount, static_cast<double>(Statistics.Frame.DrawCount));
+				Telemetry.Set(TelemetryFrameTimeP99, Statistics.FrameTimeP99 * 1e3);
+				Telemetry.Set(TelemetryResourceCount, static_cast<double>(Statistics.ResourceCount));
+				Telemetry.Set(TelemetryResourceCreated, static_cast<double>(Statistics.Total.CreateCount));
+				Telemetry.Set(TelemetryResourceCreateTime, Statistics.Total.CreateTime * 1e-6);
+				Telemetry.Set(TelemetryMemory, Engine::GetProcessMemory() / 1048576.0);
+				Telemetry.Set(TelemetryInputDropped, static_cast<double>(App->GetInputQueue().GetDropCount()));
+			}
+
+			Telemetry.Publish(FrameIndex++);
 		}
 	}
 	catch (DWORD ErrorCode)
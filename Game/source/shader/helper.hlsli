@@ -6,6 +6,7 @@ struct VS_STRUCT
 	float3 Position : POSITION;
 	float2 TexCoord : TEXCOORD;
 	float3 Normal : NORMAL;
+	float4x4 World : INSTANCE_WORLD;
 };
 
 struct PS_STRUCT
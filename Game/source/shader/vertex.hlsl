@@ -1,16 +1,21 @@
 #include "helper.hlsli"
 
-cbuffer ConstantBuffer
+cbuffer FrameBuffer : register(b0)
 {
-	matrix World;
 	matrix View;
 	matrix Projection;
 }
 
+cbuffer ObjectBuffer : register(b2)
+{
+	matrix World;
+}
+
 PS_STRUCT main(VS_STRUCT Input)
 {
 	PS_STRUCT Output;
-	Output.Position = mul(float4(Input.Position, 1.0f), World);
+	Output.Position = mul(float4(Input.Position, 1.0f), Input.World);
+	Output.Position = mul(Output.Position, World);
 	Output.Position = mul(Output.Position, View);
 	Output.Position = mul(Output.Position, Projection);
 	Output.TexCoord = Input.TexCoord;
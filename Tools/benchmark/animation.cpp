@@ -0,0 +1,98 @@
+// AnimationClip memory per clip-second against uncompressed transforms,
+// the worst rotation and translation error after decoding, and the cost of
+// Sample and Blend per joint, for a few skeleton sizes.
+
+#include "benchmark.h"
+#include "include/animation.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+
+int main()
+{
+	constexpr float SampleRate = 30.0f;
+	constexpr size_t FrameCount = 121;
+	std::mt19937 Random(1);
+	std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+
+	for (const size_t JointCount : { 30, 61, 120 })
+	{
+		// Every joint swings around its own axis; only the root translates.
+		std::vector<float> Phase(JointCount * 2);
+		for (float& Current : Phase)
+		{
+			Current = Unit(Random) * 3.0f;
+		}
+		std::vector<Engine::JOINT_TRANSFORM_STRUCT> Sample(JointCount * FrameCount);
+		for (size_t Frame = 0; Frame < FrameCount; Frame++)
+		{
+			const float Time = Frame / SampleRate;
+			for (size_t Joint = 0; Joint < JointCount; Joint++)
+			{
+				const float Swing = std::sin(Phase[Joint * 2] + Time * (1 + Joint % 3));
+				const float Turn = Phase[Joint * 2 + 1] + 0.7f * Time;
+				float Axis[3] = { std::cos(Turn), std::sin(Turn), 0.5f * Swing };
+				const float Length = std::sqrt(Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2]);
+				const float Sine = std::sin(Swing * 0.5f) / Length;
+				Sample[Frame * JointCount + Joint] = { { Joint ? 0.0f : Time * 2.0f, Joint * 0.1f, Joint ? 0.0f : std::sin(Time) },
+					{ Axis[0] * Sine, Axis[1] * Sine, Axis[2] * Sine, std::cos(Swing * 0.5f) }, { 1.0f, 1.0f, 1.0f } };
+			}
+		}
+
+		Engine::AnimationClip Clip;
+		Clip.Build(Sample.data(), JointCount, FrameCount, SampleRate);
+		Engine::SkeletonPose Pose(JointCount);
+
+		float RotationError = 0.0f;
+		float TranslationError = 0.0f;
+		for (size_t Frame = 0; Frame < FrameCount; Frame++)
+		{
+			Clip.Sample(Frame / SampleRate, Pose, false);
+			for (uint32_t Joint = 0; Joint < JointCount; Joint++)
+			{
+				const Engine::JOINT_TRANSFORM_STRUCT Local = Pose.GetLocal(Joint);
+				const Engine::JOINT_TRANSFORM_STRUCT& Expected = Sample[Frame * JointCount + Joint];
+				float Dot = 0.0f;
+				for (size_t Component = 0; Component < 4; Component++)
+				{
+					Dot += Local.Rotation[Component] * Expected.Rotation[Component];
+				}
+				RotationError = (std::max)(RotationError, 2.0f * std::acos((std::min)(std::fabs(Dot), 1.0f)) * 57.29578f);
+				for (size_t Component = 0; Component < 3; Component++)
+				{
+					TranslationError = (std::max)(TranslationError, std::fabs(Local.Translation[Component] - Expected.Translation[Component]));
+				}
+			}
+		}
+
+		const double Duration = Clip.GetDuration();
+		const size_t Raw = Sample.size() * sizeof(Engine::JOINT_TRANSFORM_STRUCT);
+		printf("%3zu joints, %.1f s: %7zu bytes, %6.0f bytes per clip-second (raw %6.0f, %.1fx), max error %.3f degrees, %.4f units\n", JointCount, Duration,
+			Clip.GetMemorySize(), Clip.GetMemorySize() / Duration, Raw / Duration, static_cast<double>(Raw) / Clip.GetMemorySize(), RotationError, TranslationError);
+
+		constexpr int SampleCount = 1000;
+		const uint64_t SampleTime = Measure(10, [&]()
+		{
+			for (int Index = 0; Index < SampleCount; Index++)
+			{
+				Clip.Sample(Index * 0.0037f, Pose);
+			}
+		});
+
+		Engine::SkeletonPose Other(JointCount);
+		Clip.Sample(1.7f, Other);
+		const uint64_t BlendTime = Measure(10, [&]()
+		{
+			for (int Index = 0; Index < SampleCount; Index++)
+			{
+				Pose.Blend(Other, 0.3f);
+			}
+		});
+		printf("%3zu joints: Sample %.2f ns per joint, Blend %.2f ns per joint\n", JointCount,
+			static_cast<double>(SampleTime) / SampleCount / JointCount, static_cast<double>(BlendTime) / SampleCount / JointCount);
+	}
+	return 0;
+}
@@ -0,0 +1,81 @@
+// MultiplyMatrices against multiplying every object on its own with
+// XMMatrixMultiply, the way the game built its world-view-projection
+// matrices before. Build against the real DirectXMath headers for numbers
+// that mean anything; a reference stub makes the baseline scalar.
+
+#include "benchmark.h"
+#include "include/platform.h"
+#include "include/batchmath.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+
+int main()
+{
+	std::mt19937 Random(1);
+	std::uniform_real_distribution<float> Value(-2.0f, 2.0f);
+
+	DirectX::XMFLOAT4X4 ViewProjection;
+	for (size_t Row = 0; Row < 4; Row++)
+	{
+		for (size_t Column = 0; Column < 4; Column++)
+		{
+			ViewProjection.m[Row][Column] = Value(Random);
+		}
+	}
+
+	bool Pass = true;
+	for (const size_t Count : { 1000, 10000, 100000 })
+	{
+		std::vector<DirectX::XMFLOAT4X4> World(Count);
+		for (DirectX::XMFLOAT4X4& Current : World)
+		{
+			for (size_t Row = 0; Row < 4; Row++)
+			{
+				for (size_t Column = 0; Column < 4; Column++)
+				{
+					Current.m[Row][Column] = Value(Random);
+				}
+			}
+		}
+
+		std::vector<DirectX::XMFLOAT4X4> Expected(Count);
+		std::vector<DirectX::XMFLOAT4X4> Output(Count);
+		for (const bool Transpose : { false, true })
+		{
+			const uint64_t Single = Measure(10, [&]()
+			{
+				const DirectX::XMMATRIX Right = DirectX::XMLoadFloat4x4(&ViewProjection);
+				for (size_t Index = 0; Index < Count; Index++)
+				{
+					const DirectX::XMMATRIX Matrix = DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&World[Index]), Right);
+					DirectX::XMStoreFloat4x4(&Expected[Index], Transpose ? DirectX::XMMatrixTranspose(Matrix) : Matrix);
+				}
+			});
+			const uint64_t Batch = Measure(10, [&]()
+			{
+				Engine::MultiplyMatrices(&World[0].m[0][0], &ViewProjection.m[0][0], &Output[0].m[0][0], Count, Transpose);
+			});
+
+			float Error = 0.0f;
+			for (size_t Index = 0; Index < Count; Index++)
+			{
+				for (size_t Row = 0; Row < 4; Row++)
+				{
+					for (size_t Column = 0; Column < 4; Column++)
+					{
+						Error = (std::max)(Error, std::fabs(Expected[Index].m[Row][Column] - Output[Index].m[Row][Column]));
+					}
+				}
+			}
+			Pass &= (Error < 1e-4f);
+
+			printf("%6zu matrices%s: XMMatrixMultiply %5.2f ns, MultiplyMatrices %5.2f ns per matrix, speedup %.2fx, max error %g\n", Count, Transpose ? ", transposed" : "",
+				static_cast<double>(Single) / Count, static_cast<double>(Batch) / Count, static_cast<double>(Single) / Batch, Error);
+		}
+	}
+	return Pass ? 0 : 1;
+}
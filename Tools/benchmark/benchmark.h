@@ -0,0 +1,36 @@
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include "include/profiler.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+// Best of Repeat runs in nanoseconds, the minimum filters scheduler noise.
+template<class Function> uint64_t Measure(int Repeat, Function Body)
+{
+	uint64_t Best = UINT64_MAX;
+	for (int Index = 0; Index < Repeat; Index++)
+	{
+		const uint64_t Start = Engine::GetTimestamp();
+		Body();
+		Best = (std::min)(Best, Engine::GetTimestamp() - Start);
+	}
+	return Best;
+}
+
+// Fails the benchmark when the cost per item at Count grew by more than Limit
+// over the cost per item at BaseCount.
+inline bool CheckScaling(const char* Name, double BaseCost, size_t BaseCount, double Cost, size_t Count, double Limit)
+{
+	const double Ratio = Cost / BaseCost;
+	printf("%-32s %zu -> %zu items: %.2fx cost per item\n", Name, BaseCount, Count, Ratio);
+	if (Ratio > Limit)
+	{
+		printf("%-32s scales worse than %.1fx\n", Name, Limit);
+		return false;
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,105 @@
+// SweepAndPrune against SpatialHash on uniform and clustered scenes of 100k
+// moving boxes. Each frame every box drifts a little, all of them are
+// updated and the pairs are found; both must report the same pair count.
+
+#include "benchmark.h"
+#include "include/broadphase.h"
+#include <random>
+#include <vector>
+
+
+
+namespace
+{
+	// Clustered scenes gather the boxes around 32 centers, like crowds or debris piles.
+	std::vector<Engine::BOUNDING_BOX_STRUCT> CreateScene(size_t Count, bool Clustered, float Extent, std::mt19937& Random)
+	{
+		std::uniform_real_distribution<float> Position(-Extent, Extent);
+		std::normal_distribution<float> Spread(0.0f, Extent * 0.03f);
+		std::uniform_real_distribution<float> Size(0.2f, 1.0f);
+
+		std::vector<float> Cluster(32 * 3);
+		for (float& Current : Cluster)
+		{
+			Current = Position(Random);
+		}
+
+		std::vector<Engine::BOUNDING_BOX_STRUCT> Box(Count);
+		for (size_t Index = 0; Index < Count; Index++)
+		{
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				Box[Index].Center[Axis] = Clustered ? Cluster[(Index % 32) * 3 + Axis] + Spread(Random) : Position(Random);
+				Box[Index].Extent[Axis] = Size(Random);
+			}
+		}
+		return Box;
+	}
+}
+
+
+
+int main()
+{
+	constexpr size_t Count = 100000;
+	constexpr int FrameCount = 20;
+	std::mt19937 Random(1);
+	std::uniform_real_distribution<float> Step(-0.1f, 0.1f);
+	Engine::ThreadPool Pool;
+	bool Pass = true;
+
+	for (const bool Clustered : { false, true })
+	{
+		std::vector<Engine::BOUNDING_BOX_STRUCT> Box = CreateScene(Count, Clustered, Clustered ? 400.0f : 250.0f, Random);
+		std::vector<float> Velocity(Count * 3);
+		for (float& Current : Velocity)
+		{
+			Current = Step(Random);
+		}
+
+		Engine::SweepAndPrune Sweep;
+		Engine::SpatialHash Hash;
+		const uint64_t SweepBuild = Measure(1, [&]() { Sweep.Build(Box.data(), Count); });
+		const uint64_t HashBuild = Measure(1, [&]() { Hash.Build(Box.data(), Count); });
+		printf("%s, %zu boxes: build sweep and prune %.2f ms, spatial hash %.2f ms (cell size %.2f)\n", Clustered ? "clustered" : "uniform", Count,
+			SweepBuild * 1e-6, HashBuild * 1e-6, Hash.GetCellSize());
+
+		std::vector<Engine::BROADPHASE_PAIR_STRUCT> Pair;
+		uint64_t Time[2][2] = {};
+		size_t PairCount[2] = {};
+		for (int Frame = 0; Frame < FrameCount; Frame++)
+		{
+			for (size_t Index = 0; Index < Count; Index++)
+			{
+				for (size_t Axis = 0; Axis < 3; Axis++)
+				{
+					Box[Index].Center[Axis] += Velocity[Index * 3 + Axis];
+				}
+			}
+
+			Engine::Broadphase* Phase[2] = { &Sweep, &Hash };
+			for (size_t Current = 0; Current < 2; Current++)
+			{
+				Time[Current][0] += Measure(1, [&]()
+				{
+					for (uint32_t Index = 0; Index < Count; Index++)
+					{
+						Phase[Current]->Update(Index, Box[Index]);
+					}
+				});
+				Time[Current][1] += Measure(1, [&]()
+				{
+					PairCount[Current] = Phase[Current]->FindPairs(Pair, &Pool);
+				});
+			}
+			Pass &= (PairCount[0] == PairCount[1]);
+		}
+
+		const char* Name[2] = { "sweep and prune", "spatial hash" };
+		for (size_t Current = 0; Current < 2; Current++)
+		{
+			printf("  %-16s update %6.2f ms, find pairs %6.2f ms, %zu pairs\n", Name[Current], Time[Current][0] * 1e-6 / FrameCount, Time[Current][1] * 1e-6 / FrameCount, PairCount[Current]);
+		}
+	}
+	return Pass ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// SceneBVH build, refit and query cost at 100k and 1M objects. Each frame moves
+// a fraction of the objects, refits, and runs the first frustum query, which
+// also brings the wide nodes up to date.
+
+#include "benchmark.h"
+#include "include/bvh.h"
+#include <random>
+#include <vector>
+
+
+
+int main()
+{
+	std::mt19937 Random(1);
+	std::uniform_real_distribution<float> Step(-0.5f, 0.5f);
+
+	Engine::FRUSTUM_STRUCT Frustum;
+	const float Plane[6][4] = { { 0.7071f, 0, 0.7071f, 0 }, { -0.7071f, 0, 0.7071f, 0 }, { 0, 0.7071f, 0.7071f, 0 }, { 0, -0.7071f, 0.7071f, 0 }, { 0, 0, 1, -0.1f }, { 0, 0, -1, 200 } };
+	for (size_t Index = 0; Index < 6; Index++)
+	{
+		for (size_t Component = 0; Component < 4; Component++)
+		{
+			Frustum.Plane[Index][Component] = Plane[Index][Component];
+		}
+	}
+
+	for (const size_t Count : { 100000, 1000000 })
+	{
+		const float Scale = 1000.0f * std::cbrt(Count / 1000000.0f);
+		std::uniform_real_distribution<float> Position(-Scale, Scale);
+		std::vector<Engine::BOUNDING_BOX_STRUCT> Box(Count);
+		for (Engine::BOUNDING_BOX_STRUCT& Current : Box)
+		{
+			Current = { { Position(Random), Position(Random), Position(Random) }, { 1.0f, 1.0f, 1.0f } };
+		}
+
+		Engine::SceneBVH Scene;
+		std::vector<uint32_t> Result;
+		const uint64_t Build = Measure(3, [&]()
+		{
+			Scene.Build(Box.data(), Box.size());
+		});
+		const uint64_t Flatten = Measure(1, [&]()
+		{
+			Scene.QueryFrustum(Frustum, Result);
+		});
+		const uint64_t Query = Measure(20, [&]()
+		{
+			Scene.QueryFrustum(Frustum, Result);
+		});
+		printf("%8zu objects: build %8.2f ms, first query %7.2f ms, query %6.3f ms (%zu visible)\n", Count, Build * 1e-6, Flatten * 1e-6, Query * 1e-6, Result.size());
+
+		for (const double Fraction : { 0.01, 1.0 })
+		{
+			const size_t MoveCount = static_cast<size_t>(Count * Fraction);
+			uint64_t Refit = 0;
+			uint64_t FirstQuery = 0;
+			uint64_t Steady = 0;
+			constexpr int FrameCount = 10;
+
+			for (int Frame = 0; Frame < FrameCount; Frame++)
+			{
+				for (size_t Move = 0; Move < MoveCount; Move++)
+				{
+					const size_t Object = MoveCount == Count ? Move : Random() % Count;
+					for (size_t Axis = 0; Axis < 3; Axis++)
+					{
+						Box[Object].Center[Axis] += Step(Random);
+					}
+				}
+
+				const uint64_t Start = Engine::GetTimestamp();
+				for (size_t Move = 0; Move < MoveCount; Move++)
+				{
+					const size_t Object = MoveCount == Count ? Move : Random() % Count;
+					Scene.Update(static_cast<uint32_t>(Object), Box[Object]);
+				}
+				Scene.Refit();
+				const uint64_t Refitted = Engine::GetTimestamp();
+				Scene.QueryFrustum(Frustum, Result);
+				const uint64_t Queried = Engine::GetTimestamp();
+				Scene.QueryFrustum(Frustum, Result);
+
+				Refit += Refitted - Start;
+				FirstQuery += Queried - Refitted;
+				Steady += Engine::GetTimestamp() - Queried;
+			}
+
+			printf("%8zu objects, %5.1f%% moved: update and refit %7.2f ms, first query %7.3f ms, query %6.3f ms\n", Count, Fraction * 100.0,
+				Refit * 1e-6 / FrameCount, FirstQuery * 1e-6 / FrameCount, Steady * 1e-6 / FrameCount);
+		}
+	}
+
+	return 0;
+}
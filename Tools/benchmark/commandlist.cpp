@@ -0,0 +1,145 @@
+// Records draws into command lists on the null backend, serially and from a
+// thread pool, against issuing the same draws on the immediate context.
+
+#include "benchmark.h"
+#include "include/engine.h"
+#include "include/threadpool.h"
+#include <memory>
+#include <random>
+#include <vector>
+
+
+
+struct DRAW_STRUCT
+{
+	Engine::IVertexShader* VertexShader;
+	Engine::IPixelShader* PixelShader;
+	Engine::ITexture* Texture;
+	Engine::IVertexBuffer* VertexBuffer;
+	Engine::IIndexBuffer* IndexBuffer;
+};
+
+static void Record(Engine::ICommandContext* Context, const DRAW_STRUCT* Draw, size_t Count)
+{
+	const DRAW_STRUCT* Last = nullptr;
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		const DRAW_STRUCT& Current = Draw[Index];
+		if (!Last || Current.VertexShader != Last->VertexShader)
+		{
+			Current.VertexShader->Set(Context);
+			Current.PixelShader->Set(Context);
+		}
+		if (!Last || Current.Texture != Last->Texture)
+		{
+			Current.Texture->Set(Context);
+		}
+		if (!Last || Current.VertexBuffer != Last->VertexBuffer)
+		{
+			Current.VertexBuffer->Set(Context);
+			Current.IndexBuffer->Set(Context);
+		}
+		Context->Draw(36);
+		Last = &Current;
+	}
+}
+
+
+
+int main()
+{
+	std::shared_ptr<Engine::IApplication> App = Engine::IApplication::Create(Engine::APPLICATION_BACKEND_NULL, "Benchmark", 0, 0, 1280, 720);
+	std::shared_ptr<Engine::INullApplication> Null = Engine::INullApplication::Get(App);
+	Engine::ThreadPool Pool;
+	const BYTE Bytecode[4] = {};
+	const UINT Index[36] = {};
+	std::mt19937 Random(1);
+
+	std::vector<std::shared_ptr<Engine::IVertexShader>> VertexShader;
+	std::vector<std::shared_ptr<Engine::IPixelShader>> PixelShader;
+	std::vector<std::shared_ptr<Engine::ITexture>> Texture;
+	std::vector<std::shared_ptr<Engine::IVertexBuffer>> VertexBuffer;
+	std::vector<std::shared_ptr<Engine::IIndexBuffer>> IndexBuffer;
+	for (int Shader = 0; Shader < 16; Shader++)
+	{
+		VertexShader.push_back(Engine::IVertexShader::Create(App, Bytecode, sizeof(Bytecode)));
+		PixelShader.push_back(Engine::IPixelShader::Create(App, Bytecode, sizeof(Bytecode)));
+	}
+	for (int Material = 0; Material < 128; Material++)
+	{
+		Texture.push_back(Engine::ITexture::Create(App, nullptr, 1, 1));
+	}
+	for (int Mesh = 0; Mesh < 256; Mesh++)
+	{
+		VertexBuffer.push_back(Engine::IVertexBuffer::Create(App, nullptr, 24, 32));
+		IndexBuffer.push_back(Engine::IIndexBuffer::Create(App, Index, 36));
+	}
+
+	const size_t ListCount = 8;
+	std::vector<std::shared_ptr<Engine::ICommandList>> List;
+	std::vector<Engine::ICommandList*> ListPointer;
+	for (size_t Current = 0; Current < ListCount; Current++)
+	{
+		List.push_back(Engine::ICommandList::Create(App));
+		ListPointer.push_back(List.back().get());
+	}
+
+	printf("%zu worker threads, %zu command lists\n", Pool.GetThreadCount(), ListCount);
+
+	const size_t Count[] = { 10000, 50000, 200000 };
+	constexpr size_t CountSize = sizeof(Count) / sizeof(Count[0]);
+	double RecordCost[CountSize];
+	bool Pass = true;
+
+	for (size_t Size = 0; Size < CountSize; Size++)
+	{
+		std::vector<DRAW_STRUCT> Draw(Count[Size]);
+		for (size_t Current = 0; Current < Draw.size(); Current++)
+		{
+			const size_t Shader = Current * VertexShader.size() / Draw.size();
+			const size_t Mesh = Random() % VertexBuffer.size();
+			Draw[Current] = { VertexShader[Shader].get(), PixelShader[Shader].get(), Texture[Random() % Texture.size()].get(), VertexBuffer[Mesh].get(), IndexBuffer[Mesh].get() };
+		}
+		const size_t Chunk = (Draw.size() + ListCount - 1) / ListCount;
+
+		const uint64_t Immediate = Measure(10, [&]()
+		{
+			Record(App->GetContext(), Draw.data(), Draw.size());
+		});
+
+		const uint64_t Serial = Measure(10, [&]()
+		{
+			for (size_t Current = 0; Current < ListCount; Current++)
+			{
+				const size_t First = (std::min)(Current * Chunk, Draw.size());
+				Record(List[Current]->Begin(), Draw.data() + First, (std::min)(Chunk, Draw.size() - First));
+				List[Current]->End();
+			}
+		});
+
+		const uint64_t Parallel = Measure(10, [&]()
+		{
+			Pool.Dispatch(ListCount, [&](size_t Current)
+			{
+				const size_t First = (std::min)(Current * Chunk, Draw.size());
+				Record(List[Current]->Begin(), Draw.data() + First, (std::min)(Chunk, Draw.size() - First));
+				List[Current]->End();
+			});
+		});
+
+		Null->ResetStatistics();
+		const uint64_t Execute = Measure(10, [&]()
+		{
+			App->Execute(ListPointer.data(), static_cast<UINT>(ListPointer.size()));
+		});
+		const bool Complete = (Null->GetStatistics().DrawCount == Count[Size] * 10);
+
+		RecordCost[Size] = static_cast<double>(Parallel) / Count[Size];
+		printf("%7zu draws: immediate %6.2f ns/draw, record serial %6.2f, record parallel %6.2f, execute %6.2f%s\n", Count[Size],
+			static_cast<double>(Immediate) / Count[Size], static_cast<double>(Serial) / Count[Size], RecordCost[Size], static_cast<double>(Execute) / Count[Size], Complete ? "" : " (draws lost)");
+		Pass &= Complete;
+	}
+	Pass &= CheckScaling("Parallel recording", RecordCost[0], Count[0], RecordCost[CountSize - 1], Count[CountSize - 1], 3.0);
+
+	return Pass ? 0 : 1;
+}
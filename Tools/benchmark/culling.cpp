@@ -0,0 +1,79 @@
+// Frustum culling throughput for boxes and spheres, single threaded and on the thread pool.
+
+#include "benchmark.h"
+#include "include/culling.h"
+#include "include/threadpool.h"
+#include <random>
+#include <vector>
+
+
+
+int main()
+{
+	Engine::ThreadPool Pool;
+	std::mt19937 Random(1);
+	std::uniform_real_distribution<float> Position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> Extent(0.5f, 4.0f);
+
+	// A 90 degree frustum looking down +z from the origin, near 0.1 and far 400.
+	Engine::FRUSTUM_STRUCT Frustum;
+	const float Plane[6][4] = { { 0.7071f, 0, 0.7071f, 0 }, { -0.7071f, 0, 0.7071f, 0 }, { 0, 0.7071f, 0.7071f, 0 }, { 0, -0.7071f, 0.7071f, 0 }, { 0, 0, 1, -0.1f }, { 0, 0, -1, 400 } };
+	for (size_t Index = 0; Index < 6; Index++)
+	{
+		for (size_t Component = 0; Component < 4; Component++)
+		{
+			Frustum.Plane[Index][Component] = Plane[Index][Component];
+		}
+	}
+
+	const size_t Count[] = { 10000, 100000, 1000000 };
+	constexpr size_t CountSize = sizeof(Count) / sizeof(Count[0]);
+	double BoxCost[CountSize];
+	bool Pass = true;
+
+	for (size_t Size = 0; Size < CountSize; Size++)
+	{
+		std::vector<float> Data[6];
+		for (std::vector<float>& Current : Data)
+		{
+			Current.resize(Count[Size]);
+		}
+		for (size_t Index = 0; Index < Count[Size]; Index++)
+		{
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				Data[Axis][Index] = Position(Random);
+				Data[3 + Axis][Index] = Extent(Random);
+			}
+		}
+
+		const Engine::CULL_BOX_STRUCT Box = { Data[0].data(), Data[1].data(), Data[2].data(), Data[3].data(), Data[4].data(), Data[5].data(), Count[Size] };
+		const Engine::CULL_SPHERE_STRUCT Sphere = { Data[0].data(), Data[1].data(), Data[2].data(), Data[3].data(), Count[Size] };
+		std::vector<uint32_t> Visible(Count[Size]);
+		size_t VisibleCount = 0;
+
+		const uint64_t BoxTime = Measure(20, [&]()
+		{
+			VisibleCount = Engine::CullBox(Frustum, Box, Visible.data());
+		});
+		const uint64_t BoxPoolTime = Measure(20, [&]()
+		{
+			Engine::CullBox(Frustum, Box, Visible.data(), &Pool);
+		});
+		const uint64_t SphereTime = Measure(20, [&]()
+		{
+			Engine::CullSphere(Frustum, Sphere, Visible.data());
+		});
+		const uint64_t SpherePoolTime = Measure(20, [&]()
+		{
+			Engine::CullSphere(Frustum, Sphere, Visible.data(), &Pool);
+		});
+
+		BoxCost[Size] = static_cast<double>(BoxTime) / Count[Size];
+		printf("%8zu objects, %5.1f%% visible: box %5.2f ns/object, pool %5.2f; sphere %5.2f ns/object, pool %5.2f\n", Count[Size], 100.0 * VisibleCount / Count[Size],
+			BoxCost[Size], static_cast<double>(BoxPoolTime) / Count[Size], static_cast<double>(SphereTime) / Count[Size], static_cast<double>(SpherePoolTime) / Count[Size]);
+	}
+	Pass &= CheckScaling("CullBox", BoxCost[0], Count[0], BoxCost[CountSize - 1], Count[CountSize - 1], 3.0);
+
+	return Pass ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+// EntityWorld iteration cost against plain std::vector baselines: a lean
+// array of structs holding only the iterated fields and a fat game object
+// with the same fields among others, as an object-oriented engine stores it.
+
+#include "benchmark.h"
+#include "include/ecs.h"
+#include <vector>
+
+
+
+namespace
+{
+	struct POSITION_STRUCT
+	{
+		float X, Y, Z;
+	};
+
+	struct VELOCITY_STRUCT
+	{
+		float X, Y, Z;
+	};
+
+	struct HEALTH_STRUCT
+	{
+		float Value;
+	};
+
+	struct LEAN_STRUCT
+	{
+		POSITION_STRUCT Position;
+		VELOCITY_STRUCT Velocity;
+	};
+
+	struct OBJECT_STRUCT
+	{
+		float World[16];
+		POSITION_STRUCT Position;
+		float Rotation[4];
+		VELOCITY_STRUCT Velocity;
+		HEALTH_STRUCT Health;
+		uint32_t Flags;
+		char Name[32];
+	};
+
+	constexpr float Delta = 1.0f / 60.0f;
+
+	void Integrate(POSITION_STRUCT& Position, const VELOCITY_STRUCT& Velocity)
+	{
+		Position.X += Velocity.X * Delta;
+		Position.Y += Velocity.Y * Delta;
+		Position.Z += Velocity.Z * Delta;
+	}
+}
+
+
+
+int main()
+{
+	constexpr size_t Count = 1000000;
+	Engine::ThreadPool Pool;
+
+	// A quarter of the entities also carry health, so the query spans two archetypes.
+	Engine::EntityWorld World;
+	std::vector<LEAN_STRUCT> Lean(Count);
+	std::vector<OBJECT_STRUCT> Object(Count);
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		const POSITION_STRUCT Position = { static_cast<float>(Index), 0.0f, 0.0f };
+		const VELOCITY_STRUCT Velocity = { 1.0f, 2.0f, 3.0f };
+		if (Index % 4 == 0)
+		{
+			World.Create(Position, Velocity, HEALTH_STRUCT{ 100.0f });
+		}
+		else
+		{
+			World.Create(Position, Velocity);
+		}
+		Lean[Index] = { Position, Velocity };
+		Object[Index] = {};
+		Object[Index].Position = Position;
+		Object[Index].Velocity = Velocity;
+	}
+	World.AddSystem<POSITION_STRUCT, const VELOCITY_STRUCT>(Integrate);
+
+	const uint64_t LeanTime = Measure(10, [&]()
+	{
+		for (LEAN_STRUCT& Current : Lean)
+		{
+			Integrate(Current.Position, Current.Velocity);
+		}
+	});
+	const uint64_t ObjectTime = Measure(10, [&]()
+	{
+		for (OBJECT_STRUCT& Current : Object)
+		{
+			Integrate(Current.Position, Current.Velocity);
+		}
+	});
+	const uint64_t EachTime = Measure(10, [&]()
+	{
+		World.Each<POSITION_STRUCT, const VELOCITY_STRUCT>(Integrate);
+	});
+	const uint64_t ChunkTime = Measure(10, [&]()
+	{
+		World.EachChunk<POSITION_STRUCT, const VELOCITY_STRUCT>([](size_t Size, POSITION_STRUCT* Position, const VELOCITY_STRUCT* Velocity)
+		{
+			for (size_t Row = 0; Row < Size; Row++)
+			{
+				Integrate(Position[Row], Velocity[Row]);
+			}
+		});
+	});
+	const uint64_t SystemTime = Measure(10, [&]()
+	{
+		World.RunSystems();
+	});
+	const uint64_t PoolTime = Measure(10, [&]()
+	{
+		World.RunSystems(&Pool);
+	});
+
+	auto Report = [](const char* Name, uint64_t Time)
+	{
+		printf("%-28s %7.2f ms, %5.2f ns per entity\n", Name, Time * 1e-6, static_cast<double>(Time) / Count);
+	};
+	printf("%zu entities in %zu archetypes\n", World.GetEntityCount(), World.GetArchetypeCount());
+	Report("AoS vector, lean", LeanTime);
+	Report("AoS vector, 128 byte object", ObjectTime);
+	Report("EntityWorld::Each", EachTime);
+	Report("EntityWorld::EachChunk", ChunkTime);
+	Report("EntityWorld::RunSystems", SystemTime);
+	printf("%-28s %7.2f ms on %zu threads\n", "RunSystems with pool", PoolTime * 1e-6, Pool.GetThreadCount());
+
+	double Checksum = 0.0;
+	World.Each<const POSITION_STRUCT>([&](const POSITION_STRUCT& Position)
+	{
+		Checksum += Position.Y;
+	});
+	for (const LEAN_STRUCT& Current : Lean)
+	{
+		Checksum -= Current.Position.Y;
+	}
+	for (const OBJECT_STRUCT& Current : Object)
+	{
+		Checksum += Current.Position.Y;
+	}
+	printf("checksum %.0f\n", Checksum);
+	return 0;
+}
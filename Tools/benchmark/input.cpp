@@ -0,0 +1,96 @@
+// Push and Pop cost of InputQueue, then the latency InputState reports for a
+// stream injected by a producer thread at 1 kHz into 60 Hz simulation steps.
+
+#include "benchmark.h"
+#include "include/input.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+
+
+int main()
+{
+	constexpr int EventCount = 1024;
+	constexpr int Repeat = 1000;
+	bool Pass = true;
+
+	Engine::InputQueue Queue(EventCount);
+	Engine::INPUT_EVENT_STRUCT Event = { 0, Engine::INPUT_EVENT_MOUSE_MOVE, 0, 1, 1 };
+	uint64_t Sum = 0;
+
+	// Push and Pop are timed apart, each over a whole ring, best of Repeat.
+	uint64_t PushTime = UINT64_MAX;
+	uint64_t PopTime = UINT64_MAX;
+	for (int Index = 0; Index < Repeat; Index++)
+	{
+		const uint64_t Start = Engine::GetTimestamp();
+		for (int Push = 0; Push < EventCount; Push++)
+		{
+			Queue.Push(Event);
+		}
+		const uint64_t Middle = Engine::GetTimestamp();
+		Engine::INPUT_EVENT_STRUCT Current;
+		while (Queue.Pop(Current))
+		{
+			Sum += Current.X;
+		}
+		const uint64_t End = Engine::GetTimestamp();
+
+		PushTime = (std::min)(PushTime, Middle - Start);
+		PopTime = (std::min)(PopTime, End - Middle);
+	}
+	Pass &= Queue.GetDropCount() == 0 && Sum == static_cast<uint64_t>(EventCount) * Repeat;
+	printf("InputQueue push                  %5d events %6.2f ns/event\n", EventCount, static_cast<double>(PushTime) / EventCount);
+	printf("InputQueue pop                   %5d events %6.2f ns/event\n", EventCount, static_cast<double>(PopTime) / EventCount);
+
+	Engine::InputState State;
+	const uint64_t UpdateTime = Measure(Repeat, [&]()
+	{
+		for (int Index = 0; Index < EventCount; Index++)
+		{
+			Event.Type = Index & 1 ? Engine::INPUT_EVENT_KEY_UP : Engine::INPUT_EVENT_KEY_DOWN;
+			Event.KeyCode = static_cast<uint8_t>(Index >> 1);
+			Queue.Push(Event);
+		}
+		State.Update(Queue, Engine::GetTimestamp());
+	});
+	Pass &= State.GetEventCount() == EventCount;
+	printf("InputState push and update       %5d events %6.2f ns/event\n", EventCount, static_cast<double>(UpdateTime) / EventCount);
+
+	// Events wait up to one step in the queue, so the mean latency is about half a step.
+	constexpr int StepCount = 60;
+	constexpr auto Step = std::chrono::microseconds(16667);
+	std::atomic<bool> Done{ false };
+	std::thread Producer([&Queue, &Done]()
+	{
+		Engine::INPUT_EVENT_STRUCT Move = { 0, Engine::INPUT_EVENT_MOUSE_MOVE, 0, 1, 0 };
+		while (!Done.load(std::memory_order_relaxed))
+		{
+			Move.Timestamp = Engine::GetTimestamp();
+			Queue.Push(Move);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	uint64_t MaxLatency = 0;
+	uint64_t TotalLatency = 0;
+	size_t TotalCount = 0;
+	State.Update(Queue, Engine::GetTimestamp());
+	for (int Index = 0; Index < StepCount; Index++)
+	{
+		std::this_thread::sleep_for(Step);
+		const size_t Count = State.Update(Queue, Engine::GetTimestamp());
+		MaxLatency = (std::max)(MaxLatency, State.GetMaxLatency());
+		TotalLatency += State.GetMeanLatency() * Count;
+		TotalCount += Count;
+	}
+	Done.store(true, std::memory_order_relaxed);
+	Producer.join();
+
+	const double MeanLatency = TotalCount ? static_cast<double>(TotalLatency) / TotalCount : 0.0;
+	printf("InputState latency at 60 Hz      %5zu events %6.2f ms mean %6.2f ms max\n", TotalCount, MeanLatency * 1e-6, MaxLatency * 1e-6);
+	Pass &= TotalCount > 0 && Queue.GetDropCount() == 0;
+
+	return Pass ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+// MeshBVH build time and ray throughput on heightfield meshes, for coherent
+// camera rays traced one at a time and as packets of four, and for incoherent rays.
+
+#include "benchmark.h"
+#include "include/meshbvh.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+
+int main()
+{
+	Engine::ThreadPool Pool;
+	std::mt19937 Random(1);
+	bool Pass = true;
+
+	for (const uint32_t Size : { 128u, 512u })
+	{
+		std::vector<float> Vertex;
+		std::vector<uint32_t> Index;
+		for (uint32_t Z = 0; Z <= Size; Z++)
+		{
+			for (uint32_t X = 0; X <= Size; X++)
+			{
+				const float U = static_cast<float>(X) / Size;
+				const float V = static_cast<float>(Z) / Size;
+				Vertex.insert(Vertex.end(), { U * 100.0f, 4.0f * std::sin(U * 17.0f) * std::cos(V * 13.0f) + 2.0f * std::sin(U * V * 40.0f), V * 100.0f });
+			}
+		}
+		for (uint32_t Z = 0; Z < Size; Z++)
+		{
+			for (uint32_t X = 0; X < Size; X++)
+			{
+				const uint32_t Corner = Z * (Size + 1) + X;
+				Index.insert(Index.end(), { Corner, Corner + Size + 1, Corner + 1, Corner + 1, Corner + Size + 1, Corner + Size + 2 });
+			}
+		}
+
+		Engine::MeshBVH Mesh;
+		const uint64_t Build = Measure(3, [&]()
+		{
+			Mesh.Build(Vertex.data(), Vertex.size() / 3, sizeof(float) * 3, Index.data(), Index.size());
+		});
+		const uint64_t BuildPool = Measure(3, [&]()
+		{
+			Mesh.Build(Vertex.data(), Vertex.size() / 3, sizeof(float) * 3, Index.data(), Index.size(), &Pool);
+		});
+		printf("%7zu triangles: build %7.2f ms, with pool %7.2f ms\n", Mesh.GetTriangleCount(), Build * 1e-6, BuildPool * 1e-6);
+
+		// A 256x256 camera image looking down at the terrain, packets are 2x2 pixel blocks.
+		constexpr uint32_t Width = 256;
+		std::vector<Engine::MESH_RAY_PACKET_STRUCT> Packet;
+		for (uint32_t Y = 0; Y < Width; Y += 2)
+		{
+			for (uint32_t X = 0; X < Width; X += 2)
+			{
+				Engine::MESH_RAY_PACKET_STRUCT Current;
+				for (uint32_t Ray = 0; Ray < 4; Ray++)
+				{
+					const float PixelX = (X + (Ray & 1) + 0.5f) / Width - 0.5f;
+					const float PixelY = (Y + (Ray >> 1) + 0.5f) / Width - 0.5f;
+					Current.OriginX[Ray] = 50.0f;
+					Current.OriginY[Ray] = 40.0f;
+					Current.OriginZ[Ray] = -20.0f;
+					Current.DirectionX[Ray] = PixelX;
+					Current.DirectionY[Ray] = -0.5f + PixelY;
+					Current.DirectionZ[Ray] = 1.0f;
+					Current.MaxDistance[Ray] = 1000.0f;
+				}
+				Packet.push_back(Current);
+			}
+		}
+		const size_t RayCount = Packet.size() * 4;
+
+		std::vector<Engine::MESH_RAY_HIT_STRUCT> Hit(RayCount);
+		const uint64_t Single = Measure(5, [&]()
+		{
+			for (size_t Current = 0; Current < RayCount; Current++)
+			{
+				const Engine::MESH_RAY_PACKET_STRUCT& Source = Packet[Current / 4];
+				const size_t Ray = Current % 4;
+				const float Origin[3] = { Source.OriginX[Ray], Source.OriginY[Ray], Source.OriginZ[Ray] };
+				const float Direction[3] = { Source.DirectionX[Ray], Source.DirectionY[Ray], Source.DirectionZ[Ray] };
+				Mesh.Raycast(Origin, Direction, Source.MaxDistance[Ray], Hit[Current]);
+			}
+		});
+
+		std::vector<Engine::MESH_RAY_HIT_STRUCT> PacketHit(RayCount);
+		const uint64_t Packed = Measure(5, [&]()
+		{
+			for (size_t Current = 0; Current < Packet.size(); Current++)
+			{
+				Mesh.Raycast4(Packet[Current], PacketHit.data() + Current * 4);
+			}
+		});
+
+		const uint64_t Parallel = Measure(5, [&]()
+		{
+			Pool.ParallelFor(Packet.size(), 256, [&](size_t First, size_t Last)
+			{
+				for (size_t Current = First; Current < Last; Current++)
+				{
+					Mesh.Raycast4(Packet[Current], PacketHit.data() + Current * 4);
+				}
+			});
+		});
+
+		size_t Agree = 0;
+		for (size_t Current = 0; Current < RayCount; Current++)
+		{
+			Agree += (Hit[Current].Triangle == PacketHit[Current].Triangle);
+		}
+		Pass &= (Agree == RayCount);
+
+		std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+		std::vector<float> Incoherent(RayCount * 6);
+		for (size_t Current = 0; Current < RayCount; Current++)
+		{
+			float* Ray = &Incoherent[Current * 6];
+			Ray[0] = 50.0f + Unit(Random) * 50.0f;
+			Ray[1] = 10.0f;
+			Ray[2] = 50.0f + Unit(Random) * 50.0f;
+			Ray[3] = Unit(Random);
+			Ray[4] = -std::fabs(Unit(Random)) - 0.05f;
+			Ray[5] = Unit(Random);
+		}
+		const uint64_t Scattered = Measure(5, [&]()
+		{
+			for (size_t Current = 0; Current < RayCount; Current++)
+			{
+				Mesh.Raycast(&Incoherent[Current * 6], &Incoherent[Current * 6 + 3], 1000.0f, Hit[Current]);
+			}
+		});
+
+		auto Rate = [RayCount](uint64_t Time)
+		{
+			return RayCount / (Time * 1e-9) * 1e-6;
+		};
+		printf("%7zu triangles: coherent %6.2f Mrays/s, packet %6.2f Mrays/s, packet on %zu threads %6.2f Mrays/s, incoherent %6.2f Mrays/s%s\n", Mesh.GetTriangleCount(),
+			Rate(Single), Rate(Packed), Pool.GetThreadCount(), Rate(Parallel), Rate(Scattered), Agree == RayCount ? "" : " (packet hits differ)");
+	}
+
+	return Pass ? 0 : 1;
+}
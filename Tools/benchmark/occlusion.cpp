@@ -0,0 +1,87 @@
+// OcclusionCuller on a street of building walls at 256x128: occluders are
+// rasterised each frame and then 100k boxes scattered behind and between
+// them are tested. Prints the culled percentage and the raster and test
+// time, and writes the depth buffer to build/benchmark/occlusion.tga.
+
+#include "benchmark.h"
+#include "include/occlusion.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+
+int main()
+{
+	constexpr size_t BoxCount = 100000;
+	constexpr int FrameCount = 20;
+	constexpr float Near = 0.1f;
+	constexpr float Far = 1000.0f;
+
+	// Row-major perspective with a 90 degree horizontal field of view at 2:1, eye 10 units above the street.
+	const float ViewProjection[16] = {
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 2.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, Far / (Far - Near), 1.0f,
+		0.0f, -20.0f, -Near * Far / (Far - Near), 0.0f,
+	};
+
+	// Building fronts on both sides of the street and a row of blocks across it further on.
+	std::vector<float> Vertex;
+	std::vector<uint32_t> Index;
+	auto AddWall = [&](float X0, float Z0, float X1, float Z1, float Height)
+	{
+		const uint32_t Base = static_cast<uint32_t>(Vertex.size() / 3);
+		Vertex.insert(Vertex.end(), { X0, Height, Z0, X1, Height, Z1, X0, 0.0f, Z0, X1, 0.0f, Z1 });
+		Index.insert(Index.end(), { Base, Base + 1, Base + 2, Base + 1, Base + 3, Base + 2 });
+	};
+	for (int Block = 0; Block < 20; Block++)
+	{
+		const float Z = 5.0f + Block * 12.0f;
+		AddWall(-6.0f, Z, -6.0f, Z + 10.0f, 15.0f + 5.0f * (Block % 3));
+		AddWall(6.0f, Z, 6.0f, Z + 10.0f, 12.0f + 6.0f * (Block % 2));
+	}
+	AddWall(-60.0f, 120.0f, 60.0f, 120.0f, 25.0f);
+
+	std::mt19937 Random(1);
+	std::uniform_real_distribution<float> X(-80.0f, 80.0f);
+	std::uniform_real_distribution<float> Z(2.0f, 400.0f);
+	std::uniform_real_distribution<float> Size(0.3f, 2.0f);
+	std::vector<float> Center[3];
+	std::vector<float> Extent[3];
+	for (size_t Axis = 0; Axis < 3; Axis++)
+	{
+		Center[Axis].resize(BoxCount);
+		Extent[Axis].resize(BoxCount);
+	}
+	for (size_t Box = 0; Box < BoxCount; Box++)
+	{
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			Extent[Axis][Box] = Size(Random);
+		}
+		Center[0][Box] = X(Random);
+		Center[1][Box] = Extent[1][Box];
+		Center[2][Box] = Z(Random);
+	}
+	const Engine::CULL_BOX_STRUCT Box = { Center[0].data(), Center[1].data(), Center[2].data(), Extent[0].data(), Extent[1].data(), Extent[2].data(), BoxCount };
+
+	Engine::OcclusionCuller Culler(256, 128);
+	Culler.SetViewProjection(ViewProjection);
+	std::vector<uint32_t> Visible(BoxCount);
+	size_t VisibleCount = 0;
+	for (int Frame = 0; Frame < FrameCount; Frame++)
+	{
+		Culler.Clear();
+		Culler.RenderOccluder(Vertex.data(), sizeof(float) * 3, Vertex.size() / 3, Index.data(), Index.size(), nullptr);
+		VisibleCount = Culler.CullBox(Box, nullptr, BoxCount, Visible.data());
+	}
+
+	const Engine::OCCLUSION_REPORT_STRUCT Report = Culler.GetReport();
+	printf("%zu boxes behind %llu occluder triangles at %ux%u: %.1f%% culled (%zu visible)\n", BoxCount, static_cast<unsigned long long>(Report.OccluderTriangleCount / FrameCount),
+		Culler.GetWidth(), Culler.GetHeight(), Report.CullPercent, VisibleCount);
+	printf("  raster %.3f ms, test %.3f ms (%.1f ns per box) per frame\n", Report.RasterTime * 1e3 / FrameCount, Report.TestTime * 1e3 / FrameCount,
+		Report.TestTime * 1e9 / Report.TestCount);
+
+	return Culler.SaveDepth("build/benchmark/occlusion.tga") ? 0 : 1;
+}
@@ -0,0 +1,44 @@
+// ParticleSystem cost per stage for a million particles, serially and on the
+// thread pool. Lifetimes are spread so a frame kills a few percent of the
+// particles and Update has to compact the survivors.
+
+#include "benchmark.h"
+#include "include/particle.h"
+#include <algorithm>
+#include <vector>
+
+
+
+int main()
+{
+	constexpr size_t Count = 1000000;
+	const Engine::PARTICLE_EMITTER_STRUCT Emitter = { { 0.0f, 0.0f, 0.0f }, { 5.0f, 5.0f, 5.0f }, { 0.0f, 2.0f, 0.0f }, { 1.0f, 1.0f, 1.0f }, 0.5f, 0.49f, 0.05f, 0xFFFFFFFF };
+	const float Acceleration[3] = { 0.0f, -9.8f, 0.0f };
+	const float View[16] = { 0.8f, 0.0f, -0.6f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.6f, 0.0f, 0.8f, 0.0f, 0.0f, 0.0f, 10.0f, 1.0f };
+
+	Engine::ParticleSystem System(Count);
+	Engine::ThreadPool Pool;
+	std::vector<Engine::PARTICLE_VERTEX_STRUCT> Vertex(Count * 4);
+	std::vector<uint32_t> Color(Count);
+
+	for (Engine::ThreadPool* Current : { static_cast<Engine::ThreadPool*>(nullptr), &Pool })
+	{
+		uint64_t Emit = ~0ull;
+		uint64_t Update = ~0ull;
+		uint64_t Sort = ~0ull;
+		uint64_t Build = ~0ull;
+		size_t Live = 0;
+		for (int Repeat = 0; Repeat < 10; Repeat++)
+		{
+			System.Clear();
+			Emit = (std::min)(Emit, Measure(1, [&]() { System.Emit(Emitter, Count, Current); }));
+			Update = (std::min)(Update, Measure(1, [&]() { System.Update(1.0f / 60.0f, Acceleration, 0.1f, Current); }));
+			Sort = (std::min)(Sort, Measure(1, [&]() { System.Sort(View, Current); }));
+			Build = (std::min)(Build, Measure(1, [&]() { System.Build(View, Vertex.data(), Color.data(), Current); }));
+			Live = System.GetCount();
+		}
+		printf("%zu particles %s: emit %.2f ms, update %.2f ms (%zu live), sort %.2f ms, build %.2f ms, %.1f ns per particle\n", Count,
+			Current ? "on the pool" : "serial", Emit * 1e-6, Update * 1e-6, Live, Sort * 1e-6, Build * 1e-6, static_cast<double>(Emit + Update + Sort + Build) / Count);
+	}
+	return 0;
+}
@@ -0,0 +1,82 @@
+// FramePipeline throughput and latency against depth on the null backend.
+// Each frame simulates for 3 ms on the calling thread and presents for 3 ms
+// on the render thread, with the present blocking rather than spinning like
+// a vsync wait. Latency runs from the start of a simulated frame to the end
+// of its present.
+
+#include "benchmark.h"
+#include "include/engine.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+
+
+namespace
+{
+	struct SNAPSHOT_STRUCT
+	{
+		uint64_t Start;
+		std::vector<float> Data;
+	};
+
+	void Spin(uint64_t Duration)
+	{
+		const uint64_t Start = Engine::GetTimestamp();
+		while (Engine::GetTimestamp() - Start < Duration)
+		{
+		}
+	}
+}
+
+
+
+int main()
+{
+	constexpr int FrameCount = 200;
+	constexpr uint64_t Simulation = 3000000;
+	constexpr uint64_t Present = 3000000;
+
+	std::shared_ptr<Engine::IApplication> App = Engine::IApplication::Create(Engine::APPLICATION_BACKEND_NULL, "Benchmark", 0, 0, 1280, 720);
+	double Serial = 0.0;
+	bool Pass = true;
+	for (const UINT Depth : { 0u, 1u, 2u, 3u })
+	{
+		uint64_t Latency = 0;
+		Engine::SnapshotPipeline<SNAPSHOT_STRUCT> Pipeline(Depth, [&](const SNAPSHOT_STRUCT& Snapshot)
+		{
+			App->BeginDraw(0.0f, 0.0f, 0.0f, 1.0f);
+			std::this_thread::sleep_for(std::chrono::nanoseconds(Present));
+			App->EndDraw(0);
+			Latency += Engine::GetTimestamp() - Snapshot.Start;
+		});
+
+		const uint64_t Start = Engine::GetTimestamp();
+		for (int Frame = 0; Frame < FrameCount; Frame++)
+		{
+			App->Run();
+			SNAPSHOT_STRUCT& Snapshot = Pipeline.Begin();
+			Snapshot.Start = Engine::GetTimestamp();
+			Snapshot.Data.assign(1000, static_cast<float>(Frame));
+			Spin(Simulation);
+			Pipeline.End();
+		}
+		Pipeline.Flush();
+		const double FrameTime = (Engine::GetTimestamp() - Start) * 1e-6 / FrameCount;
+
+		const Engine::PIPELINE_STATISTICS_STRUCT Statistics = Pipeline.GetStatistics();
+		printf("depth %u: %.2f ms per frame, latency %.2f ms, simulation waited %.1f ms, render waited %.1f ms over %d frames\n", Depth, FrameTime,
+			Latency * 1e-6 / FrameCount, Statistics.SimulationWaitTime * 1000.0, Statistics.RenderWaitTime * 1000.0, FrameCount);
+
+		if (Depth == 0)
+		{
+			Serial = FrameTime;
+		}
+		else if (Depth == 1)
+		{
+			// Overlapping simulation with the present should approach the longer of the two.
+			Pass &= (FrameTime < Serial * 0.75);
+		}
+	}
+	return Pass ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// Sorts and submits render packets through the null backend, so the cost of
+// the queue and of Backend::Flush is measured without a GPU.
+
+#include "benchmark.h"
+#include "include/engine.h"
+#include "include/renderqueue.h"
+#include <memory>
+#include <random>
+#include <vector>
+
+
+
+struct SCENE_STRUCT
+{
+	std::vector<std::shared_ptr<Engine::IVertexShader>> VertexShader;
+	std::vector<std::shared_ptr<Engine::IPixelShader>> PixelShader;
+	std::vector<std::shared_ptr<Engine::ITexture>> Texture;
+	std::vector<std::shared_ptr<Engine::IVertexBuffer>> VertexBuffer;
+	std::vector<std::shared_ptr<Engine::IIndexBuffer>> IndexBuffer;
+};
+
+struct ITEM_STRUCT
+{
+	uint64_t Key;
+	Engine::DRAW_COMMAND_STRUCT Command;
+	float Constant[16];
+};
+
+
+
+static std::vector<ITEM_STRUCT> MakeItem(const SCENE_STRUCT& Scene, size_t Count, std::mt19937& Random)
+{
+	std::uniform_real_distribution<float> Depth(0.0f, 1.0f);
+	std::vector<ITEM_STRUCT> Item(Count);
+
+	for (ITEM_STRUCT& Current : Item)
+	{
+		const uint32_t Shader = Random() % Scene.VertexShader.size();
+		const uint32_t Material = Random() % Scene.Texture.size();
+		const uint32_t Mesh = Random() % Scene.VertexBuffer.size();
+
+		Current.Key = Random() % 8 ? Engine::MakeOpaqueKey(Engine::RENDER_PASS_OPAQUE, Shader, Material, Depth(Random)) : Engine::MakeTransparentKey(Engine::RENDER_PASS_TRANSPARENT, Shader, Material, Depth(Random));
+		Current.Command = {};
+		Current.Command.VertexShader = Scene.VertexShader[Shader].get();
+		Current.Command.PixelShader = Scene.PixelShader[Shader].get();
+		Current.Command.ConstantData = Current.Constant;
+		Current.Command.ConstantDataSize = sizeof(Current.Constant);
+		Current.Command.Texture = Scene.Texture[Material].get();
+		Current.Command.VertexBuffer = Scene.VertexBuffer[Mesh].get();
+		Current.Command.IndexBuffer = Scene.IndexBuffer[Mesh].get();
+		Current.Command.IndexCount = 36;
+	}
+
+	return Item;
+}
+
+
+
+int main()
+{
+	const size_t Count[] = { 1000, 10000, 100000 };
+	constexpr size_t CountSize = sizeof(Count) / sizeof(Count[0]);
+	std::mt19937 Random(1);
+	bool Pass = true;
+
+	double SortCost[CountSize];
+	for (size_t Index = 0; Index < CountSize; Index++)
+	{
+		std::vector<uint64_t> Key(Count[Index]);
+		std::uniform_real_distribution<float> Depth(0.0f, 1.0f);
+		for (uint64_t& Current : Key)
+		{
+			Current = Engine::MakeOpaqueKey(Engine::RENDER_PASS_OPAQUE, Random() % 64, Random() % 256, Depth(Random));
+		}
+
+		Engine::RenderQueue Queue;
+		Queue.Reserve(Count[Index]);
+		const uint64_t Time = Measure(20, [&]()
+		{
+			Queue.Clear();
+			for (size_t Packet = 0; Packet < Key.size(); Packet++)
+			{
+				Queue.Submit(Key[Packet], static_cast<uint32_t>(Packet));
+			}
+			Queue.Sort();
+		});
+
+		SortCost[Index] = static_cast<double>(Time) / Count[Index];
+		printf("RenderQueue submit and sort      %7zu packets %8.3f ms %6.2f ns/packet\n", Count[Index], Time * 1e-6, SortCost[Index]);
+	}
+	Pass &= CheckScaling("RenderQueue submit and sort", SortCost[0], Count[0], SortCost[CountSize - 1], Count[CountSize - 1], 3.0);
+
+	std::shared_ptr<Engine::IApplication> App = Engine::IApplication::Create(Engine::APPLICATION_BACKEND_NULL, "Benchmark", 0, 0, 1280, 720);
+	std::shared_ptr<Engine::INullApplication> Null = Engine::INullApplication::Get(App);
+	const BYTE Bytecode[4] = {};
+	const UINT Index[36] = {};
+
+	SCENE_STRUCT Scene;
+	for (int Shader = 0; Shader < 64; Shader++)
+	{
+		Scene.VertexShader.push_back(Engine::IVertexShader::Create(App, Bytecode, sizeof(Bytecode)));
+		Scene.PixelShader.push_back(Engine::IPixelShader::Create(App, Bytecode, sizeof(Bytecode)));
+	}
+	for (int Material = 0; Material < 256; Material++)
+	{
+		Scene.Texture.push_back(Engine::ITexture::Create(App, nullptr, 1, 1));
+	}
+	for (int Mesh = 0; Mesh < 512; Mesh++)
+	{
+		Scene.VertexBuffer.push_back(Engine::IVertexBuffer::Create(App, nullptr, 24, 32));
+		Scene.IndexBuffer.push_back(Engine::IIndexBuffer::Create(App, Index, 36));
+	}
+
+	double FlushCost[CountSize];
+	for (size_t Size = 0; Size < CountSize; Size++)
+	{
+		const std::vector<ITEM_STRUCT> Item = MakeItem(Scene, Count[Size], Random);
+		Null->ResetStatistics();
+		const uint64_t Time = Measure(10, [&]()
+		{
+			for (const ITEM_STRUCT& Current : Item)
+			{
+				App->Submit(Current.Key, Current.Command);
+			}
+			App->Flush();
+		});
+
+		const Engine::NULL_STATISTICS_STRUCT& Statistics = Null->GetStatistics();
+		FlushCost[Size] = static_cast<double>(Time) / Count[Size];
+		printf("Backend submit and flush         %7zu draws   %8.3f ms %6.2f ns/draw %6.2f binds/draw\n", Count[Size], Time * 1e-6, FlushCost[Size], static_cast<double>(Statistics.BindCount) / Statistics.DrawCount);
+	}
+	Pass &= CheckScaling("Backend submit and flush", FlushCost[0], Count[0], FlushCost[CountSize - 1], Count[CountSize - 1], 3.0);
+
+	return Pass ? 0 : 1;
+}
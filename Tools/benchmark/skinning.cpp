@@ -0,0 +1,95 @@
+// SkinLinear and SkinDualQuaternion throughput in skinned vertices per ms
+// per core, on a 64 joint chain with two influences per vertex, serially and
+// split across the thread pool.
+
+#include "benchmark.h"
+#include "include/animation.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <random>
+#include <vector>
+
+
+
+namespace
+{
+	struct VERTEX_STRUCT
+	{
+		float Position[3];
+		float Texcoord[2];
+		float Normal[3];
+	};
+}
+
+
+
+int main()
+{
+	constexpr size_t JointCount = 64;
+	std::mt19937 Random(1);
+	std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+
+	Engine::Skeleton Skeleton;
+	Engine::SkeletonPose Pose(JointCount);
+	for (uint32_t Joint = 0; Joint < JointCount; Joint++)
+	{
+		float InverseBind[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, -static_cast<float>(Joint), 0, 1 };
+		Skeleton.AddJoint(Joint ? Joint - 1 : Engine::Skeleton::Invalid, InverseBind);
+
+		const float Angle = 0.3f * Unit(Random);
+		const Engine::JOINT_TRANSFORM_STRUCT Local = { { 0.0f, Joint ? 1.0f : 0.0f, 0.0f }, { 0.0f, 0.0f, std::sin(Angle), std::cos(Angle) }, { 1.0f, 1.0f, 1.0f } };
+		Pose.SetLocal(Joint, Local);
+	}
+
+	const uint64_t PoseTime = Measure(10, [&]()
+	{
+		Pose.Update(Skeleton);
+	});
+	printf("%zu joint pose update: %.2f us\n", JointCount, PoseTime * 1e-3);
+
+	constexpr size_t Count = 200000;
+	std::vector<VERTEX_STRUCT> Vertex(Count);
+	std::vector<VERTEX_STRUCT> Output(Count);
+	std::vector<Engine::SKIN_WEIGHT_STRUCT> Weight(Count);
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		const float Height = (JointCount - 1) * (Unit(Random) + 1.0f) * 0.5f;
+		Vertex[Index] = { { Unit(Random) * 0.3f, Height, Unit(Random) * 0.3f }, { 0.5f, 0.5f }, { 1.0f, 0.0f, 0.0f } };
+
+		const uint16_t First = static_cast<uint16_t>((std::min)(static_cast<size_t>(Height), JointCount - 1));
+		const uint16_t Second = static_cast<uint16_t>((std::min)(static_cast<size_t>(First) + 1, JointCount - 1));
+		const float Fraction = Height - First;
+		Weight[Index] = { { First, Second, First, First }, { 1.0f - Fraction, Fraction, 0.0f, 0.0f } };
+	}
+	const Engine::SKIN_STREAM_STRUCT Stream = { Vertex.data(), Weight.data(), Output.data(), Count, sizeof(VERTEX_STRUCT), offsetof(VERTEX_STRUCT, Normal) };
+
+	Engine::ThreadPool Pool;
+	auto Report = [&](const char* Name, uint64_t Serial, uint64_t Parallel)
+	{
+		printf("%-20s %8.0f vertices/ms on 1 core, %8.0f vertices/ms on %zu threads (%.0f per core)\n", Name, Count / (Serial * 1e-6), Count / (Parallel * 1e-6),
+			Pool.GetThreadCount(), Count / (Parallel * 1e-6) / Pool.GetThreadCount());
+	};
+
+	const uint64_t Linear = Measure(10, [&]()
+	{
+		Engine::SkinLinear(Stream, Pose.GetSkinMatrix());
+	});
+	const uint64_t LinearPool = Measure(10, [&]()
+	{
+		Engine::SkinLinear(Stream, Pose.GetSkinMatrix(), &Pool);
+	});
+	Report("SkinLinear", Linear, LinearPool);
+
+	const uint64_t Dual = Measure(10, [&]()
+	{
+		Engine::SkinDualQuaternion(Stream, Pose.GetSkinDualQuaternion());
+	});
+	const uint64_t DualPool = Measure(10, [&]()
+	{
+		Engine::SkinDualQuaternion(Stream, Pose.GetSkinDualQuaternion(), &Pool);
+	});
+	Report("SkinDualQuaternion", Dual, DualPool);
+	return 0;
+}
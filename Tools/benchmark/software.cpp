@@ -0,0 +1,138 @@
+// Software backend throughput on a grid of lit cubes at 1280x720, in
+// triangles and shaded pixels per second for 1 to N rasterizer threads.
+// The last frame is written to build/benchmark/software.tga for inspection.
+
+#include "benchmark.h"
+#include "include/engine.h"
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+
+struct VERTEX_STRUCT
+{
+	float Position[3];
+	float TexCoord[2];
+	float Normal[3];
+};
+
+// Faces seen from outside are clockwise on screen, with U x V pointing into the cube.
+static void CreateCube(std::vector<VERTEX_STRUCT>& Vertex, std::vector<UINT>& Index)
+{
+	const float Face[6][3][3] = {
+		{ { 0, 0, -1 }, { 1, 0, 0 }, { 0, 1, 0 } },
+		{ { 0, 0, 1 }, { -1, 0, 0 }, { 0, 1, 0 } },
+		{ { 1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+		{ { -1, 0, 0 }, { 0, 0, -1 }, { 0, 1, 0 } },
+		{ { 0, 1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+		{ { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, -1 } },
+	};
+	for (const auto& Current : Face)
+	{
+		const UINT Base = static_cast<UINT>(Vertex.size());
+		for (UINT Corner = 0; Corner < 4; Corner++)
+		{
+			const float U = (Corner & 1) ? 0.5f : -0.5f;
+			const float V = (Corner & 2) ? -0.5f : 0.5f;
+			VERTEX_STRUCT Output = { {}, { U + 0.5f, 0.5f - V }, { Current[0][0], Current[0][1], Current[0][2] } };
+			for (UINT Axis = 0; Axis < 3; Axis++)
+			{
+				Output.Position[Axis] = Current[0][Axis] * 0.5f + Current[1][Axis] * U + Current[2][Axis] * V;
+			}
+			Vertex.push_back(Output);
+		}
+		Index.insert(Index.end(), { Base, Base + 1, Base + 2, Base + 1, Base + 3, Base + 2 });
+	}
+}
+
+
+
+int main()
+{
+	constexpr UINT Width = 1280;
+	constexpr UINT Height = 720;
+	constexpr int GridSize = 100;
+
+	std::shared_ptr<Engine::IApplication> App = Engine::IApplication::Create(Engine::APPLICATION_BACKEND_SOFTWARE, "Benchmark", 0, 0, Width, Height);
+	std::shared_ptr<Engine::ISoftwareApplication> Software = Engine::ISoftwareApplication::Get(App);
+
+	std::vector<VERTEX_STRUCT> Vertex;
+	std::vector<UINT> Index;
+	CreateCube(Vertex, Index);
+
+	// Instance and frame matrices are stored transposed, as the game uploads them.
+	std::vector<float> Instance;
+	for (int Z = 0; Z < GridSize; Z++)
+	{
+		for (int X = 0; X < GridSize; X++)
+		{
+			const float Offset[3] = { (X - GridSize / 2) * 1.5f, -4.0f + 0.5f * std::sin(X * 0.7f + Z * 0.3f), 8.0f + Z * 1.5f };
+			Instance.insert(Instance.end(), { 1, 0, 0, Offset[0], 0, 1, 0, Offset[1], 0, 0, 1, Offset[2], 0, 0, 0, 1 });
+		}
+	}
+
+	const float Near = 0.1f;
+	const float Far = 500.0f;
+	const float ScaleY = 1.0f / std::tan(0.5f);
+	const float ScaleX = ScaleY * Height / Width;
+	const float Frame[32] = {
+		1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1,
+		ScaleX, 0, 0, 0, 0, ScaleY, 0, 0, 0, 0, Far / (Far - Near), -Near * Far / (Far - Near), 0, 0, 1, 0,
+	};
+
+	const BYTE Bytecode[4] = {};
+	std::shared_ptr<Engine::IVertexShader> VertexShader = Engine::IVertexShader::Create(App, Bytecode, sizeof(Bytecode));
+	std::shared_ptr<Engine::IPixelShader> PixelShader = Software->CreatePixelShader([](const Engine::SOFTWARE_VARYING_STRUCT& Input, const Engine::SOFTWARE_TEXTURE_STRUCT&)
+	{
+		const float Light = 0.3f + 0.7f * (std::max)(0.0f, Input.Normal.x * 0.3f + Input.Normal.y * 0.8f - Input.Normal.z * 0.5f);
+		return DirectX::XMFLOAT4{ Light * (0.5f + 0.5f * Input.TexCoord.x), Light * (0.5f + 0.5f * Input.TexCoord.y), Light, 1.0f };
+	});
+	std::shared_ptr<Engine::IVertexBuffer> VertexBuffer = Engine::IVertexBuffer::Create(App, Vertex.data(), Vertex.size(), sizeof(VERTEX_STRUCT));
+	std::shared_ptr<Engine::IIndexBuffer> IndexBuffer = Engine::IIndexBuffer::Create(App, Index.data(), Index.size());
+	std::shared_ptr<Engine::IInstanceBuffer> InstanceBuffer = Engine::IInstanceBuffer::Create(App, Instance.data(), GridSize * GridSize, sizeof(float) * 16);
+	std::shared_ptr<Engine::IConstantBuffer> FrameBuffer = Engine::IConstantBuffer::Create(App, sizeof(Frame));
+	FrameBuffer->Update(Frame);
+
+	const UINT Hardware = (std::max)(1u, std::thread::hardware_concurrency());
+	std::vector<UINT> ThreadCount;
+	for (UINT Threads = 1; Threads < Hardware; Threads *= 2)
+	{
+		ThreadCount.push_back(Threads);
+	}
+	ThreadCount.push_back(Hardware);
+
+	printf("%d cubes, %zu triangles per frame at %ux%u\n", GridSize * GridSize, Index.size() / 3 * GridSize * GridSize, Width, Height);
+	double Single = 0.0;
+	for (const UINT Threads : ThreadCount)
+	{
+		Software->SetThreadCount(Threads);
+		Software->ResetStatistics();
+		const uint64_t Time = Measure(5, [&]()
+		{
+			App->BeginDraw(0.1f, 0.1f, 0.15f, 1.0f);
+			VertexShader->Set();
+			PixelShader->Set();
+			FrameBuffer->SetVertexShader();
+			VertexBuffer->Set();
+			IndexBuffer->Set();
+			InstanceBuffer->Set();
+			App->DrawInstanced(static_cast<UINT>(Index.size()), GridSize * GridSize);
+			App->EndDraw(0);
+		});
+
+		const Engine::SOFTWARE_STATISTICS_STRUCT& Statistics = Software->GetStatistics();
+		const double Triangle = static_cast<double>(Statistics.TriangleCount) / Statistics.FrameCount;
+		const double Pixel = static_cast<double>(Statistics.PixelCount) / Statistics.FrameCount;
+		const double Seconds = Time * 1e-9;
+		if (Threads == 1)
+		{
+			Single = Seconds;
+		}
+		printf("  %2u threads: %6.2f ms per frame, %6.2f Mtris/s, %6.2f Mpixels/s (%.0f%% rasterized triangles, %.0f shaded pixels), speedup %.2fx\n", Software->GetThreadCount(),
+			Time * 1e-6, Triangle / Seconds * 1e-6, Pixel / Seconds * 1e-6, 100.0 * Statistics.RasterTriangleCount / Statistics.TriangleCount, Pixel, Single / Seconds);
+	}
+
+	return Software->SaveImage("build/benchmark/software.tga") ? 0 : 1;
+}
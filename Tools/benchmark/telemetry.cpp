@@ -0,0 +1,70 @@
+// Publishes the telemetry segment with as many counters as the game registers
+// and with larger sets, then reads it back the way Tools/telemetry does.
+
+#include "benchmark.h"
+#include "include/telemetry.h"
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+
+
+int main()
+{
+	const uint32_t Count[] = { 12, 64, 1024 };
+	constexpr size_t CountSize = sizeof(Count) / sizeof(Count[0]);
+	constexpr int PublishCount = 10000;
+	const std::string Name = "telemetry_benchmark_" + std::to_string(getpid());
+	bool Pass = true;
+
+	double PublishCost[CountSize];
+	for (size_t Size = 0; Size < CountSize; Size++)
+	{
+		Engine::TelemetryPublisher Publisher(Name.c_str(), Count[Size]);
+		if (!Publisher.IsOpen())
+		{
+			printf("Telemetry segment %s could not be created\n", Name.c_str());
+			return 1;
+		}
+
+		std::vector<uint32_t> Counter;
+		for (uint32_t Index = 0; Index < Count[Size]; Index++)
+		{
+			Counter.push_back(Publisher.Register(("counter." + std::to_string(Index)).c_str()));
+		}
+
+		uint64_t Frame = 0;
+		const uint64_t Time = Measure(20, [&]()
+		{
+			for (int Publish = 0; Publish < PublishCount; Publish++)
+			{
+				for (uint32_t Index : Counter)
+				{
+					Publisher.Set(Index, static_cast<double>(Frame + Index));
+				}
+				Publisher.Publish(++Frame);
+			}
+		});
+
+		Engine::TelemetryReader Reader;
+		std::vector<Engine::TELEMETRY_VALUE_STRUCT> Value;
+		uint64_t ReadFrame = 0;
+		uint64_t ReadTimestamp = 0;
+		bool Read = Reader.Open(Name.c_str());
+		const uint64_t ReadTime = Measure(20, [&]()
+		{
+			for (int Publish = 0; Publish < PublishCount / 10; Publish++)
+			{
+				Read &= Reader.Read(ReadFrame, ReadTimestamp, Value);
+			}
+		});
+		Pass &= Read && Value.size() == Count[Size] && ReadFrame == Frame;
+
+		PublishCost[Size] = static_cast<double>(Time) / PublishCount;
+		printf("Telemetry set and publish        %5u counters %8.1f ns/frame %6.2f ns/counter\n", Count[Size], PublishCost[Size], PublishCost[Size] / Count[Size]);
+		printf("Telemetry read                   %5u counters %8.1f ns/read\n", Count[Size], static_cast<double>(ReadTime) / (PublishCount / 10));
+	}
+	Pass &= CheckScaling("Telemetry set and publish", PublishCost[1] / Count[1], Count[1], PublishCost[CountSize - 1] / Count[CountSize - 1], Count[CountSize - 1], 2.0);
+
+	return Pass ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+// ThreadPool job overhead and ParallelFor scaling. Spawn cost is measured
+// for empty jobs from the owning thread, from inside jobs and from a thread
+// outside the pool; ParallelFor runs a fixed workload on 1 to N workers.
+
+#include "benchmark.h"
+#include "include/threadpool.h"
+#include <cmath>
+#include <thread>
+#include <vector>
+
+
+
+int main()
+{
+	constexpr size_t JobCount = 100000;
+	const size_t Hardware = (std::max)(1u, std::thread::hardware_concurrency());
+
+	{
+		Engine::ThreadPool Pool;
+		const uint64_t Owner = Measure(5, [&]()
+		{
+			Engine::JOB_COUNTER_STRUCT Counter;
+			for (size_t Index = 0; Index < JobCount; Index++)
+			{
+				Pool.Spawn([]() {}, &Counter);
+			}
+			Pool.Wait(Counter);
+		});
+
+		// Each of 100 parents spawns its share of children against the same counter.
+		const uint64_t Nested = Measure(5, [&]()
+		{
+			Engine::JOB_COUNTER_STRUCT Counter;
+			for (size_t Parent = 0; Parent < 100; Parent++)
+			{
+				Pool.Spawn([&Pool, &Counter]()
+				{
+					for (size_t Index = 1; Index < JobCount / 100; Index++)
+					{
+						Pool.Spawn([]() {}, &Counter);
+					}
+				}, &Counter);
+			}
+			Pool.Wait(Counter);
+		});
+
+		const uint64_t Foreign = Measure(5, [&]()
+		{
+			std::thread([&]()
+			{
+				Engine::JOB_COUNTER_STRUCT Counter;
+				for (size_t Index = 0; Index < JobCount; Index++)
+				{
+					Pool.Spawn([]() {}, &Counter);
+				}
+				Pool.Wait(Counter);
+			}).join();
+		});
+
+		printf("spawn+wait of %zu empty jobs on %zu threads: owner %.1f ns, nested %.1f ns, foreign thread %.1f ns per job\n", JobCount, Pool.GetThreadCount(),
+			static_cast<double>(Owner) / JobCount, static_cast<double>(Nested) / JobCount, static_cast<double>(Foreign) / JobCount);
+
+		const uint64_t Dispatch = Measure(5, [&]()
+		{
+			Pool.Dispatch(JobCount, [](size_t) {});
+		});
+		printf("Dispatch of %zu empty indices: %.1f ns per index\n", JobCount, static_cast<double>(Dispatch) / JobCount);
+	}
+
+	constexpr size_t Count = 1 << 22;
+	std::vector<float> Data(Count, 1.0f);
+	auto Work = [&](size_t First, size_t Last)
+	{
+		for (size_t Index = First; Index < Last; Index++)
+		{
+			Data[Index] = std::sqrt(Data[Index] * 1.0001f + 0.5f);
+		}
+	};
+	const uint64_t Serial = Measure(5, [&]()
+	{
+		Work(0, Count);
+	});
+	printf("ParallelFor over %zu elements, serial loop %.2f ms\n", Count, Serial * 1e-6);
+
+	std::vector<size_t> ThreadCount;
+	for (size_t Threads = 1; Threads < Hardware; Threads *= 2)
+	{
+		ThreadCount.push_back(Threads);
+	}
+	ThreadCount.push_back(Hardware);
+	for (const size_t Threads : ThreadCount)
+	{
+		Engine::ThreadPool Pool(Threads);
+		for (const size_t Grain : { 1024, 16384, 262144 })
+		{
+			const uint64_t Time = Measure(5, [&]()
+			{
+				Pool.ParallelFor(Count, Grain, Work);
+			});
+			printf("  %2zu threads, grain %6zu: %7.2f ms, speedup %.2fx\n", Pool.GetThreadCount(), Grain, Time * 1e-6, static_cast<double>(Serial) / Time);
+		}
+	}
+	return 0;
+}
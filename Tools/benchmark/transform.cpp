@@ -0,0 +1,92 @@
+// TransformHierarchy update cost over a million transforms, when 1% of the
+// locals changed and when all of them did, with and without a thread pool.
+
+#include "benchmark.h"
+#include "include/transform.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+
+
+int main()
+{
+	constexpr size_t Count = 1000000;
+	constexpr size_t Fanout = 4;
+
+	// Roots with four children each, down to depth six, like many small scene graphs.
+	Engine::TransformHierarchy Hierarchy;
+	std::vector<uint32_t> Transform;
+	Transform.reserve(Count);
+	const Engine::TRANSFORM_STRUCT Local = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f } };
+	while (Transform.size() < Count)
+	{
+		const size_t Root = Transform.size();
+		Transform.push_back(Hierarchy.Create(Local));
+		for (size_t Current = Root; Current < Transform.size() && Transform.size() < Count; Current++)
+		{
+			if (Transform.size() - Root >= 1365)
+			{
+				break;
+			}
+			for (size_t Child = 0; Child < Fanout && Transform.size() < Count; Child++)
+			{
+				Transform.push_back(Hierarchy.Create(Local, Transform[Current]));
+			}
+		}
+	}
+
+	const uint64_t First = Measure(1, [&]()
+	{
+		Hierarchy.Update();
+	});
+	printf("%zu transforms in %zu levels: first update %.2f ms\n", Hierarchy.GetCount(), Hierarchy.GetLevelCount(), First * 1e-6);
+
+	Engine::ThreadPool Pool;
+	std::mt19937 Random(1);
+	std::uniform_int_distribution<size_t> Pick(0, Count - 1);
+	std::uniform_real_distribution<float> Offset(-1.0f, 1.0f);
+	bool Pass = true;
+	for (const size_t Percent : { 1, 100 })
+	{
+		const size_t Changed = Count * Percent / 100;
+		std::vector<uint32_t> Target(Changed);
+		for (size_t Index = 0; Index < Changed; Index++)
+		{
+			Target[Index] = (Percent == 100 ? Transform[Index] : Transform[Pick(Random)]);
+		}
+
+		uint64_t SetTime = 0;
+		auto Touch = [&]()
+		{
+			const uint64_t Start = Engine::GetTimestamp();
+			for (const uint32_t Current : Target)
+			{
+				const Engine::TRANSFORM_STRUCT Moved = { { Offset(Random), Offset(Random), Offset(Random) }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f } };
+				Hierarchy.SetLocal(Current, Moved);
+			}
+			SetTime = Engine::GetTimestamp() - Start;
+		};
+
+		uint64_t Serial = ~0ull;
+		uint64_t Parallel = ~0ull;
+		for (int Repeat = 0; Repeat < 5; Repeat++)
+		{
+			Touch();
+			Serial = (std::min)(Serial, Measure(1, [&]() { Hierarchy.Update(); }));
+			Touch();
+			Parallel = (std::min)(Parallel, Measure(1, [&]() { Hierarchy.Update(&Pool); }));
+		}
+
+		// An update without changes should only scan the dirty flags.
+		const uint64_t Clean = Measure(5, [&]()
+		{
+			Hierarchy.Update();
+		});
+		printf("%3zu%% dirty (%7zu SetLocal, last %.2f ms): update %7.2f ms, on %zu threads %7.2f ms, %.1f ns per transform; clean update %.2f ms\n",
+			Percent, Changed, SetTime * 1e-6, Serial * 1e-6, Pool.GetThreadCount(), Parallel * 1e-6, static_cast<double>(Serial) / Count, Clean * 1e-6);
+		Pass &= (Clean <= Serial);
+	}
+
+	return Pass ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+// Tails the shared memory telemetry segment published by the game.
+// Built as build/telemetry by make -C Tools; run it next to the game, optionally
+// passing the segment name and the refresh interval in milliseconds.
+
+#include "include/telemetry.h"
+#include "include/profiler.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+
+
+int main(int argc, char* argv[])
+{
+	const char* const Name = argc > 1 ? argv[1] : "game_telemetry";
+	const int Interval = argc > 2 ? atoi(argv[2]) : 250;
+
+	Engine::TelemetryReader Reader;
+	std::vector<Engine::TELEMETRY_VALUE_STRUCT> Value;
+	uint64_t LastFrame = 0;
+	uint64_t LastTimestamp = 0;
+
+	while (true)
+	{
+		uint64_t Frame = 0;
+		uint64_t Timestamp = 0;
+
+		if (!Reader.Read(Frame, Timestamp, Value) && !(Reader.Open(Name) && Reader.Read(Frame, Timestamp, Value)))
+		{
+			printf("\x1b[H\x1b[2JWaiting for %s\n", Name);
+			fflush(stdout);
+			std::this_thread::sleep_for(std::chrono::milliseconds(500));
+			continue;
+		}
+
+		if (Engine::GetTimestamp() - Timestamp > 2000000000)
+		{
+			Reader.Close();
+		}
+
+		const double Rate = Timestamp > LastTimestamp && LastTimestamp ? (Frame - LastFrame) / ((Timestamp - LastTimestamp) * 1e-9) : 0.0;
+		LastFrame = Frame;
+		LastTimestamp = Timestamp;
+
+		printf("\x1b[H\x1b[2J%s  frame %llu  %.1f fps\n\n", Name, static_cast<unsigned long long>(Frame), Rate);
+		for (const Engine::TELEMETRY_VALUE_STRUCT& Current : Value)
+		{
+			printf("%-32s %14.3f\n", Current.Name.c_str(), Current.Value);
+		}
+		fflush(stdout);
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(Interval));
+	}
+}
@@ -0,0 +1,138 @@
+// SceneBVH queries against brute force while objects move, which rotates the
+// binary tree and collapses parts of the wide tree again, and while objects
+// are inserted and removed.
+
+#include "test.h"
+#include "include/bvh.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+
+static bool Overlap(const Engine::BOUNDING_BOX_STRUCT& A, const Engine::BOUNDING_BOX_STRUCT& B)
+{
+	for (size_t Axis = 0; Axis < 3; Axis++)
+	{
+		if (std::fabs(A.Center[Axis] - B.Center[Axis]) > A.Extent[Axis] + B.Extent[Axis])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static float RayDistance(const Engine::BOUNDING_BOX_STRUCT& Box, const float* Origin, const float* Direction)
+{
+	float Enter = 0.0f;
+	float Exit = 1e30f;
+	for (size_t Axis = 0; Axis < 3; Axis++)
+	{
+		const float Inverse = 1.0f / Direction[Axis];
+		float Near = (Box.Center[Axis] - Box.Extent[Axis] - Origin[Axis]) * Inverse;
+		float Far = (Box.Center[Axis] + Box.Extent[Axis] - Origin[Axis]) * Inverse;
+		if (Near > Far)
+		{
+			std::swap(Near, Far);
+		}
+		Enter = (std::max)(Enter, Near);
+		Exit = (std::min)(Exit, Far);
+	}
+	return Enter <= Exit ? Enter : -1.0f;
+}
+
+int main()
+{
+	std::mt19937 Random(11);
+	std::uniform_real_distribution<float> Position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> Size(0.2f, 2.0f);
+	std::uniform_real_distribution<float> Step(-1.0f, 1.0f);
+
+	std::vector<Engine::BOUNDING_BOX_STRUCT> Box(4000);
+	for (Engine::BOUNDING_BOX_STRUCT& Current : Box)
+	{
+		Current = { { Position(Random), Position(Random), Position(Random) }, { Size(Random), Size(Random), Size(Random) } };
+	}
+	std::vector<bool> Live(Box.size(), true);
+
+	Engine::SceneBVH Scene;
+	Scene.Build(Box.data(), Box.size());
+
+	int Mismatch = 0;
+	for (int Round = 0; Round < 200; Round++)
+	{
+		// Most objects jitter, a few teleport across the scene to force rotations.
+		for (int Move = 0; Move < 100; Move++)
+		{
+			const uint32_t Object = Random() % Box.size();
+			if (!Live[Object])
+			{
+				continue;
+			}
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				Box[Object].Center[Axis] = (Move % 10 ? Box[Object].Center[Axis] + Step(Random) : Position(Random));
+			}
+			Scene.Update(Object, Box[Object]);
+		}
+		if (Round % 3 == 0)
+		{
+			Scene.Refit();
+		}
+
+		if (Round % 25 == 24)
+		{
+			const uint32_t Object = Random() % Box.size();
+			if (Live[Object])
+			{
+				Scene.Remove(Object);
+				Live[Object] = false;
+			}
+			Engine::BOUNDING_BOX_STRUCT Inserted = { { Position(Random), Position(Random), Position(Random) }, { 1.0f, 1.0f, 1.0f } };
+			const uint32_t Index = Scene.Insert(Inserted);
+			if (Index >= Box.size())
+			{
+				Box.resize(Index + 1);
+				Live.resize(Index + 1, false);
+			}
+			Box[Index] = Inserted;
+			Live[Index] = true;
+		}
+
+		const Engine::BOUNDING_BOX_STRUCT Query = { { Position(Random), Position(Random), Position(Random) }, { 20.0f, 20.0f, 20.0f } };
+		std::vector<uint32_t> Result;
+		Scene.QueryBox(Query, Result);
+		std::sort(Result.begin(), Result.end());
+
+		std::vector<uint32_t> Expected;
+		for (uint32_t Object = 0; Object < Box.size(); Object++)
+		{
+			if (Live[Object] && Overlap(Box[Object], Query))
+			{
+				Expected.push_back(Object);
+			}
+		}
+		Mismatch += (Result != Expected);
+
+		const float Origin[3] = { Position(Random), Position(Random), -150.0f };
+		float Direction[3] = { Step(Random) * 0.3f, Step(Random) * 0.3f, 1.0f };
+		Engine::BVH_RAY_HIT_STRUCT Hit;
+		const bool Found = Scene.Raycast(Origin, Direction, 1000.0f, Hit);
+
+		float Nearest = 1000.0f;
+		for (uint32_t Object = 0; Object < Box.size(); Object++)
+		{
+			const float Distance = Live[Object] ? RayDistance(Box[Object], Origin, Direction) : -1.0f;
+			if (Distance >= 0.0f && Distance < Nearest)
+			{
+				Nearest = Distance;
+			}
+		}
+		Mismatch += (Found != (Nearest < 1000.0f)) || (Found && std::fabs(Hit.Distance - Nearest) > 1e-3f);
+	}
+
+	CHECK(Mismatch == 0);
+	CHECK(Scene.GetObjectCount() == static_cast<size_t>(std::count(Live.begin(), Live.end(), true)));
+	return Report("bvh");
+}
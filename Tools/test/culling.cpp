@@ -0,0 +1,105 @@
+// Every culling lane width, SIMD and scalar tail, must agree with a plain reference.
+
+#include "test.h"
+#include "include/culling.h"
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+
+
+static bool Reference(const Engine::FRUSTUM_STRUCT& Frustum, const float* Center, const float* Extent)
+{
+	for (const float* Plane : Frustum.Plane)
+	{
+		const float Distance = Center[0] * Plane[0] + Center[1] * Plane[1] + Center[2] * Plane[2] + Plane[3];
+		const float Radius = Extent[0] * std::fabs(Plane[0]) + Extent[1] * std::fabs(Plane[1]) + Extent[2] * std::fabs(Plane[2]);
+		if (Distance + Radius < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	Engine::FRUSTUM_STRUCT Frustum;
+	const float Plane[6][4] = { { 1, 0, 0, 10 }, { -1, 0, 0, 10 }, { 0, 1, 0, 10 }, { 0, -1, 0, 10 }, { 0, 0, 1, 0 }, { 0, 0, -1, 100 } };
+	for (size_t Index = 0; Index < 6; Index++)
+	{
+		for (size_t Component = 0; Component < 4; Component++)
+		{
+			Frustum.Plane[Index][Component] = Plane[Index][Component];
+		}
+	}
+
+	std::mt19937 Random(3);
+	std::uniform_real_distribution<float> Position(-40.0f, 120.0f);
+	std::uniform_real_distribution<float> Size(0.0f, 5.0f);
+	const float NaN = std::numeric_limits<float>::quiet_NaN();
+
+	for (const size_t Count : { 1, 3, 4, 7, 8, 13, 31, 1000, 40000 })
+	{
+		std::vector<float> Center[3];
+		std::vector<float> Extent[3];
+		for (size_t Axis = 0; Axis < 3; Axis++)
+		{
+			Center[Axis].resize(Count);
+			Extent[Axis].resize(Count);
+		}
+
+		for (size_t Index = 0; Index < Count; Index++)
+		{
+			for (size_t Axis = 0; Axis < 3; Axis++)
+			{
+				Center[Axis][Index] = Position(Random);
+				Extent[Axis][Index] = Size(Random);
+			}
+			if (Index % 5 == 2)
+			{
+				Center[Index % 3][Index] = NaN;
+			}
+		}
+
+		std::vector<uint32_t> Expected;
+		for (size_t Index = 0; Index < Count; Index++)
+		{
+			const float CurrentCenter[3] = { Center[0][Index], Center[1][Index], Center[2][Index] };
+			const float CurrentExtent[3] = { Extent[0][Index], Extent[1][Index], Extent[2][Index] };
+			if (Reference(Frustum, CurrentCenter, CurrentExtent))
+			{
+				Expected.push_back(static_cast<uint32_t>(Index));
+			}
+		}
+
+		std::vector<uint32_t> Visible(Count);
+		const Engine::CULL_BOX_STRUCT Box = { Center[0].data(), Center[1].data(), Center[2].data(), Extent[0].data(), Extent[1].data(), Extent[2].data(), Count };
+		Visible.resize(Engine::CullBox(Frustum, Box, Visible.data()));
+		CHECK(Visible == Expected);
+
+		Visible.assign(Count, 0);
+		const Engine::CULL_SPHERE_STRUCT Sphere = { Center[0].data(), Center[1].data(), Center[2].data(), Extent[0].data(), Count };
+		Visible.resize(Engine::CullSphere(Frustum, Sphere, Visible.data()));
+		std::vector<uint32_t> ExpectedSphere;
+		for (size_t Index = 0; Index < Count; Index++)
+		{
+			const float CurrentCenter[3] = { Center[0][Index], Center[1][Index], Center[2][Index] };
+			const float CurrentExtent[3] = { Extent[0][Index], 0.0f, 0.0f };
+			bool Inside = true;
+			for (const float* Current : Frustum.Plane)
+			{
+				const float Distance = CurrentCenter[0] * Current[0] + CurrentCenter[1] * Current[1] + CurrentCenter[2] * Current[2] + Current[3];
+				Inside = Inside && !(Distance + CurrentExtent[0] < 0.0f);
+			}
+			if (Inside)
+			{
+				ExpectedSphere.push_back(static_cast<uint32_t>(Index));
+			}
+		}
+		CHECK(Visible == ExpectedSphere);
+	}
+
+	return Report("culling");
+}
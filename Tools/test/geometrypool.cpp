@@ -0,0 +1,168 @@
+// Geometry pool churn on the null backend: live meshes never overlap, removed
+// handles are rejected, and compaction leaves one free region per buffer.
+
+#include "test.h"
+#include "include/engine.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+
+
+struct LIVE_STRUCT
+{
+	UINT Mesh;
+	UINT VertexCount;
+	UINT IndexCount;
+};
+
+static bool CheckOverlap(Engine::IGeometryPool* Pool, const std::vector<LIVE_STRUCT>& Live)
+{
+	std::vector<std::pair<UINT, UINT>> Vertex;
+	std::vector<std::pair<UINT, UINT>> Index;
+	for (const LIVE_STRUCT& Current : Live)
+	{
+		const Engine::GEOMETRY_MESH_STRUCT Mesh = Pool->GetMesh(Current.Mesh);
+		if (Mesh.IndexCount != Current.IndexCount)
+		{
+			return false;
+		}
+		Vertex.push_back({ static_cast<UINT>(Mesh.BaseVertex), static_cast<UINT>(Mesh.BaseVertex) + Current.VertexCount });
+		Index.push_back({ Mesh.StartIndex, Mesh.StartIndex + Current.IndexCount });
+	}
+
+	for (std::vector<std::pair<UINT, UINT>>* Range : { &Vertex, &Index })
+	{
+		std::sort(Range->begin(), Range->end());
+		for (size_t Current = 1; Current < Range->size(); Current++)
+		{
+			if ((*Range)[Current - 1].second > (*Range)[Current].first)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void TestStress(std::shared_ptr<Engine::IApplication> App)
+{
+	constexpr UINT VertexCapacity = 1 << 16;
+	constexpr UINT IndexCapacity = 1 << 18;
+	std::shared_ptr<Engine::IGeometryPool> Pool = Engine::IGeometryPool::Create(App, VertexCapacity, 32, IndexCapacity);
+	std::vector<LIVE_STRUCT> Live;
+	std::vector<UINT> Removed;
+	std::mt19937 Random(7);
+	int FullCount = 0;
+	bool Overlap = false;
+
+	CHECK(Pool->GetIndexBuffer()->GetIndexCount() == IndexCapacity);
+
+	for (int Step = 0; Step < 20000; Step++)
+	{
+		if (Live.empty() || Random() % 3)
+		{
+			const UINT VertexCount = 1 + Random() % 600;
+			const UINT IndexCount = 3 * (1 + Random() % 1000);
+			try
+			{
+				const UINT Mesh = Pool->Add(nullptr, VertexCount, nullptr, IndexCount);
+				Live.push_back({ Mesh, VertexCount, IndexCount });
+				Removed.erase(std::remove(Removed.begin(), Removed.end(), Mesh), Removed.end());
+			}
+			catch (HRESULT Result)
+			{
+				CHECK(Result == E_OUTOFMEMORY);
+				FullCount++;
+
+				const size_t Index = Random() % Live.size();
+				Pool->Remove(Live[Index].Mesh);
+				Removed.push_back(Live[Index].Mesh);
+				Live[Index] = Live.back();
+				Live.pop_back();
+			}
+		}
+		else
+		{
+			const size_t Index = Random() % Live.size();
+			Pool->Remove(Live[Index].Mesh);
+			Removed.push_back(Live[Index].Mesh);
+			Live[Index] = Live.back();
+			Live.pop_back();
+		}
+
+		if (Step % 1000 == 999)
+		{
+			Overlap |= !CheckOverlap(Pool.get(), Live);
+			if (Step % 5000 == 4999)
+			{
+				Pool->Compact();
+				Overlap |= !CheckOverlap(Pool.get(), Live);
+			}
+		}
+	}
+
+	CHECK(!Overlap);
+	CHECK(FullCount > 0);
+	CHECK(Pool->GetReport().MeshCount == Live.size());
+	for (const UINT Mesh : Removed)
+	{
+		CHECK_THROW(Pool->GetMesh(Mesh), E_INVALIDARG);
+	}
+	CHECK_THROW(Pool->GetMesh(0xFFFFFF), E_INVALIDARG);
+}
+
+static void TestFragmentationReport(std::shared_ptr<Engine::IApplication> App)
+{
+	std::shared_ptr<Engine::IGeometryPool> Pool = Engine::IGeometryPool::Create(App, 4096, 32, 4096);
+	std::vector<UINT> Mesh;
+	for (int Index = 0; Index < 32; Index++)
+	{
+		Mesh.push_back(Pool->Add(nullptr, 64, nullptr, 96));
+	}
+
+	Engine::GEOMETRY_REPORT_STRUCT Report = Pool->GetReport();
+	CHECK(Report.MeshCount == 32);
+	CHECK(Report.Vertex.TotalFree == 4096 - 32 * 64);
+	CHECK(Report.Index.TotalFree == 4096 - 32 * 96);
+	CHECK(Report.Vertex.FreeRegionCount == 1);
+	CHECK(Report.Vertex.Fragmentation == 0.0f);
+
+	// Every other mesh removed leaves holes that no single large mesh fits in.
+	for (size_t Index = 0; Index < Mesh.size(); Index += 2)
+	{
+		Pool->Remove(Mesh[Index]);
+	}
+	Report = Pool->GetReport();
+	CHECK(Report.MeshCount == 16);
+	CHECK(Report.Vertex.TotalFree == 4096 - 16 * 64);
+	CHECK(Report.Vertex.FreeRegionCount == 17);
+	CHECK(Report.Vertex.LargestFree == 4096 - 32 * 64);
+	CHECK(Report.Vertex.Fragmentation == 1.0f - 2048.0f / 3072.0f);
+	CHECK(Report.Index.FreeRegionCount == 17);
+	CHECK(Report.Index.Fragmentation > 0.0f);
+	CHECK_THROW(Pool->Add(nullptr, 3000, nullptr, 96), E_OUTOFMEMORY);
+
+	Pool->Compact();
+	Report = Pool->GetReport();
+	CHECK(Report.MeshCount == 16);
+	CHECK(Report.Vertex.TotalFree == 4096 - 16 * 64);
+	CHECK(Report.Vertex.FreeRegionCount == 1);
+	CHECK(Report.Vertex.LargestFree == Report.Vertex.TotalFree);
+	CHECK(Report.Vertex.Fragmentation == 0.0f);
+	CHECK(Report.Index.FreeRegionCount == 1);
+	CHECK(Pool->GetMesh(Mesh[1]).BaseVertex == 0);
+	CHECK(Pool->GetMesh(Mesh[3]).BaseVertex == 64);
+	CHECK(Pool->GetMesh(Mesh[3]).StartIndex == 96);
+	CHECK(Pool->GetMesh(Pool->Add(nullptr, 3000, nullptr, 96)).IndexCount == 96);
+}
+
+
+
+int main()
+{
+	std::shared_ptr<Engine::IApplication> App = Engine::IApplication::Create(Engine::APPLICATION_BACKEND_NULL, "Test", 0, 0, 64, 64);
+	TestStress(App);
+	TestFragmentationReport(App);
+	return Report("geometrypool");
+}
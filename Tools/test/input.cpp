@@ -0,0 +1,156 @@
+// InputQueue and InputState: events come out in push order across the wrap of
+// the ring, pushes into a full ring are dropped and counted, edges within one
+// step are all reported, and a producer thread loses nothing to the consumer.
+
+#include "test.h"
+#include "include/input.h"
+#include <thread>
+
+
+
+static Engine::INPUT_EVENT_STRUCT MakeKey(Engine::INPUT_EVENT_TYPE Type, uint8_t KeyCode, uint64_t Timestamp)
+{
+	return { Timestamp, Type, KeyCode, 0, 0 };
+}
+
+static Engine::INPUT_EVENT_STRUCT MakeMove(int32_t X, int32_t Y, uint64_t Timestamp)
+{
+	return { Timestamp, Engine::INPUT_EVENT_MOUSE_MOVE, 0, X, Y };
+}
+
+
+
+int main()
+{
+	// Capacities round up to a power of two.
+	CHECK(Engine::InputQueue(1).GetCapacity() == 2);
+	CHECK(Engine::InputQueue(5).GetCapacity() == 8);
+	CHECK(Engine::InputQueue().GetCapacity() == 1024);
+
+	// Ordering across many wraps of an 8 event ring.
+	{
+		Engine::InputQueue Queue(8);
+		Engine::INPUT_EVENT_STRUCT Event;
+		CHECK(!Queue.Pop(Event));
+
+		uint64_t Pushed = 0;
+		uint64_t Popped = 0;
+		bool Ordered = true;
+		for (int Round = 0; Round < 100; Round++)
+		{
+			for (int Index = 0; Index < 5; Index++)
+			{
+				CHECK(Queue.Push(MakeMove(static_cast<int32_t>(Pushed++), 0, 0)));
+			}
+			while (Queue.Pop(Event))
+			{
+				Ordered &= Event.X == static_cast<int32_t>(Popped++);
+			}
+		}
+		CHECK(Ordered);
+		CHECK(Popped == Pushed);
+		CHECK(Queue.GetDropCount() == 0);
+	}
+
+	// A full ring drops new events and keeps the old ones.
+	{
+		Engine::InputQueue Queue(4);
+		for (int32_t Index = 0; Index < 4; Index++)
+		{
+			CHECK(Queue.Push(MakeMove(Index, 0, 0)));
+		}
+		CHECK(!Queue.Push(MakeMove(4, 0, 0)));
+		CHECK(!Queue.Push(MakeMove(5, 0, 0)));
+		CHECK(Queue.GetDropCount() == 2);
+
+		Engine::INPUT_EVENT_STRUCT Event;
+		for (int32_t Index = 0; Index < 4; Index++)
+		{
+			CHECK(Queue.Pop(Event) && Event.X == Index);
+		}
+		CHECK(!Queue.Pop(Event));
+		CHECK(Queue.Push(MakeMove(6, 0, 0)));
+		CHECK(Queue.GetDropCount() == 2);
+	}
+
+	// Edges, held keys, mouse sums and latency of one step.
+	{
+		Engine::InputQueue Queue(16);
+		Engine::InputState State;
+
+		Queue.Push(MakeKey(Engine::INPUT_EVENT_KEY_DOWN, 'W', 100));
+		Queue.Push(MakeKey(Engine::INPUT_EVENT_KEY_DOWN, 'P', 200));
+		Queue.Push(MakeKey(Engine::INPUT_EVENT_KEY_UP, 'P', 300));
+		Queue.Push(MakeMove(3, -1, 400));
+		Queue.Push(MakeMove(2, -4, 500));
+		CHECK(State.Update(Queue, 1000) == 5);
+		CHECK(State.GetEventCount() == 5);
+		CHECK(State.GetKeyState('W') && State.IsKeyPressed('W') && !State.IsKeyReleased('W'));
+		CHECK(!State.GetKeyState('P') && State.IsKeyPressed('P') && State.IsKeyReleased('P'));
+		CHECK(State.GetMouseDirectionX() == 5);
+		CHECK(State.GetMouseDirectionY() == -5);
+		CHECK(State.GetMaxLatency() == 900);
+		CHECK(State.GetMeanLatency() == 700);
+
+		// Held keys keep their state without edges, repeats do not press again.
+		Queue.Push(MakeKey(Engine::INPUT_EVENT_KEY_DOWN, 'W', 1100));
+		CHECK(State.Update(Queue, 1200) == 1);
+		CHECK(State.GetKeyState('W') && !State.IsKeyPressed('W'));
+		CHECK(!State.IsKeyPressed('P') && !State.IsKeyReleased('P'));
+		CHECK(State.GetMouseDirectionX() == 0 && State.GetMouseDirectionY() == 0);
+
+		// Release and press again within one step reports both edges and stays down.
+		Queue.Push(MakeKey(Engine::INPUT_EVENT_KEY_UP, 'W', 1300));
+		Queue.Push(MakeKey(Engine::INPUT_EVENT_KEY_DOWN, 'W', 1400));
+		CHECK(State.Update(Queue, 1500) == 2);
+		CHECK(State.GetKeyState('W') && State.IsKeyPressed('W') && State.IsKeyReleased('W'));
+
+		// Events stamped after the step count as no latency.
+		Queue.Push(MakeMove(1, 1, 2000));
+		CHECK(State.Update(Queue, 1600) == 1);
+		CHECK(State.GetMaxLatency() == 0 && State.GetMeanLatency() == 0);
+
+		CHECK(State.Update(Queue, 1700) == 0);
+		CHECK(State.GetMeanLatency() == 0);
+	}
+
+	// A producer thread retrying pushes into a small ring while the consumer
+	// drains it: every event arrives once and in order.
+	{
+		constexpr int32_t EventCount = 200000;
+		Engine::InputQueue Queue(64);
+		std::thread Producer([&Queue]()
+		{
+			for (int32_t Index = 0; Index < EventCount; Index++)
+			{
+				while (!Queue.Push(MakeMove(Index, 1, 0)))
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		Engine::INPUT_EVENT_STRUCT Event;
+		int32_t Next = 0;
+		bool Ordered = true;
+		while (Next < EventCount)
+		{
+			if (Queue.Pop(Event))
+			{
+				Ordered &= Event.X == Next && Event.Y == 1;
+				Next++;
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+		Producer.join();
+
+		CHECK(Ordered);
+		CHECK(!Queue.Pop(Event));
+		CHECK(Next == EventCount);
+	}
+
+	return Report("input");
+}
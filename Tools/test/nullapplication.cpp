@@ -0,0 +1,85 @@
+// Scripted frames on the null backend: a main.cpp style loop consumes the
+// input script through InputState, draws every frame, and stops when Run()
+// runs out of script. The recorded counters must match what the script did.
+
+#include "test.h"
+#include "include/engine.h"
+#include <memory>
+#include <vector>
+
+
+
+int main()
+{
+	constexpr int FrameCount = 120;
+	constexpr UINT ObjectCount = 10;
+
+	std::shared_ptr<Engine::IApplication> App = Engine::IApplication::Create(Engine::APPLICATION_BACKEND_NULL, "Test", 0, 0, 1280, 720);
+	std::shared_ptr<Engine::INullApplication> Null = Engine::INullApplication::Get(App);
+	CHECK(Null != nullptr);
+
+	// W is held for frames 0-29, P is tapped on frame 30 and 31 and the mouse moves right on frames 40-59.
+	for (int Frame = 0; Frame < FrameCount; Frame++)
+	{
+		Engine::NULL_INPUT_STRUCT Input = {};
+		Input.KeyState['W'] = Frame < 30;
+		Input.KeyState['P'] = Frame == 30 || Frame == 32;
+		Input.MouseDirectionX = (Frame >= 40 && Frame < 60) ? 5 : 0;
+		Null->PushInput(Input);
+	}
+
+	const BYTE Bytecode[4] = {};
+	const UINT Index[36] = {};
+	std::shared_ptr<Engine::IVertexShader> VertexShader = Engine::IVertexShader::Create(App, Bytecode, sizeof(Bytecode));
+	std::shared_ptr<Engine::IPixelShader> PixelShader = Engine::IPixelShader::Create(App, Bytecode, sizeof(Bytecode));
+	std::shared_ptr<Engine::IVertexBuffer> VertexBuffer = Engine::IVertexBuffer::Create(App, nullptr, 24, 32);
+	std::shared_ptr<Engine::IIndexBuffer> IndexBuffer = Engine::IIndexBuffer::Create(App, Index, 36);
+	Null->ResetStatistics();
+
+	Engine::InputState Input;
+	int Frame = 0;
+	int Forward = 0;
+	int Pressed = 0;
+	int Released = 0;
+	int MouseX = 0;
+	while (App->Run())
+	{
+		Input.Update(App->GetInputQueue(), Engine::GetTimestamp());
+		CHECK(Input.GetKeyState('W') == App->GetKeyState('W'));
+
+		Forward += Input.GetKeyState('W');
+		Pressed += Input.IsKeyPressed('P');
+		Released += Input.IsKeyReleased('P');
+		MouseX += Input.GetMouseDirectionX();
+
+		App->BeginDraw(0.0f, 0.0f, 0.0f, 1.0f);
+		VertexShader->Set();
+		PixelShader->Set();
+		VertexBuffer->Set();
+		IndexBuffer->Set();
+		for (UINT Object = 0; Object < ObjectCount; Object++)
+		{
+			App->Draw(36);
+		}
+		App->EndDraw(1);
+		Frame++;
+	}
+
+	const Engine::NULL_STATISTICS_STRUCT& Statistics = Null->GetStatistics();
+	CHECK(Frame == FrameCount);
+	CHECK(!App->Run());
+	CHECK(Forward == 30);
+	CHECK(Pressed == 2);
+	CHECK(Released == 2);
+	CHECK(MouseX == 100);
+	CHECK(Statistics.DrawCount == FrameCount * ObjectCount);
+	CHECK(Statistics.IndexCount == FrameCount * ObjectCount * 36);
+
+	// Frame statistics count the intervals between presents and report the last frame on its own.
+	const Engine::APPLICATION_STATISTICS_STRUCT FrameStatistics = App->GetFrameStatistics();
+	CHECK(FrameStatistics.FrameCount == FrameCount - 1);
+	CHECK(FrameStatistics.Frame.DrawCount == ObjectCount);
+	CHECK(FrameStatistics.Total.DrawCount == FrameCount * ObjectCount);
+
+	return Report("nullapplication");
+}
@@ -0,0 +1,72 @@
+// OcclusionCuller against a wall covering the left half of the view: boxes
+// behind it are culled, boxes beside or in front of it are kept, and boxes
+// crossing the near plane are kept however large they project.
+
+#include "test.h"
+#include "include/occlusion.h"
+#include <cstdio>
+
+
+
+int main()
+{
+	// Row-major perspective with a 90 degree field of view, near 0.1 and far 100.
+	constexpr float Near = 0.1f;
+	constexpr float Far = 100.0f;
+	const float ViewProjection[16] = {
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, Far / (Far - Near), 1.0f,
+		0.0f, 0.0f, -Near * Far / (Far - Near), 0.0f,
+	};
+
+	// The wall spans x in [-5, 0] and y in [-5, 5] at z = 5, the left half of the screen.
+	const float Wall[4][3] = { { -5.0f, 5.0f, 5.0f }, { 0.0f, 5.0f, 5.0f }, { -5.0f, -5.0f, 5.0f }, { 0.0f, -5.0f, 5.0f } };
+	const uint32_t Index[6] = { 0, 1, 2, 1, 3, 2 };
+
+	Engine::OcclusionCuller Culler(128, 64);
+	Culler.SetViewProjection(ViewProjection);
+	Culler.Clear();
+	Culler.RenderOccluder(Wall, sizeof(Wall[0]), 4, Index, 6, nullptr);
+
+	CHECK(!Culler.TestBox({ { -3.0f, 0.0f, 20.0f }, { 0.5f, 0.5f, 0.5f } }));
+	CHECK(Culler.TestBox({ { 5.0f, 0.0f, 20.0f }, { 0.5f, 0.5f, 0.5f } }));
+	CHECK(Culler.TestBox({ { -1.0f, 0.0f, 20.0f }, { 2.0f, 0.5f, 0.5f } }));
+	CHECK(Culler.TestBox({ { -3.0f, 0.0f, 2.0f }, { 0.5f, 0.5f, 0.5f } }));
+	CHECK(!Culler.TestBox({ { 1000.0f, 0.0f, 20.0f }, { 0.5f, 0.5f, 0.5f } }));
+
+	// Every corner has a positive w, but the box reaches in front of the near plane and fills the screen.
+	CHECK(Culler.TestBox({ { 0.0f, 0.0f, 1.00001f }, { 1e5f, 1e5f, 0.99998f } }));
+	CHECK(Culler.TestBox({ { -3.0f, 0.0f, 0.05f }, { 0.5f, 0.5f, 0.5f } }));
+	// Large but entirely beyond the near plane, so the screen bounds are clamped rather than cast out of range.
+	CHECK(Culler.TestBox({ { 0.0f, 0.0f, 20.0f }, { 1e7f, 1e7f, 1.0f } }));
+
+	const Engine::OCCLUSION_REPORT_STRUCT Statistics = Culler.GetReport();
+	CHECK(Statistics.OccluderTriangleCount == 2);
+	CHECK(Statistics.TestCount == 8);
+	CHECK(Statistics.CullCount == 2);
+	CHECK(Statistics.CullPercent == 25.0f);
+
+	// The wall is 5 units away and the rest of the buffer is cleared to the far plane.
+	const float* Depth = Culler.GetDepth();
+	const float WallDepth = (Far / (Far - Near) * 5.0f - Near * Far / (Far - Near)) / 5.0f;
+	CHECK(Depth[32 * 128 + 16] > WallDepth - 1e-4f && Depth[32 * 128 + 16] < WallDepth + 1e-4f);
+	CHECK(Depth[32 * 128 + 100] == 1.0f);
+
+	const char* FileName = "build/occlusion.tga";
+	CHECK(Culler.SaveDepth(FileName));
+	FILE* File = fopen(FileName, "rb");
+	CHECK(File != nullptr);
+	if (File)
+	{
+		unsigned char Header[18] = {};
+		CHECK(fread(Header, 1, sizeof(Header), File) == sizeof(Header));
+		CHECK(Header[2] == 3 && Header[12] == 128 && Header[14] == 64 && Header[16] == 8);
+		fclose(File);
+		remove(FileName);
+	}
+
+	Culler.ResetReport();
+	CHECK(Culler.GetReport().TestCount == 0);
+	return Report("occlusion");
+}
@@ -0,0 +1,173 @@
+// Profiler frame trees and trace export: nested scopes, merging of repeated
+// siblings, several threads, ring slots of exited threads being reused, JSON
+// escaping and the per-thread ring keeping only its most recent events.
+
+#include "test.h"
+#include "include/profiler.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+
+static void Record(const char* Name, int Count)
+{
+	for (int Index = 0; Index < Count; Index++)
+	{
+		PROFILE_SCOPE(Name);
+	}
+}
+
+static uint32_t GetThreadIndex()
+{
+	Engine::Profiler::NextFrame();
+	Record("Probe", 1);
+	Engine::Profiler::NextFrame();
+
+	std::vector<Engine::PROFILE_NODE_STRUCT> Node;
+	Engine::Profiler::GetFrame(Node);
+	return Node.size() == 1 ? Node[0].Thread : Engine::Profiler::Invalid;
+}
+
+static std::string Load(const char* FileName)
+{
+	std::string Text;
+	FILE* File = fopen(FileName, "rb");
+	if (File)
+	{
+		char Buffer[4096];
+		size_t Size;
+		while ((Size = fread(Buffer, 1, sizeof(Buffer), File)) > 0)
+		{
+			Text.append(Buffer, Size);
+		}
+		fclose(File);
+	}
+	return Text;
+}
+
+static size_t CountOf(const std::string& Text, const char* Pattern)
+{
+	size_t Count = 0;
+	for (size_t Position = Text.find(Pattern); Position != std::string::npos; Position = Text.find(Pattern, Position + 1))
+	{
+		Count++;
+	}
+	return Count;
+}
+
+
+
+int main()
+{
+	// Scopes recorded before the first frame boundary are not reported.
+	Record("Before", 1);
+	Engine::Profiler::NextFrame();
+
+	{
+		PROFILE_SCOPE("A");
+		Record("B", 2);
+		{
+			PROFILE_SCOPE("C");
+			Record("D", 1);
+		}
+	}
+	Record("E", 1);
+	{
+		PROFILE_SCOPE("A");
+		Record("B", 1);
+		Record("F", 1);
+	}
+
+	std::thread Worker([]()
+	{
+		for (int Index = 0; Index < 2; Index++)
+		{
+			PROFILE_SCOPE("Job");
+			Record("Step", 1);
+		}
+	});
+	Worker.join();
+
+	Engine::Profiler::NextFrame();
+
+	std::vector<Engine::PROFILE_NODE_STRUCT> Node;
+	CHECK(Engine::Profiler::GetFrame(Node) > 0.0);
+	CHECK(Node.size() == 8);
+	if (Node.size() == 8)
+	{
+		// A merges both instances, its children B, C and F follow it before E.
+		const char* Name[8] = { "A", "B", "C", "D", "F", "E", "Job", "Step" };
+		const uint32_t Parent[8] = { Engine::Profiler::Invalid, 0, 0, 2, 0, Engine::Profiler::Invalid, Engine::Profiler::Invalid, 6 };
+		const uint32_t Depth[8] = { 0, 1, 1, 2, 1, 0, 0, 1 };
+		const uint32_t Count[8] = { 2, 3, 1, 1, 1, 1, 2, 2 };
+		for (int Index = 0; Index < 8; Index++)
+		{
+			CHECK(strcmp(Node[Index].Name, Name[Index]) == 0);
+			CHECK(Node[Index].Parent == Parent[Index]);
+			CHECK(Node[Index].Depth == Depth[Index]);
+			CHECK(Node[Index].Count == Count[Index]);
+			CHECK(Node[Index].Time > 0.0);
+		}
+
+		CHECK(Node[0].Time >= Node[1].Time + Node[2].Time + Node[4].Time);
+		CHECK(Node[2].Time >= Node[3].Time);
+		CHECK(Node[0].Thread == Node[5].Thread);
+		CHECK(Node[6].Thread != Node[0].Thread);
+		CHECK(Node[7].Thread == Node[6].Thread);
+
+		// A new thread takes over the ring of the exited worker.
+		uint32_t Reused = Engine::Profiler::Invalid;
+		std::thread Next([&Reused]() { Reused = GetThreadIndex(); });
+		Next.join();
+		CHECK(Reused == Node[6].Thread);
+	}
+
+	// Disabled scopes still nest but record nothing.
+	Engine::Profiler::SetEnabled(false);
+	CHECK(!Engine::Profiler::IsEnabled());
+	Engine::Profiler::NextFrame();
+	Record("Disabled", 4);
+	Engine::Profiler::NextFrame();
+	Engine::Profiler::GetFrame(Node);
+	CHECK(Node.empty());
+	Engine::Profiler::SetEnabled(true);
+
+	// Quotes and backslashes are escaped, control characters dropped, and
+	// the ring of a thread only keeps its last 64K events.
+	constexpr int EventCapacity = 1 << 16;
+	std::thread Overflow([]()
+	{
+		Engine::Profiler::SetThreadName("Worker \"1\"\\");
+		Record("Quote\" Slash\\ Tab\t", 1);
+		Record("Overflow", EventCapacity + 100);
+	});
+	Overflow.join();
+	Engine::Profiler::SetThreadName("Main");
+
+	const char* FileName = "build/profiler.json";
+	CHECK(Engine::Profiler::SaveTrace(FileName));
+	const std::string Text = Load(FileName);
+	CHECK(Text.compare(0, 16, "{\"traceEvents\":[") == 0);
+	CHECK(Text.find("],\"displayTimeUnit\":\"ms\"}") != std::string::npos);
+	CHECK(CountOf(Text, "\"name\":\"thread_name\"") == 2);
+	CHECK(CountOf(Text, "\"args\":{\"name\":\"Main\"}") == 1);
+	CHECK(CountOf(Text, "\"args\":{\"name\":\"Worker \\\"1\\\"\\\\\"}") == 1);
+	CHECK(CountOf(Text, "\"name\":\"Quote\\\" Slash\\\\ Tab\"") == 0);
+	CHECK(CountOf(Text, "\"name\":\"Overflow\"") == EventCapacity);
+	CHECK(CountOf(Text, "\"name\":\"Before\"") == 1);
+	CHECK(Text.find('\t') == std::string::npos);
+
+	// The escaped name survives in a ring that is not overwritten.
+	std::thread Escape([]()
+	{
+		Record("Quote\" Slash\\ Tab\t", 1);
+	});
+	Escape.join();
+	CHECK(Engine::Profiler::SaveTrace(FileName));
+	CHECK(CountOf(Load(FileName), "\"name\":\"Quote\\\" Slash\\\\ Tab\"") == 1);
+
+	return Report("profiler");
+}
@@ -0,0 +1,113 @@
+// RingAllocator and FencedRing against a fake fence that the test advances by hand.
+
+#include "test.h"
+#include "include/platform.h"
+#include "include/ringallocator.h"
+#include <memory>
+
+
+
+static void TestRingAllocator()
+{
+	Engine::RingAllocator Ring(1024, 256);
+	CHECK(Ring.GetCapacity() == 1024);
+	CHECK(Ring.Allocate(1) == 0);
+	CHECK(Ring.Allocate(256) == 256);
+	Ring.EndFrame(0);
+	CHECK(Ring.Allocate(300) == 512);
+	Ring.EndFrame(1);
+	CHECK(Ring.GetUsed() == 1024);
+	CHECK(Ring.GetPendingFrameCount() == 2);
+
+	// Full until frame 0 retires, then the next allocation wraps to its space.
+	CHECK(Ring.Allocate(1) == Engine::RingAllocator::Invalid);
+	Ring.Retire(0);
+	CHECK(Ring.Allocate(1) == Engine::RingAllocator::Invalid);
+	Ring.Retire(1);
+	CHECK(Ring.GetPendingFrameCount() == 1);
+	CHECK(Ring.GetUsed() == 512);
+	CHECK(Ring.Allocate(512) == 0);
+	CHECK(Ring.Allocate(1) == Engine::RingAllocator::Invalid);
+	Ring.EndFrame(2);
+
+	// Wrapping past the end of the buffer wastes the tail, which retires with the frame.
+	Ring.Retire(2);
+	CHECK(Ring.GetUsed() == 512);
+	CHECK(Ring.Allocate(256) == 512);
+	Ring.EndFrame(3);
+	Ring.Retire(3);
+	CHECK(Ring.Allocate(512) == 0);
+	CHECK(Ring.GetUsed() == 1024);
+	Ring.EndFrame(4);
+	Ring.Retire(5);
+	CHECK(Ring.GetUsed() == 0);
+	CHECK(Ring.GetPendingFrameCount() == 0);
+
+	CHECK(Ring.Allocate(2048) == Engine::RingAllocator::Invalid);
+	Ring.Reset();
+	CHECK(Ring.Allocate(1024) == 0);
+}
+
+static void TestFencedRing()
+{
+	std::shared_ptr<Engine::FRAME_FENCE_STRUCT> Fence = std::make_shared<Engine::FRAME_FENCE_STRUCT>();
+	int FlushCount = 0;
+	Engine::FencedRing Ring(Fence, 1000, 256, true, [&FlushCount]() { FlushCount++; });
+	bool Discard = false;
+
+	CHECK(Ring.GetCapacity() == 1024);
+	CHECK(Ring.Allocate(256, Discard) == 0);
+	CHECK(Discard);
+	CHECK(Ring.Allocate(256, Discard) == 256);
+	CHECK(!Discard);
+	CHECK(FlushCount == 0);
+
+	// Frame 0 is still on the GPU: frame 1 fills the rest, then overflows.
+	Fence->Current = 1;
+	CHECK(Ring.Allocate(512, Discard) == 512);
+	CHECK(!Discard);
+	CHECK(Ring.Allocate(256, Discard) == 0);
+	CHECK(Discard);
+	CHECK(FlushCount == 1);
+	CHECK(Ring.GetUsed() == 256);
+
+	// Once frames 1 and 2 complete, frame 3 wraps around without discarding.
+	Fence->Current = 2;
+	CHECK(Ring.Allocate(512, Discard) == 256);
+	CHECK(!Discard);
+	Fence->Current = 3;
+	Fence->Completed = 2;
+	CHECK(Ring.Allocate(256, Discard) == 768);
+	CHECK(Ring.GetUsed() == 768);
+	Fence->Completed = 3;
+	CHECK(Ring.Allocate(512, Discard) == 0);
+	CHECK(!Discard);
+	CHECK(Ring.GetUsed() == 768);
+	CHECK(FlushCount == 1);
+
+	CHECK_THROW(Ring.Allocate(2048, Discard), E_OUTOFMEMORY);
+	CHECK(FlushCount == 2);
+
+	// Without no-overwrite every allocation discards and flushes what came before.
+	Engine::FencedRing DiscardRing(Fence, 1024, 256, false, [&FlushCount]() { FlushCount++; });
+	CHECK(DiscardRing.Allocate(16, Discard) == 0);
+	CHECK(Discard);
+	CHECK(FlushCount == 2);
+	CHECK(DiscardRing.Allocate(16, Discard) == 0);
+	CHECK(Discard);
+	CHECK(FlushCount == 3);
+
+	Engine::FencedRing Unflushed(Fence, 256, 256, true);
+	CHECK(Unflushed.Allocate(256, Discard) == 0);
+	CHECK(Unflushed.Allocate(256, Discard) == 0);
+	CHECK(Discard);
+}
+
+
+
+int main()
+{
+	TestRingAllocator();
+	TestFencedRing();
+	return Report("ringallocator");
+}
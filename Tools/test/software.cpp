@@ -0,0 +1,134 @@
+// Software backend coverage and depth on known quads: a quad spanning pixel
+// edges covers exactly the pixels whose centers it contains, a nearer quad
+// wins over a farther one whatever the draw order, and the image round-trips
+// through SaveImage.
+
+#include "test.h"
+#include "include/engine.h"
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+
+
+struct VERTEX_STRUCT
+{
+	float Position[3];
+	float TexCoord[2];
+	float Normal[3];
+};
+
+static constexpr UINT Size = 64;
+
+// A quad between the pixel edges Left and Right, Top and Bottom at clip depth Z.
+static std::shared_ptr<Engine::IVertexBuffer> CreateQuad(std::shared_ptr<Engine::IApplication> App, float Left, float Top, float Right, float Bottom, float Z)
+{
+	auto X = [](float Pixel) { return Pixel / Size * 2.0f - 1.0f; };
+	auto Y = [](float Pixel) { return 1.0f - Pixel / Size * 2.0f; };
+	const VERTEX_STRUCT Vertex[4] = {
+		{ { X(Left), Y(Top), Z }, { 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } },
+		{ { X(Right), Y(Top), Z }, { 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } },
+		{ { X(Left), Y(Bottom), Z }, { 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } },
+		{ { X(Right), Y(Bottom), Z }, { 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } },
+	};
+	return Engine::IVertexBuffer::Create(App, Vertex, 4, sizeof(VERTEX_STRUCT));
+}
+
+static size_t CountColor(const uint32_t* Color, uint32_t Value, UINT Left, UINT Top, UINT Right, UINT Bottom)
+{
+	size_t Count = 0;
+	for (UINT Y = Top; Y < Bottom; Y++)
+	{
+		for (UINT X = Left; X < Right; X++)
+		{
+			Count += (Color[Y * Size + X] == Value);
+		}
+	}
+	return Count;
+}
+
+
+
+int main()
+{
+	std::shared_ptr<Engine::IApplication> App = Engine::IApplication::Create(Engine::APPLICATION_BACKEND_SOFTWARE, "Test", 0, 0, Size, Size);
+	std::shared_ptr<Engine::ISoftwareApplication> Software = Engine::ISoftwareApplication::Get(App);
+	CHECK(Software != nullptr);
+
+	const BYTE Bytecode[4] = {};
+	const UINT Index[6] = { 0, 1, 2, 1, 3, 2 };
+	std::shared_ptr<Engine::IVertexShader> VertexShader = Engine::IVertexShader::Create(App, Bytecode, sizeof(Bytecode));
+	std::shared_ptr<Engine::IIndexBuffer> IndexBuffer = Engine::IIndexBuffer::Create(App, Index, 6);
+	auto Solid = [&](float R, float G, float B)
+	{
+		return Software->CreatePixelShader([=](const Engine::SOFTWARE_VARYING_STRUCT&, const Engine::SOFTWARE_TEXTURE_STRUCT&) { return DirectX::XMFLOAT4{ R, G, B, 1.0f }; });
+	};
+	std::shared_ptr<Engine::IPixelShader> Red = Solid(1.0f, 0.0f, 0.0f);
+	std::shared_ptr<Engine::IPixelShader> Green = Solid(0.0f, 1.0f, 0.0f);
+	std::shared_ptr<Engine::IPixelShader> Blue = Solid(0.0f, 0.0f, 1.0f);
+	constexpr uint32_t Black = 0xFF000000;
+	constexpr uint32_t RedColor = 0xFF0000FF;
+	constexpr uint32_t GreenColor = 0xFF00FF00;
+	constexpr uint32_t BlueColor = 0xFFFF0000;
+
+	std::shared_ptr<Engine::IVertexBuffer> Middle = CreateQuad(App, 16.0f, 16.0f, 48.0f, 48.0f, 0.5f);
+	std::shared_ptr<Engine::IVertexBuffer> Behind = CreateQuad(App, 8.0f, 8.0f, 56.0f, 56.0f, 0.75f);
+	std::shared_ptr<Engine::IVertexBuffer> Front = CreateQuad(App, 40.0f, 40.0f, 60.5f, 60.5f, 0.25f);
+
+	auto Draw = [&](Engine::IVertexBuffer* Quad, Engine::IPixelShader* Shader)
+	{
+		VertexShader->Set();
+		Shader->Set();
+		Quad->Set();
+		IndexBuffer->Set();
+		App->Draw(6);
+	};
+
+	for (UINT ThreadCount : { 1u, 4u })
+	{
+		Software->SetThreadCount(ThreadCount);
+
+		// Exact coverage of a single quad.
+		Software->ResetStatistics();
+		App->BeginDraw(0.0f, 0.0f, 0.0f, 1.0f);
+		Draw(Middle.get(), Red.get());
+		App->EndDraw(0);
+		const uint32_t* Color = Software->GetColor();
+		CHECK(CountColor(Color, RedColor, 16, 16, 48, 48) == 32 * 32);
+		CHECK(CountColor(Color, Black, 0, 0, Size, Size) == Size * Size - 32 * 32);
+		CHECK(Software->GetStatistics().TriangleCount == 2);
+		CHECK(Software->GetStatistics().PixelCount == 32 * 32);
+
+		// The farther quad drawn last only fills what the middle one leaves and the nearer one covers both;
+		// its right and bottom edges pass through pixel centers, which the top-left rule leaves uncovered.
+		App->BeginDraw(0.0f, 0.0f, 0.0f, 1.0f);
+		Draw(Middle.get(), Red.get());
+		Draw(Behind.get(), Green.get());
+		Draw(Front.get(), Blue.get());
+		App->EndDraw(0);
+		Color = Software->GetColor();
+		CHECK(CountColor(Color, RedColor, 16, 16, 48, 48) == 32 * 32 - 8 * 8);
+		CHECK(CountColor(Color, BlueColor, 40, 40, 61, 61) == 20 * 20);
+		CHECK(CountColor(Color, GreenColor, 0, 0, Size, Size) == 48 * 48 - 32 * 32 - (16 * 16 - 8 * 8));
+		CHECK(CountColor(Color, Black, 0, 0, 8, Size) == 8 * Size);
+	}
+
+	const char* FileName = "build/software.tga";
+	CHECK(Software->SaveImage(FileName));
+	FILE* File = fopen(FileName, "rb");
+	CHECK(File != nullptr);
+	if (File)
+	{
+		BYTE Header[18] = {};
+		BYTE Pixel[4] = {};
+		CHECK(fread(Header, 1, sizeof(Header), File) == sizeof(Header));
+		CHECK(Header[2] == 2 && Header[12] == Size && Header[14] == Size && Header[16] == 32);
+		fseek(File, 18 + (20 * Size + 20) * 4, SEEK_SET);
+		CHECK(fread(Pixel, 1, sizeof(Pixel), File) == sizeof(Pixel));
+		CHECK(Pixel[0] == 0 && Pixel[1] == 0 && Pixel[2] == 0xFF && Pixel[3] == 0xFF);
+		fclose(File);
+		remove(FileName);
+	}
+
+	return Report("software");
+}
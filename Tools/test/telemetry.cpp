@@ -0,0 +1,101 @@
+// TelemetryPublisher and TelemetryReader over a shared memory segment: counter
+// registration, snapshots of a published frame, and a reader racing a
+// publisher never seeing a frame torn across the sequence lock.
+
+#include "test.h"
+#include "include/telemetry.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+
+
+int main()
+{
+	const std::string Name = "telemetry_test_" + std::to_string(getpid());
+	constexpr uint32_t Capacity = 256;
+	std::vector<Engine::TELEMETRY_VALUE_STRUCT> Value;
+	uint64_t Frame = 0;
+	uint64_t Timestamp = 0;
+
+	Engine::TelemetryReader Reader;
+	CHECK(!Reader.Open(Name.c_str()));
+	CHECK(!Reader.Read(Frame, Timestamp, Value));
+
+	Engine::TelemetryPublisher Publisher(Name.c_str(), Capacity);
+	CHECK(Publisher.IsOpen());
+
+	std::vector<uint32_t> Counter;
+	for (uint32_t Index = 0; Index < Capacity; Index++)
+	{
+		Counter.push_back(Publisher.Register(("counter." + std::to_string(Index)).c_str()));
+		CHECK(Counter.back() == Index);
+	}
+	CHECK(Publisher.Register("overflow") == Engine::TelemetryPublisher::Invalid);
+
+	// Set only stages values until Publish.
+	CHECK(Reader.Open(Name.c_str()));
+	Publisher.Set(Counter[3], 3.5);
+	CHECK(Reader.Read(Frame, Timestamp, Value));
+	CHECK(Value.size() == Capacity);
+	CHECK(Frame == 0);
+	CHECK(Value.size() == Capacity && Value[3].Name == "counter.3" && Value[3].Value == 0.0);
+
+	Publisher.Publish(1);
+	CHECK(Reader.Read(Frame, Timestamp, Value));
+	CHECK(Frame == 1);
+	CHECK(Timestamp != 0);
+	CHECK(Value.size() == Capacity && Value[3].Value == 3.5);
+
+	// Every counter of frame F holds F + Index, so a snapshot mixing two frames shows up.
+	constexpr uint64_t FrameCount = 200000;
+	std::atomic<bool> Done{ false };
+	std::thread Writer([&]()
+	{
+		for (uint64_t Current = 2; Current <= FrameCount; Current++)
+		{
+			for (uint32_t Index : Counter)
+			{
+				Publisher.Set(Index, static_cast<double>(Current + Index));
+			}
+			Publisher.Publish(Current);
+		}
+		Done.store(true, std::memory_order_release);
+	});
+
+	uint64_t ReadCount = 0;
+	uint64_t TornCount = 0;
+	uint64_t LastFrame = 0;
+	bool Ordered = true;
+	while (!Done.load(std::memory_order_acquire))
+	{
+		if (!Reader.Read(Frame, Timestamp, Value))
+		{
+			continue;
+		}
+
+		ReadCount++;
+		Ordered &= Frame >= LastFrame;
+		LastFrame = Frame;
+		for (uint32_t Index = 0; Frame > 1 && Index < Value.size(); Index++)
+		{
+			if (Value[Index].Value != static_cast<double>(Frame + Index))
+			{
+				TornCount++;
+				break;
+			}
+		}
+	}
+	Writer.join();
+
+	CHECK(ReadCount > 0);
+	CHECK(TornCount == 0);
+	CHECK(Ordered);
+	CHECK(Reader.Read(Frame, Timestamp, Value));
+	CHECK(Frame == FrameCount);
+	CHECK(Value.size() == Capacity && Value[Capacity - 1].Value == static_cast<double>(FrameCount + Capacity - 1));
+
+	return Report("telemetry");
+}
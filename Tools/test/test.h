@@ -0,0 +1,44 @@
+#ifndef _TEST_H_
+#define _TEST_H_
+
+#include <cstdio>
+
+// Counts failed checks; main() returns Report() so make test stops on the first failing file.
+inline int& GetFailureCount()
+{
+	static int FailureCount = 0;
+	return FailureCount;
+}
+
+#define CHECK(Expression) \
+	do \
+	{ \
+		if (!(Expression)) \
+		{ \
+			printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #Expression); \
+			GetFailureCount()++; \
+		} \
+	} while (false)
+
+#define CHECK_THROW(Expression, Result) \
+	do \
+	{ \
+		bool Thrown = false; \
+		try \
+		{ \
+			Expression; \
+		} \
+		catch (HRESULT Error) \
+		{ \
+			Thrown = (Error == (Result)); \
+		} \
+		CHECK(Thrown && #Expression); \
+	} while (false)
+
+inline int Report(const char* Name)
+{
+	printf("%s: %s\n", Name, GetFailureCount() ? "FAILED" : "passed");
+	return GetFailureCount() ? 1 : 0;
+}
+
+#endif